@@ -3,6 +3,8 @@
 #include "btstack_stdio_esp32.h"
 #include "uni.h"
 
+#include <esp_timer.h>
+
 #include "sdkconfig.h"
 #include "Board/ogxm_log.h"
 #include "Board/board_api.h"
@@ -18,6 +20,12 @@ void BTManager::run_task()
     {
         UserProfile profile = UserSettings::get_instance().get_profile_by_index(i);
         devices_[i].mapper.set_profile(profile);
+
+        FBContext& fb_context = devices_[i].fb_context;
+        fb_context.index = i;
+        fb_context.packet_out = &devices_[i].packet_out;
+        fb_context.cb_reg.callback = send_feedback_cb;
+        fb_context.cb_reg.context = reinterpret_cast<void*>(&fb_context);
     }
 
     i2c_driver_.initialize_i2c(
@@ -27,6 +35,13 @@ void BTManager::run_task()
         CONFIG_I2C_BAUDRATE
     );
 
+    //Every pad exchange reads rumble back, there's no separate feedback poll
+    i2c_driver_.set_pad_out_callback(
+        [](uint8_t index, const I2CDriver::PacketOut& packet_out)
+        {
+            get_instance().pad_out_cb(index, packet_out);
+        });
+
     xTaskCreatePinnedToCore(
         [](void* parameter)
         { 
@@ -171,79 +186,50 @@ void BTManager::send_feedback_cb(void* context)
 
     I2CDriver::PacketOut packet_out = fb_context->packet_out->load();
 
-    if (packet_out.rumble_l || packet_out.rumble_r)
-    {
-        bp_device->report_parser.play_dual_rumble(
-            bp_device, 
-            0, 
-            FEEDBACK_TIME_MS, 
-            packet_out.rumble_l, 
-            packet_out.rumble_r
-            );
-    }
+    bp_device->report_parser.play_dual_rumble(
+        bp_device, 
+        0, 
+        RUMBLE_DURATION_MS, 
+        packet_out.rumble_l, 
+        packet_out.rumble_r
+        );
 }
 
-//This will have to be changed once full support for multiple devices is added
-void BTManager::feedback_timer_cb(btstack_timer_source *ts)
+//Called on the i2c thread after each pad exchange
+void BTManager::pad_out_cb(uint8_t index, const I2CDriver::PacketOut& packet_out)
 {
-    static FBContext fb_contexts[MAX_GAMEPADS];
-    BTManager& bt_manager = get_instance();
-
-    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    if (index >= devices_.size() || !devices_[index].connected.load())
     {
-        if (!get_connected_bp32_device(i))
-        {
-            continue;
-        }
+        return;
+    }
 
-        FBContext& fb_context = fb_contexts[i];
-        fb_context.index = i;
-        fb_context.packet_out = &bt_manager.devices_[i].packet_out;
-        fb_context.cb_reg.callback = send_feedback_cb;
-        fb_context.cb_reg.context = reinterpret_cast<void*>(&fb_context);
+    Device& device = devices_[index];
+    int64_t now_us = esp_timer_get_time();
 
-        //Register a read on i2c thread, with callback to send feedback on btstack thread
-        bt_manager.i2c_driver_.read_packet(I2CDriver::MULTI_SLAVE ? i + 1 : 0x01,
-            [&fb_context](const I2CDriver::PacketOut& packet_out)
-            {
-                fb_context.packet_out->store(packet_out);
-                btstack_run_loop_execute_on_main_thread(&fb_context.cb_reg);
-            });
+    bool changed = (packet_out.rumble_l != device.rumble_l) || (packet_out.rumble_r != device.rumble_r);
+    bool refresh = (packet_out.rumble_l || packet_out.rumble_r) && (now_us - device.rumble_sent_us >= RUMBLE_REFRESH_US);
+    if (!changed && !refresh)
+    {
+        return;
     }
 
-    btstack_run_loop_set_timer(ts, FEEDBACK_TIME_MS);
-    btstack_run_loop_add_timer(ts);
+    device.rumble_l = packet_out.rumble_l;
+    device.rumble_r = packet_out.rumble_r;
+    device.rumble_sent_us = now_us;
+    device.packet_out.store(packet_out);
+    btstack_run_loop_execute_on_main_thread(&device.fb_context.cb_reg);
 }
 
 void BTManager::manage_connection(uint8_t index, bool connected)
 {
     devices_[index].connected.store(connected);
-    if (connected)
+    if (!connected)
     {
-        if (!fb_timer_running_)
-        {
-            fb_timer_running_ = true;
-            fb_timer_.process = feedback_timer_cb;
-            fb_timer_.context = nullptr;
-            btstack_run_loop_set_timer(&fb_timer_, FEEDBACK_TIME_MS);
-            btstack_run_loop_add_timer(&fb_timer_);
-        }
-    }
-    else
-    {
-        if (!any_connected())
-        {
-            if (fb_timer_running_)
-            {
-                fb_timer_running_ = false;
-                btstack_run_loop_remove_timer(&fb_timer_);
-            }
-        }
-
+        //Neutral input, sent once, then the pad stops being polled
         I2CDriver::PacketIn packet_in = I2CDriver::PacketIn();
         packet_in.packet_id = I2CDriver::PacketID::SET_PAD;
         packet_in.index = index;
-        i2c_driver_.write_packet(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in);
+        i2c_driver_.set_pad(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in, false);
     }
 }
 
@@ -31,37 +31,42 @@ private:
     BTManager(const BTManager&) = delete;
     BTManager& operator=(const BTManager&) = delete;
 
-    static constexpr uint32_t FEEDBACK_TIME_MS = 200;
+    //Rumble is played for RUMBLE_DURATION_MS and refreshed after RUMBLE_REFRESH_MS while it's on
+    static constexpr uint32_t RUMBLE_DURATION_MS = 200;
+    static constexpr int64_t  RUMBLE_REFRESH_US = 150 * 1000;
     static constexpr uint32_t LED_TIME_MS = 500;
 
+    struct FBContext
+    {
+        uint8_t index;
+        std::atomic<I2CDriver::PacketOut>* packet_out;
+        btstack_context_callback_registration_t cb_reg;
+    };
+
     struct Device
     {
         std::atomic<bool> connected{false};
         GamepadMapper mapper;
         I2CDriver::PacketIn packet_in;
         std::atomic<I2CDriver::PacketOut> packet_out; //Can be updated from i2c thread
-    };
+        FBContext fb_context;
 
-    struct FBContext
-    {
-        uint8_t index;
-        std::atomic<I2CDriver::PacketOut>* packet_out;
-        btstack_context_callback_registration_t cb_reg;
+        //i2c thread only, what was last handed to send_feedback_cb
+        uint8_t rumble_l{0};
+        uint8_t rumble_r{0};
+        int64_t rumble_sent_us{0};
     };
 
     std::array<Device, MAX_GAMEPADS> devices_;
     I2CDriver i2c_driver_;
 
-    btstack_timer_source_t fb_timer_;
-    bool fb_timer_running_ = false;
-
     void send_driver_type(DeviceDriverType driver_type);
     void manage_connection(uint8_t index, bool connected);
+    void pad_out_cb(uint8_t index, const I2CDriver::PacketOut& packet_out);
     
     static uni_hid_device_t* get_connected_bp32_device(uint8_t index);
     static void check_led_cb(btstack_timer_source *ts);
     static void send_feedback_cb(void* context);
-    static void feedback_timer_cb(btstack_timer_source *ts);
     static void driver_update_timer_cb(btstack_timer_source *ts);
 
     //Bluepad32 driver
@@ -1,3 +1,5 @@
+#include <esp_timer.h>
+
 #include "btstack_port_esp32.h"
 #include "btstack_run_loop.h"
 #include "btstack_stdio_esp32.h"
@@ -17,6 +19,9 @@ void BTManager::init_complete_cb(void)
     uni_bt_enable_new_connections_unsafe(true);
     // uni_bt_del_keys_unsafe();
     uni_property_dump_all();
+
+    //Includes loading UserSettings, which reads every profile once up front
+    OGXM_LOG("BP32: Scanning %u ms after boot\n", static_cast<unsigned>(esp_timer_get_time() / 1000));
 }
 
 uni_error_t BTManager::device_discovered_cb(bd_addr_t addr, const char* name, uint16_t cod, uint8_t rssi) 
@@ -135,7 +140,7 @@ void BTManager::controller_data_cb(uni_hid_device_t* bp_device, uni_controller_t
     std::tie(packet_in.joystick_lx, packet_in.joystick_ly) = mapper.scale_joystick_l<10>(uni_gp->axis_x, uni_gp->axis_y);
     std::tie(packet_in.joystick_rx, packet_in.joystick_ry) = mapper.scale_joystick_r<10>(uni_gp->axis_rx, uni_gp->axis_ry);
 
-    i2c_driver_.write_packet(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in);
+    i2c_driver_.set_pad(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in);
 
     std::memcpy(&prev_uni_gps[idx], uni_gp, sizeof(uni_gamepad_t));
 }
@@ -1,10 +1,13 @@
+#include <algorithm>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/timers.h>
 #include <driver/gpio.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #include "I2CDriver/I2CDriver.h"
+#include "Board/ogxm_log.h"
 
 I2CDriver::~I2CDriver()
 {
@@ -38,17 +41,377 @@ void I2CDriver::initialize_i2c(i2c_port_t i2c_port, gpio_num_t sda, gpio_num_t s
 
 void I2CDriver::run_tasks()
 {
-    std::function<void()> task;
+    Task task;
+    task_handle_.store(xTaskGetCurrentTaskHandle());
 
     while (true)
     {   
+        exchange_pads();
+
         while (task_queue_.pop(task))
         {
             task();
         }
 
-        vTaskDelay(1);
+        log_stats();
+
+        //Anything queued since the top of the loop has notified, so this returns right away
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POLL_INTERVAL_MS));
+    }
+}
+
+void I2CDriver::notify()
+{
+    TaskHandle_t task_handle = task_handle_.load();
+    if (task_handle)
+    {
+        xTaskNotifyGive(task_handle);
+    }
+}
+
+void I2CDriver::task_queued()
+{
+    uint32_t depth = static_cast<uint32_t>(task_queue_.size());
+    if (depth > stats_.max_queue_depth.load(std::memory_order_relaxed))
+    {
+        stats_.max_queue_depth.store(depth, std::memory_order_relaxed);
+    }
+    notify();
+}
+
+void I2CDriver::exchange_pads()
+{
+    if (!MULTI_SLAVE && links_[SINGLE_SLAVE_ADDRESS].multi)
+    {
+        exchange_pads_multi(SINGLE_SLAVE_ADDRESS);
+        return;
+    }
+
+    for (uint8_t i = 0; i < pad_mailboxes_.size(); ++i)
+    {
+        PadMailbox& mailbox = pad_mailboxes_[i];
+        PacketIn packet_in;
+        uint8_t address = 0;
+        int64_t dirty_since_us = 0;
+        int64_t now_us = esp_timer_get_time();
+
+        taskENTER_CRITICAL(&mailbox_mux_);
+        bool dirty = mailbox.dirty;
+        bool poll = !dirty && mailbox.polling && 
+                    (now_us - mailbox.last_exchange_us >= static_cast<int64_t>(POLL_INTERVAL_MS) * 1000);
+        if (dirty || poll)
+        {
+            packet_in = mailbox.packet_in;
+            address = mailbox.address;
+            dirty_since_us = mailbox.dirty_since_us;
+            mailbox.dirty = false;
+        }
+        taskEXIT_CRITICAL(&mailbox_mux_);
+
+        if (!dirty && !poll)
+        {
+            continue;
+        }
+
+        PacketOut packet_out;
+        esp_err_t ret = exchange_pad(address, packet_in, packet_out);
+
+        int64_t end_us = esp_timer_get_time();
+        mailbox.last_exchange_us = end_us;
+        ++stats_.exchanges;
+        stats_.last_exchange_us = static_cast<uint32_t>(end_us - now_us);
+        stats_.max_exchange_us = std::max(stats_.max_exchange_us, stats_.last_exchange_us);
+
+        if (poll)
+        {
+            ++stats_.polls;
+        }
+        else
+        {
+            uint32_t latency_us = static_cast<uint32_t>(end_us - dirty_since_us);
+            stats_.last_latency_us = latency_us;
+            stats_.max_latency_us = std::max(stats_.max_latency_us, latency_us);
+            stats_.total_latency_us += latency_us;
+        }
+
+        if (ret != ESP_OK)
+        {
+            ++stats_.errors;
+            continue;
+        }
+        if (pad_out_callback_)
+        {
+            pad_out_callback_(i, packet_out);
+        }
+    }
+}
+
+//Every changed pad in one write, the reply carries every pad's rumble so it also polls them all
+void I2CDriver::exchange_pads_multi(uint8_t address)
+{
+    std::array<PacketIn, CONFIG_BLUEPAD32_MAX_DEVICES> packets_in;
+    std::array<int64_t, CONFIG_BLUEPAD32_MAX_DEVICES> dirty_since_us;
+    uint8_t pads = 0;      //Changed since the last exchange
+    uint8_t connected = 0;
+    bool poll = false;
+    int64_t now_us = esp_timer_get_time();
+
+    for (uint8_t i = 0; i < pad_mailboxes_.size(); ++i)
+    {
+        PadMailbox& mailbox = pad_mailboxes_[i];
+
+        taskENTER_CRITICAL(&mailbox_mux_);
+        if (mailbox.dirty)
+        {
+            packets_in[i] = mailbox.packet_in;
+            dirty_since_us[i] = mailbox.dirty_since_us;
+            mailbox.dirty = false;
+            pads |= (1U << i);
+        }
+        if (mailbox.polling)
+        {
+            connected |= (1U << i);
+            poll |= (now_us - mailbox.last_exchange_us >= static_cast<int64_t>(POLL_INTERVAL_MS) * 1000);
+        }
+        taskEXIT_CRITICAL(&mailbox_mux_);
+    }
+
+    if (!pads && !poll)
+    {
+        return;
+    }
+
+    std::array<I2CLink::PadState, I2CLink::MAX_PADS> states;
+    for (uint8_t i = 0; i < pad_mailboxes_.size(); ++i)
+    {
+        if (pads & (1U << i))
+        {
+            states[i] = to_pad_state(packets_in[i]);
+        }
+    }
+
+    uint8_t frame[I2CLink::MAX_MULTI_LEN];
+    size_t len = I2CLink::encode_multi(encoders_.data(), states.data(), pads, static_cast<uint8_t>(PacketID::SET_PADS), frame);
+    I2CLink::MultiReply reply;
+
+    esp_err_t ret = i2c_write_read_blocking(address, frame, len, 
+                                            reinterpret_cast<uint8_t*>(&reply), sizeof(reply), 
+                                            transfer_timeout(len + sizeof(reply)));
+    if (ret == ESP_OK && 
+        (reply.packet_len != sizeof(reply) || reply.packet_id != static_cast<uint8_t>(PacketID::SET_PADS)))
+    {
+        ret = ESP_ERR_INVALID_RESPONSE;
+    }
+
+    int64_t end_us = esp_timer_get_time();
+    ++stats_.exchanges;
+    stats_.bytes += len + sizeof(reply);
+    stats_.last_exchange_us = static_cast<uint32_t>(end_us - now_us);
+    stats_.max_exchange_us = std::max(stats_.max_exchange_us, stats_.last_exchange_us);
+
+    if (!pads)
+    {
+        ++stats_.polls;
+    }
+    for (uint8_t i = 0; i < pad_mailboxes_.size(); ++i)
+    {
+        if ((pads | connected) & (1U << i))
+        {
+            pad_mailboxes_[i].last_exchange_us = end_us;
+        }
+        if (pads & (1U << i))
+        {
+            uint32_t latency_us = static_cast<uint32_t>(end_us - dirty_since_us[i]);
+            stats_.last_latency_us = latency_us;
+            stats_.max_latency_us = std::max(stats_.max_latency_us, latency_us);
+            stats_.total_latency_us += latency_us;
+        }
+    }
+
+    if (ret != ESP_OK)
+    {
+        ++stats_.errors;
+        if (ret == ESP_FAIL)
+        {
+            //Not acknowledged, the slave may have restarted with other firmware
+            links_[address] = Link();
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < pad_mailboxes_.size(); ++i)
+    {
+        if (pads & (1U << i))
+        {
+            encoders_[i].commit();
+        }
+        if (reply.need_key & (1U << i))
+        {
+            encoders_[i].request_key();
+        }
+        if (pad_out_callback_ && ((pads | connected) & (1U << i)))
+        {
+            PacketOut packet_out;
+            packet_out.packet_id = PacketID::SET_PADS;
+            packet_out.index = i;
+            packet_out.rumble_l = reply.rumble[i].rumble_l;
+            packet_out.rumble_r = reply.rumble[i].rumble_r;
+            pad_out_callback_(i, packet_out);
+        }
+    }
+}
+
+void I2CDriver::log_stats()
+{
+    static int64_t last_us = 0;
+    int64_t now_us = esp_timer_get_time();
+    if (now_us - last_us < STATS_INTERVAL_US)
+    {
+        return;
+    }
+    last_us = now_us;
+
+    const uint32_t changes = stats_.exchanges - stats_.polls;
+
+    OGXM_LOG("I2C: exchanges %u, polls %u, errors %u, bytes %u, bus time last %u us, max %u us\n",
+        static_cast<unsigned>(stats_.exchanges),
+        static_cast<unsigned>(stats_.polls),
+        static_cast<unsigned>(stats_.errors),
+        static_cast<unsigned>(stats_.bytes),
+        static_cast<unsigned>(stats_.last_exchange_us),
+        static_cast<unsigned>(stats_.max_exchange_us));
+    OGXM_LOG("I2C: coalesced %u, max queue depth %u, queue drops %u, latency last %u us, avg %u us, max %u us\n",
+        static_cast<unsigned>(stats_.coalesced.load()),
+        static_cast<unsigned>(stats_.max_queue_depth.load()),
+        static_cast<unsigned>(task_queue_.drops()),
+        static_cast<unsigned>(stats_.last_latency_us),
+        static_cast<unsigned>(changes ? (stats_.total_latency_us / changes) : 0),
+        static_cast<unsigned>(stats_.max_latency_us));
+}
+
+void I2CDriver::get_caps(uint8_t address, Link& link)
+{
+    PacketIn packet_in;
+    packet_in.packet_id = PacketID::GET_CAPS;
+    PacketOut packet_out;
+
+    esp_err_t ret = i2c_write_read_blocking(address, 
+                                            reinterpret_cast<const uint8_t*>(&packet_in), sizeof(PacketIn), 
+                                            reinterpret_cast<uint8_t*>(&packet_out), sizeof(PacketOut));
+    stats_.bytes += sizeof(PacketIn) + sizeof(PacketOut);
+    if (ret == ESP_FAIL)
+    {
+        //Nobody there yet, ask again next time
+        return;
+    }
+    if (ret == ESP_OK && packet_out.packet_id == PacketID::GET_CAPS)
+    {
+        link.caps_known = true;
+        const uint8_t caps = I2CLink::negotiate(packet_out.caps);
+        link.delta = (caps & I2CLink::CAP_DELTA);
+        link.multi = (caps & I2CLink::CAP_MULTI);
+
+        //The slave reset its decoders
+        for (auto& encoder : encoders_)
+        {
+            encoder.request_key();
+        }
+        OGXM_LOG("I2C: Slave 0x%02X takes %s packets\n", address, link.multi ? "multi" : (link.delta ? "delta" : "full"));
+    }
+    else if (++link.caps_retries >= CAPS_RETRIES)
+    {
+        //Older firmware, it ignores GET_CAPS
+        link.caps_known = true;
+        link.delta = false;
+        OGXM_LOG("I2C: Slave 0x%02X takes full packets\n", address);
+    }
+}
+
+esp_err_t I2CDriver::exchange_pad(uint8_t address, const PacketIn& data_in, PacketOut& packet_out)
+{
+    Link* link = (address < links_.size()) ? &links_[address] : nullptr;
+    if (link && !link->caps_known)
+    {
+        get_caps(address, *link);
+    }
+
+    if (!link || !link->delta || data_in.index >= encoders_.size())
+    {
+        stats_.bytes += sizeof(PacketIn) + sizeof(PacketOut);
+        return i2c_write_read_blocking( address, 
+                                        reinterpret_cast<const uint8_t*>(&data_in), sizeof(PacketIn), 
+                                        reinterpret_cast<uint8_t*>(&packet_out), sizeof(PacketOut));
     }
+
+    I2CLink::PadState state = to_pad_state(data_in);
+    I2CLink::Encoder& encoder = encoders_[data_in.index];
+    uint8_t frame[I2CLink::MAX_FRAME_LEN];
+    size_t len = encoder.encode(state, static_cast<uint8_t>(PacketID::SET_PAD_DELTA), data_in.index, frame);
+
+    esp_err_t ret = i2c_write_read_blocking(address, frame, len, reinterpret_cast<uint8_t*>(&packet_out), sizeof(PacketOut));
+    stats_.bytes += len + sizeof(PacketOut);
+
+    if (ret == ESP_OK)
+    {
+        encoder.commit();
+        if (packet_out.flags & I2CLink::FLAG_NEED_KEY)
+        {
+            encoder.request_key();
+        }
+    }
+    else if (ret == ESP_FAIL)
+    {
+        //Not acknowledged, the slave may have restarted with other firmware
+        *link = Link();
+    }
+    return ret;
+}
+
+I2CLink::PadState I2CDriver::to_pad_state(const PacketIn& data_in)
+{
+    I2CLink::PadState state;
+    state.dpad = data_in.dpad;
+    state.buttons = data_in.buttons;
+    state.trigger_l = data_in.trigger_l;
+    state.trigger_r = data_in.trigger_r;
+    state.joystick_lx = data_in.joystick_lx;
+    state.joystick_ly = data_in.joystick_ly;
+    state.joystick_rx = data_in.joystick_rx;
+    state.joystick_ry = data_in.joystick_ry;
+    return state;
+}
+
+void I2CDriver::set_pad_out_callback(PadOutCallback callback)
+{
+    pad_out_callback_ = callback;
+}
+
+void I2CDriver::set_pad(uint8_t address, const PacketIn& data_in, bool connected)
+{
+    if (data_in.index >= pad_mailboxes_.size())
+    {
+        return;
+    }
+
+    PadMailbox& mailbox = pad_mailboxes_[data_in.index];
+    int64_t now_us = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&mailbox_mux_);
+    if (mailbox.dirty)
+    {
+        stats_.coalesced.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        mailbox.dirty_since_us = now_us;
+    }
+    mailbox.packet_in = data_in;
+    mailbox.address = address;
+    mailbox.dirty = true;
+    mailbox.polling = connected;
+    taskEXIT_CRITICAL(&mailbox_mux_);
+
+    notify();
 }
 
 void I2CDriver::write_packet(uint8_t address, const PacketIn& data_in) 
@@ -56,17 +419,27 @@ void I2CDriver::write_packet(uint8_t address, const PacketIn& data_in)
     task_queue_.push([this, address, data_in]() 
     {
         i2c_write_blocking(address, reinterpret_cast<const uint8_t*>(&data_in), sizeof(PacketIn));
+        stats_.bytes += sizeof(PacketIn);
     });
+
+    task_queued();
 }
 
-void I2CDriver::read_packet(uint8_t address, std::function<void(const PacketOut&)> callback) 
+void I2CDriver::read_packet(uint8_t address, ReadCallback callback) 
 {
     task_queue_.push([this, address, callback]() 
     {
         PacketOut data_out;
         if (i2c_read_blocking(address, reinterpret_cast<uint8_t*>(&data_out), sizeof(PacketOut)) == ESP_OK)
         {
+            if ((data_out.flags & I2CLink::FLAG_NEED_KEY) && data_out.index < encoders_.size())
+            {
+                encoders_[data_out.index].request_key();
+            }
             callback(data_out);
         }
+        stats_.bytes += sizeof(PacketOut);
     });
+
+    task_queued();
 }
\ No newline at end of file
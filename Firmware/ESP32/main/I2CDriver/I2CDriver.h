@@ -3,11 +3,16 @@
 
 #include <cstdint>
 #include <cstring>
-#include <functional>
+#include <array>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <driver/i2c.h>
 
 #include "sdkconfig.h"
 #include "RingBuffer.h"
+#include "InlineFunction.h"
+#include "I2CLink/I2CLink.h"
 #include "UserSettings/DeviceDriverTypes.h"
 
 class I2CDriver 
@@ -20,7 +25,7 @@ public:
         true;
 #endif
 
-    enum class PacketID : uint8_t { UNKNOWN = 0, SET_PAD, GET_PAD, SET_DRIVER };
+    enum class PacketID : uint8_t { UNKNOWN = 0, SET_PAD, GET_PAD, SET_DRIVER, GET_CAPS, SET_PAD_DELTA, SET_PADS };
     enum class PacketResp : uint8_t { OK = 1, ERROR };
 
     #pragma pack(push, 1)
@@ -49,11 +54,16 @@ public:
         uint8_t index{0};
         uint8_t rumble_l{0};
         uint8_t rumble_r{0};
-        std::array<uint8_t, 3> reserved{0};
+        uint8_t flags{0}; //I2CLink::FLAG_*
+        I2CLink::Caps caps{I2CLink::Caps()}; //Only in replies to GET_CAPS
     };
     static_assert(sizeof(PacketOut) == 8, "PacketOut is misaligned");
     #pragma pack(pop)
 
+    //Captures are copied into the task queue, keep them to pointers and small values
+    using ReadCallback = InlineFunction<void(const PacketOut&), 16>;
+    using PadOutCallback = InlineFunction<void(uint8_t index, const PacketOut&), 16>;
+
     I2CDriver() = default;
     ~I2CDriver();
 
@@ -62,15 +72,94 @@ public:
     //Does not return
     void run_tasks();
 
+    //Latest wins, a pad's state is sent once however often it changed since the last exchange.
+    //Each exchange reads the slave's PacketOut back in the same transaction, a connected pad
+    //that hasn't changed is exchanged again every POLL_INTERVAL_MS so rumble still gets through.
+    //In single slave mode a slave with I2CLink::CAP_MULTI gets every changed pad in one exchange.
+    void set_pad(uint8_t address, const PacketIn& data_in, bool connected = true);
+    //Called from the I2C task with the reply to every pad exchange, set before run_tasks()
+    void set_pad_out_callback(PadOutCallback callback);
     void write_packet(uint8_t address, const PacketIn& data_in);
-    void read_packet(uint8_t address, std::function<void(const PacketOut&)> callback);
+    void read_packet(uint8_t address, ReadCallback callback);
 
 private:
-    using TaskQueue = RingBuffer<std::function<void()>, CONFIG_I2C_RING_BUFFER_SIZE>;
-    
+    //Room for a PacketIn or a ReadCallback plus the driver and an address
+    using Task = InlineFunction<void(), 64>;
+    //Only the btstack run loop queues today, a full queue keeps the older tasks
+    using TaskQueue = MPSCRingBuffer<Task, CONFIG_I2C_RING_BUFFER_SIZE, RingBufferPolicy::REJECT>;
+
+    //Unanswered GET_CAPS before sending a slave only full PacketIns
+    static constexpr uint8_t CAPS_RETRIES = 3;
+    //Where BTManager sends every pad in single slave mode
+    static constexpr uint8_t SINGLE_SLAVE_ADDRESS = 0x01;
+
+    static_assert(CONFIG_BLUEPAD32_MAX_DEVICES <= I2CLink::MAX_PADS, "More pads than a multi frame carries");
+
+    static constexpr int64_t STATS_INTERVAL_US = 5000 * 1000;
+    static constexpr uint32_t POLL_INTERVAL_MS = 10;
+
+    struct PadMailbox
+    {
+        PacketIn packet_in;
+        uint8_t address{0};
+        bool dirty{false};
+        bool polling{false};
+        int64_t dirty_since_us{0};
+        int64_t last_exchange_us{0}; //I2C task only
+    };
+
+    struct Stats
+    {
+        std::atomic<uint32_t> coalesced{0};       //Pad states replaced before they were sent
+        std::atomic<uint32_t> max_queue_depth{0};
+        uint32_t exchanges{0};
+        uint32_t polls{0};                        //Exchanges of an unchanged pad
+        uint32_t errors{0};
+        uint64_t bytes{0};                        //Written and read, without address bytes
+        uint32_t last_exchange_us{0};             //Bus time of the last exchange
+        uint32_t max_exchange_us{0};
+        uint32_t last_latency_us{0};              //From set_pad() to the end of the exchange
+        uint32_t max_latency_us{0};
+        uint64_t total_latency_us{0};
+    };
+
+    struct Link
+    {
+        bool caps_known{false};
+        bool delta{false}; //Slave takes SET_PAD_DELTA frames
+        bool multi{false}; //Slave takes SET_PADS multi frames
+        uint8_t caps_retries{0};
+    };
+
     TaskQueue task_queue_;
     i2c_port_t i2c_port_ = I2C_NUM_0;
     bool initialized_ = false;
+    std::atomic<TaskHandle_t> task_handle_{nullptr};
+    PadOutCallback pad_out_callback_;
+
+    std::array<PadMailbox, CONFIG_BLUEPAD32_MAX_DEVICES> pad_mailboxes_;
+    portMUX_TYPE mailbox_mux_ = portMUX_INITIALIZER_UNLOCKED;
+    Stats stats_;
+
+    //Only used from run_tasks(), links_ is indexed by slave address and encoders_ by pad index
+    std::array<Link, CONFIG_BLUEPAD32_MAX_DEVICES + 1> links_;
+    std::array<I2CLink::Encoder, CONFIG_BLUEPAD32_MAX_DEVICES> encoders_;
+
+    void notify();
+    void task_queued();
+    void exchange_pads();
+    void exchange_pads_multi(uint8_t address);
+    void log_stats();
+    void get_caps(uint8_t address, Link& link);
+    esp_err_t exchange_pad(uint8_t address, const PacketIn& data_in, PacketOut& packet_out);
+
+    static I2CLink::PadState to_pad_state(const PacketIn& data_in);
+
+    //Bus time for len bytes at CONFIG_I2C_BAUDRATE plus the usual margin, multi frames can outlast a fixed timeout
+    static constexpr TickType_t transfer_timeout(size_t len)
+    {
+        return pdMS_TO_TICKS(2 + (len * 9 * 1000) / CONFIG_I2C_BAUDRATE);
+    }
 
     static inline esp_err_t i2c_write_blocking(uint8_t address, const uint8_t* buffer, size_t len) 
     {
@@ -85,6 +174,32 @@ private:
         return ret;
     }
 
+    //Write, repeated start, read, in one transaction
+    static inline esp_err_t i2c_write_read_blocking(uint8_t address, const uint8_t* write_buffer, size_t write_len, 
+                                                    uint8_t* read_buffer, size_t read_len, 
+                                                    TickType_t timeout = pdMS_TO_TICKS(2)) 
+    {
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
+        i2c_master_write(cmd, write_buffer, write_len, true);
+
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_READ, true);
+
+        if (read_len > 1) 
+        {
+            i2c_master_read(cmd, read_buffer, read_len - 1, I2C_MASTER_ACK);
+        }
+
+        i2c_master_read_byte(cmd, read_buffer + read_len - 1, I2C_MASTER_NACK);
+        i2c_master_stop(cmd);
+
+        esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, cmd, timeout);
+        i2c_cmd_link_delete(cmd);
+        return ret;
+    }
+
     static inline esp_err_t i2c_read_blocking(uint8_t address, uint8_t* buffer, size_t len) 
     {
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
@@ -0,0 +1,52 @@
+#ifndef _INLINE_FUNCTION_H_
+#define _INLINE_FUNCTION_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*  Callable kept in a fixed buffer, for queues that can't allocate. The callable is
+    copied byte for byte, so its captures must be trivially copyable and destructible
+    (pointers, references, integers, packed structs) and fit in STORAGE_SIZE, both are
+    checked at compile time. */
+
+template<typename Signature, size_t STORAGE_SIZE>
+class InlineFunction;
+
+template<typename Return, typename... Args, size_t STORAGE_SIZE>
+class InlineFunction<Return(Args...), STORAGE_SIZE>
+{
+public:
+    InlineFunction() = default;
+
+    template<typename Function>
+    requires (!std::is_same_v<std::decay_t<Function>, InlineFunction>)
+    InlineFunction(const Function& function)
+    {
+        static_assert(sizeof(Function) <= STORAGE_SIZE, "InlineFunction: captures don't fit in STORAGE_SIZE");
+        static_assert(alignof(Function) <= alignof(std::max_align_t), "InlineFunction: captures are over-aligned");
+        static_assert(  std::is_trivially_copyable_v<Function> && std::is_trivially_destructible_v<Function>,
+                        "InlineFunction: captures must be trivially copyable and destructible");
+
+        ::new (static_cast<void*>(storage_)) Function(function);
+        invoke_ = [](const void* storage, Args... args) -> Return
+        {
+            return (*static_cast<const Function*>(storage))(std::forward<Args>(args)...);
+        };
+    }
+
+    Return operator()(Args... args) const
+    {
+        return invoke_(storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+
+private:
+    alignas(std::max_align_t) uint8_t storage_[STORAGE_SIZE]{0};
+    Return (*invoke_)(const void*, Args...){nullptr};
+};
+
+#endif // _INLINE_FUNCTION_H_
@@ -2,29 +2,53 @@
 #define _RING_BUFFER_H_
 
 #include <cstdint>
+#include <cstddef>
 #include <atomic>
 #include <array>
 
+/*  Bounded lock-free ring buffers.
+
+    SPSCRingBuffer: exactly one thread pushes and one thread pops. A full buffer rejects
+    the push, dropping the oldest item would mean moving the consumer's index from the
+    producer side.
+
+    MPSCRingBuffer: any number of threads push, one thread pops. Every cell carries a
+    sequence number (Vyukov's bounded queue), a producer claims a position and only
+    writes the cell once the consumer has released it, the consumer only reads a cell
+    once its producer has published it. What happens when it's full is the Policy:
+    REJECT drops the new item, DROP_OLDEST pops the oldest one to make room. The cells
+    allow any thread to pop so that's safe. Popping doesn't always make room though: the
+    consumer may be between claiming and releasing the cell the push needs, or the
+    oldest cell's producer hasn't published it yet, and that thread may be preempted by
+    the pushing one. So after EVICT_ATTEMPTS pops without room DROP_OLDEST drops the new
+    item instead, push() never waits on another thread.
+
+    Dropped items are counted either way. */
+
+enum class RingBufferPolicy : uint8_t
+{
+    REJECT = 0,
+    DROP_OLDEST
+};
+
 template<typename Type, size_t SIZE>
-class RingBuffer
+class SPSCRingBuffer
 {
 public:
-    RingBuffer() : head_(0), tail_(0) {}
-
-    RingBuffer(const RingBuffer&) = delete;
-    RingBuffer& operator=(const RingBuffer&) = delete;
-
-    RingBuffer(RingBuffer&&) = default;
-    RingBuffer& operator=(RingBuffer&&) = default;
+    SPSCRingBuffer() = default;
+    SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+    SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
 
+    //Producer only, false if full
     bool push(const Type& item)
     {
         size_t head = head_.load(std::memory_order_relaxed);
-        size_t next_head = (head + 1) % SIZE;
+        size_t next_head = (head + 1) % buffer_.size();
 
         if (next_head == tail_.load(std::memory_order_acquire))
         {
-            tail_.store((tail_.load(std::memory_order_relaxed) + 1) % SIZE, std::memory_order_release);
+            drops_.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
 
         buffer_[head] = item;
@@ -32,6 +56,7 @@ public:
         return true;
     }
 
+    //Consumer only
     bool pop(Type& item)
     {
         size_t tail = tail_.load(std::memory_order_relaxed);
@@ -42,14 +67,163 @@ public:
         }
 
         item = buffer_[tail];
-        tail_.store((tail + 1) % SIZE, std::memory_order_release);
+        tail_.store((tail + 1) % buffer_.size(), std::memory_order_release);
         return true;
     }
 
+    //Approximate while the other side is pushing or popping
+    size_t size() const
+    {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return (head + buffer_.size() - tail) % buffer_.size();
+    }
+
+    uint32_t drops() const { return drops_.load(std::memory_order_relaxed); }
+
 private:
-    std::array<Type, SIZE> buffer_;
-    std::atomic<size_t> head_;
-    std::atomic<size_t> tail_;
+    //One slot stays empty to tell full from empty
+    std::array<Type, SIZE + 1> buffer_;
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    std::atomic<uint32_t> drops_{0};
+};
+
+template<typename Type, size_t SIZE, RingBufferPolicy POLICY = RingBufferPolicy::REJECT>
+class MPSCRingBuffer
+{
+public:
+    MPSCRingBuffer()
+    {
+        for (size_t i = 0; i < CAPACITY; ++i)
+        {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    MPSCRingBuffer(const MPSCRingBuffer&) = delete;
+    MPSCRingBuffer& operator=(const MPSCRingBuffer&) = delete;
+
+    static constexpr uint8_t EVICT_ATTEMPTS = 4;
+
+    //Any thread, false if the item was dropped
+    bool push(const Type& item)
+    {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        uint8_t evictions = 0;
+
+        while (true)
+        {
+            Cell& cell = cells_[pos & MASK];
+            intptr_t diff = static_cast<intptr_t>(cell.seq.load(std::memory_order_acquire) - pos);
+
+            if (diff == 0)
+            {
+                //Free, claim it
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.item = item;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                //Full
+                if constexpr (POLICY == RingBufferPolicy::REJECT)
+                {
+                    drops_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    if (evictions++ == EVICT_ATTEMPTS)
+                    {
+                        drops_.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    Type oldest;
+                    if (pop(oldest))
+                    {
+                        drops_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                //Another producer got there first
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Consumer, or a producer dropping the oldest item
+    bool pop(Type& item)
+    {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            Cell& cell = cells_[pos & MASK];
+            intptr_t diff = static_cast<intptr_t>(cell.seq.load(std::memory_order_acquire) - (pos + 1));
+
+            if (diff == 0)
+            {
+                //Published, claim it
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    item = cell.item;
+                    cell.seq.store(pos + CAPACITY, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                //Empty, or the next producer hasn't finished writing
+                return false;
+            }
+            else
+            {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Approximate while others are pushing or popping
+    size_t size() const
+    {
+        size_t enqueue_pos = enqueue_pos_.load(std::memory_order_acquire);
+        size_t dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+        return (enqueue_pos > dequeue_pos) ? (enqueue_pos - dequeue_pos) : 0;
+    }
+
+    uint32_t drops() const { return drops_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t round_up_pow2(size_t value)
+    {
+        size_t pow2 = 1;
+        while (pow2 < value)
+        {
+            pow2 <<= 1;
+        }
+        return pow2;
+    }
+
+    //Positions wrap at SIZE_MAX, a power of two keeps (pos & MASK) continuous across that
+    static constexpr size_t CAPACITY = round_up_pow2(SIZE < 2 ? 2 : SIZE);
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        Type item;
+    };
+
+    std::array<Cell, CAPACITY> cells_;
+    std::atomic<size_t> enqueue_pos_{0};
+    std::atomic<size_t> dequeue_pos_{0};
+    std::atomic<uint32_t> drops_{0};
 };
 
-#endif // _RING_BUFFER_H_
\ No newline at end of file
+#endif // _RING_BUFFER_H_
@@ -10,6 +10,7 @@
 #include <nvs.h>
 #include <esp_err.h>
 
+//The namespace is opened once and kept open, every access holds nvs_mutex_
 class NVSHelper
 {
 public:
@@ -19,69 +20,95 @@ public:
         return instance;
     }
 
-    esp_err_t write(const std::string& key, const void* value, size_t len)
+    //Holds the lock for several writes and commits them once, on commit() or when it goes out of scope
+    class Batch
     {
-        esp_err_t err;
-        nvs_handle_t handle;
+    public:
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
 
-        xSemaphoreTake(nvs_mutex_, portMAX_DELAY);
+        ~Batch()
+        {
+            commit();
+        }
 
-        if ((err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle)) != ESP_OK) 
+        esp_err_t write(const std::string& key, const void* value, size_t len)
         {
-            xSemaphoreGive(nvs_mutex_);
-            return err;
+            if (committed_ || err_ != ESP_OK)
+            {
+                return committed_ ? ESP_ERR_INVALID_STATE : err_;
+            }
+            err_ = nvs_set_blob(nvs_.handle_, key.c_str(), value, len);
+            return err_;
         }
 
-        if ((err = nvs_set_blob(handle, key.c_str(), value, len)) != ESP_OK) 
+        //First error of the batch, or the result of nvs_commit
+        esp_err_t commit()
         {
-            nvs_close(handle);
-            xSemaphoreGive(nvs_mutex_);
-            return err;
-        } 
+            if (committed_)
+            {
+                return err_;
+            }
+            committed_ = true;
+            if (err_ == ESP_OK)
+            {
+                err_ = nvs_commit(nvs_.handle_);
+            }
+            xSemaphoreGive(nvs_.nvs_mutex_);
+            return err_;
+        }
 
-        err = nvs_commit(handle);
-        nvs_close(handle);
+    private:
+        friend class NVSHelper;
 
-        xSemaphoreGive(nvs_mutex_);
-        return err;
+        Batch(NVSHelper& nvs)
+            : nvs_(nvs)
+        {
+            xSemaphoreTake(nvs_.nvs_mutex_, portMAX_DELAY);
+            err_ = nvs_.open_err_;
+        }
+
+        NVSHelper& nvs_;
+        esp_err_t err_{ESP_OK};
+        bool committed_{false};
+    };
+
+    Batch batch()
+    {
+        return Batch(*this);
     }
 
-    esp_err_t read(const std::string& key, void* value, size_t len)
+    esp_err_t write(const std::string& key, const void* value, size_t len)
     {
-        esp_err_t err;
-        nvs_handle_t handle;
+        Batch batch(*this);
+        batch.write(key, value, len);
+        return batch.commit();
+    }
 
+    esp_err_t read(const std::string& key, void* value, size_t len)
+    {
         xSemaphoreTake(nvs_mutex_, portMAX_DELAY);
 
-        if ((err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle)) != ESP_OK) 
+        esp_err_t err = open_err_;
+        if (err == ESP_OK)
         {
-            xSemaphoreGive(nvs_mutex_);
-            return err;
+            err = nvs_get_blob(handle_, key.c_str(), value, &len);
         }
 
-        err = nvs_get_blob(handle, key.c_str(), value, &len);
-        nvs_close(handle);
-
         xSemaphoreGive(nvs_mutex_);
         return err;
     }
 
     esp_err_t erase_all()
     {
-        esp_err_t err;
-        nvs_handle_t handle;
-
         xSemaphoreTake(nvs_mutex_, portMAX_DELAY);
 
-        if ((err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle)) != ESP_OK) 
+        esp_err_t err = open_err_;
+        if (err == ESP_OK && (err = nvs_erase_all(handle_)) == ESP_OK)
         {
-            xSemaphoreGive(nvs_mutex_);
-            return err;
+            err = nvs_commit(handle_);
         }
 
-        err = nvs_erase_all(handle);
-        nvs_close(handle);
-
         xSemaphoreGive(nvs_mutex_);
         return err;
     }
@@ -92,22 +119,32 @@ private:
         nvs_mutex_ = xSemaphoreCreateMutex();
         xSemaphoreTake(nvs_mutex_, portMAX_DELAY);
 
-        if (nvs_flash_init() != ESP_OK) 
+        if (nvs_flash_init() != ESP_OK)
         {
             ESP_ERROR_CHECK(nvs_flash_erase());
             ESP_ERROR_CHECK(nvs_flash_init());
         }
 
+        open_err_ = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle_);
+
         xSemaphoreGive(nvs_mutex_);
     }
-    ~NVSHelper() = default;
+    ~NVSHelper()
+    {
+        if (open_err_ == ESP_OK)
+        {
+            nvs_close(handle_);
+        }
+    }
     NVSHelper(const NVSHelper&) = delete;
-    NVSHelper& operator=(const NVSHelper&) = delete; 
+    NVSHelper& operator=(const NVSHelper&) = delete;
 
     SemaphoreHandle_t nvs_mutex_;
+    nvs_handle_t handle_{0};
+    esp_err_t open_err_{ESP_FAIL};
 
     static constexpr char NVS_NAMESPACE[] = "user_data";
-    
+
 }; // class NVSHelper
 
-#endif // _NVS_HELPER_H_
\ No newline at end of file
+#endif // _NVS_HELPER_H_
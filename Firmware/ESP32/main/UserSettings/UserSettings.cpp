@@ -96,31 +96,62 @@ void UserSettings::initialize_flash()
     if (init_flag == INIT_FLAG)
     {
         ESP_LOGD("UserSettings", "UserSettings already initialized");
+        load_cache();
         return;
     }
 
     ESP_ERROR_CHECK(nvs_helper_.erase_all());
     OGXM_LOG("Initializing UserSettings\n");
 
+    NVSHelper::Batch batch = nvs_helper_.batch();
+
     current_driver_ = DEFAULT_DRIVER();
     uint8_t driver_type = static_cast<uint8_t>(current_driver_);
-    ESP_ERROR_CHECK(nvs_helper_.write(DRIVER_TYPE_KEY(), &driver_type, sizeof(driver_type)));
+    ESP_ERROR_CHECK(batch.write(DRIVER_TYPE_KEY(), &driver_type, sizeof(driver_type)));
 
     uint8_t active_id = 1;
     for (uint8_t i = 0; i < MAX_GAMEPADS; i++)
     {
-        ESP_ERROR_CHECK(nvs_helper_.write(ACTIVE_PROFILE_KEY(i), &active_id, sizeof(active_id)));
+        ESP_ERROR_CHECK(batch.write(ACTIVE_PROFILE_KEY(i), &active_id, sizeof(active_id)));
+        active_ids_[i] = active_id;
     }
 
     UserProfile profile = UserProfile();
     for (uint8_t i = 0; i < MAX_PROFILES; i++)
     {
         profile.id = i + 1;
-        ESP_ERROR_CHECK(nvs_helper_.write(PROFILE_KEY(profile.id), &profile, sizeof(UserProfile)));
+        ESP_ERROR_CHECK(batch.write(PROFILE_KEY(profile.id), &profile, sizeof(UserProfile)));
+        profiles_[i] = profile;
     }
 
     init_flag = INIT_FLAG;
-    ESP_ERROR_CHECK(nvs_helper_.write(INIT_FLAG_KEY(), &init_flag, sizeof(init_flag)));
+    ESP_ERROR_CHECK(batch.write(INIT_FLAG_KEY(), &init_flag, sizeof(init_flag)));
+    ESP_ERROR_CHECK(batch.commit());
+}
+
+//One pass over everything get_profile_by_*() and get_active_profile_id() hand out
+void UserSettings::load_cache()
+{
+    for (uint8_t i = 0; i < MAX_PROFILES; i++)
+    {
+        if (nvs_helper_.read(PROFILE_KEY(i + 1), &profiles_[i], sizeof(UserProfile)) != ESP_OK)
+        {
+            profiles_[i] = UserProfile();
+            profiles_[i].id = i + 1;
+        }
+    }
+
+    for (uint8_t i = 0; i < MAX_GAMEPADS; i++)
+    {
+        uint8_t active_id = 0;
+        if (nvs_helper_.read(ACTIVE_PROFILE_KEY(i), &active_id, sizeof(active_id)) != ESP_OK ||
+            active_id < 1 ||
+            active_id > MAX_PROFILES)
+        {
+            active_id = 0x01;
+        }
+        active_ids_[i] = active_id;
+    }
 }
 
 DeviceDriverType UserSettings::get_current_driver()
@@ -200,40 +231,58 @@ void UserSettings::store_driver_type(DeviceDriverType new_driver_type)
     nvs_helper_.write(DRIVER_TYPE_KEY(), &new_driver, sizeof(new_driver));
 }
 
-void UserSettings::store_profile(const uint8_t index, UserProfile& profile)
+//Queues the profile and active id, the cache is only updated once the batch commits
+bool UserSettings::write_profile(NVSHelper::Batch& batch, const uint8_t index, UserProfile& profile)
 {
-    if (index > MAX_GAMEPADS || profile.id < 1 || profile.id > MAX_PROFILES)
+    if (index >= MAX_GAMEPADS || profile.id < 1 || profile.id > MAX_PROFILES)
     {
-        return;
+        return false;
     }
 
     OGXM_LOG("Storing profile %d for gamepad %d\n", profile.id, index);
 
-    if (nvs_helper_.write(PROFILE_KEY(profile.id), &profile, sizeof(UserProfile)) == ESP_OK)
+    return  batch.write(PROFILE_KEY(profile.id), &profile, sizeof(UserProfile)) == ESP_OK &&
+            batch.write(ACTIVE_PROFILE_KEY(index), &profile.id, sizeof(profile.id)) == ESP_OK;
+}
+
+void UserSettings::store_profile(const uint8_t index, UserProfile& profile)
+{
+    NVSHelper::Batch batch = nvs_helper_.batch();
+
+    if (write_profile(batch, index, profile) && batch.commit() == ESP_OK)
     {
+        profiles_[profile.id - 1] = profile;
+        active_ids_[index] = profile.id;
         OGXM_LOG("Profile %d stored successfully\n", profile.id);
-
-        nvs_helper_.write(ACTIVE_PROFILE_KEY(index), &profile.id, sizeof(profile.id));
     }
 }
 
+//Driver type and profile go out with one commit
 void UserSettings::store_profile_and_driver_type(DeviceDriverType new_driver_type, const uint8_t index, UserProfile& profile)
 {
-    store_driver_type(new_driver_type);
-    store_profile(index, profile);
+    NVSHelper::Batch batch = nvs_helper_.batch();
+
+    if (is_valid_driver(new_driver_type))
+    {
+        uint8_t new_driver = static_cast<uint8_t>(new_driver_type);
+        batch.write(DRIVER_TYPE_KEY(), &new_driver, sizeof(new_driver));
+    }
+
+    if (write_profile(batch, index, profile) && batch.commit() == ESP_OK)
+    {
+        profiles_[profile.id - 1] = profile;
+        active_ids_[index] = profile.id;
+        OGXM_LOG("Profile %d stored successfully\n", profile.id);
+    }
 }
 
 uint8_t UserSettings::get_active_profile_id(const uint8_t index)
 {
-    uint8_t read_profile_id = 0;
-
-    if (nvs_helper_.read(ACTIVE_PROFILE_KEY(index), &read_profile_id, sizeof(read_profile_id)) != ESP_OK ||
-        read_profile_id < 1 || 
-        read_profile_id > MAX_PROFILES)
+    if (index >= MAX_GAMEPADS)
     {
         return 0x01;
     }
-    return read_profile_id;
+    return active_ids_[index];
 }
 
 UserProfile UserSettings::get_profile_by_index(const uint8_t index)
@@ -243,16 +292,11 @@ UserProfile UserSettings::get_profile_by_index(const uint8_t index)
 
 UserProfile UserSettings::get_profile_by_id(const uint8_t profile_id)
 {
-    UserProfile profile;
-
-    if (profile_id < 1 || 
-        profile_id > MAX_PROFILES ||
-        nvs_helper_.read(PROFILE_KEY(profile_id), &profile, sizeof(UserProfile)) != ESP_OK)
+    if (profile_id < 1 || profile_id > MAX_PROFILES)
     {
         return UserProfile();
     }
-
-    return profile;
+    return profiles_[profile_id - 1];
 }
 
 DeviceDriverType UserSettings::DEFAULT_DRIVER()
@@ -3,8 +3,10 @@
 
 #include <cstdint>
 #include <atomic>
+#include <array>
 
 #include "sdkconfig.h"
+#include "Board/Config.h"
 #include "I2CDriver/I2CDriver.h"
 #include "UserSettings/UserProfile.h"
 #include "UserSettings/DeviceDriverTypes.h"
@@ -47,7 +49,14 @@ private:
     NVSHelper& nvs_helper_{NVSHelper::get_instance()};
     DeviceDriverType current_driver_{DeviceDriverType::NONE};
 
+    //Copies of what's stored, loaded by initialize_flash() and kept in step by the store functions.
+    //Only used from the btstack thread.
+    std::array<UserProfile, MAX_PROFILES> profiles_;
+    std::array<uint8_t, MAX_GAMEPADS> active_ids_;
+
     bool is_valid_driver(DeviceDriverType mode);
+    void load_cache();
+    bool write_profile(NVSHelper::Batch& batch, uint8_t index, UserProfile& profile);
 
     DeviceDriverType DEFAULT_DRIVER();
     const std::string INIT_FLAG_KEY();
@@ -6,13 +6,16 @@
 #include "btstack.h"
 
 #include "BLEServer/BLEServer.h"
+#include "BLEServer/ProfileTransfer.h"
 #include "UserSettings/UserProfile.h"
 #include "UserSettings/UserSettings.h"
 #include "TaskQueue/TaskQueue.h"
 
 namespace BLEServer {
 
-static constexpr uint16_t PACKET_LEN_MAX = 20;
+static_assert(DEFAULT_PAYLOAD_LEN == payload_len(ATT_DEFAULT_MTU), "BLEServer::DEFAULT_PAYLOAD_LEN doesn't match ATT_DEFAULT_MTU");
+//How often input is checked for changes while GAMEPAD notifications are on
+static constexpr uint32_t INPUT_NOTIFY_MS = 8;
 
 namespace Handle {
     static constexpr uint16_t FW_VERSION    = ATT_CHARACTERISTIC_12345678_1234_1234_1234_123456789020_01_VALUE_HANDLE;
@@ -23,8 +26,11 @@ namespace Handle {
     static constexpr uint16_t GET_SETUP   = ATT_CHARACTERISTIC_12345678_1234_1234_1234_123456789032_01_VALUE_HANDLE;
 
     static constexpr uint16_t PROFILE  = ATT_CHARACTERISTIC_12345678_1234_1234_1234_123456789040_01_VALUE_HANDLE;
+    static constexpr uint16_t PROFILE_STREAM     = ATT_CHARACTERISTIC_12345678_1234_1234_1234_123456789041_01_VALUE_HANDLE;
+    static constexpr uint16_t PROFILE_STREAM_CFG = ATT_CHARACTERISTIC_12345678_1234_1234_1234_123456789041_01_CLIENT_CONFIGURATION_HANDLE;
 
     static constexpr uint16_t GAMEPAD  = ATT_CHARACTERISTIC_12345678_1234_1234_1234_123456789050_01_VALUE_HANDLE;
+    static constexpr uint16_t GAMEPAD_CFG = ATT_CHARACTERISTIC_12345678_1234_1234_1234_123456789050_01_CLIENT_CONFIGURATION_HANDLE;
 }
 
 namespace ADV {
@@ -51,135 +57,47 @@ namespace ADV {
     #pragma pack(pop)
 }
 
-#pragma pack(push, 1)
-struct SetupPacket {
-    DeviceDriverType device_type{DeviceDriverType::NONE};
-    uint8_t max_gamepads{MAX_GAMEPADS};
-    uint8_t player_idx{0};
-    uint8_t profile_id{0};
-};
-static_assert(sizeof(SetupPacket) == 4, "BLEServer::SetupPacket struct size mismatch");
-#pragma pack(pop)
-
-class ProfileReader {
-public:
-    ProfileReader() = default;
-    ~ProfileReader() = default;
-
-    void set_setup_packet(const SetupPacket& setup_packet) {
-        setup_packet_ = setup_packet;
-        current_offset_ = 0;
-    }
-
-    const SetupPacket& get_setup_packet() const {
-        return setup_packet_;
-    }
+//The config client, one at a time
+struct Connection {
+    hci_con_handle_t handle{HCI_CON_HANDLE_INVALID};
+    uint16_t mtu{ATT_DEFAULT_MTU};
+    bool notify_profile{false};
+    bool notify_gamepad{false};
 
-    uint16_t get_xfer_len() {
-        return static_cast<uint16_t>(std::min(static_cast<size_t>(PACKET_LEN_MAX), sizeof(UserProfile) - current_offset_));
-    }
-
-    uint16_t get_profile_data(uint8_t* buffer, uint16_t buffer_len) {
-        size_t copy_len = get_xfer_len();
-        if (!buffer || buffer_len < copy_len) {
-            return 0;
-        }
-        if (current_offset_ == 0 && !set_profile()) {
-            return 0;
-        }
-        std::memcpy(buffer, reinterpret_cast<uint8_t*>(&profile_) + current_offset_, copy_len);
-        current_offset_ += copy_len;
-        if (current_offset_ >= sizeof(UserProfile)) {
-            current_offset_ = 0;
-        }
-        return copy_len;
-    }
-
-private:
-    SetupPacket setup_packet_;
-    UserProfile profile_;
-    size_t current_offset_ = 0;
-
-    bool set_profile() {
-        if (setup_packet_.profile_id == 0xFF) {
-            if (setup_packet_.player_idx >= UserSettings::MAX_PROFILES) {
-                return false;
-            }
-            profile_ = UserSettings::get_instance().get_profile_by_index(setup_packet_.player_idx);
-        } else {
-            if (setup_packet_.profile_id > UserSettings::MAX_PROFILES) {
-                return false;
-            }
-            profile_ = UserSettings::get_instance().get_profile_by_id(setup_packet_.profile_id);
-        }
-        return true;
+    uint16_t payload_len() const {
+        return BLEServer::payload_len(mtu);
     }
 };
 
-class ProfileWriter
-{
-public:
-    ProfileWriter() = default;
-    ~ProfileWriter() = default;
-
-    void set_setup_packet(const SetupPacket& setup_packet) {
-        setup_packet_ = setup_packet;
-        current_offset_ = 0;
-    }
-
-    const SetupPacket& get_setup_packet() const {
-        return setup_packet_;
-    }
-
-    uint16_t get_xfer_len() {
-        return static_cast<uint16_t>(std::min(static_cast<size_t>(PACKET_LEN_MAX), sizeof(UserProfile) - current_offset_));
-    }
-
-    size_t set_profile_data(const uint8_t* buffer, uint16_t buffer_len) {
-        size_t copy_len = get_xfer_len();
-        if (!buffer || buffer_len < copy_len) {
-            return 0;
-        }
-
-        std::memcpy(reinterpret_cast<uint8_t*>(&profile_) + current_offset_, buffer, copy_len);
-
-        current_offset_ += copy_len;
-        size_t ret = current_offset_;
-
-        if (current_offset_ >= sizeof(UserProfile)) {
-            current_offset_ = 0;
-        }
-        return ret;
-    }
-
-    bool commit_profile() {
-        bool success = false;
-        if (setup_packet_.device_type != DeviceDriverType::NONE) {
-            success = TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), 1000, false,
-                [driver_type = setup_packet_.device_type, profile = profile_, index = setup_packet_.player_idx]
-                {
-                    UserSettings::get_instance().store_profile_and_driver_type(driver_type, index, profile);
-                });
-        } else {
-            success = TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), 1000, false,
-                [index = setup_packet_.player_idx, profile = profile_]
-                {
-                    UserSettings::get_instance().store_profile(index, profile);
-                });
-        }
-        return success;
-    }
-
-private:
-    SetupPacket setup_packet_;
-    UserProfile profile_;
-    size_t current_offset_ = 0;
-};
-
 std::array<Gamepad*, MAX_GAMEPADS> gamepads_;
 ProfileReader profile_reader_;
+ProfileReader profile_streamer_;
 ProfileWriter profile_writer_;
 
+Connection connection_;
+bool profile_stream_pending_{false};
+bool input_pending_{false};
+Gamepad::PadIn pad_in_sent_;
+btstack_timer_source_t input_timer_;
+
+static bool commit_profile(const ProfileWriter& writer) {
+    bool success = false;
+    if (writer.get_setup_packet().device_type != DeviceDriverType::NONE) {
+        success = TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), 1000, false,
+            [driver_type = writer.get_setup_packet().device_type, profile = writer.get_profile(), index = writer.get_setup_packet().player_idx]
+            {
+                UserSettings::get_instance().store_profile_and_driver_type(driver_type, index, profile);
+            });
+    } else {
+        success = TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), 1000, false,
+            [index = writer.get_setup_packet().player_idx, profile = writer.get_profile()]
+            {
+                UserSettings::get_instance().store_profile(index, profile);
+            });
+    }
+    return success;
+}
+
 static int verify_write(const uint16_t buffer_size, const uint16_t expected_size) {
     if (buffer_size != expected_size) {
         return ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH;
@@ -205,6 +123,84 @@ static void queue_disconnect(hci_con_handle_t connection_handle, uint32_t dealy_
     btstack_run_loop_add_timer(&disconnect_timer);
 }
 
+static void request_can_send_now() {
+    if (connection_.handle != HCI_CON_HANDLE_INVALID) {
+        att_server_request_can_send_now_event(connection_.handle);
+    }
+}
+
+//One notification per can send now event, a profile stream goes ahead of input
+static void send_notification() {
+    if (profile_stream_pending_ && connection_.notify_profile) {
+        uint8_t buffer[sizeof(UserProfile)];
+        uint16_t len = profile_streamer_.get_profile_data(buffer, sizeof(buffer), connection_.payload_len());
+        if (len > 0) {
+            att_server_notify(connection_.handle, Handle::PROFILE_STREAM, buffer, len);
+        }
+        profile_stream_pending_ = (len > 0) && !profile_streamer_.at_start();
+    } else if (input_pending_ && connection_.notify_gamepad) {
+        pad_in_sent_ = gamepads_.front()->peek_pad_in();
+        att_server_notify(connection_.handle, Handle::GAMEPAD, reinterpret_cast<const uint8_t*>(&pad_in_sent_), sizeof(Gamepad::PadIn));
+        input_pending_ = false;
+    }
+
+    if ((profile_stream_pending_ && connection_.notify_profile) || (input_pending_ && connection_.notify_gamepad)) {
+        request_can_send_now();
+    }
+}
+
+//PadIn only fits a notification once the MTU has been raised, clients on the default MTU read it instead
+static void input_timer_cb(btstack_timer_source_t* ts) {
+    if (connection_.notify_gamepad && connection_.payload_len() >= sizeof(Gamepad::PadIn) && !input_pending_) {
+        Gamepad::PadIn pad_in = gamepads_.front()->peek_pad_in();
+        if (std::memcmp(&pad_in, &pad_in_sent_, sizeof(Gamepad::PadIn)) != 0) {
+            input_pending_ = true;
+            request_can_send_now();
+        }
+    }
+    btstack_run_loop_set_timer(ts, INPUT_NOTIFY_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void att_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    if (packet_type != HCI_EVENT_PACKET) {
+        return;
+    }
+
+    switch (hci_event_packet_get_type(packet)) {
+        case ATT_EVENT_CONNECTED:
+            connection_ = Connection();
+            connection_.handle = att_event_connected_get_handle(packet);
+            connection_.mtu = att_server_get_mtu(connection_.handle);
+            profile_stream_pending_ = false;
+            input_pending_ = false;
+            pad_in_sent_ = Gamepad::PadIn();
+
+            input_timer_.process = input_timer_cb;
+            btstack_run_loop_set_timer(&input_timer_, INPUT_NOTIFY_MS);
+            btstack_run_loop_add_timer(&input_timer_);
+            break;
+
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+            connection_.mtu = att_event_mtu_exchange_complete_get_MTU(packet);
+            break;
+
+        case ATT_EVENT_CAN_SEND_NOW:
+            send_notification();
+            break;
+
+        case ATT_EVENT_DISCONNECTED:
+            btstack_run_loop_remove_timer(&input_timer_);
+            connection_ = Connection();
+            profile_stream_pending_ = false;
+            input_pending_ = false;
+            break;
+
+        default:
+            break;
+    }
+}
+
 static uint16_t att_read_callback(  hci_con_handle_t connection_handle,
                                     uint16_t att_handle,
                                     uint16_t offset,
@@ -246,7 +242,7 @@ static uint16_t att_read_callback(  hci_con_handle_t connection_handle,
 
         case Handle::GAMEPAD:
             if (buffer) {
-                pad_in = gamepads_.front()->get_pad_in();
+                pad_in = gamepads_.front()->peek_pad_in();
                 std::memcpy(buffer, &pad_in, sizeof(Gamepad::PadIn));
             }
             return static_cast<uint16_t>(sizeof(Gamepad::PadIn));
@@ -280,14 +276,44 @@ static int att_write_callback(  hci_con_handle_t connection_handle,
             profile_writer_.set_setup_packet(*reinterpret_cast<SetupPacket*>(buffer));
             break;
 
+        //Legacy clients write DEFAULT_PAYLOAD_LEN byte chunks, with a raised MTU the profile fits one write
         case Handle::PROFILE:
-            if ((ret = verify_write(buffer_size, profile_writer_.get_xfer_len())) != 0) {
+            if (buffer_size == 0 || buffer_size > profile_writer_.get_xfer_len(connection_.payload_len())) {
+                ret = ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH;
                 break;
             }
             if (profile_writer_.set_profile_data(buffer, buffer_size) == sizeof(UserProfile)) {
                 queue_disconnect(connection_handle, 500);
-                profile_writer_.commit_profile();
+                commit_profile(profile_writer_);
+            }
+            break;
+
+        //Same setup as SETUP_READ, the profile then arrives as notifications of up to payload_len() bytes
+        case Handle::PROFILE_STREAM:
+            if ((ret = verify_write(buffer_size, sizeof(SetupPacket))) != 0) {
+                break;
+            }
+            if (!connection_.notify_profile) {
+                ret = ATT_ERROR_WRITE_NOT_PERMITTED;
+                break;
+            }
+            profile_streamer_.set_setup_packet(*reinterpret_cast<SetupPacket*>(buffer));
+            profile_stream_pending_ = true;
+            request_can_send_now();
+            break;
+
+        case Handle::PROFILE_STREAM_CFG:
+            if ((ret = verify_write(buffer_size, sizeof(uint16_t))) != 0) {
+                break;
+            }
+            connection_.notify_profile = (little_endian_read_16(buffer, 0) & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) != 0;
+            break;
+
+        case Handle::GAMEPAD_CFG:
+            if ((ret = verify_write(buffer_size, sizeof(uint16_t))) != 0) {
+                break;
             }
+            connection_.notify_gamepad = (little_endian_read_16(buffer, 0) & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) != 0;
             break;
 
         default:
@@ -305,6 +331,7 @@ void init_server(Gamepad(&gamepads)[MAX_GAMEPADS]) {
 
     // setup ATT server
     att_server_init(profile_data, att_read_callback, att_write_callback);
+    att_server_register_packet_handler(att_packet_handler);
 
     // setup advertisements
     uint16_t adv_int_min = 0x0030;
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "Board/Config.h"
+#include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
+#include "UserSettings/UserProfile.h"
+#include "UserSettings/UserSettings.h"
+
+/*  Profile transfers of the BLE config server, kept apart from btstack so the chunking
+    can be checked on a host. Chunks are at most the negotiated ATT MTU minus 3 bytes,
+    DEFAULT_PAYLOAD_LEN until the client raises it. */
+namespace BLEServer {
+
+//Value length that fits the default ATT MTU of 23
+static constexpr uint16_t DEFAULT_PAYLOAD_LEN = 20;
+
+//Longest value a notification or write can carry, the ATT header takes 3 bytes
+static constexpr uint16_t payload_len(uint16_t mtu) {
+    return static_cast<uint16_t>(mtu - 3);
+}
+
+#pragma pack(push, 1)
+struct SetupPacket {
+    DeviceDriverType device_type{DeviceDriverType::NONE};
+    uint8_t max_gamepads{MAX_GAMEPADS};
+    uint8_t player_idx{0};
+    uint8_t profile_id{0};
+};
+static_assert(sizeof(SetupPacket) == 4, "BLEServer::SetupPacket struct size mismatch");
+#pragma pack(pop)
+
+class ProfileReader {
+public:
+    ProfileReader() = default;
+    ~ProfileReader() = default;
+
+    void set_setup_packet(const SetupPacket& setup_packet) {
+        setup_packet_ = setup_packet;
+        current_offset_ = 0;
+    }
+
+    const SetupPacket& get_setup_packet() const {
+        return setup_packet_;
+    }
+
+    uint16_t get_xfer_len(uint16_t max_len = DEFAULT_PAYLOAD_LEN) {
+        return static_cast<uint16_t>(std::min(static_cast<size_t>(max_len), sizeof(UserProfile) - current_offset_));
+    }
+
+    //True before the first chunk of a profile and after the last one
+    bool at_start() const {
+        return current_offset_ == 0;
+    }
+
+    uint16_t get_profile_data(uint8_t* buffer, uint16_t buffer_len, uint16_t max_len = DEFAULT_PAYLOAD_LEN) {
+        size_t copy_len = get_xfer_len(max_len);
+        if (!buffer || buffer_len < copy_len) {
+            return 0;
+        }
+        if (current_offset_ == 0 && !set_profile()) {
+            return 0;
+        }
+        std::memcpy(buffer, reinterpret_cast<uint8_t*>(&profile_) + current_offset_, copy_len);
+        current_offset_ += copy_len;
+        if (current_offset_ >= sizeof(UserProfile)) {
+            current_offset_ = 0;
+        }
+        return copy_len;
+    }
+
+private:
+    SetupPacket setup_packet_;
+    UserProfile profile_;
+    size_t current_offset_ = 0;
+
+    bool set_profile() {
+        if (setup_packet_.profile_id == 0xFF) {
+            if (setup_packet_.player_idx >= UserSettings::MAX_PROFILES) {
+                return false;
+            }
+            profile_ = UserSettings::get_instance().get_profile_by_index(setup_packet_.player_idx);
+        } else {
+            if (setup_packet_.profile_id > UserSettings::MAX_PROFILES) {
+                return false;
+            }
+            profile_ = UserSettings::get_instance().get_profile_by_id(setup_packet_.profile_id);
+        }
+        return true;
+    }
+};
+
+class ProfileWriter
+{
+public:
+    ProfileWriter() = default;
+    ~ProfileWriter() = default;
+
+    void set_setup_packet(const SetupPacket& setup_packet) {
+        setup_packet_ = setup_packet;
+        current_offset_ = 0;
+    }
+
+    const SetupPacket& get_setup_packet() const {
+        return setup_packet_;
+    }
+
+    uint16_t get_xfer_len(uint16_t max_len = DEFAULT_PAYLOAD_LEN) {
+        return static_cast<uint16_t>(std::min(static_cast<size_t>(max_len), sizeof(UserProfile) - current_offset_));
+    }
+
+    //Chunks can be any length up to what's left of the profile
+    size_t set_profile_data(const uint8_t* buffer, uint16_t buffer_len) {
+        size_t copy_len = buffer_len;
+        if (!buffer || copy_len == 0 || copy_len > sizeof(UserProfile) - current_offset_) {
+            return 0;
+        }
+
+        std::memcpy(reinterpret_cast<uint8_t*>(&profile_) + current_offset_, buffer, copy_len);
+
+        current_offset_ += copy_len;
+        size_t ret = current_offset_;
+
+        if (current_offset_ >= sizeof(UserProfile)) {
+            current_offset_ = 0;
+        }
+        return ret;
+    }
+
+    const UserProfile& get_profile() const {
+        return profile_;
+    }
+
+private:
+    SetupPacket setup_packet_;
+    UserProfile profile_;
+    size_t current_offset_ = 0;
+};
+
+} // namespace BLEServer
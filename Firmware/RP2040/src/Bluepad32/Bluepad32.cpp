@@ -9,6 +9,7 @@
 
 #include "sdkconfig.h"
 #include "Bluepad32/Bluepad32.h"
+#include "Bluepad32/RumbleScheduler.h"
 #include "Board/board_api.h"
 #include "Board/ogxm_log.h"
 
@@ -20,12 +21,25 @@ static_assert((CONFIG_BLUEPAD32_MAX_DEVICES == MAX_GAMEPADS), "Mismatch between
 
 namespace bluepad32 {
 
-static constexpr uint32_t FEEDBACK_TIME_MS = 250;
+//How often pad_out is checked for new rumble, nothing is sent unless it changed or needs a refresh
+static constexpr uint32_t FEEDBACK_POLL_MS = 4;
 static constexpr uint32_t LED_CHECK_TIME_MS = 500;
 
+//Noise thresholds in Bluepad32 units (sticks -512..511, triggers 0..1023), a report is
+//only remapped if an axis moved further than this from the last one that was published.
+//0 publishes any change.
+static constexpr int32_t JOYSTICK_L_THRESHOLD = 0;
+static constexpr int32_t JOYSTICK_R_THRESHOLD = 0;
+static constexpr int32_t TRIGGER_THRESHOLD = 0;
+
 struct BTDevice {
     bool connected{false};
     Gamepad* gamepad{nullptr};
+    //Last report that was published and the profile it was mapped with
+    bool published{false};
+    uint8_t profile_seq{0};
+    uni_gamepad_t uni_gp{};
+    RumbleScheduler rumble;
 };
 
 BTDevice bt_devices_[MAX_GAMEPADS];
@@ -34,6 +48,15 @@ btstack_timer_source_t led_timer_;
 bool led_timer_set_{false};
 bool feedback_timer_set_{false};
 
+#if defined(CONFIG_OGXM_DEBUG)
+struct ReportStats {
+    uint32_t received{0};
+    uint32_t skipped{0};
+    uint32_t since_ms{0};
+};
+ReportStats report_stats_;
+#endif
+
 bool any_connected()
 {
     for (auto& device : bt_devices_)
@@ -85,9 +108,35 @@ void set_rumble(uni_hid_device_t* bp_device, uint16_t length, uint8_t rumble_l,
     }
 }
 
+//How often each controller type takes a rumble command and how long one plays for.
+//Controllers that queue output reports (PS3, Switch, Wii) get a longer interval so
+//bursts from the console don't back up behind each other.
+RumbleScheduler::Model rumble_model(uni_hid_device_t* bp_device)
+{
+    switch (bp_device->controller_type)
+    {
+        case CONTROLLER_TYPE_XBoxOneController:
+        case CONTROLLER_TYPE_PS4Controller:
+        case CONTROLLER_TYPE_PS5Controller:
+            return { 10, 250 };
+        case CONTROLLER_TYPE_PS3Controller:
+        case CONTROLLER_TYPE_PSMoveController:
+        case CONTROLLER_TYPE_AndroidController:
+            return { 20, 250 };
+        case CONTROLLER_TYPE_SwitchProController:
+        case CONTROLLER_TYPE_SwitchJoyConRight:
+        case CONTROLLER_TYPE_SwitchJoyConLeft:
+        case CONTROLLER_TYPE_WiiController:
+            return { 30, 250 };
+        default:
+            return { 20, 250 };
+    }
+}
+
 static void send_feedback_cb(btstack_timer_source *ts)
 {
     uni_hid_device_t* bp_device = nullptr;
+    const uint32_t now_ms = btstack_run_loop_get_time_ms();
 
     for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
     {
@@ -97,14 +146,21 @@ static void send_feedback_cb(btstack_timer_source *ts)
             continue;
         }
 
-        Gamepad::PadOut gp_out = bt_devices_[i].gamepad->get_pad_out();
-        if (gp_out.rumble_l > 0 || gp_out.rumble_r > 0)
+        BTDevice& bt_device = bt_devices_[i];
+        if (bt_device.gamepad->new_pad_out())
         {
-            set_rumble(bp_device, static_cast<uint16_t>(FEEDBACK_TIME_MS), gp_out.rumble_l, gp_out.rumble_r);
+            Gamepad::PadOut gp_out = bt_device.gamepad->get_pad_out();
+            bt_device.rumble.set(gp_out.rumble_l, gp_out.rumble_r);
+        }
+
+        RumbleScheduler::Command command;
+        if (bt_device.rumble.update(now_ms, command))
+        {
+            set_rumble(bp_device, command.duration_ms, command.rumble_l, command.rumble_r);
         }
     }
 
-    btstack_run_loop_set_timer(ts, FEEDBACK_TIME_MS);
+    btstack_run_loop_set_timer(ts, FEEDBACK_POLL_MS);
     btstack_run_loop_add_timer(ts);
 }
 
@@ -148,6 +204,7 @@ static void device_disconnected_cb(uni_hid_device_t* device) {
     }
 
     bt_devices_[idx].connected = false;
+    bt_devices_[idx].published = false;
     bt_devices_[idx].gamepad->reset_pad_in();
 
     if (!led_timer_set_ && !any_connected()) {
@@ -170,6 +227,10 @@ static uni_error_t device_ready_cb(uni_hid_device_t* device) {
     }
 
     bt_devices_[idx].connected = true;
+    bt_devices_[idx].published = false;
+    bt_devices_[idx].rumble.reset(rumble_model(device));
+    //Pick up whatever the console last asked for
+    bt_devices_[idx].gamepad->resend_pad_out();
 
     if (led_timer_set_) {
         led_timer_set_ = false;
@@ -180,7 +241,7 @@ static uni_error_t device_ready_cb(uni_hid_device_t* device) {
         feedback_timer_set_ = true;
         feedback_timer_.process = send_feedback_cb;
         feedback_timer_.context = nullptr;
-        btstack_run_loop_set_timer(&feedback_timer_, FEEDBACK_TIME_MS);
+        btstack_run_loop_set_timer(&feedback_timer_, FEEDBACK_POLL_MS);
         btstack_run_loop_add_timer(&feedback_timer_);
     }
     return UNI_ERROR_SUCCESS;
@@ -190,17 +251,72 @@ static void oob_event_cb(uni_platform_oob_event_t event, void* data) {
 	return;
 }
 
-static void controller_data_cb(uni_hid_device_t* device, uni_controller_t* controller) {
-    static uni_gamepad_t prev_uni_gp[MAX_GAMEPADS] = {};
+static inline bool axis_changed(int32_t value, int32_t prev, int32_t threshold) {
+    return (value > prev) ? (value - prev > threshold) : (prev - value > threshold);
+}
+
+//True if the report differs from the last published one in anything we map
+static bool report_changed(const uni_gamepad_t& uni_gp, const uni_gamepad_t& prev) {
+    return  uni_gp.dpad != prev.dpad ||
+            uni_gp.buttons != prev.buttons ||
+            uni_gp.misc_buttons != prev.misc_buttons ||
+            axis_changed(uni_gp.axis_x,  prev.axis_x,  JOYSTICK_L_THRESHOLD) ||
+            axis_changed(uni_gp.axis_y,  prev.axis_y,  JOYSTICK_L_THRESHOLD) ||
+            axis_changed(uni_gp.axis_rx, prev.axis_rx, JOYSTICK_R_THRESHOLD) ||
+            axis_changed(uni_gp.axis_ry, prev.axis_ry, JOYSTICK_R_THRESHOLD) ||
+            axis_changed(uni_gp.brake,    prev.brake,    TRIGGER_THRESHOLD) ||
+            axis_changed(uni_gp.throttle, prev.throttle, TRIGGER_THRESHOLD);
+}
 
+#if defined(CONFIG_OGXM_DEBUG)
+static void count_report(bool skipped) {
+    ++report_stats_.received;
+    if (skipped) {
+        ++report_stats_.skipped;
+    }
+
+    uint32_t now_ms = btstack_run_loop_get_time_ms();
+    if (now_ms - report_stats_.since_ms >= 1000) {
+        OGXM_LOG("BT reports/s: %u, skipped: %u\n",
+            static_cast<unsigned>(report_stats_.received), static_cast<unsigned>(report_stats_.skipped));
+        report_stats_ = ReportStats();
+        report_stats_.since_ms = now_ms;
+    }
+}
+#endif
+
+static void controller_data_cb(uni_hid_device_t* device, uni_controller_t* controller) {
     if (controller->klass != UNI_CONTROLLER_CLASS_GAMEPAD){
         return;
     }
 
     uni_gamepad_t *uni_gp = &controller->gamepad;
     int idx = uni_hid_device_get_idx_for_instance(device);
+    if (idx >= MAX_GAMEPADS || idx < 0) {
+        return;
+    }
+
+    BTDevice& bt_device = bt_devices_[idx];
+    Gamepad* gamepad = bt_device.gamepad;
+
+    //Most controllers report at a fixed rate whether or not anything changed,
+    //skip the remap and the pad_in lock unless there's something new to publish
+    const uint8_t profile_seq = gamepad->profile_seq();
+    gamepad->apply_pending_profile();
+    const bool skip =   bt_device.published &&
+                        bt_device.profile_seq == profile_seq &&
+                        !report_changed(*uni_gp, bt_device.uni_gp);
+#if defined(CONFIG_OGXM_DEBUG)
+    count_report(skip);
+#endif
+    if (skip) {
+        return;
+    }
+
+    bt_device.published = true;
+    bt_device.profile_seq = profile_seq;
+    bt_device.uni_gp = *uni_gp;
 
-    Gamepad* gamepad = bt_devices_[idx].gamepad;
     Gamepad::PadIn gp_in;
 
     switch (uni_gp->dpad) 
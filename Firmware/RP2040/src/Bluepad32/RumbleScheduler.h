@@ -0,0 +1,87 @@
+#ifndef _RUMBLE_SCHEDULER_H_
+#define _RUMBLE_SCHEDULER_H_
+
+#include <cstdint>
+
+/*  Decides when rumble is sent to a Bluetooth controller. A new value goes out as soon
+    as the controller's minimum interval allows, values arriving faster than that are
+    coalesced and only the latest is sent. Rumble plays for duration_ms per command, so
+    nonzero rumble is refreshed shortly before it runs out, zero is sent once.
+    Nothing here depends on btstack, times are in ms from any monotonic clock. */
+class RumbleScheduler
+{
+public:
+    struct Model
+    {
+        uint16_t min_interval_ms;   //Shortest time between two commands
+        uint16_t duration_ms;       //How long one command plays for
+    };
+
+    struct Command
+    {
+        uint8_t rumble_l{0};
+        uint8_t rumble_r{0};
+        uint16_t duration_ms{0};
+    };
+
+    //Sent this long before the previous command runs out
+    static constexpr uint16_t REFRESH_LEAD_MS = 30;
+
+    void reset(const Model& model)
+    {
+        model_ = model;
+        rumble_l_ = rumble_r_ = 0;
+        sent_l_ = sent_r_ = 0;
+        pending_ = false;
+        sent_once_ = false;
+    }
+
+    //Latest value from the console
+    void set(uint8_t rumble_l, uint8_t rumble_r)
+    {
+        rumble_l_ = rumble_l;
+        rumble_r_ = rumble_r;
+        pending_ = (rumble_l_ != sent_l_ || rumble_r_ != sent_r_);
+    }
+
+    //True if a command should be sent now, fills command and assumes it's sent
+    bool update(uint32_t now_ms, Command& command)
+    {
+        const uint32_t elapsed = now_ms - sent_ms_;
+        const bool sent_any = (sent_l_ || sent_r_);
+
+        if (pending_)
+        {
+            if (sent_once_ && elapsed < model_.min_interval_ms)
+            {
+                return false;
+            }
+        }
+        else if (!sent_any || elapsed + REFRESH_LEAD_MS < model_.duration_ms)
+        {
+            return false;
+        }
+
+        command.rumble_l = sent_l_ = rumble_l_;
+        command.rumble_r = sent_r_ = rumble_r_;
+        command.duration_ms = model_.duration_ms;
+        sent_ms_ = now_ms;
+        pending_ = false;
+        sent_once_ = true;
+        return true;
+    }
+
+    inline bool pending() const { return pending_; }
+
+private:
+    Model model_{0, 0};
+    uint8_t rumble_l_{0};
+    uint8_t rumble_r_{0};
+    uint8_t sent_l_{0};
+    uint8_t sent_r_{0};
+    uint32_t sent_ms_{0};
+    bool pending_{false};
+    bool sent_once_{false}; //A command has been sent since reset()
+};
+
+#endif // _RUMBLE_SCHEDULER_H_
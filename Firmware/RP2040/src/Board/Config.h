@@ -48,6 +48,7 @@
     #define I2C_SCL_PIN         11
     #define SLAVE_ADDR_PIN_1    20
     #define SLAVE_ADDR_PIN_2    21
+    #define I2C_BAUDRATE_FAST   1000 * 1000 // Short on-board traces, master tries Fast-mode Plus first
 
 #elif defined(CONFIG_OGXM_BOARD_EXTERNAL_4CH)
     #define OGXM_BOARD          EXTERNAL_4CH_I2C
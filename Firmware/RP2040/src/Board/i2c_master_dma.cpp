@@ -0,0 +1,205 @@
+#include "Board/Config.h"
+#if defined(CONFIG_EN_4CH)
+
+#include <atomic>
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+
+#include "Board/i2c_master_dma.h"
+
+namespace i2c_master_dma {
+
+static i2c_inst_t* i2c_ = nullptr;
+static int tx_chan_ = -1;
+static int rx_chan_ = -1;
+static dma_channel_config tx_cfg_;
+static dma_channel_config rx_cfg_;
+
+//Data and command words for IC_DATA_CMD, one per byte written or read
+static uint32_t cmds_[MAX_TRANSFER_LEN];
+
+static Transfer* batch_ = nullptr;
+static uint8_t batch_count_ = 0;
+static uint8_t batch_idx_ = 0;
+static uint32_t transfer_start_us_ = 0;
+static uint32_t abort_source_ = 0;
+static std::atomic<bool> busy_{false};
+
+static inline i2c_hw_t* hw() {
+    return i2c_get_hw(i2c_);
+}
+
+static void start_transfer(Transfer& transfer) {
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < transfer.write_len; ++i) {
+        cmds_[count++] = transfer.write[i];
+    }
+    for (uint8_t i = 0; i < transfer.read_len; ++i) {
+        cmds_[count] = I2C_IC_DATA_CMD_CMD_BITS;
+        if (i == 0 && transfer.write_len > 0) {
+            cmds_[count] |= I2C_IC_DATA_CMD_RESTART_BITS;
+        }
+        ++count;
+    }
+    cmds_[count - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    hw()->enable = 0;
+    hw()->tar = transfer.address;
+    hw()->enable = 1;
+
+    abort_source_ = 0;
+    transfer_start_us_ = time_us_32();
+
+    if (transfer.read_len > 0) {
+        dma_channel_configure(rx_chan_, &rx_cfg_, transfer.read, &hw()->data_cmd, transfer.read_len, true);
+    }
+    dma_channel_configure(tx_chan_, &tx_cfg_, &hw()->data_cmd, cmds_, count, true);
+}
+
+static void finish_transfer() {
+    Transfer& transfer = batch_[batch_idx_];
+
+    if (abort_source_ == 0 && transfer.read_len > 0) {
+        //The last byte can still be on its way out of the rx fifo after the stop
+        for (uint32_t spins = 0; dma_channel_is_busy(rx_chan_) && spins < 1000; ++spins) {
+            tight_loop_contents();
+        }
+    }
+    if (abort_source_ != 0 || dma_channel_is_busy(rx_chan_)) {
+        dma_channel_abort(rx_chan_);
+        while (hw()->rxflr) {
+            (void)hw()->data_cmd;
+        }
+    }
+
+    transfer.time_us = time_us_32() - transfer_start_us_;
+
+    if (abort_source_ == 0) {
+        transfer.result = Result::OK;
+    } else if (abort_source_ & I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS) {
+        transfer.result = Result::NACK;
+    } else {
+        transfer.result = Result::BUS_ERROR;
+    }
+
+    if (++batch_idx_ < batch_count_) {
+        start_transfer(batch_[batch_idx_]);
+    } else {
+        busy_.store(false);
+    }
+}
+
+static void __isr i2c_irq_handler() {
+    uint32_t status = hw()->intr_stat;
+
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        abort_source_ = hw()->tx_abrt_source;
+        (void)hw()->clr_tx_abrt;
+        //The controller flushed the tx fifo, don't let DMA refill it
+        dma_channel_abort(tx_chan_);
+    }
+    //The controller sends a stop after an abort too, so every transfer ends here
+    if (status & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw()->clr_stop_det;
+        if (busy_.load()) {
+            finish_transfer();
+        }
+    }
+}
+
+void init(i2c_inst_t* i2c, uint32_t baudrate) {
+    i2c_ = i2c;
+    i2c_init(i2c_, baudrate);
+
+    tx_chan_ = dma_claim_unused_channel(true);
+    rx_chan_ = dma_claim_unused_channel(true);
+
+    tx_cfg_ = dma_channel_get_default_config(tx_chan_);
+    channel_config_set_transfer_data_size(&tx_cfg_, DMA_SIZE_32);
+    channel_config_set_read_increment(&tx_cfg_, true);
+    channel_config_set_write_increment(&tx_cfg_, false);
+    channel_config_set_dreq(&tx_cfg_, i2c_get_dreq(i2c_, true));
+
+    rx_cfg_ = dma_channel_get_default_config(rx_chan_);
+    channel_config_set_transfer_data_size(&rx_cfg_, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx_cfg_, false);
+    channel_config_set_write_increment(&rx_cfg_, true);
+    channel_config_set_dreq(&rx_cfg_, i2c_get_dreq(i2c_, false));
+
+    hw()->dma_tdlr = 8;
+    hw()->dma_rdlr = 0;
+    hw()->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    hw()->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+    const uint irq_num = (i2c_hw_index(i2c_) == 0) ? I2C0_IRQ : I2C1_IRQ;
+    irq_set_exclusive_handler(irq_num, i2c_irq_handler);
+    irq_set_enabled(irq_num, true);
+}
+
+uint32_t set_baudrate(uint32_t baudrate) {
+    if (busy_.load()) {
+        return 0;
+    }
+    return i2c_set_baudrate(i2c_, baudrate);
+}
+
+bool start(Transfer* transfers, uint8_t count) {
+    if (busy_.load() || count == 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; ++i) {
+        const size_t len = transfers[i].write_len + transfers[i].read_len;
+        if (len == 0 || len > MAX_TRANSFER_LEN) {
+            return false;
+        }
+        transfers[i].result = Result::PENDING;
+        transfers[i].time_us = 0;
+    }
+
+    batch_ = transfers;
+    batch_count_ = count;
+    batch_idx_ = 0;
+    busy_.store(true);
+
+    start_transfer(batch_[0]);
+    return true;
+}
+
+bool busy() {
+    return busy_.load();
+}
+
+void abort() {
+    const uint irq_num = (i2c_hw_index(i2c_) == 0) ? I2C0_IRQ : I2C1_IRQ;
+    irq_set_enabled(irq_num, false);
+
+    if (busy_.load()) {
+        dma_channel_abort(tx_chan_);
+        dma_channel_abort(rx_chan_);
+
+        hw_set_bits(&hw()->enable, I2C_IC_ENABLE_ABORT_BITS);
+        for (uint32_t spins = 0; (hw()->enable & I2C_IC_ENABLE_ABORT_BITS) && spins < 10000; ++spins) {
+            tight_loop_contents();
+        }
+        hw()->enable = 0;
+        while (hw()->rxflr) {
+            (void)hw()->data_cmd;
+        }
+        (void)hw()->clr_intr;
+        hw()->enable = 1;
+
+        for (uint8_t i = batch_idx_; i < batch_count_; ++i) {
+            batch_[i].result = Result::TIMEOUT;
+        }
+        busy_.store(false);
+    }
+
+    irq_set_enabled(irq_num, true);
+}
+
+} // namespace i2c_master_dma
+
+#endif // defined(CONFIG_EN_4CH)
@@ -0,0 +1,50 @@
+#ifndef _OGXM_I2C_MASTER_DMA_H_
+#define _OGXM_I2C_MASTER_DMA_H_
+
+#include "Board/Config.h"
+#if defined(CONFIG_EN_4CH)
+
+#include <cstdint>
+#include <cstddef>
+#include <hardware/i2c.h>
+
+/*  I2C master transfers driven by DMA. A batch of transfers is started with one call,
+    each one is a write, a read, or a write followed by a read after a repeated start.
+    The I2C interrupt starts the next transfer as soon as one stops, so a poll of every
+    slave runs back to back on the bus while the CPU does other work. */
+namespace i2c_master_dma {
+    enum class Result : uint8_t {
+        PENDING = 0,
+        OK,
+        NACK,       //No slave at the address
+        BUS_ERROR,  //Data NACK, lost arbitration or any other abort
+        TIMEOUT     //Cut short by abort()
+    };
+
+    struct Transfer {
+        uint8_t         address{0};
+        const uint8_t*  write{nullptr};
+        uint8_t         write_len{0};
+        uint8_t*        read{nullptr};
+        uint8_t         read_len{0};
+        //Set once the transfer is done
+        Result          result{Result::PENDING};
+        uint32_t        time_us{0};
+    };
+
+    //Longest write_len + read_len of a transfer
+    static constexpr size_t MAX_TRANSFER_LEN = 48;
+
+    void init(i2c_inst_t* i2c, uint32_t baudrate);
+    //Call while idle, returns the actual baudrate
+    uint32_t set_baudrate(uint32_t baudrate);
+    //transfers must stay valid until busy() is false, fails if a batch is still running
+    bool start(Transfer* transfers, uint8_t count);
+    bool busy();
+    //Stops the running batch, transfers that didn't finish are set to TIMEOUT
+    void abort();
+} // namespace i2c_master_dma
+
+#endif // defined(CONFIG_EN_4CH)
+
+#endif // _OGXM_I2C_MASTER_DMA_H_
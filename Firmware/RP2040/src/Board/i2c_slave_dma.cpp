@@ -0,0 +1,194 @@
+#include "Board/Config.h"
+#if defined(CONFIG_EN_4CH)
+
+#include <cstring>
+#include <algorithm>
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+
+#include "Board/i2c_slave_dma.h"
+
+namespace i2c_slave_dma {
+
+static i2c_inst_t* i2c_ = nullptr;
+static WriteHandler handler_ = nullptr;
+static int tx_chan_ = -1;
+static int rx_chan_ = -1;
+static dma_channel_config tx_cfg_;
+static dma_channel_config rx_cfg_;
+
+//DMA writes to rx_buffers_[write_idx_], rx_buffers_[ready_idx_] waits for receive()
+static uint8_t rx_buffers_[2][MAX_PACKET_LEN];
+static uint8_t write_idx_ = 0;
+static uint8_t ready_idx_ = 1;
+static size_t ready_len_ = 0;
+static bool ready_ = false;
+static bool rx_overflow_ = false;
+
+static Response tx_response_;
+static Stats stats_;
+
+static inline i2c_hw_t* hw() {
+    return i2c_get_hw(i2c_);
+}
+
+static inline uint irq_num() {
+    return (i2c_hw_index(i2c_) == 0) ? I2C0_IRQ : I2C1_IRQ;
+}
+
+static void start_rx() {
+    dma_channel_configure(rx_chan_, &rx_cfg_, rx_buffers_[write_idx_], &hw()->data_cmd, MAX_PACKET_LEN, true);
+}
+
+static void finish_write() {
+    //Let DMA empty the fifo before counting
+    for (uint32_t spins = 0; hw()->rxflr && dma_channel_is_busy(rx_chan_) && spins < 1000; ++spins) {
+        tight_loop_contents();
+    }
+    if (hw()->rxflr) {
+        //More than a buffer's worth
+        rx_overflow_ = true;
+    }
+
+    const size_t len = MAX_PACKET_LEN - dma_channel_hw_addr(rx_chan_)->transfer_count;
+    if (len == 0 && !rx_overflow_) {
+        //End of a read
+        return;
+    }
+    dma_channel_abort(rx_chan_);
+
+    if (rx_overflow_) {
+        rx_overflow_ = false;
+        ++stats_.length_errors;
+        while (hw()->rxflr) {
+            (void)hw()->data_cmd;
+        }
+    } else {
+        if (const Response* response = handler_(rx_buffers_[write_idx_], len)) {
+            tx_response_ = *response;
+        }
+        if (ready_) {
+            ++stats_.overruns;
+        }
+        ready_idx_ = write_idx_;
+        ready_len_ = len;
+        ready_ = true;
+        write_idx_ ^= 1;
+        ++stats_.packets;
+    }
+    start_rx();
+}
+
+static void __isr i2c_irq_handler() {
+    uint32_t status = hw()->intr_stat;
+
+    if (status & I2C_IC_INTR_STAT_R_RX_OVER_BITS) {
+        (void)hw()->clr_rx_over;
+        rx_overflow_ = true;
+    }
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        //Master ended the read early, the controller flushed what was left
+        (void)hw()->clr_tx_abrt;
+        dma_channel_abort(tx_chan_);
+    }
+    if (status & (I2C_IC_INTR_STAT_R_RESTART_DET_BITS | I2C_IC_INTR_STAT_R_STOP_DET_BITS)) {
+        (void)hw()->clr_restart_det;
+        (void)hw()->clr_stop_det;
+        finish_write();
+    }
+    if (status & I2C_IC_INTR_STAT_R_RD_REQ_BITS) {
+        (void)hw()->clr_rd_req;
+        if (tx_response_.len > 0 && !dma_channel_is_busy(tx_chan_)) {
+            dma_channel_configure(tx_chan_, &tx_cfg_, &hw()->data_cmd, tx_response_.words, tx_response_.len, true);
+        } else {
+            //Nothing to say, don't leave the master stretched
+            hw()->data_cmd = 0;
+        }
+        ++stats_.reads;
+    }
+}
+
+void init(i2c_inst_t* i2c, uint8_t address, uint32_t baudrate, WriteHandler handler) {
+    i2c_ = i2c;
+    handler_ = handler;
+
+    i2c_init(i2c_, baudrate);
+    i2c_set_slave_mode(i2c_, true, address);
+    //Other slaves share the bus, only stop for our own transfers
+    hw_set_bits(&hw()->con, I2C_IC_CON_STOP_DET_IFADDRESSED_BITS);
+
+    tx_chan_ = dma_claim_unused_channel(true);
+    rx_chan_ = dma_claim_unused_channel(true);
+
+    tx_cfg_ = dma_channel_get_default_config(tx_chan_);
+    channel_config_set_transfer_data_size(&tx_cfg_, DMA_SIZE_32);
+    channel_config_set_read_increment(&tx_cfg_, true);
+    channel_config_set_write_increment(&tx_cfg_, false);
+    channel_config_set_dreq(&tx_cfg_, i2c_get_dreq(i2c_, true));
+
+    rx_cfg_ = dma_channel_get_default_config(rx_chan_);
+    channel_config_set_transfer_data_size(&rx_cfg_, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx_cfg_, false);
+    channel_config_set_write_increment(&rx_cfg_, true);
+    channel_config_set_dreq(&rx_cfg_, i2c_get_dreq(i2c_, false));
+
+    hw()->dma_tdlr = 4;
+    hw()->dma_rdlr = 0;
+    hw()->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    hw()->intr_mask =   I2C_IC_INTR_MASK_M_RX_OVER_BITS |
+                        I2C_IC_INTR_MASK_M_TX_ABRT_BITS |
+                        I2C_IC_INTR_MASK_M_RESTART_DET_BITS |
+                        I2C_IC_INTR_MASK_M_STOP_DET_BITS |
+                        I2C_IC_INTR_MASK_M_RD_REQ_BITS;
+
+    start_rx();
+
+    irq_set_exclusive_handler(irq_num(), i2c_irq_handler);
+    irq_set_enabled(irq_num(), true);
+}
+
+void set_response(Response& response, const void* data, size_t len) {
+    len = std::min(len, MAX_RESPONSE_LEN);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    for (size_t i = 0; i < len; ++i) {
+        response.words[i] = bytes[i];
+    }
+    response.len = static_cast<uint8_t>(len);
+    restore_interrupts(irq_state);
+}
+
+bool receive(uint8_t* data, size_t& len) {
+    //The interrupt can't swap buffers while this runs, DMA keeps writing to the other one
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (!ready_) {
+        restore_interrupts(irq_state);
+        return false;
+    }
+    std::memcpy(data, rx_buffers_[ready_idx_], ready_len_);
+    len = ready_len_;
+    ready_ = false;
+    restore_interrupts(irq_state);
+    return true;
+}
+
+void count_length_error() {
+    uint32_t irq_state = save_and_disable_interrupts();
+    ++stats_.length_errors;
+    restore_interrupts(irq_state);
+}
+
+Stats stats() {
+    uint32_t irq_state = save_and_disable_interrupts();
+    Stats stats = stats_;
+    restore_interrupts(irq_state);
+    return stats;
+}
+
+} // namespace i2c_slave_dma
+
+#endif // defined(CONFIG_EN_4CH)
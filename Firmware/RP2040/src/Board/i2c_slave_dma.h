@@ -0,0 +1,47 @@
+#ifndef _OGXM_I2C_SLAVE_DMA_H_
+#define _OGXM_I2C_SLAVE_DMA_H_
+
+#include "Board/Config.h"
+#if defined(CONFIG_EN_4CH)
+
+#include <cstdint>
+#include <cstddef>
+#include <hardware/i2c.h>
+
+/*  I2C slave driven by DMA. Writes from the master land in one of two buffers, when the
+    master stops or restarts the buffers are swapped and the packet is left for the main
+    loop to pick up with receive(), only the newest one is kept. The interrupt handler
+    doesn't touch the data beyond asking the WriteHandler which preloaded Response to
+    send if the master reads next, which then goes out by DMA as well. */
+namespace i2c_slave_dma {
+    static constexpr size_t MAX_PACKET_LEN = 40; //Room for an I2CLink key frame
+    static constexpr size_t MAX_RESPONSE_LEN = 32;
+
+    struct Response {
+        uint8_t  len{0};
+        uint32_t words[MAX_RESPONSE_LEN]{0}; //One IC_DATA_CMD write per byte
+    };
+
+    struct Stats {
+        uint32_t packets{0};
+        uint32_t overruns{0};       //Packets replaced before receive() got to them
+        uint32_t length_errors{0};  //Longer than MAX_PACKET_LEN or rejected by the caller
+        uint32_t reads{0};
+    };
+
+    //Called from the I2C interrupt at the end of each write, returns the response for
+    //the read that follows or nullptr to keep the previous one. Keep it short.
+    using WriteHandler = const Response* (*)(const uint8_t* data, size_t len);
+
+    void init(i2c_inst_t* i2c, uint8_t address, uint32_t baudrate, WriteHandler handler);
+    //Fills a response while the interrupt can't read it
+    void set_response(Response& response, const void* data, size_t len);
+    //Copies out the newest packet (MAX_PACKET_LEN bytes of room), false if there's none
+    bool receive(uint8_t* data, size_t& len);
+    void count_length_error();
+    Stats stats();
+} // namespace i2c_slave_dma
+
+#endif // defined(CONFIG_EN_4CH)
+
+#endif // _OGXM_I2C_SLAVE_DMA_H_
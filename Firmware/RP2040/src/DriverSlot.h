@@ -0,0 +1,58 @@
+#ifndef _DRIVER_SLOT_H_
+#define _DRIVER_SLOT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Holds one driver of any of the listed types in storage reserved up front, so
+// mounting or switching drivers never touches the heap. Sized and aligned for
+// the largest of them, emplacing a type that isn't listed doesn't compile.
+template <typename Base, typename... Drivers> class DriverSlot {
+public:
+  static constexpr size_t SIZE = std::max({sizeof(Drivers)...});
+  static constexpr size_t ALIGN = std::max({alignof(Drivers)...});
+
+  static_assert(sizeof...(Drivers) > 0, "DriverSlot needs a driver type");
+  static_assert(std::has_virtual_destructor_v<Base>,
+                "DriverSlot destroys drivers through Base");
+  static_assert((std::is_base_of_v<Base, Drivers> && ...),
+                "DriverSlot drivers must derive from Base");
+
+  DriverSlot() = default;
+  ~DriverSlot() { reset(); }
+
+  DriverSlot(const DriverSlot &) = delete;
+  DriverSlot &operator=(const DriverSlot &) = delete;
+
+  // Destroys the current driver, if any, and constructs a T in its place
+  template <typename T, typename... Args> T *emplace(Args &&...args) {
+    static_assert((std::is_same_v<T, Drivers> || ...),
+                  "Driver type isn't in this DriverSlot");
+    static_assert(sizeof(T) <= SIZE && alignof(T) <= ALIGN,
+                  "Driver doesn't fit DriverSlot storage");
+    reset();
+    T *driver = new (storage_) T(std::forward<Args>(args)...);
+    driver_ = driver;
+    return driver;
+  }
+
+  void reset() {
+    if (driver_) {
+      driver_->~Base();
+      driver_ = nullptr;
+    }
+  }
+
+  Base *get() const { return driver_; }
+  Base *operator->() const { return driver_; }
+  explicit operator bool() const { return driver_ != nullptr; }
+
+private:
+  alignas(ALIGN) unsigned char storage_[SIZE];
+  Base *driver_{nullptr};
+};
+
+#endif // _DRIVER_SLOT_H_
@@ -0,0 +1,45 @@
+#ifndef _I2C_LINK_PAD_H_
+#define _I2C_LINK_PAD_H_
+
+#include <cstring>
+
+#include "I2CLink/I2CLink.h"
+#include "Gamepad/Gamepad.h"
+
+//Conversions between Gamepad input and the I2CLink PadState the board links carry
+namespace I2CLink {
+
+    static inline PadState to_pad_state(const Gamepad::PadIn& pad_in, const Gamepad::ChatpadIn& chatpad_in) {
+        PadState state;
+        state.dpad = pad_in.dpad;
+        state.buttons = pad_in.buttons;
+        state.trigger_l = pad_in.trigger_l;
+        state.trigger_r = pad_in.trigger_r;
+        state.joystick_lx = pad_in.joystick_lx;
+        state.joystick_ly = pad_in.joystick_ly;
+        state.joystick_rx = pad_in.joystick_rx;
+        state.joystick_ry = pad_in.joystick_ry;
+        std::memcpy(state.analog.data(), pad_in.analog, state.analog.size());
+        state.accel_x = pad_in.accel_x;
+        state.chatpad = chatpad_in;
+        return state;
+    }
+
+    static inline Gamepad::PadIn to_pad_in(const PadState& state) {
+        Gamepad::PadIn pad_in;
+        pad_in.dpad = state.dpad;
+        pad_in.buttons = state.buttons;
+        pad_in.trigger_l = state.trigger_l;
+        pad_in.trigger_r = state.trigger_r;
+        pad_in.joystick_lx = state.joystick_lx;
+        pad_in.joystick_ly = state.joystick_ly;
+        pad_in.joystick_rx = state.joystick_rx;
+        pad_in.joystick_ry = state.joystick_ry;
+        std::memcpy(pad_in.analog, state.analog.data(), state.analog.size());
+        pad_in.accel_x = state.accel_x;
+        return pad_in;
+    }
+
+} // namespace I2CLink
+
+#endif // _I2C_LINK_PAD_H_
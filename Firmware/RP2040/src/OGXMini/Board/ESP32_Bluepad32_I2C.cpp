@@ -3,6 +3,7 @@
 #if (OGXM_BOARD == ESP32_BLUEPAD32_I2C)
 
 #include <cstring>
+#include <algorithm>
 #include <pico/multicore.h>
 #include <pico/i2c_slave.h>
 #include <hardware/gpio.h>
@@ -16,13 +17,17 @@
 #include "Board/board_api.h"
 #include "Board/esp32_api.h"
 #include "Gamepad/Gamepad.h"
+#include "Gamepad/I2CLinkPad.h"
 #include "TaskQueue/TaskQueue.h"
 
 enum class PacketID : uint8_t { 
     UNKNOWN = 0, 
     SET_PAD, 
     GET_PAD, 
-    SET_DRIVER 
+    SET_DRIVER,
+    GET_CAPS,       //Answered with our I2CLink::Caps in PacketOut
+    SET_PAD_DELTA,  //I2CLink frame
+    SET_PADS        //I2CLink multi frame, answered with I2CLink::MultiReply
 };
 
 #pragma pack(push, 1)
@@ -32,7 +37,7 @@ struct PacketIn {
     uint8_t             index{0};
     DeviceDriverType    device_type{DeviceDriverType::NONE};
     Gamepad::PadIn      pad_in{Gamepad::PadIn()};
-    uint8_t             reserved[5]{0};
+    uint8_t             reserved[3]{0};
 };
 static_assert(sizeof(PacketIn) == 32, "i2c_driver_esp::PacketIn size mismatch");
 
@@ -41,28 +46,32 @@ struct PacketOut {
     PacketID        packet_id{PacketID::GET_PAD};
     uint8_t         index{0};
     Gamepad::PadOut pad_out{Gamepad::PadOut()};
-    uint8_t         reserved[3]{0};
+    uint8_t         flags{0}; //I2CLink::FLAG_*
+    I2CLink::Caps   caps{I2CLink::Caps()};
 };
 static_assert(sizeof(PacketOut) == 8, "i2c_driver_esp::PacketOut size mismatch");
 #pragma pack(pop)
 
-constexpr size_t  MAX_BUFFER_SIZE = std::max(sizeof(PacketOut), sizeof(PacketIn));
+constexpr size_t  MAX_BUFFER_SIZE = std::max({ sizeof(PacketOut), sizeof(PacketIn), I2CLink::MAX_MULTI_LEN });
 constexpr uint8_t I2C_ADDR = 0x01;
 
 static Gamepad _gamepads[MAX_GAMEPADS];
 static bool _uart_bridge_mode = false;
 
+static I2CLink::Decoder _decoders[MAX_GAMEPADS];
+static I2CLink::PadState _pad_states[MAX_GAMEPADS];
+
 static inline void slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
     static size_t count = 0;
-    static PacketIn packet_in;
-    static PacketOut packet_out;
-    static DeviceDriverType current_device_type = 
-        UserSettings::get_instance().get_current_driver();
+    static uint8_t buffer_in[MAX_BUFFER_SIZE];
+    //Header of the last write, the read that follows answers it
+    static PacketID packet_id = PacketID::UNKNOWN;
+    static uint8_t index = 0;
 
     switch (event) {
         case I2C_SLAVE_RECEIVE:
-            if (count < sizeof(PacketIn)) {
-                reinterpret_cast<uint8_t*>(&packet_in)[count] = i2c_read_byte_raw(i2c);
+            if (count < sizeof(buffer_in)) {
+                buffer_in[count] = i2c_read_byte_raw(i2c);
                 ++count;
             }
             break;
@@ -70,45 +79,99 @@ static inline void slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
             if (count == 0) {
                 break;
             }
-            switch (packet_in.packet_id) {
+            packet_id = static_cast<PacketID>(buffer_in[1]);
+            index = buffer_in[2];
+
+            switch (packet_id) {
                 case PacketID::SET_PAD:
-                    if (packet_in.index < MAX_GAMEPADS) {
-                        _gamepads[packet_in.index].set_pad_in(packet_in.pad_in);
+                    if (index < MAX_GAMEPADS) {
+                        _gamepads[index].set_pad_in(reinterpret_cast<const PacketIn*>(buffer_in)->pad_in);
+                    }
+                    break;
+                case PacketID::SET_PAD_DELTA:
+                    if (index < MAX_GAMEPADS) {
+                        I2CLink::Decoder::Result result = _decoders[index].decode(buffer_in, count, _pad_states[index]);
+                        if (result == I2CLink::Decoder::Result::OK || result == I2CLink::Decoder::Result::GAP) {
+                            _gamepads[index].set_pad_in(I2CLink::to_pad_in(_pad_states[index]));
+                        }
+                    }
+                    break;
+                case PacketID::SET_PADS:
+                    I2CLink::split_multi(buffer_in, count, [](uint8_t i, const uint8_t* frame, size_t len) {
+                        if (i < MAX_GAMEPADS) {
+                            I2CLink::Decoder::Result result = _decoders[i].decode(frame, len, _pad_states[i]);
+                            if (result == I2CLink::Decoder::Result::OK || result == I2CLink::Decoder::Result::GAP) {
+                                _gamepads[i].set_pad_in(I2CLink::to_pad_in(_pad_states[i]));
+                            }
+                        }
+                    });
+                    break;
+                case PacketID::GET_CAPS:
+                    //ESP32 is starting over, its next frames are key frames
+                    for (auto& decoder : _decoders) {
+                        decoder.reset();
                     }
                     break;
-                case PacketID::SET_DRIVER:
-                    if (packet_in.device_type != DeviceDriverType::NONE &&
-                        packet_in.device_type != current_device_type) {
+                case PacketID::SET_DRIVER: {
+                    const DeviceDriverType device_type = reinterpret_cast<const PacketIn*>(buffer_in)->device_type;
+                    if (device_type != DeviceDriverType::NONE &&
+                        device_type != DeviceManager::get_instance().get_driver_type()) {
                         OGXM_LOG("I2C: Driver change detected.\n");
                         //Any writes to flash should be done on Core0
                         TaskQueue::Core0::queue_delayed_task(
                             TaskQueue::Core0::get_new_task_id(), 1000, false, 
-                            [new_device_type = packet_in.device_type] { 
-                                UserSettings::get_instance().store_driver_type(new_device_type);
+                            [new_device_type = device_type] { 
+                                if (UserSettings::get_instance().store_driver_type(new_device_type)) {
+                                    DeviceManager::get_instance().switch_driver(new_device_type, _gamepads);
+                                }
                             }
                         );
                     }
                     break;
+                }
                 default:
                     break;
             }
             count = 0;
             break;
-        case I2C_SLAVE_REQUEST:
-            if (packet_in.index < MAX_GAMEPADS) {
-                packet_out.index = packet_in.index;
-                packet_out.pad_out = _gamepads[packet_in.index].get_pad_out();
+        case I2C_SLAVE_REQUEST: {
+            if (packet_id == PacketID::SET_PADS) {
+                I2CLink::MultiReply reply;
+                reply.packet_id = static_cast<uint8_t>(PacketID::SET_PADS);
+                for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
+                    const Gamepad::PadOut pad_out = _gamepads[i].get_pad_out();
+                    reply.rumble[i].rumble_l = pad_out.rumble_l;
+                    reply.rumble[i].rumble_r = pad_out.rumble_r;
+                    reply.need_key |= _decoders[i].need_key() ? (1U << i) : 0;
+                }
+                i2c_write_raw_blocking( i2c, 
+                                        reinterpret_cast<const uint8_t*>(&reply), 
+                                        reply.packet_len);
+                break;
+            }
+            PacketOut packet_out;
+            if (packet_id == PacketID::GET_CAPS) {
+                packet_out.packet_id = PacketID::GET_CAPS;
+                packet_out.caps.caps = I2CLink::CAP_DELTA | I2CLink::CAP_MULTI;
+            } else if (index < MAX_GAMEPADS) {
+                packet_out.index = index;
+                packet_out.pad_out = _gamepads[index].get_pad_out();
+                packet_out.flags = _decoders[index].need_key() ? I2CLink::FLAG_NEED_KEY : 0;
             }
             i2c_write_raw_blocking( i2c, 
                                     reinterpret_cast<const uint8_t*>(&packet_out), 
                                     packet_out.packet_len);
             break;
+        }
         default:
             break;
     }
 }
 
 static void core1_task() {
+    //Keep running while core0 writes flash
+    multicore_lockout_victim_init();
+
     i2c_init(I2C_PORT, I2C_BAUDRATE);
 
     gpio_init(I2C_SDA_PIN);
@@ -178,7 +241,8 @@ void esp32_bp32_i2c::run() {
 
     esp32_api::reset();
 
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    //Driver can be replaced at runtime, don't cache it
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
     tud_init(BOARD_TUD_RHPORT);
 
@@ -186,7 +250,7 @@ void esp32_bp32_i2c::run() {
         TaskQueue::Core0::process_tasks();
 
         for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
-            device_driver->process(i, _gamepads[i]);
+            device_manager.process(i, _gamepads[i]);
             tud_task();
         }
         sleep_ms(1);
@@ -41,6 +41,9 @@ static Gamepad _gamepads[MAX_GAMEPADS];
 static bool _uart_bridge_mode = false;
 
 static void core1_task() {
+    //Keep running while core0 writes flash
+    multicore_lockout_victim_init();
+
     i2c_init(I2C_PORT, I2C_BAUDRATE);
 
     gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);
@@ -112,18 +115,16 @@ static void core1_task() {
     }
 }
 
-void set_gp_check_timer(uint32_t task_id) {
+//Check gamepad inputs for button combo to change usb device driver
+void check_driver_combo() {
     UserSettings& user_settings = UserSettings::get_instance();
-    
-    TaskQueue::Core0::queue_delayed_task(task_id, UserSettings::GP_CHECK_DELAY_MS, true, 
-    [&user_settings] {
-        //Check gamepad inputs for button combo to change usb device driver
-        if (user_settings.check_for_driver_change(_gamepads[0])) {
-            OGXM_LOG("Driver change detected, storing new driver.\n");
-            //This will store the new mode and reboot the pico
-            user_settings.store_driver_type(user_settings.get_current_driver());
+    if (user_settings.check_for_driver_change(_gamepads[0])) {
+        OGXM_LOG("Driver change detected, storing new driver.\n");
+        //Store the new mode and re-enumerate as the new device, core1 keeps running
+        if (user_settings.store_driver_type(user_settings.get_current_driver())) {
+            DeviceManager::get_instance().switch_driver(user_settings.get_current_driver(), _gamepads);
         }
-    });
+    }
 }
 
 void run_uart_bridge() {
@@ -177,16 +178,15 @@ void esp32_br_i2c::run() {
     multicore_reset_core1();
     multicore_launch_core1(core1_task);
 
-    uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
-    set_gp_check_timer(tid_gp_check);
-
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    //Driver can be replaced at runtime, don't cache it
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
     tud_init(BOARD_TUD_RHPORT);
 
     while (true) {
         TaskQueue::Core0::process_tasks();
-        device_driver->process(0, _gamepads[0]);
+        check_driver_combo();
+        device_manager.process(0, _gamepads[0]);
         tud_task();
         sleep_ms(1);
     }
@@ -3,11 +3,12 @@
 #if ((OGXM_BOARD == INTERNAL_4CH_I2C) || (OGXM_BOARD == EXTERNAL_4CH_I2C))
 
 #include <atomic>
+#include <array>
+#include <algorithm>
 #include <cstring>
 #include <pico/multicore.h>
 #include <hardware/gpio.h>
 #include <hardware/i2c.h>
-#include <pico/i2c_slave.h>
 
 #include "tusb.h"
 #include "bsp/board_api.h"
@@ -17,8 +18,11 @@
 #include "USBHost/HostManager.h"
 #include "Board/board_api.h"
 #include "Board/ogxm_log.h"
+#include "Board/i2c_master_dma.h"
+#include "Board/i2c_slave_dma.h"
 #include "UserSettings/UserSettings.h"
 #include "Gamepad/Gamepad.h"
+#include "Gamepad/I2CLinkPad.h"
 #include "TaskQueue/TaskQueue.h"
 
 constexpr uint32_t FEEDBACK_DELAY_MS = 250;
@@ -33,12 +37,14 @@ namespace I2C {
     enum class PacketID : uint8_t { 
         UNKNOWN = 0, 
         PAD, 
-        COMMAND 
+        COMMAND,
+        PAD_DELTA   //I2CLink frame, sent once the slave's CAPS say it can take them
     };
     enum class Command : uint8_t { 
         UNKNOWN = 0, 
         STATUS, 
-        DISABLE 
+        DISABLE,
+        CAPS
     };
     enum class Status : uint8_t { 
         UNKNOWN = 0, 
@@ -55,7 +61,7 @@ namespace I2C {
         PacketID            packet_id{PacketID::PAD};
         Gamepad::PadIn      pad_in{Gamepad::PadIn()};
         Gamepad::ChatpadIn  chatpad_in{0};
-        uint8_t             reserved[4]{0};
+        uint8_t             reserved[2]{0};
     };
     static_assert(sizeof(PacketIn) == 32, "I2CDriver::PacketIn is misaligned");
 
@@ -63,7 +69,8 @@ namespace I2C {
         uint8_t         packet_len{sizeof(PacketOut)};
         PacketID        packet_id{PacketID::PAD};
         Gamepad::PadOut pad_out{Gamepad::PadOut()};
-        uint8_t         reserved[4]{0};
+        uint8_t         flags{0}; //I2CLink::FLAG_*
+        uint8_t         reserved[3]{0};
     };
     static_assert(sizeof(PacketOut) == 8, "I2CDriver::PacketOut is misaligned");
 
@@ -72,17 +79,45 @@ namespace I2C {
         PacketID    packet_id{PacketID::COMMAND};
         Command     command{Command::UNKNOWN};
         Status      status{Status::UNKNOWN};
-        uint8_t     reserved[4]{0};
+        I2CLink::Caps caps{I2CLink::Caps()};
+        uint8_t     reserved[2]{0};
     };
     static_assert(sizeof(PacketCMD) == 8, "I2CDriver::PacketCMD is misaligned");
     #pragma pack(pop)
 
-    constexpr size_t MAX_PACKET_SIZE = sizeof(PacketIn);
+    constexpr size_t MAX_PACKET_SIZE = std::max(sizeof(PacketIn), I2CLink::MAX_FRAME_LEN);
+    static_assert(MAX_PACKET_SIZE <= i2c_slave_dma::MAX_PACKET_LEN, "I2C slave can't receive MAX_PACKET_SIZE");
+    static_assert(MAX_PACKET_SIZE + sizeof(PacketOut) <= i2c_master_dma::MAX_TRANSFER_LEN, "I2C master can't send MAX_PACKET_SIZE");
 
     static Role _i2c_role = Role::SLAVE;
 
     namespace Slave {
-        static inline PacketID get_packet_id(uint8_t* buffer_in) {
+        using Response = i2c_slave_dma::Response;
+
+        //Preloaded replies, picked by write_handler() for the read that follows each write
+        static Response _pad_response;
+        static Response _status_ready;
+        static Response _status_not_ready;
+        static Response _disable_ok;
+        static Response _caps_response;
+
+        //Whether our own controller is mounted, kept up to date by process()
+        static std::atomic<bool> _host_mounted{false};
+        //Commands are latched so a newer PacketIn can't replace them before process() runs
+        static std::atomic<bool> _status_pending{false};
+        static std::atomic<bool> _disable_pending{false};
+        static std::atomic<bool> _caps_pending{false};
+        static bool _enabled = false;
+
+        static I2CLink::Decoder _decoder;
+        static I2CLink::PadState _pad_state;
+        //Whether _pad_response asks for a key frame
+        static bool _need_key = false;
+
+        static inline PacketID get_packet_id(const uint8_t* buffer_in, size_t len) {
+            if (len < 2 || buffer_in[0] != len) {
+                return PacketID::UNKNOWN;
+            }
             switch (static_cast<PacketID>(buffer_in[1])) {
                 case PacketID::PAD:
                     if (buffer_in[0] == sizeof(PacketIn)) {
@@ -94,174 +129,389 @@ namespace I2C {
                         return PacketID::COMMAND;
                     }
                     break;
+                case PacketID::PAD_DELTA:
+                    //Length is checked against the fields by the decoder
+                    if (len >= I2CLink::MIN_FRAME_LEN && len <= I2CLink::MAX_FRAME_LEN) {
+                        return PacketID::PAD_DELTA;
+                    }
+                    break;
                 default:
                     break;
             }
             return PacketID::UNKNOWN;
         }
 
-        static void slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
-            static size_t count = 0;
-            static bool enabled = false;
-            static uint8_t buffer_in[MAX_PACKET_SIZE];
-            static uint8_t buffer_out[MAX_PACKET_SIZE];
-
-            PacketIn  *packet_in_p = reinterpret_cast<PacketIn*>(buffer_in);
-            PacketOut *packet_out_p = reinterpret_cast<PacketOut*>(buffer_out);
-            PacketCMD *packet_cmd_in_p = reinterpret_cast<PacketCMD*>(buffer_in);
-            PacketCMD *packet_cmd_out_p = reinterpret_cast<PacketCMD*>(buffer_out);
-
-            switch (event) {
-                case I2C_SLAVE_RECEIVE: // master has written
-                    if (count < MAX_PACKET_SIZE) {
-                        buffer_in[count] = i2c_read_byte_raw(i2c);
-                        ++count;
-                    }
-                    break;
+        static void set_command_response(Response& response, Command command, Status status) {
+            PacketCMD packet_cmd;
+            packet_cmd.command = command;
+            packet_cmd.status = status;
+            i2c_slave_dma::set_response(response, &packet_cmd, sizeof(PacketCMD));
+        }
 
-                case I2C_SLAVE_FINISH:
-                    // Each master write has an ID indicating the type of data to send back on the next read request
-                    // Every write has an associated read
-                    switch (get_packet_id(buffer_in)) {
-                        case PacketID::PAD:
-                            // instance_->packet_in_ = *packet_in_p;
-                            // *packet_out_p = instance_->packet_out_;
-                            // instance_->new_pad_in_.store(true);
-                            _gamepads[0].set_pad_in(packet_in_p->pad_in);
-                            if (_gamepads[0].new_pad_out()) {
-                                packet_out_p->pad_out = _gamepads[0].get_pad_out();
-                            }
-                            break;
+        // Each master write has an ID indicating the type of data to send back on the next read request
+        // Every write has an associated read. Runs in the I2C interrupt, everything else waits for process()
+        static const Response* write_handler(const uint8_t* data, size_t len) {
+            const bool host_mounted = _host_mounted.load(std::memory_order_relaxed);
 
-                        case PacketID::COMMAND:
-                            switch (packet_cmd_in_p->command) {
-                                case Command::DISABLE:
-                                    packet_cmd_out_p->packet_len = sizeof(PacketCMD);
-                                    packet_cmd_out_p->packet_id = PacketID::COMMAND;
-                                    packet_cmd_out_p->command = Command::DISABLE;
-                                    packet_cmd_out_p->status = Status::OK;
-
-                                    if (!tuh_mounted(BOARD_TUH_RHPORT)) {
-                                        four_ch_i2c::host_mounted(false);
-                                    }
-                                    break;
-
-                                case Command::STATUS:
-                                    packet_cmd_out_p->packet_len = sizeof(PacketCMD);
-                                    packet_cmd_out_p->packet_id = PacketID::COMMAND;
-                                    packet_cmd_out_p->command = Command::STATUS;
-                                    packet_cmd_out_p->status = 
-                                        tuh_mounted(BOARD_TUH_RHPORT) ? Status::NOT_READY : Status::READY;
-
-                                    if (!tuh_mounted(BOARD_TUH_RHPORT) && !enabled) {
-                                        enabled = true;
-                                        four_ch_i2c::host_mounted(true);
-                                    }
-                                    break;
-
-                                default:
-                                    break;
-                            }
+            switch (get_packet_id(data, len)) {
+                case PacketID::PAD:
+                case PacketID::PAD_DELTA:
+                    //Our own controller is in use, tell the master instead of taking its input
+                    return host_mounted ? &_status_not_ready : &_pad_response;
+
+                case PacketID::COMMAND:
+                    switch (reinterpret_cast<const PacketCMD*>(data)->command) {
+                        case Command::DISABLE:
+                            _disable_pending.store(true);
+                            return &_disable_ok;
+                        case Command::STATUS:
+                            _status_pending.store(true);
+                            return host_mounted ? &_status_not_ready : &_status_ready;
+                        case Command::CAPS:
+                            //Master is starting over, its next frame is a key frame
+                            _caps_pending.store(true);
+                            return &_caps_response;
+                        default:
                             break;
                     }
-                    count = 0;
-                    std::memset(buffer_in, 0, sizeof(buffer_in));
-                    break;
-
-                case I2C_SLAVE_REQUEST:
-                    i2c_write_raw_blocking(i2c, buffer_out, buffer_out[0]);
                     break;
 
                 default:
                     break;
             }
+            return nullptr;
+        }
+
+        static void process() {
+            const bool host_mounted = tuh_mounted(BOARD_TUH_RHPORT);
+            _host_mounted.store(host_mounted, std::memory_order_relaxed);
+
+            //Before receive(), a frame sent after the CAPS reply must not be reset away
+            if (_caps_pending.exchange(false)) {
+                _decoder.reset();
+            }
+
+            uint8_t buffer_in[i2c_slave_dma::MAX_PACKET_LEN];
+            size_t len = 0;
+            if (i2c_slave_dma::receive(buffer_in, len)) {
+                switch (get_packet_id(buffer_in, len)) {
+                    case PacketID::PAD:
+                        if (!host_mounted) {
+                            _gamepads[0].set_pad_in(reinterpret_cast<const PacketIn*>(buffer_in)->pad_in);
+                        }
+                        break;
+                    case PacketID::PAD_DELTA: {
+                        //Decoded even while our own controller is in use to stay in step with the master
+                        I2CLink::Decoder::Result result = _decoder.decode(buffer_in, len, _pad_state);
+                        if (!host_mounted && 
+                            (result == I2CLink::Decoder::Result::OK || result == I2CLink::Decoder::Result::GAP)) {
+                            _gamepads[0].set_pad_in(I2CLink::to_pad_in(_pad_state));
+                        }
+                        break;
+                    }
+                    case PacketID::COMMAND:
+                        break;
+                    default:
+                        i2c_slave_dma::count_length_error();
+                        break;
+                }
+            }
+
+            const bool need_key = _decoder.need_key();
+            if (_gamepads[0].new_pad_out() || need_key != _need_key) {
+                _need_key = need_key;
+                PacketOut packet_out;
+                packet_out.pad_out = _gamepads[0].get_pad_out();
+                packet_out.flags = need_key ? I2CLink::FLAG_NEED_KEY : 0;
+                i2c_slave_dma::set_response(_pad_response, &packet_out, sizeof(PacketOut));
+            }
+
+            if (_status_pending.exchange(false) && !host_mounted && !_enabled) {
+                _enabled = true;
+                four_ch_i2c::host_mounted(true);
+            }
+            if (_disable_pending.exchange(false) && !host_mounted) {
+                //Master lost this pad, stay enumerated with neutral input
+                _enabled = false;
+                _gamepads[0].reset_pad_in();
+                four_ch_i2c::host_mounted(false);
+            }
+
+#if defined(CONFIG_OGXM_DEBUG)
+            static uint32_t last_ms = 0;
+            uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+            if (now_ms - last_ms >= 5000) {
+                last_ms = now_ms;
+                i2c_slave_dma::Stats stats = i2c_slave_dma::stats();
+                OGXM_LOG("I2C slave: packets %u, reads %u, overruns %u, length errors %u\n", 
+                    static_cast<unsigned>(stats.packets), static_cast<unsigned>(stats.reads), 
+                    static_cast<unsigned>(stats.overruns), static_cast<unsigned>(stats.length_errors));
+
+                const I2CLink::Decoder::Stats& link_stats = _decoder.stats();
+                OGXM_LOG("I2C slave: frames %u, keys %u, gaps %u, length errors %u, crc errors %u\n", 
+                    static_cast<unsigned>(link_stats.frames), static_cast<unsigned>(link_stats.keys), 
+                    static_cast<unsigned>(link_stats.gaps), static_cast<unsigned>(link_stats.length_errors), 
+                    static_cast<unsigned>(link_stats.crc_errors));
+            }
+#endif
+        }
+
+        static void init(uint8_t address) {
+            PacketOut packet_out;
+            i2c_slave_dma::set_response(_pad_response, &packet_out, sizeof(PacketOut));
+            set_command_response(_status_ready, Command::STATUS, Status::READY);
+            set_command_response(_status_not_ready, Command::STATUS, Status::NOT_READY);
+            set_command_response(_disable_ok, Command::DISABLE, Status::OK);
+            set_command_response(_caps_response, Command::CAPS, Status::OK);
+#if defined(I2C_BAUDRATE_FAST)
+            i2c_slave_dma::init(I2C_PORT, address, I2C_BAUDRATE_FAST, write_handler);
+#else
+            i2c_slave_dma::init(I2C_PORT, address, I2C_BAUDRATE, write_handler);
+#endif
         }
     } // namespace Slave
 
     namespace Master {
+        struct Stats {
+            uint32_t transfers{0};
+            uint32_t nacks{0};
+            uint32_t errors{0};     //Bus errors and timeouts
+            uint32_t last_us{0};    //Duration of the last transfer
+            uint32_t max_us{0};
+        };
+
         struct Slave {
             uint8_t address{0xFF};
             Status  status{Status::NC};
             bool    enabled{false};
+            uint8_t disable_retries{0}; //DISABLE commands left to send
+            bool    caps_known{false};  //Asked for CAPS since the slave was last seen
+            bool    delta{false};       //Slave takes PAD_DELTA frames
+            uint8_t caps_retries{0};
+            I2CLink::Encoder encoder;
+            Stats   stats;
+            //Owned by the transfer in flight
+            std::array<uint8_t, MAX_PACKET_SIZE> out{0};
+            std::array<uint8_t, sizeof(PacketOut)> in{0};
         };
+        static_assert(sizeof(PacketOut) == sizeof(PacketCMD), "I2CMaster replies must be the same size");
 
         static constexpr size_t NUM_SLAVES = MAX_GAMEPADS - 1;
         static_assert(NUM_SLAVES > 0, "I2CMaster::NUM_SLAVES must be greater than 0 to use I2C");
 
+        static constexpr uint8_t  DISABLE_RETRIES = 10;
+        //Unanswered CAPS before treating the slave as one that only takes PacketIn
+        static constexpr uint8_t  CAPS_RETRIES = 3;
+        static constexpr uint32_t BATCH_TIMEOUT_US = 5000;
+        //Bus errors in a row before dropping from Fast-mode Plus to I2C_BAUDRATE
+        static constexpr uint8_t  FAST_MODE_ERROR_LIMIT = 8;
+
         std::array<Slave, NUM_SLAVES> _slaves; 
 
-        static inline bool read_blocking(uint8_t address, void* buffer, size_t len) {
-            return (i2c_read_blocking(  I2C_PORT, address, reinterpret_cast<uint8_t*>(buffer), 
-                                        len, false) == static_cast<int>(len));
-        }
+        //Batch on the bus, _batch_slaves[i] is the index of the slave _batch[i] is for
+        std::array<i2c_master_dma::Transfer, NUM_SLAVES> _batch;
+        std::array<uint8_t, NUM_SLAVES> _batch_slaves;
+        uint8_t _batch_count = 0;
+        uint32_t _batch_start_us = 0;
 
-        static inline bool write_blocking(uint8_t address, void* buffer, size_t len) {
-            return (i2c_write_blocking( I2C_PORT, address, reinterpret_cast<uint8_t*>(buffer), 
-                                        len, false) == static_cast<int>(len));
+        bool _fast_mode = false;
+        uint8_t _bus_errors = 0;
+
+        static void notify_disable(Slave& slave) {
+            slave.disable_retries = DISABLE_RETRIES;
         }
 
-        static inline bool slave_detected(uint8_t address) {
-            uint8_t dummy = 0;
-            int result = i2c_write_timeout_us(I2C_PORT, address, &dummy, 0, false, 1000);
-            return (result >= 0);
+        static inline void set_transfer(i2c_master_dma::Transfer& transfer, Slave& slave, const void* packet, size_t len) {
+            std::memcpy(slave.out.data(), packet, len);
+            transfer.address = slave.address;
+            transfer.write = slave.out.data();
+            transfer.write_len = static_cast<uint8_t>(len);
+            transfer.read = slave.in.data();
+            transfer.read_len = static_cast<uint8_t>(slave.in.size());
         }
 
-        static void notify_disable(uint8_t address) {
-            if (!slave_detected(address)) {
-                return;
-            }
-            int retries = 10;
+        //Queues the next exchange for each slave, returns false if there's nothing to do
+        static bool build_batch() {
+            _batch_count = 0;
 
-            while (retries--) {
-                PacketCMD packet_cmd;
-                packet_cmd.packet_id = PacketID::COMMAND;
-                packet_cmd.command = Command::DISABLE;
+            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
+                Slave& slave = _slaves[i];
+                i2c_master_dma::Transfer& transfer = _batch[_batch_count];
 
-                if (write_blocking(address, &packet_cmd, sizeof(PacketCMD))) {
-                    if (read_blocking(address, &packet_cmd, sizeof(PacketCMD))) {
-                        if (packet_cmd.status == Status::OK) {
-                            break;
-                        }
-                    }
+                if (slave.disable_retries > 0) {
+                    PacketCMD packet_cmd;
+                    packet_cmd.command = Command::DISABLE;
+                    set_transfer(transfer, slave, &packet_cmd, sizeof(PacketCMD));
+                } else if (!slave.enabled) {
+                    continue;
+                } else if (slave.status != Status::READY) {
+                    //Known ready slaves skip this, a slave that stops being ready says so in its reply
+                    PacketCMD packet_cmd;
+                    packet_cmd.command = Command::STATUS;
+                    set_transfer(transfer, slave, &packet_cmd, sizeof(PacketCMD));
+                } else if (!slave.caps_known) {
+                    PacketCMD packet_cmd;
+                    packet_cmd.command = Command::CAPS;
+                    set_transfer(transfer, slave, &packet_cmd, sizeof(PacketCMD));
+                } else if (slave.delta) {
+                    Gamepad& gamepad = _gamepads[i + 1];
+                    uint8_t frame[I2CLink::MAX_FRAME_LEN];
+                    size_t len = slave.encoder.encode(I2CLink::to_pad_state(gamepad.get_pad_in(), gamepad.get_chatpad_in()), 
+                                                      static_cast<uint8_t>(PacketID::PAD_DELTA), 0, frame);
+                    set_transfer(transfer, slave, frame, len);
+                } else {
+                    Gamepad& gamepad = _gamepads[i + 1];
+                    PacketIn packet_in;
+                    packet_in.pad_in = gamepad.get_pad_in();
+                    packet_in.chatpad_in = gamepad.get_chatpad_in();
+                    set_transfer(transfer, slave, &packet_in, sizeof(PacketIn));
                 }
-                sleep_ms(1);
+                _batch_slaves[_batch_count++] = i;
             }
+            return (_batch_count > 0);
         }
 
-        static void process() {
-            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
-                Slave& slave = _slaves[i];
+        static void update_stats(Slave& slave, const i2c_master_dma::Transfer& transfer) {
+            ++slave.stats.transfers;
+            slave.stats.last_us = transfer.time_us;
+            slave.stats.max_us = std::max(slave.stats.max_us, transfer.time_us);
 
-                if (!slave.enabled || !slave_detected(slave.address)) {
-                    continue;
-                }
+            switch (transfer.result) {
+                case i2c_master_dma::Result::OK:
+                    _bus_errors = 0;
+                    break;
+                case i2c_master_dma::Result::NACK:
+                    ++slave.stats.nacks;
+                    break;
+                default:
+                    ++slave.stats.errors;
+                    ++_bus_errors;
+                    break;
+            }
+        }
 
-                PacketCMD packet_cmd;
-                packet_cmd.packet_id = PacketID::COMMAND;
-                packet_cmd.command = Command::STATUS;
+        static void complete_batch() {
+            for (uint8_t i = 0; i < _batch_count; ++i) {
+                const i2c_master_dma::Transfer& transfer = _batch[i];
+                Slave& slave = _slaves[_batch_slaves[i]];
+                const PacketID sent_id = static_cast<PacketID>(slave.out[1]);
+                const Command sent_cmd = (sent_id == PacketID::COMMAND) ? static_cast<Command>(slave.out[2]) : Command::UNKNOWN;
 
-                if (!write_blocking(slave.address, &packet_cmd, sizeof(PacketCMD)) ||
-                    !read_blocking(slave.address, &packet_cmd, sizeof(PacketCMD))) {
+                update_stats(slave, transfer);
+
+                if (transfer.result != i2c_master_dma::Result::OK) {
+                    if (slave.disable_retries > 0) {
+                        //Nobody there to tell
+                        slave.disable_retries = (transfer.result == i2c_master_dma::Result::NACK) ? 0 : slave.disable_retries - 1;
+                    }
+                    if (transfer.result == i2c_master_dma::Result::NACK) {
+                        //Might come back with new firmware
+                        slave.status = Status::NC;
+                        slave.caps_known = false;
+                        slave.caps_retries = 0;
+                    } else {
+                        slave.status = Status::ERROR;
+                    }
                     continue;
                 }
 
-                if (packet_cmd.status == Status::READY) {
-                    Gamepad& gamepad = _gamepads[i + 1];
-                    PacketIn packet_in;
-                    packet_in.pad_in = gamepad.get_pad_in();
-                    packet_in.chatpad_in = gamepad.get_chatpad_in();
+                const PacketOut* packet_out = reinterpret_cast<const PacketOut*>(slave.in.data());
+                const PacketCMD* packet_cmd = reinterpret_cast<const PacketCMD*>(slave.in.data());
 
-                    if (write_blocking(slave.address, &packet_in, sizeof(PacketIn))) {
-                        PacketOut packet_out;
-                        if (read_blocking(slave.address, &packet_out, sizeof(PacketOut))) {
-                            gamepad.set_pad_out(packet_out.pad_out);
+                if ((sent_id == PacketID::PAD || sent_id == PacketID::PAD_DELTA) && packet_out->packet_id == PacketID::PAD) {
+                    if (sent_id == PacketID::PAD_DELTA) {
+                        slave.encoder.commit();
+                        if (packet_out->flags & I2CLink::FLAG_NEED_KEY) {
+                            slave.encoder.request_key();
                         }
                     }
+                    _gamepads[_batch_slaves[i] + 1].set_pad_out(packet_out->pad_out);
+                } else if (packet_cmd->packet_id == PacketID::COMMAND) {
+                    if (packet_cmd->command == Command::DISABLE && slave.disable_retries > 0) {
+                        slave.disable_retries = (packet_cmd->status == Status::OK) ? 0 : slave.disable_retries - 1;
+                        slave.status = Status::NC;
+                    } else if (packet_cmd->command == Command::STATUS) {
+                        slave.status = packet_cmd->status;
+                    } else if (packet_cmd->command == Command::CAPS && sent_cmd == Command::CAPS) {
+                        slave.caps_known = true;
+                        slave.delta = (I2CLink::negotiate(packet_cmd->caps) & I2CLink::CAP_DELTA);
+                        slave.encoder.request_key();
+                        OGXM_LOG("I2C slave %u: %s packets\n", 
+                            static_cast<unsigned>(slave.address), slave.delta ? "delta" : "full");
+                    }
+                } else if (slave.disable_retries > 0) {
+                    --slave.disable_retries;
+                }
+
+                //Older slaves leave CAPS unanswered
+                if (sent_cmd == Command::CAPS && !slave.caps_known && ++slave.caps_retries >= CAPS_RETRIES) {
+                    slave.caps_known = true;
+                    slave.delta = false;
                 }
-                sleep_ms(1);
+            }
+            _batch_count = 0;
+
+            if (_fast_mode && _bus_errors >= FAST_MODE_ERROR_LIMIT) {
+                _fast_mode = false;
+                _bus_errors = 0;
+                OGXM_LOG("I2C: Bus errors at Fast-mode Plus, dropping to %u Hz\n", 
+                    static_cast<unsigned>(i2c_master_dma::set_baudrate(I2C_BAUDRATE)));
             }
         }
 
+#if defined(CONFIG_OGXM_DEBUG)
+        static void log_stats() {
+            static uint32_t last_ms = 0;
+            uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+            if (now_ms - last_ms < 5000) {
+                return;
+            }
+            last_ms = now_ms;
+
+            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
+                const Stats& stats = _slaves[i].stats;
+                OGXM_LOG("I2C slave %u: transfers %u, nacks %u, errors %u, last %u us, max %u us\n", 
+                    static_cast<unsigned>(_slaves[i].address), static_cast<unsigned>(stats.transfers), 
+                    static_cast<unsigned>(stats.nacks), static_cast<unsigned>(stats.errors), 
+                    static_cast<unsigned>(stats.last_us), static_cast<unsigned>(stats.max_us));
+            }
+        }
+#endif
+
+        //Never blocks, results of the last batch are handled and the next started once it's off the bus
+        static void process() {
+            if (i2c_master_dma::busy()) {
+                if (time_us_32() - _batch_start_us < BATCH_TIMEOUT_US) {
+                    return;
+                }
+                i2c_master_dma::abort();
+            }
+            if (_batch_count > 0) {
+                complete_batch();
+            }
+#if defined(CONFIG_OGXM_DEBUG)
+            log_stats();
+#endif
+            if (build_batch()) {
+                _batch_start_us = time_us_32();
+                if (!i2c_master_dma::start(_batch.data(), _batch_count)) {
+                    _batch_count = 0;
+                }
+            }
+        }
+
+        static void init() {
+            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
+                _slaves[i].address = i + 1;
+            }
+#if defined(I2C_BAUDRATE_FAST)
+            _fast_mode = true;
+            i2c_master_dma::init(I2C_PORT, I2C_BAUDRATE_FAST);
+#else
+            i2c_master_dma::init(I2C_PORT, I2C_BAUDRATE);
+#endif
+        }
+
         static void xbox360w_connect(bool connected, uint8_t idx) {
             if (idx < 1 || idx >= MAX_GAMEPADS) {
                 return;
@@ -272,7 +522,9 @@ namespace I2C {
             [&slave = _slaves[idx - 1], connected]() {
                 slave.enabled = connected;
                 if (!connected) {
-                    notify_disable(slave.address);
+                    notify_disable(slave);
+                } else {
+                    slave.disable_retries = 0;
                 }
             });
         }
@@ -287,7 +539,7 @@ namespace I2C {
                 []() {
                     for (auto& slave : _slaves) {
                         slave.enabled = false;
-                        notify_disable(slave.address);
+                        notify_disable(slave);
                     }
                 });
             }
@@ -323,7 +575,11 @@ namespace I2C {
         uint8_t i2c_address = get_address();
         _i2c_role = (i2c_address == 0xFF) ? Role::MASTER : _i2c_role = Role::SLAVE;
 
-        i2c_init(I2C_PORT, I2C_BAUDRATE);
+        if (_i2c_role == Role::MASTER) {
+            Master::init();
+        } else {
+            Slave::init(i2c_address);
+        }
 
         gpio_init(I2C_SDA_PIN);
         gpio_init(I2C_SCL_PIN);
@@ -331,14 +587,13 @@ namespace I2C {
         gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);
         gpio_pull_up(I2C_SDA_PIN);
         gpio_pull_up(I2C_SCL_PIN);
-
-        if (_i2c_role == Role::SLAVE) {
-            i2c_slave_init(I2C_PORT, i2c_address, &Slave::slave_handler);
-        }
     }
 } // namespace I2C
 
 void core1_task() {
+    //Keep running while core0 writes flash
+    multicore_lockout_victim_init();
+
     HostManager& host_manager = HostManager::get_instance();
     host_manager.initialize(_gamepads);
 
@@ -365,17 +620,15 @@ void core1_task() {
     }
 }
 
-void set_gp_check_timer(uint32_t task_id) {
+//Check gamepad inputs for button combo to change usb device driver
+void check_driver_combo() {
     UserSettings& user_settings = UserSettings::get_instance();
-    TaskQueue::Core0::queue_delayed_task(task_id, UserSettings::GP_CHECK_DELAY_MS, true, 
-    [&user_settings] {
-        //Check gamepad inputs for button combo to change usb device driver
-        if (user_settings.check_for_driver_change(_gamepads[0]))
-        {
-            //This will store the new mode and reboot the pico
-            user_settings.store_driver_type(user_settings.get_current_driver());
+    if (user_settings.check_for_driver_change(_gamepads[0])) {
+        //Store the new mode and re-enumerate as the new device, core1 keeps running
+        if (user_settings.store_driver_type(user_settings.get_current_driver())) {
+            DeviceManager::get_instance().switch_driver(user_settings.get_current_driver(), _gamepads);
         }
-    });
+    }
 }
 
 void four_ch_i2c::wireless_connected(bool connected, uint8_t idx) {
@@ -384,22 +637,17 @@ void four_ch_i2c::wireless_connected(bool connected, uint8_t idx) {
     }
 }
 
+//The device side stays enumerated once initialized, 
+//unplugged slots are left neutral by HostManager or the I2C master
 void four_ch_i2c::host_mounted(bool mounted) {
     static std::atomic<bool> tud_is_inited = false;
 
     board_api::set_led(mounted);
 
-    if (!mounted && tud_is_inited.load()) {
-        TaskQueue::Core0::queue_task([]() {
-            OGXM_LOG("Disconnecting USB and rebooting.\n");
-            board_api::usb::disconnect_all();
-            board_api::reboot();
-        });
-    } else if (!tud_is_inited.load() && mounted) {
+    if (mounted && !tud_is_inited.exchange(true)) {
         TaskQueue::Core0::queue_task([]() { 
             OGXM_LOG("Initializing USB device stack.\n");
             tud_init(BOARD_TUD_RHPORT); 
-            tud_is_inited.store(true);
         });
     }
 }
@@ -417,8 +665,10 @@ void four_ch_i2c::initialize() {
 
     board_api::init_board();
 
+    //Core1 isn't running yet, the profiles can go straight in
     for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
         _gamepads[i].set_profile(user_settings.get_profile_by_index(i));
+        _gamepads[i].apply_pending_profile();
     }
 
     DeviceManager::get_instance().initialize_driver(user_settings.get_current_driver(), _gamepads);
@@ -430,29 +680,33 @@ void four_ch_i2c::run() {
     multicore_reset_core1();
     multicore_launch_core1(core1_task);
 
-    //Wait for something to call tud_init
+    //Wait for something to call tud_init, on a slave that's the master's first STATUS
     while (!tud_inited()) {
         TaskQueue::Core0::process_tasks();
-        sleep_ms(100);
+        if (I2C::role() == I2C::Role::SLAVE) {
+            I2C::Slave::process();
+        }
+        sleep_ms(I2C::role() == I2C::Role::SLAVE ? 1 : 100);
     }
 
-    uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
-    set_gp_check_timer(tid_gp_check);
-
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    //Driver can be replaced at runtime, don't cache it
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
     if (I2C::role() == I2C::Role::MASTER) {
         while (true) {
             TaskQueue::Core0::process_tasks();
+            check_driver_combo();
             I2C::Master::process();
-            device_driver->process(0, _gamepads[0]);
+            device_manager.process(0, _gamepads[0]);
             tud_task();
             sleep_ms(1);
         }
     } else {
         while (true) {
             TaskQueue::Core0::process_tasks();
-            device_driver->process(0, _gamepads[0]);
+            check_driver_combo();
+            I2C::Slave::process();
+            device_manager.process(0, _gamepads[0]);
             tud_task();
             sleep_ms(1);
         }
@@ -19,22 +19,24 @@
 Gamepad _gamepads[MAX_GAMEPADS];
 
 void core1_task() {
+    //Keep running while core0 writes flash
+    multicore_lockout_victim_init();
+
     board_api::init_bluetooth();
     board_api::set_led(true);
     BLEServer::init_server(_gamepads);
     bluepad32::run_task(_gamepads);
 }
 
-void set_gp_check_timer(uint32_t task_id) {
+//Check gamepad inputs for button combo to change usb device driver
+void check_driver_combo() {
     UserSettings& user_settings = UserSettings::get_instance();
-    TaskQueue::Core0::queue_delayed_task(task_id, UserSettings::GP_CHECK_DELAY_MS, true, 
-    [&user_settings] {
-        //Check gamepad inputs for button combo to change usb device driver
-        if (user_settings.check_for_driver_change(_gamepads[0])) {
-            //This will store the new mode and reboot the pico
-            user_settings.store_driver_type(user_settings.get_current_driver());
+    if (user_settings.check_for_driver_change(_gamepads[0])) {
+        //Store the new mode and re-enumerate as the new device, core1 keeps running
+        if (user_settings.store_driver_type(user_settings.get_current_driver())) {
+            DeviceManager::get_instance().switch_driver(user_settings.get_current_driver(), _gamepads);
         }
-    });
+    }
 }
 
 void pico_w::initialize() {
@@ -43,8 +45,10 @@ void pico_w::initialize() {
     UserSettings& user_settings = UserSettings::get_instance();
     user_settings.initialize_flash();
 
+    //Core1 isn't running yet, the profiles can go straight in
     for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
         _gamepads[i].set_profile(user_settings.get_profile_by_index(i));
+        _gamepads[i].apply_pending_profile();
     }
 
     DeviceManager& device_manager = DeviceManager::get_instance();
@@ -55,18 +59,17 @@ void pico_w::run() {
     multicore_reset_core1();
     multicore_launch_core1(core1_task);
 
-    uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
-    set_gp_check_timer(tid_gp_check);
-
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    //Driver can be replaced at runtime, don't cache it
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
     tud_init(BOARD_TUD_RHPORT);
 
     while (true) {
         TaskQueue::Core0::process_tasks();
+        check_driver_combo();
 
         for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
-            device_driver->process(i, _gamepads[i]);
+            device_manager.process(i, _gamepads[i]);
             tud_task();
         }
         sleep_ms(1);
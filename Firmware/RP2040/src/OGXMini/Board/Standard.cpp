@@ -2,6 +2,7 @@
 #include "OGXMini/Board/Standard.h"
 #if ((OGXM_BOARD == PI_PICO) || (OGXM_BOARD == RP2040_ZERO) || (OGXM_BOARD == ADAFRUIT_FEATHER))
 
+#include <atomic>
 #include <pico/multicore.h>
 
 #include "tusb.h"
@@ -20,6 +21,9 @@ constexpr uint32_t FEEDBACK_DELAY_MS = 200;
 Gamepad _gamepads[MAX_GAMEPADS];
 
 void core1_task() {
+    //Keep running while core0 writes flash
+    multicore_lockout_victim_init();
+
     HostManager& host_manager = HostManager::get_instance();
     host_manager.initialize(_gamepads);
 
@@ -46,35 +50,29 @@ void core1_task() {
     }
 }
 
-void set_gp_check_timer(uint32_t task_id) {
+//Check gamepad inputs for button combo to change usb device driver
+void check_driver_combo() {
     UserSettings& user_settings = UserSettings::get_instance();
-    
-    TaskQueue::Core0::queue_delayed_task(task_id, UserSettings::GP_CHECK_DELAY_MS, true, 
-    [&user_settings] {
-        //Check gamepad inputs for button combo to change usb device driver
-        if (user_settings.check_for_driver_change(_gamepads[0])) {
-            OGXM_LOG("Driver change detected, storing new driver.\n");
-            //This will store the new mode and reboot the pico
-            user_settings.store_driver_type(user_settings.get_current_driver());
+    if (user_settings.check_for_driver_change(_gamepads[0])) {
+        OGXM_LOG("Driver change detected, storing new driver.\n");
+        //Store the new mode and re-enumerate as the new device, core1 keeps running
+        if (user_settings.store_driver_type(user_settings.get_current_driver())) {
+            DeviceManager::get_instance().switch_driver(user_settings.get_current_driver(), _gamepads);
         }
-    });
+    }
 }
 
-//Called by tusb host so we know to connect or disconnect usb
+//Called by tusb host so we know to connect usb, the device side stays
+//enumerated after that and HostManager leaves unplugged slots neutral
 void standard::host_mounted(bool host_mounted) {
     static std::atomic<bool> tud_is_inited = false;
     board_api::set_led(host_mounted);
 
-    if (!host_mounted && tud_is_inited.load()) {
-        TaskQueue::Core0::queue_task([]() {
-            OGXM_LOG("USB disconnected, rebooting.\n");
-            board_api::usb::disconnect_all();
-            board_api::reboot();
-        });
-    } else if (!tud_is_inited.load()) {
+    if (!host_mounted) {
+        OGXM_LOG("USB host disconnected, waiting for a controller.\n");
+    } else if (!tud_is_inited.exchange(true)) {
         TaskQueue::Core0::queue_task([]() { 
             tud_init(BOARD_TUD_RHPORT); 
-            tud_is_inited.store(true);
         });
     }
 }
@@ -85,8 +83,10 @@ void standard::initialize() {
     UserSettings& user_settings = UserSettings::get_instance();
     user_settings.initialize_flash();
 
+    //Core1 isn't running yet, the profiles can go straight in
     for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
         _gamepads[i].set_profile(user_settings.get_profile_by_index(i));
+        _gamepads[i].apply_pending_profile();
     }
 
     DeviceManager::get_instance().initialize_driver(user_settings.get_current_driver(), _gamepads);
@@ -109,16 +109,15 @@ void standard::run() {
         host_mounted(true);
     }
 
-    uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
-    set_gp_check_timer(tid_gp_check);
-
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    //Driver can be replaced at runtime, don't cache it
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
     while (true) {
         TaskQueue::Core0::process_tasks();
+        check_driver_combo();
 
         for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
-            device_driver->process(i, _gamepads[i]);
+            device_manager.process(i, _gamepads[i]);
         }
         tud_task();
         sleep_ms(1);
@@ -21,6 +21,7 @@ public:
     const uint8_t* get_hid_descriptor_report_cb(uint8_t itf)  override;
     const uint8_t* get_descriptor_configuration_cb(uint8_t index) override;
     const uint8_t* get_descriptor_device_qualifier_cb() override;
+    bool supports_config_itf() override { return true; }
 
 private:
     std::array<DInput::InReport, MAX_GAMEPADS> in_reports_;
@@ -18,6 +18,8 @@
 class DeviceDriver
 {
 public:
+    virtual ~DeviceDriver() = default;
+
     virtual void initialize() = 0;
     virtual void process(const uint8_t idx, Gamepad& gamepad) = 0;
     virtual uint16_t get_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t req_len) = 0;
@@ -28,6 +30,9 @@ public:
     virtual const uint8_t* get_hid_descriptor_report_cb(uint8_t itf) = 0;
     virtual const uint8_t* get_descriptor_configuration_cb(uint8_t index) = 0;
     virtual const uint8_t* get_descriptor_device_qualifier_cb() = 0;
+
+    //True if the console tolerates a CDC config interface appended to this driver's descriptors
+    virtual bool supports_config_itf() { return false; }
     
     const usbd_class_driver_t* get_class_driver() { return &class_driver_; };
 
@@ -25,6 +25,7 @@ public:
   const uint8_t *get_hid_descriptor_report_cb(uint8_t itf) override;
   const uint8_t *get_descriptor_configuration_cb(uint8_t index) override;
   const uint8_t *get_descriptor_device_qualifier_cb() override;
+  bool supports_config_itf() override { return true; }
 
 private:
   PS3::InReport report_in_;
@@ -0,0 +1,70 @@
+#ifndef _WEBAPP_COMMANDS_H_
+#define _WEBAPP_COMMANDS_H_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppFrame.h"
+
+/*  Commands carried in the payload of framed WebApp DATA and EVENT frames, shared by
+    the firmware and host tools. Each payload starts with a CommandHeader, the data
+    described next to each PacketID follows. */
+namespace WebAppCommands
+{
+    enum class PacketID : uint8_t
+    {
+        NONE = 0,
+        GET_PROFILE_BY_ID = 0x50,   //Responds with the same id and a UserProfile
+        GET_PROFILE_BY_IDX = 0x55,  //Responds with the same id and a UserProfile
+        SET_PROFILE_START = 0x60,   //Legacy packets only
+        SET_PROFILE = 0x61,         //UserProfile, echoed without data once stored
+        GET_BANK = 0x70,            //Responds with BANK_DATA chunks and a BANK_COMMIT
+        BANK_DATA = 0x71,           //BankChunk and up to BANK_CHUNK_LEN bytes of a ProfileBank
+        BANK_COMMIT = 0x72,         //BankCommit, echoed by the device once stored
+        SET_GP_IN = 0x80,           //Gamepad::PadIn, pushed as EVENT frames
+        SET_GP_OUT = 0x81,
+        TELEMETRY_START = 0x90,     //TelemetryConfig, echoed
+        TELEMETRY_STOP = 0x91,      //Echoed
+        TELEMETRY = 0x92,           //WebAppTelemetry::Header and fields, pushed as EVENT frames
+        RESP_ERROR = 0xFF
+    };
+
+    #pragma pack(push, 1)
+    struct CommandHeader
+    {
+        PacketID packet_id{PacketID::NONE};
+        DeviceDriverType device_driver{DeviceDriverType::WEBAPP};
+        uint8_t max_gamepads{0};
+        uint8_t player_idx{0};
+        uint8_t profile_id{0};
+    };
+    static_assert(sizeof(CommandHeader) == 5, "WebApp command size mismatch");
+
+    struct BankChunk
+    {
+        uint16_t offset{0};
+        uint16_t total_len{0};
+    };
+    static_assert(sizeof(BankChunk) == 4, "WebApp command size mismatch");
+
+    struct BankCommit
+    {
+        uint16_t total_len{0};
+        uint32_t crc{0};            //ProfileBank::crc32 of the whole image
+    };
+    static_assert(sizeof(BankCommit) == 6, "WebApp command size mismatch");
+
+    struct TelemetryConfig
+    {
+        uint8_t gamepad_mask{0};
+        uint32_t min_interval_us{0};
+    };
+    static_assert(sizeof(TelemetryConfig) == 5, "WebApp command size mismatch");
+    #pragma pack(pop)
+
+    static constexpr size_t BANK_CHUNK_LEN = WebAppFrame::MAX_PAYLOAD - sizeof(CommandHeader) - sizeof(BankChunk);
+
+} // namespace WebAppCommands
+
+#endif // _WEBAPP_COMMANDS_H_
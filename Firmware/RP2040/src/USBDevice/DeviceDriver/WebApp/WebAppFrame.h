@@ -0,0 +1,223 @@
+#ifndef _WEBAPP_FRAME_H_
+#define _WEBAPP_FRAME_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+
+/*  Framing for the WebApp protocol: Header | payload | CRC-16 (little endian), COBS encoded
+    and terminated by a 0x00 delimiter, so a lost or corrupted byte only costs the frame it
+    landed in. Nothing here depends on the firmware, host tools can include it as is. */
+namespace WebAppFrame
+{
+    static constexpr uint8_t DELIMITER = 0x00;
+    static constexpr size_t MAX_PAYLOAD = 240;
+    //DATA frames either side may have unacknowledged, and how long before they're resent
+    static constexpr uint8_t WINDOW = 4;
+    static constexpr uint32_t RETRANSMIT_MS = 100;
+
+    enum class Type : uint8_t
+    {
+        NONE = 0,
+        DATA,   //Reliable, delivered in seq order and acknowledged
+        ACK,    //Acknowledges every DATA frame up to and including ack
+        NAK,    //Receiver is missing the DATA frame after ack, resend from there
+        EVENT,  //Unreliable and unacknowledged, seq is unused
+        SYNC    //Host starts the session over, both sides drop their seq state and the device echoes it with the same seq
+    };
+
+    #pragma pack(push, 1)
+    struct Header
+    {
+        Type    type{Type::NONE};
+        uint8_t seq{0};
+        uint8_t ack{0};     //Last in-order DATA seq received by the sender
+        uint8_t len{0};     //Payload length
+    };
+    static_assert(sizeof(Header) == 4, "WebAppFrame::Header size mismatch");
+    #pragma pack(pop)
+
+    static constexpr size_t CRC_LEN = sizeof(uint16_t);
+    static constexpr size_t MAX_FRAME = sizeof(Header) + MAX_PAYLOAD + CRC_LEN;
+    //COBS adds a code byte per 254 bytes plus one, then the delimiter
+    static constexpr size_t MAX_ENCODED = MAX_FRAME + (MAX_FRAME / 254) + 2;
+
+    static constexpr std::array<uint16_t, 256> CRC16_TABLE = []
+    {
+        std::array<uint16_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint16_t crc = static_cast<uint16_t>(i << 8);
+            for (uint8_t j = 0; j < 8; ++j)
+            {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    //CRC-16/CCITT-FALSE, pass the previous result as crc to continue a running checksum
+    static inline uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF)
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            crc = static_cast<uint16_t>((crc << 8) ^ CRC16_TABLE[((crc >> 8) ^ data[i]) & 0xFF]);
+        }
+        return crc;
+    }
+
+    //Returns the encoded length, out must hold len + len / 254 + 1 bytes
+    static inline size_t cobs_encode(const uint8_t* in, size_t len, uint8_t* out)
+    {
+        size_t out_idx = 1;
+        size_t code_idx = 0;
+        uint8_t code = 1;
+
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (in[i] != 0)
+            {
+                out[out_idx++] = in[i];
+                ++code;
+            }
+            if (in[i] == 0 || code == 0xFF)
+            {
+                out[code_idx] = code;
+                code_idx = out_idx++;
+                code = 1;
+            }
+        }
+        out[code_idx] = code;
+        return out_idx;
+    }
+
+    //Returns the decoded length, 0 if the input isn't valid COBS or doesn't fit out_len
+    static inline size_t cobs_decode(const uint8_t* in, size_t len, uint8_t* out, size_t out_len)
+    {
+        size_t in_idx = 0;
+        size_t out_idx = 0;
+
+        while (in_idx < len)
+        {
+            const uint8_t code = in[in_idx++];
+            if (code == 0 || in_idx + code - 1 > len || out_idx + code > out_len + 1)
+            {
+                return 0;
+            }
+            for (uint8_t i = 1; i < code; ++i)
+            {
+                if (in[in_idx] == 0)
+                {
+                    return 0;
+                }
+                out[out_idx++] = in[in_idx++];
+            }
+            if (code != 0xFF && in_idx < len)
+            {
+                if (out_idx >= out_len)
+                {
+                    return 0;
+                }
+                out[out_idx++] = 0;
+            }
+        }
+        return out_idx;
+    }
+
+    //Writes a complete frame including the delimiter to out (MAX_ENCODED bytes), returns its length
+    static inline size_t encode(Type type, uint8_t seq, uint8_t ack, const void* payload, size_t len, uint8_t* out)
+    {
+        if (len > MAX_PAYLOAD)
+        {
+            return 0;
+        }
+
+        std::array<uint8_t, MAX_FRAME> raw;
+        Header header;
+        header.type = type;
+        header.seq = seq;
+        header.ack = ack;
+        header.len = static_cast<uint8_t>(len);
+
+        std::memcpy(raw.data(), &header, sizeof(Header));
+        if (len > 0)
+        {
+            std::memcpy(raw.data() + sizeof(Header), payload, len);
+        }
+
+        const uint16_t crc = crc16(raw.data(), sizeof(Header) + len);
+        raw[sizeof(Header) + len] = static_cast<uint8_t>(crc & 0xFF);
+        raw[sizeof(Header) + len + 1] = static_cast<uint8_t>(crc >> 8);
+
+        size_t out_len = cobs_encode(raw.data(), sizeof(Header) + len + CRC_LEN, out);
+        out[out_len++] = DELIMITER;
+        return out_len;
+    }
+
+    //Collects received bytes and validates each frame as its delimiter arrives
+    class Decoder
+    {
+    public:
+        //Returns true if byte completed a valid frame, read it with header() and payload()
+        bool push(uint8_t byte)
+        {
+            if (byte != DELIMITER)
+            {
+                if (len_ < encoded_.size())
+                {
+                    encoded_[len_] = byte;
+                }
+                len_ = (len_ <= encoded_.size()) ? len_ + 1 : len_;
+                return false;
+            }
+
+            const size_t encoded_len = len_;
+            len_ = 0;
+
+            //Back to back delimiters are used to resync
+            if (encoded_len == 0)
+            {
+                return false;
+            }
+
+            const size_t frame_len = (encoded_len <= encoded_.size())
+                ? cobs_decode(encoded_.data(), encoded_len, frame_.data(), frame_.size()) : 0;
+
+            if (frame_len < sizeof(Header) + CRC_LEN)
+            {
+                ++errors_;
+                return false;
+            }
+
+            std::memcpy(&header_, frame_.data(), sizeof(Header));
+            const size_t crc_offset = sizeof(Header) + header_.len;
+
+            if (crc_offset + CRC_LEN != frame_len ||
+                crc16(frame_.data(), crc_offset) != static_cast<uint16_t>(frame_[crc_offset] | (frame_[crc_offset + 1] << 8)))
+            {
+                ++errors_;
+                return false;
+            }
+            return true;
+        }
+
+        void reset() { len_ = 0; }
+
+        const Header& header() const { return header_; }
+        const uint8_t* payload() const { return frame_.data() + sizeof(Header); }
+        //Frames dropped for bad COBS, length or CRC
+        uint32_t errors() const { return errors_; }
+
+    private:
+        std::array<uint8_t, MAX_ENCODED> encoded_;
+        std::array<uint8_t, MAX_FRAME> frame_;
+        size_t len_{0};
+        Header header_;
+        uint32_t errors_{0};
+    };
+
+} // namespace WebAppFrame
+
+#endif // _WEBAPP_FRAME_H_
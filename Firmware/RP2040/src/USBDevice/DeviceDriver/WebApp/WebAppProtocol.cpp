@@ -0,0 +1,758 @@
+#include <cstring>
+#include <algorithm>
+#include <pico/time.h>
+
+#include "class/cdc/cdc_device.h"
+
+#include "Board/ogxm_log.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppProtocol.h"
+
+static inline uint32_t ms_since_boot()
+{
+    return to_ms_since_boot(get_absolute_time());
+}
+
+void WebAppProtocol::line_state_changed(bool connected)
+{
+    reset();
+    if (!connected)
+    {
+        tud_cdc_read_flush();
+    }
+}
+
+void WebAppProtocol::reset()
+{
+    rx_buffer_len_ = 0;
+    rx_buffer_idx_ = 0;
+    rx_len_ = 0;
+    profile_pending_ = false;
+    store_reply_ = false;
+
+    framed_ = false;
+    decoder_.reset();
+    rx_seq_ = 0;
+    tx_seq_ = 0;
+    tx_acked_ = 0;
+    bank_tx_active_ = false;
+    bank_rx_len_ = 0;
+    telemetry_ = TelemetryConfig();
+
+    tx_head_ = 0;
+    tx_count_ = 0;
+    pad_in_sent_.fill(Gamepad::PadIn());
+}
+
+/* ---- Tx ---- */
+
+bool WebAppProtocol::queue_bytes(const void* data, size_t len)
+{
+    if (tx_free() < len)
+    {
+        return false;
+    }
+
+    const uint8_t* data_ptr = reinterpret_cast<const uint8_t*>(data);
+    size_t tail = (tx_head_ + tx_count_) % TX_FIFO_LEN;
+    size_t first = std::min(len, TX_FIFO_LEN - tail);
+
+    std::memcpy(tx_fifo_.data() + tail, data_ptr, first);
+    std::memcpy(tx_fifo_.data(), data_ptr + first, len - first);
+    tx_count_ += len;
+    return true;
+}
+
+//Writes as much of the fifo as the CDC fifo will take
+void WebAppProtocol::write_queued()
+{
+    while (tx_count_ > 0)
+    {
+        size_t len = std::min(tx_count_, TX_FIFO_LEN - tx_head_);
+        uint32_t written = tud_cdc_write(tx_fifo_.data() + tx_head_, static_cast<uint32_t>(len));
+        if (written == 0)
+        {
+            break;
+        }
+        tx_head_ = (tx_head_ + written) % TX_FIFO_LEN;
+        tx_count_ -= written;
+    }
+    tud_cdc_write_flush();
+}
+
+bool WebAppProtocol::queue_chunked(PacketHeader header, const void* data, size_t len)
+{
+    const uint8_t* data_ptr = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t total_chunks = static_cast<uint8_t>((len + CHUNK_LEN - 1) / CHUNK_LEN);
+
+    if (tx_free() < total_chunks * sizeof(Packet))
+    {
+        return false;
+    }
+
+    Packet packet;
+    packet.header = header;
+    packet.header.device_driver = driver_type_;
+    packet.header.max_gamepads = MAX_GAMEPADS;
+    packet.header.chunks_total = total_chunks;
+
+    for (uint8_t chunk = 0; chunk < total_chunks; ++chunk)
+    {
+        size_t offset = chunk * CHUNK_LEN;
+        packet.header.chunk_idx = chunk;
+        packet.header.chunk_len = static_cast<uint8_t>(std::min(CHUNK_LEN, len - offset));
+
+        std::memcpy(packet.data.data(), data_ptr + offset, packet.header.chunk_len);
+        queue_bytes(&packet, sizeof(Packet));
+    }
+    return true;
+}
+
+bool WebAppProtocol::queue_frame(WebAppFrame::Type type, uint8_t seq, const void* payload, size_t len)
+{
+    uint8_t encoded[WebAppFrame::MAX_ENCODED];
+    size_t encoded_len = WebAppFrame::encode(type, seq, rx_seq_, payload, len, encoded);
+    return (encoded_len > 0) && queue_bytes(encoded, encoded_len);
+}
+
+//Keeps a copy in the window until the host acknowledges it
+bool WebAppProtocol::send_data(const void* payload, size_t len)
+{
+    if (unacked() >= WINDOW || len > WebAppFrame::MAX_PAYLOAD || tx_free() < WebAppFrame::MAX_ENCODED)
+    {
+        return false;
+    }
+
+    TxFrame& frame = tx_window_[++tx_seq_ % WINDOW];
+    frame.len = static_cast<uint8_t>(len);
+    std::memcpy(frame.payload.data(), payload, len);
+
+    if (unacked() == 1)
+    {
+        tx_sent_ms_ = ms_since_boot();
+    }
+    return queue_frame(WebAppFrame::Type::DATA, tx_seq_, frame.payload.data(), frame.len);
+}
+
+bool WebAppProtocol::send_command(PacketID packet_id, uint8_t player_idx, uint8_t profile_id, const void* data, size_t len, bool reliable)
+{
+    std::array<uint8_t, WebAppFrame::MAX_PAYLOAD> payload;
+    if (sizeof(CommandHeader) + len > payload.size())
+    {
+        return false;
+    }
+
+    CommandHeader header;
+    header.packet_id = packet_id;
+    header.device_driver = driver_type_;
+    header.max_gamepads = MAX_GAMEPADS;
+    header.player_idx = player_idx;
+    header.profile_id = profile_id;
+
+    std::memcpy(payload.data(), &header, sizeof(CommandHeader));
+    if (len > 0)
+    {
+        std::memcpy(payload.data() + sizeof(CommandHeader), data, len);
+    }
+
+    return reliable
+        ? send_data(payload.data(), sizeof(CommandHeader) + len)
+        : queue_frame(WebAppFrame::Type::EVENT, 0, payload.data(), sizeof(CommandHeader) + len);
+}
+
+void WebAppProtocol::send_error()
+{
+    if (framed_)
+    {
+        send_command(PacketID::RESP_ERROR, 0, 0, nullptr, 0);
+        return;
+    }
+    Packet packet;
+    packet.header.packet_id = PacketID::RESP_ERROR;
+    packet.header.device_driver = driver_type_;
+    packet.header.chunks_total = 1;
+    queue_bytes(&packet, sizeof(Packet));
+}
+
+void WebAppProtocol::send_profile(uint8_t index, const UserProfile& profile, PacketID packet_id)
+{
+    bool sent = false;
+    if (framed_)
+    {
+        sent = send_command(packet_id, index, profile.id, &profile, sizeof(UserProfile));
+    }
+    else
+    {
+        PacketHeader header;
+        header.packet_id = packet_id;
+        header.player_idx = index;
+        header.profile_id = profile.id;
+        sent = queue_chunked(header, &profile, sizeof(UserProfile));
+    }
+    if (!sent)
+    {
+        send_error();
+    }
+}
+
+void WebAppProtocol::send_gamepad(uint8_t index, const Gamepad::PadIn& pad_in)
+{
+    if (framed_)
+    {
+        send_command(PacketID::SET_GP_IN, index, 0, &pad_in, sizeof(Gamepad::PadIn), false);
+        return;
+    }
+    PacketHeader header;
+    header.packet_id = PacketID::SET_GP_IN;
+    header.player_idx = index;
+    queue_chunked(header, &pad_in, sizeof(Gamepad::PadIn));
+}
+
+//Queues the next chunks of the bank while the window has room, then the commit
+void WebAppProtocol::send_bank()
+{
+    const ProfileBank& bank = user_settings_.read_profile_bank();
+    const uint8_t* bank_ptr = reinterpret_cast<const uint8_t*>(&bank);
+
+    //Keep room for an ACK and a response so the host's requests aren't held up
+    while (bank_tx_active_ && unacked() < WINDOW && tx_free() >= TX_RESERVE + WebAppFrame::MAX_ENCODED)
+    {
+        if (bank_tx_offset_ >= sizeof(ProfileBank))
+        {
+            BankCommit commit;
+            commit.total_len = sizeof(ProfileBank);
+            commit.crc = ProfileBank::crc32(bank_ptr, sizeof(ProfileBank));
+            bank_tx_active_ = !send_command(PacketID::BANK_COMMIT, 0, 0, &commit, sizeof(BankCommit));
+            break;
+        }
+
+        std::array<uint8_t, sizeof(BankChunk) + BANK_CHUNK_LEN> data;
+        BankChunk chunk;
+        chunk.offset = static_cast<uint16_t>(bank_tx_offset_);
+        chunk.total_len = sizeof(ProfileBank);
+        const size_t chunk_len = std::min(BANK_CHUNK_LEN, sizeof(ProfileBank) - bank_tx_offset_);
+
+        std::memcpy(data.data(), &chunk, sizeof(BankChunk));
+        std::memcpy(data.data() + sizeof(BankChunk), bank_ptr + bank_tx_offset_, chunk_len);
+
+        if (!send_command(PacketID::BANK_DATA, 0, 0, data.data(), sizeof(BankChunk) + chunk_len))
+        {
+            break;
+        }
+        bank_tx_offset_ += chunk_len;
+    }
+}
+
+//Sends the gamepad's latest sample if it's new and there's bandwidth for it
+void WebAppProtocol::send_telemetry(uint8_t index, Gamepad& gamepad)
+{
+    TelemetryState& state = telemetry_state_[index];
+    const Gamepad::InputSample input = gamepad.peek_input_sample();
+    if (input.count == state.count)
+    {
+        return;
+    }
+
+    //Samples overwritten before this loop got to them count as dropped too
+    const uint32_t missed = (state.count == 0) ? 0 : (input.count - state.count - 1);
+    state.count = input.count;
+    state.dropped = static_cast<uint8_t>(std::min<uint32_t>(255, state.dropped + missed));
+
+    const uint32_t now_us = static_cast<uint32_t>(to_us_since_boot(get_absolute_time()));
+    if ((now_us - state.sent_us) < telemetry_.min_interval_us ||
+        tx_free() < TX_RESERVE + WebAppFrame::MAX_ENCODED)
+    {
+        state.dropped = static_cast<uint8_t>(std::min(255, state.dropped + 1));
+        return;
+    }
+
+    WebAppTelemetry::Sample sample;
+    sample.raw_joystick_lx = input.raw.joystick_lx;
+    sample.raw_joystick_ly = input.raw.joystick_ly;
+    sample.raw_joystick_rx = input.raw.joystick_rx;
+    sample.raw_joystick_ry = input.raw.joystick_ry;
+    sample.raw_trigger_l = input.raw.trigger_l;
+    sample.raw_trigger_r = input.raw.trigger_r;
+    sample.dpad = input.pad_in.dpad;
+    sample.buttons = input.pad_in.buttons;
+    sample.trigger_l = input.pad_in.trigger_l;
+    sample.trigger_r = input.pad_in.trigger_r;
+    sample.joystick_lx = input.pad_in.joystick_lx;
+    sample.joystick_ly = input.pad_in.joystick_ly;
+    sample.joystick_rx = input.pad_in.joystick_rx;
+    sample.joystick_ry = input.pad_in.joystick_ry;
+    std::memcpy(sample.analog.data(), input.pad_in.analog, sample.analog.size());
+    sample.accel_x = input.pad_in.accel_x;
+
+    std::array<uint8_t, sizeof(WebAppTelemetry::Header) + sizeof(WebAppTelemetry::Sample)> data;
+    WebAppTelemetry::Header header;
+    header.time_us = input.time_us;
+    header.seq = state.seq;
+    header.dropped = state.dropped;
+
+    const bool key = (state.seq % WebAppTelemetry::KEY_INTERVAL) == 0;
+    const size_t len = WebAppTelemetry::encode_delta(sample, state.sent, key, header.fields, data.data() + sizeof(header));
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    if (send_command(PacketID::TELEMETRY, index, 0, data.data(), sizeof(header) + len, false))
+    {
+        state.sent = sample;
+        state.sent_us = now_us;
+        state.dropped = 0;
+        ++state.seq;
+    }
+}
+
+//Frees window slots up to ack, ignores acks outside of what's in flight
+void WebAppProtocol::release_acked(uint8_t ack)
+{
+    const uint8_t acked = static_cast<uint8_t>(ack - tx_acked_);
+    if (acked == 0 || acked > unacked())
+    {
+        return;
+    }
+    tx_acked_ = ack;
+    tx_sent_ms_ = ms_since_boot();
+}
+
+void WebAppProtocol::retransmit()
+{
+    for (uint8_t seq = tx_acked_ + 1; seq != static_cast<uint8_t>(tx_seq_ + 1); ++seq)
+    {
+        const TxFrame& frame = tx_window_[seq % WINDOW];
+        if (!queue_frame(WebAppFrame::Type::DATA, seq, frame.payload.data(), frame.len))
+        {
+            break;
+        }
+    }
+    tx_sent_ms_ = ms_since_boot();
+}
+
+/* ---- Rx ---- */
+
+//Legacy SET_PROFILE, the WebApp expects the adapter to reboot into what it stored
+bool WebAppProtocol::store_profile(DeviceDriverType driver_type, uint8_t index, const UserProfile& profile)
+{
+    const bool new_driver = (driver_type != DeviceDriverType::WEBAPP &&
+                             driver_type != driver_type_ &&
+                             user_settings_.is_valid_driver(driver_type));
+
+    return new_driver
+        ? user_settings_.store_profile_and_driver_type(driver_type, index, profile)
+        : user_settings_.store_profile(index, profile);
+}
+
+/*  Framed SET_PROFILE latched by handle_command(). The bank write erases a flash sector with
+    core1 locked out, so host polling and this device loop stall for its duration (tens of ms).
+    That's acceptable here, between two passes of the loop with the host waiting on the
+    response, but not in tud_cdc_rx_cb(). The profile is applied in process(), a new driver
+    by the board's loop. */
+void WebAppProtocol::store_pending_profile()
+{
+    store_pending_ = false;
+
+    const bool new_driver = (store_driver_ != DeviceDriverType::WEBAPP &&
+                             store_driver_ != driver_type_ &&
+                             user_settings_.is_valid_driver(store_driver_));
+    const bool stored = user_settings_.store_profile_live(store_index_, profile_);
+    if (stored)
+    {
+        profiles_changed_ = static_cast<uint8_t>((1U << MAX_GAMEPADS) - 1);
+        if (new_driver)
+        {
+            user_settings_.request_driver_change(store_driver_);
+        }
+    }
+
+    if (!store_reply_)
+    {
+        return;
+    }
+    store_reply_ = false;
+    if (stored)
+    {
+        send_command(PacketID::SET_PROFILE, store_index_, profile_.id, nullptr, 0);
+    }
+    else
+    {
+        send_error();
+    }
+}
+
+//Chunks may arrive in any order, the commit's CRC decides if the image is complete
+void WebAppProtocol::handle_bank_chunk(const uint8_t* data, size_t len)
+{
+    BankChunk chunk;
+    if (len < sizeof(BankChunk))
+    {
+        send_error();
+        return;
+    }
+    std::memcpy(&chunk, data, sizeof(BankChunk));
+    const size_t chunk_len = len - sizeof(BankChunk);
+
+    if (chunk.total_len != sizeof(ProfileBank) ||
+        chunk.offset > sizeof(ProfileBank) - chunk_len)
+    {
+        OGXM_LOG("Invalid bank chunk\n");
+        bank_rx_len_ = 0;
+        send_error();
+        return;
+    }
+
+    std::memcpy(reinterpret_cast<uint8_t*>(&bank_rx_) + chunk.offset, data + sizeof(BankChunk), chunk_len);
+    bank_rx_len_ += chunk_len;
+}
+
+void WebAppProtocol::handle_bank_commit(const uint8_t* data, size_t len)
+{
+    BankCommit commit;
+    const uint8_t* bank_ptr = reinterpret_cast<const uint8_t*>(&bank_rx_);
+    const size_t received = bank_rx_len_;
+    bank_rx_len_ = 0;
+
+    if (len < sizeof(BankCommit))
+    {
+        send_error();
+        return;
+    }
+    std::memcpy(&commit, data, sizeof(BankCommit));
+
+    if (commit.total_len != sizeof(ProfileBank) ||
+        received < sizeof(ProfileBank) ||
+        commit.crc != ProfileBank::crc32(bank_ptr, sizeof(ProfileBank)) ||
+        !user_settings_.store_profile_bank(bank_rx_))
+    {
+        OGXM_LOG("Bank commit failed\n");
+        send_error();
+        return;
+    }
+
+    OGXM_LOG("Profile bank stored\n");
+    profiles_changed_ = static_cast<uint8_t>((1U << MAX_GAMEPADS) - 1);
+    send_command(PacketID::BANK_COMMIT, 0, 0, &commit, sizeof(BankCommit));
+}
+
+void WebAppProtocol::handle_profile_chunk(const Packet& packet)
+{
+    if (packet.header.packet_id != PacketID::SET_PROFILE)
+    {
+        OGXM_LOG("Invalid packet ID: %i\n", packet.header.packet_id);
+        profile_pending_ = false;
+        send_error();
+        return;
+    }
+    if (profile_chunks_ == 0)
+    {
+        profile_chunks_ = packet.header.chunks_total;
+    }
+    if (profile_chunks_ == 0 ||
+        packet.header.chunk_len > sizeof(UserProfile) - profile_offset_)
+    {
+        OGXM_LOG("Invalid chunk\n");
+        profile_pending_ = false;
+        send_error();
+        return;
+    }
+
+    std::memcpy(reinterpret_cast<uint8_t*>(&profile_) + profile_offset_, packet.data.data(), packet.header.chunk_len);
+    profile_offset_ += packet.header.chunk_len;
+
+    if (++profile_chunk_idx_ < profile_chunks_)
+    {
+        return;
+    }
+
+    profile_pending_ = false;
+    OGXM_LOG("Profile read successfully\n");
+
+    if (!store_profile(profile_header_.device_driver, profile_header_.player_idx, profile_))
+    {
+        send_error();
+    }
+}
+
+void WebAppProtocol::handle_packet(const Packet& packet)
+{
+    OGXM_LOG("Received packet with ID: %d\n", packet.header.packet_id);
+
+    if (profile_pending_)
+    {
+        handle_profile_chunk(packet);
+        return;
+    }
+
+    switch (packet.header.packet_id)
+    {
+        case PacketID::GET_PROFILE_BY_ID:
+            send_profile(0, user_settings_.get_profile_by_id(packet.header.profile_id), PacketID::GET_PROFILE_BY_ID);
+            break;
+
+        case PacketID::GET_PROFILE_BY_IDX:
+            send_profile(packet.header.player_idx, user_settings_.get_profile_by_index(packet.header.player_idx), PacketID::GET_PROFILE_BY_IDX);
+            break;
+
+        case PacketID::SET_PROFILE_START:
+            //The profile follows in SET_PROFILE packets
+            profile_pending_ = true;
+            profile_header_ = packet.header;
+            profile_chunks_ = 0;
+            profile_chunk_idx_ = 0;
+            profile_offset_ = 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void WebAppProtocol::handle_command(const uint8_t* payload, size_t len)
+{
+    CommandHeader command;
+    if (len < sizeof(CommandHeader))
+    {
+        send_error();
+        return;
+    }
+    std::memcpy(&command, payload, sizeof(CommandHeader));
+
+    OGXM_LOG("Received command with ID: %d\n", command.packet_id);
+
+    switch (command.packet_id)
+    {
+        case PacketID::GET_PROFILE_BY_ID:
+            send_profile(0, user_settings_.get_profile_by_id(command.profile_id), PacketID::GET_PROFILE_BY_ID);
+            break;
+
+        case PacketID::GET_PROFILE_BY_IDX:
+            send_profile(command.player_idx, user_settings_.get_profile_by_index(command.player_idx), PacketID::GET_PROFILE_BY_IDX);
+            break;
+
+        //The whole profile fits in one frame, SET_PROFILE_START isn't used
+        case PacketID::SET_PROFILE:
+            if (len < sizeof(CommandHeader) + sizeof(UserProfile))
+            {
+                send_error();
+                break;
+            }
+            //Stored and answered by process(), see store_pending_profile()
+            std::memcpy(&profile_, payload + sizeof(CommandHeader), sizeof(UserProfile));
+            store_pending_ = true;
+            store_reply_ = true;
+            store_driver_ = command.device_driver;
+            store_index_ = command.player_idx;
+            break;
+
+        case PacketID::GET_BANK:
+            bank_tx_active_ = true;
+            bank_tx_offset_ = 0;
+            send_bank();
+            break;
+
+        case PacketID::BANK_DATA:
+            handle_bank_chunk(payload + sizeof(CommandHeader), len - sizeof(CommandHeader));
+            break;
+
+        case PacketID::BANK_COMMIT:
+            handle_bank_commit(payload + sizeof(CommandHeader), len - sizeof(CommandHeader));
+            break;
+
+        //Streams start over with a key event
+        case PacketID::TELEMETRY_START:
+            if (len < sizeof(CommandHeader) + sizeof(TelemetryConfig))
+            {
+                send_error();
+                break;
+            }
+            std::memcpy(&telemetry_, payload + sizeof(CommandHeader), sizeof(TelemetryConfig));
+            telemetry_.gamepad_mask &= static_cast<uint8_t>((1U << MAX_GAMEPADS) - 1);
+            telemetry_state_.fill(TelemetryState());
+            send_command(PacketID::TELEMETRY_START, 0, 0, &telemetry_, sizeof(TelemetryConfig));
+            break;
+
+        case PacketID::TELEMETRY_STOP:
+            telemetry_ = TelemetryConfig();
+            send_command(PacketID::TELEMETRY_STOP, 0, 0, nullptr, 0);
+            break;
+
+        default:
+            send_error();
+            break;
+    }
+}
+
+void WebAppProtocol::handle_frame(const WebAppFrame::Header& header, const uint8_t* payload)
+{
+    //Its ack belongs to no session yet
+    if (header.type == WebAppFrame::Type::SYNC)
+    {
+        OGXM_LOG("WebApp session synced\n");
+        start_session();
+        queue_frame(WebAppFrame::Type::SYNC, header.seq, nullptr, 0);
+        return;
+    }
+
+    release_acked(header.ack);
+
+    switch (header.type)
+    {
+        case WebAppFrame::Type::DATA:
+            if (header.seq == static_cast<uint8_t>(rx_seq_ + 1) && unacked() >= WINDOW)
+            {
+                //No room for the response, the host resends it after its timeout
+                break;
+            }
+            if (header.seq == static_cast<uint8_t>(rx_seq_ + 1))
+            {
+                rx_seq_ = header.seq;
+                handle_command(payload, header.len);
+                queue_frame(WebAppFrame::Type::ACK, 0, nullptr, 0);
+            }
+            else if (static_cast<uint8_t>(rx_seq_ - header.seq) < WINDOW)
+            {
+                //Already handled, the ACK was lost
+                queue_frame(WebAppFrame::Type::ACK, 0, nullptr, 0);
+            }
+            else
+            {
+                queue_frame(WebAppFrame::Type::NAK, 0, nullptr, 0);
+            }
+            break;
+
+        case WebAppFrame::Type::NAK:
+            retransmit();
+            break;
+
+        default:
+            break;
+    }
+}
+
+//Frames already in the tx fifo still go out, the host ignores them until its SYNC comes back
+void WebAppProtocol::start_session()
+{
+    framed_ = true;
+    profile_pending_ = false;
+    rx_seq_ = 0;
+    tx_seq_ = 0;
+    tx_acked_ = 0;
+    bank_tx_active_ = false;
+    bank_rx_len_ = 0;
+    telemetry_ = TelemetryConfig();
+}
+
+void WebAppProtocol::receive_packet(uint8_t byte)
+{
+    //A delimiter can't start a legacy packet (packet_len is 64), the host is switching to frames
+    if (rx_len_ == 0 && byte == WebAppFrame::DELIMITER)
+    {
+        OGXM_LOG("WebApp framed session started\n");
+        start_session();
+        decoder_.reset();
+        return;
+    }
+    //Nothing else can start one either, skip ahead to the next packet or delimiter
+    if (rx_len_ == 0 && byte != sizeof(Packet))
+    {
+        return;
+    }
+
+    reinterpret_cast<uint8_t*>(&rx_packet_)[rx_len_++] = byte;
+    if (rx_len_ == sizeof(Packet))
+    {
+        rx_len_ = 0;
+        handle_packet(rx_packet_);
+    }
+}
+
+void WebAppProtocol::receive_frame(uint8_t byte)
+{
+    if (decoder_.push(byte))
+    {
+        handle_frame(decoder_.header(), decoder_.payload());
+    }
+}
+
+void WebAppProtocol::receive()
+{
+    if (!tud_cdc_connected())
+    {
+        return;
+    }
+
+    //Stop while a response might not fit, the rest stays buffered by tusb
+    while (can_respond())
+    {
+        if (rx_buffer_idx_ >= rx_buffer_len_)
+        {
+            rx_buffer_idx_ = 0;
+            rx_buffer_len_ = tud_cdc_available() ? tud_cdc_read(rx_buffer_.data(), rx_buffer_.size()) : 0;
+            if (rx_buffer_len_ == 0)
+            {
+                break;
+            }
+        }
+
+        uint8_t byte = rx_buffer_[rx_buffer_idx_++];
+        if (framed_)
+        {
+            receive_frame(byte);
+        }
+        else
+        {
+            receive_packet(byte);
+        }
+    }
+    send_bank();
+    write_queued();
+}
+
+void WebAppProtocol::process(const uint8_t idx, Gamepad& gamepad)
+{
+    if (store_pending_)
+    {
+        store_pending_profile();
+    }
+
+    //Profiles stored without a reboot take effect here, even once the port has closed
+    if (idx < MAX_GAMEPADS && (profiles_changed_ & (1U << idx)))
+    {
+        profiles_changed_ &= static_cast<uint8_t>(~(1U << idx));
+        gamepad.set_profile(user_settings_.get_profile_by_index(idx));
+    }
+
+    if (!tud_cdc_connected())
+    {
+        if (framed_ || rx_len_ || tx_count_ || profile_pending_)
+        {
+            reset();
+            //Whatever the closed session left unread, e.g. its last ACKs, would misalign the next one
+            tud_cdc_read_flush();
+        }
+        return;
+    }
+
+    receive();
+
+    if (framed_ && unacked() > 0 &&
+        (ms_since_boot() - tx_sent_ms_) >= RETRANSMIT_MS)
+    {
+        retransmit();
+    }
+
+    if (idx < MAX_GAMEPADS && (telemetry_.gamepad_mask & (1U << idx)))
+    {
+        send_telemetry(idx, gamepad);
+    }
+    //Stream input between requests, peek so a device driver sharing the gamepad still sees new_pad_in()
+    else if (idx < MAX_GAMEPADS && rx_len_ == 0 && !profile_pending_ && tx_free() >= TX_RESERVE)
+    {
+        Gamepad::PadIn pad_in = gamepad.peek_pad_in();
+        if (std::memcmp(&pad_in, &pad_in_sent_[idx], sizeof(Gamepad::PadIn)) != 0)
+        {
+            pad_in_sent_[idx] = pad_in;
+            send_gamepad(idx, pad_in);
+        }
+    }
+
+    write_queued();
+}
@@ -0,0 +1,206 @@
+#ifndef _WEBAPP_PROTOCOL_H_
+#define _WEBAPP_PROTOCOL_H_
+
+#include <cstdint>
+#include <array>
+#include <algorithm>
+
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/UserSettings.h"
+#include "UserSettings/UserProfile.h"
+#include "UserSettings/ProfileBank.h"
+#include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppFrame.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppCommands.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppTelemetry.h"
+
+/*  WebApp protocol over CDC, used by WebAppDevice and by the config interface of
+    composite drivers. Nothing here waits on the host: received data is handled as it
+    arrives, responses go into a tx fifo that's written out as the CDC fifo frees up,
+    and reading stops (leaving data with tusb) while there's no room for a response.
+
+    Two wire formats are accepted:
+    - Legacy: fixed 64 byte packets, a profile split into chunks over several packets.
+    - Framed: a 0x00 at a packet boundary switches the session to WebAppFrame frames.
+      The host then sends a SYNC and waits for its echo, which starts the session over
+      from whatever state a previous host left behind. Commands (WebAppCommands.h) are
+      DATA frames holding a CommandHeader and its data, the first one after a SYNC has seq 1. Each side acknowledges DATA frames in order
+      and may have WINDOW of them unacknowledged, input is pushed as EVENT frames. The session
+      returns to legacy packets when the port is closed or DTR changes. SET_PROFILE stores and applies the
+      profile without a reboot here, a legacy store still reboots the way the WebApp expects.
+      The framed store is only latched by the rx path and written by process(), which then
+      sends the response, nothing more is read until then.
+
+    Bulk transfer (framed only): the whole ProfileBank moves as BANK_DATA chunks, each
+    holding a BankChunk and up to BANK_CHUNK_LEN bytes of the image, followed by a
+    BANK_COMMIT with the image length and CRC32. GET_BANK streams it to the host as the
+    window frees up. The host sends the same sequence to replace every profile, the image
+    is staged in RAM and only written (in one flash write) once the commit checks out,
+    the device echoes the BANK_COMMIT when it's stored.
+
+    Telemetry (framed only): TELEMETRY_START subscribes the gamepads in its mask, each
+    new input sample is then pushed as a TELEMETRY event in the WebAppTelemetry format
+    instead of SET_GP_IN. Samples are skipped, and counted as dropped, while the tx fifo
+    is backed up or min_interval_us hasn't passed, so the stream settles at whatever
+    rate the host reads it. */
+class WebAppProtocol
+{
+public:
+    //driver_type is reported to the WebApp in each response
+    WebAppProtocol(DeviceDriverType driver_type)
+        : driver_type_(driver_type) {}
+
+    //Call from tud_cdc_rx_cb(), also called by process() to resume after backpressure
+    void receive();
+    //Call from the device loop, returns immediately if the CDC port isn't open
+    void process(const uint8_t idx, Gamepad& gamepad);
+    //Call from tud_cdc_line_state_cb(), a host opening or closing the port ends the session
+    void line_state_changed(bool connected);
+    void reset();
+
+private:
+    using PacketID = WebAppCommands::PacketID;
+    using CommandHeader = WebAppCommands::CommandHeader;
+    using BankChunk = WebAppCommands::BankChunk;
+    using BankCommit = WebAppCommands::BankCommit;
+    using TelemetryConfig = WebAppCommands::TelemetryConfig;
+
+    #pragma pack(push, 1)
+    struct PacketHeader
+    {
+        uint8_t packet_len{64};
+        PacketID packet_id{PacketID::NONE};
+        DeviceDriverType device_driver{DeviceDriverType::WEBAPP};
+        uint8_t max_gamepads{MAX_GAMEPADS};
+        uint8_t player_idx{0};
+        uint8_t profile_id{0};
+        uint8_t chunks_total{0};
+        uint8_t chunk_idx{0};
+        uint8_t chunk_len{0};
+    };
+    static_assert(sizeof(PacketHeader) == 9, "WebApp report size mismatch");
+
+    struct Packet
+    {
+        PacketHeader header;
+        std::array<uint8_t, 64 - sizeof(PacketHeader)> data{0};
+    };
+    static_assert(sizeof(Packet) == 64, "WebApp report size mismatch");
+
+    #pragma pack(pop)
+
+    static_assert(sizeof(CommandHeader) + sizeof(UserProfile) <= WebAppFrame::MAX_PAYLOAD, "UserProfile doesn't fit a frame");
+
+    static constexpr size_t CHUNK_LEN = sizeof(Packet::data);
+    static constexpr uint8_t PROFILE_CHUNKS = static_cast<uint8_t>((sizeof(UserProfile) + CHUNK_LEN - 1) / CHUNK_LEN);
+
+    static constexpr size_t BANK_CHUNK_LEN = WebAppCommands::BANK_CHUNK_LEN;
+
+    static constexpr uint8_t WINDOW = WebAppFrame::WINDOW;
+    static constexpr uint32_t RETRANSMIT_MS = WebAppFrame::RETRANSMIT_MS;
+    //A full window plus an ACK, an input event and a response
+    static constexpr size_t TX_FIFO_LEN = WebAppFrame::MAX_ENCODED * (WINDOW + 3);
+    //Room needed before handling a request, the largest response and an ACK
+    static constexpr size_t TX_RESERVE = std::max(PROFILE_CHUNKS * sizeof(Packet), WebAppFrame::MAX_ENCODED * 2);
+
+    struct TxFrame
+    {
+        uint8_t len{0};
+        std::array<uint8_t, WebAppFrame::MAX_PAYLOAD> payload;
+    };
+
+    const DeviceDriverType driver_type_;
+    UserSettings& user_settings_{UserSettings::get_instance()};
+
+    std::array<uint8_t, 64> rx_buffer_;
+    size_t rx_buffer_len_{0};
+    size_t rx_buffer_idx_{0};
+
+    //Legacy packets
+    Packet rx_packet_;
+    size_t rx_len_{0};
+
+    //Profile being received after SET_PROFILE_START
+    bool profile_pending_{false};
+    PacketHeader profile_header_;
+    UserProfile profile_;
+    uint8_t profile_chunks_{0};
+    uint8_t profile_chunk_idx_{0};
+    size_t profile_offset_{0};
+
+    //Framed session
+    bool framed_{false};
+    WebAppFrame::Decoder decoder_;
+    uint8_t rx_seq_{0};     //Last in-order DATA seq received
+    uint8_t tx_seq_{0};     //Last DATA seq sent
+    uint8_t tx_acked_{0};   //Last DATA seq the host acknowledged
+    uint32_t tx_sent_ms_{0};
+    std::array<TxFrame, WINDOW> tx_window_;
+
+    //Bulk transfer, bank_tx_offset_ is past the end once the commit has been sent
+    bool bank_tx_active_{false};
+    size_t bank_tx_offset_{0};
+    ProfileBank bank_rx_;
+    size_t bank_rx_len_{0};
+    //Gamepads that haven't picked up a newly stored bank or profile yet
+    uint8_t profiles_changed_{0};
+
+    //Framed SET_PROFILE waiting for process() to store it, store_reply_ is cleared if the session ends first
+    bool store_pending_{false};
+    bool store_reply_{false};
+    DeviceDriverType store_driver_{DeviceDriverType::NONE};
+    uint8_t store_index_{0};
+
+    struct TelemetryState
+    {
+        WebAppTelemetry::Sample sent;
+        uint32_t count{0};      //Gamepad sample count last seen
+        uint32_t sent_us{0};
+        uint8_t seq{0};
+        uint8_t dropped{0};
+    };
+
+    TelemetryConfig telemetry_;
+    std::array<TelemetryState, MAX_GAMEPADS> telemetry_state_;
+
+    std::array<uint8_t, TX_FIFO_LEN> tx_fifo_;
+    size_t tx_head_{0};
+    size_t tx_count_{0};
+
+    //Last input sent for each gamepad
+    std::array<Gamepad::PadIn, MAX_GAMEPADS> pad_in_sent_;
+
+    void start_session();
+    void receive_packet(uint8_t byte);
+    void receive_frame(uint8_t byte);
+
+    void handle_packet(const Packet& packet);
+    void handle_profile_chunk(const Packet& packet);
+    void handle_frame(const WebAppFrame::Header& header, const uint8_t* payload);
+    void handle_command(const uint8_t* payload, size_t len);
+    bool store_profile(DeviceDriverType driver_type, uint8_t index, const UserProfile& profile);
+    void store_pending_profile();
+    void handle_bank_chunk(const uint8_t* data, size_t len);
+    void handle_bank_commit(const uint8_t* data, size_t len);
+
+    bool queue_bytes(const void* data, size_t len);
+    bool queue_chunked(PacketHeader header, const void* data, size_t len);
+    bool queue_frame(WebAppFrame::Type type, uint8_t seq, const void* payload, size_t len);
+    bool send_data(const void* payload, size_t len);
+    bool send_command(PacketID packet_id, uint8_t player_idx, uint8_t profile_id, const void* data, size_t len, bool reliable = true);
+    void send_error();
+    void send_profile(uint8_t index, const UserProfile& profile, PacketID packet_id);
+    void send_gamepad(uint8_t index, const Gamepad::PadIn& pad_in);
+    void send_bank();
+    void send_telemetry(uint8_t index, Gamepad& gamepad);
+    void release_acked(uint8_t ack);
+    void retransmit();
+    void write_queued();
+
+    inline size_t tx_free() const { return TX_FIFO_LEN - tx_count_; }
+    inline uint8_t unacked() const { return static_cast<uint8_t>(tx_seq_ - tx_acked_); }
+    //ACKs must still be read while the window is full, a DATA frame that can't be answered is dropped
+    inline bool can_respond() const { return tx_free() >= TX_RESERVE && !store_pending_; }
+};
+
+#endif // _WEBAPP_PROTOCOL_H_
@@ -0,0 +1,128 @@
+#ifndef _WEBAPP_TELEMETRY_H_
+#define _WEBAPP_TELEMETRY_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+
+/*  Wire format of the WebApp input telemetry stream. Each TELEMETRY event carries a
+    Header and the fields of a Sample that changed since the previous event for that
+    gamepad, in field order. Events are unreliable, a gap in seq means the decoded
+    sample may be stale until the next key event (all fields set), which is sent
+    every KEY_INTERVAL events. Nothing here depends on the firmware, host tools can
+    include it as is. */
+namespace WebAppTelemetry
+{
+    static constexpr uint8_t KEY_INTERVAL = 64;
+
+    #pragma pack(push, 1)
+    struct Sample
+    {
+        //Before joystick and trigger settings
+        int16_t  raw_joystick_lx{0};
+        int16_t  raw_joystick_ly{0};
+        int16_t  raw_joystick_rx{0};
+        int16_t  raw_joystick_ry{0};
+        uint8_t  raw_trigger_l{0};
+        uint8_t  raw_trigger_r{0};
+        //As sent to the console
+        uint8_t  dpad{0};
+        uint16_t buttons{0};
+        uint8_t  trigger_l{0};
+        uint8_t  trigger_r{0};
+        int16_t  joystick_lx{0};
+        int16_t  joystick_ly{0};
+        int16_t  joystick_rx{0};
+        int16_t  joystick_ry{0};
+        std::array<uint8_t, 10> analog{0};
+        int16_t  accel_x{0};
+    };
+    static_assert(sizeof(Sample) == 35, "WebAppTelemetry::Sample size mismatch");
+
+    struct Header
+    {
+        uint32_t time_us{0};    //When the input arrived from the controller
+        uint16_t fields{0};     //Bit per entry in FIELDS present in the event
+        uint8_t  seq{0};
+        uint8_t  dropped{0};    //Samples skipped since the last event, saturates at 255
+    };
+    static_assert(sizeof(Header) == 8, "WebAppTelemetry::Header size mismatch");
+    #pragma pack(pop)
+
+    struct Field
+    {
+        uint8_t offset;
+        uint8_t len;
+    };
+
+    static constexpr std::array<Field, 16> FIELDS =
+    {{
+        { offsetof(Sample, raw_joystick_lx), 2 },
+        { offsetof(Sample, raw_joystick_ly), 2 },
+        { offsetof(Sample, raw_joystick_rx), 2 },
+        { offsetof(Sample, raw_joystick_ry), 2 },
+        { offsetof(Sample, raw_trigger_l),   1 },
+        { offsetof(Sample, raw_trigger_r),   1 },
+        { offsetof(Sample, dpad),            1 },
+        { offsetof(Sample, buttons),         2 },
+        { offsetof(Sample, trigger_l),       1 },
+        { offsetof(Sample, trigger_r),       1 },
+        { offsetof(Sample, joystick_lx),     2 },
+        { offsetof(Sample, joystick_ly),     2 },
+        { offsetof(Sample, joystick_rx),     2 },
+        { offsetof(Sample, joystick_ry),     2 },
+        { offsetof(Sample, analog),          10 },
+        { offsetof(Sample, accel_x),         2 },
+    }};
+
+    static constexpr uint16_t ALL_FIELDS = 0xFFFF;
+
+    //Writes the fields of sample that differ from prev (or all of them if key) to out
+    //(sizeof(Sample) bytes), returns their length and sets fields, 0 if nothing changed
+    static inline size_t encode_delta(const Sample& sample, const Sample& prev, bool key, uint16_t& fields, uint8_t* out)
+    {
+        const uint8_t* cur_ptr = reinterpret_cast<const uint8_t*>(&sample);
+        const uint8_t* prev_ptr = reinterpret_cast<const uint8_t*>(&prev);
+        size_t len = 0;
+        fields = 0;
+
+        for (size_t i = 0; i < FIELDS.size(); ++i)
+        {
+            const Field& field = FIELDS[i];
+            if (key || std::memcmp(cur_ptr + field.offset, prev_ptr + field.offset, field.len) != 0)
+            {
+                std::memcpy(out + len, cur_ptr + field.offset, field.len);
+                len += field.len;
+                fields |= static_cast<uint16_t>(1U << i);
+            }
+        }
+        return len;
+    }
+
+    //Applies the fields of an event to sample, false if len doesn't match fields
+    static inline bool apply_delta(Sample& sample, uint16_t fields, const uint8_t* data, size_t len)
+    {
+        uint8_t* sample_ptr = reinterpret_cast<uint8_t*>(&sample);
+        size_t offset = 0;
+
+        for (size_t i = 0; i < FIELDS.size(); ++i)
+        {
+            if (!(fields & (1U << i)))
+            {
+                continue;
+            }
+            const Field& field = FIELDS[i];
+            if (offset + field.len > len)
+            {
+                return false;
+            }
+            std::memcpy(sample_ptr + field.offset, data + offset, field.len);
+            offset += field.len;
+        }
+        return offset == len;
+    }
+
+} // namespace WebAppTelemetry
+
+#endif // _WEBAPP_TELEMETRY_H_
@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <cstring>
+
 #include "tusb.h"
+#include "class/cdc/cdc_device.h"
 
 #include "Board/Config.h"
+#include "Board/board_api.h"
+#include "Board/ogxm_log.h"
+#include "DriverSlot.h"
 #include "USBDevice/DeviceDriver/DInput/DInput.h"
 #include "USBDevice/DeviceDriver/DS4/DS4.h"
 #include "USBDevice/DeviceDriver/PS3/PS3.h"
@@ -21,6 +28,18 @@
 #include "USBDevice/DeviceDriver/UARTBridge/UARTBridge.h"
 #endif // defined(CONFIG_EN_UART_BRIDGE)
 
+// Storage for whichever device driver is running, switching drivers reuses it
+using DeviceDriverSlot =
+    DriverSlot<DeviceDriver, DInputDevice, PS3Device, DS4Device, PSClassicDevice,
+               SwitchDevice, XInputDevice, XInputGuitar360Device, XboxOGDevice,
+               XboxOGSBDevice, XboxOneDevice, XboxOGXRDevice, WebAppDevice
+#if defined(CONFIG_EN_UART_BRIDGE)
+               , UARTBridgeDevice
+#endif // defined(CONFIG_EN_UART_BRIDGE)
+               >;
+
+static DeviceDriverSlot _device_driver;
+
 void DeviceManager::initialize_driver(DeviceDriverType driver_type,
                                       Gamepad (&gamepads)[MAX_GAMEPADS]) {
   // TODO: Put gamepad setup in the drivers themselves
@@ -29,55 +48,57 @@ void DeviceManager::initialize_driver(DeviceDriverType driver_type,
   switch (driver_type) {
   case DeviceDriverType::DINPUT:
     has_analog = true;
-    device_driver_ = std::make_unique<DInputDevice>();
+    device_driver_ = _device_driver.emplace<DInputDevice>();
     break;
   case DeviceDriverType::PS3:
     has_analog = true;
-    device_driver_ = std::make_unique<PS3Device>();
+    device_driver_ = _device_driver.emplace<PS3Device>();
     break;
 
   case DeviceDriverType::DS4:
     has_analog = true;
-    device_driver_ = std::make_unique<DS4Device>();
+    device_driver_ = _device_driver.emplace<DS4Device>();
     break;
   case DeviceDriverType::PSCLASSIC:
-    device_driver_ = std::make_unique<PSClassicDevice>();
+    device_driver_ = _device_driver.emplace<PSClassicDevice>();
     break;
   case DeviceDriverType::SWITCH:
-    device_driver_ = std::make_unique<SwitchDevice>();
+    device_driver_ = _device_driver.emplace<SwitchDevice>();
     break;
   case DeviceDriverType::XINPUT:
-    device_driver_ = std::make_unique<XInputDevice>();
+    device_driver_ = _device_driver.emplace<XInputDevice>();
     break;
   case DeviceDriverType::XINPUT_GUITAR_360:
-    device_driver_ = std::make_unique<XInputGuitar360Device>();
+    device_driver_ = _device_driver.emplace<XInputGuitar360Device>();
     break;
 
   case DeviceDriverType::XBOXOG:
     has_analog = true;
-    device_driver_ = std::make_unique<XboxOGDevice>();
+    device_driver_ = _device_driver.emplace<XboxOGDevice>();
     break;
   case DeviceDriverType::XBOXOG_SB:
-    device_driver_ = std::make_unique<XboxOGSBDevice>();
+    device_driver_ = _device_driver.emplace<XboxOGSBDevice>();
     break;
   case DeviceDriverType::XBOXONE:
-    device_driver_ = std::make_unique<XboxOneDevice>();
+    device_driver_ = _device_driver.emplace<XboxOneDevice>();
     break;
   case DeviceDriverType::XBOXOG_XR:
-    device_driver_ = std::make_unique<XboxOGXRDevice>();
+    device_driver_ = _device_driver.emplace<XboxOGXRDevice>();
     break;
   case DeviceDriverType::WEBAPP:
-    device_driver_ = std::make_unique<WebAppDevice>();
+    device_driver_ = _device_driver.emplace<WebAppDevice>();
     break;
 #if defined(CONFIG_EN_UART_BRIDGE)
   case DeviceDriverType::UART_BRIDGE:
-    device_driver_ = std::make_unique<UARTBridgeDevice>();
+    device_driver_ = _device_driver.emplace<UARTBridgeDevice>();
     break;
 #endif // defined(CONFIG_EN_UART_BRIDGE)
   default:
     return;
   }
 
+  driver_type_ = driver_type;
+
   if (has_analog) {
     for (size_t i = 0; i < MAX_GAMEPADS; ++i) {
       gamepads[i].set_analog_device(true);
@@ -85,4 +106,175 @@ void DeviceManager::initialize_driver(DeviceDriverType driver_type,
   }
 
   device_driver_->initialize();
-}
\ No newline at end of file
+
+#if defined(CONFIG_EN_CONFIG_ITF)
+  composite_ = device_driver_->supports_config_itf() && build_composite();
+#endif // defined(CONFIG_EN_CONFIG_ITF)
+
+  if (composite_ || driver_type == DeviceDriverType::WEBAPP) {
+    config_protocol_.emplace(driver_type);
+  }
+}
+
+// Appends a CDC interface to the driver's configuration, it takes the next two
+// interface numbers and the endpoints after the highest one the driver uses
+bool DeviceManager::build_composite() {
+  const uint8_t *desc_config = device_driver_->get_descriptor_configuration_cb(0);
+  const uint8_t *desc_device = device_driver_->get_descriptor_device_cb();
+  if (!desc_config || !desc_device) {
+    return false;
+  }
+
+  tusb_desc_configuration_t config;
+  std::memcpy(&config, desc_config, sizeof(config));
+  const uint16_t config_len = tu_le16toh(config.wTotalLength);
+
+  uint8_t ep_max = 0;
+  for (uint16_t offset = 0; offset < config_len; offset += desc_config[offset]) {
+    if (desc_config[offset] == 0) {
+      return false;
+    }
+    if (desc_config[offset + 1] == TUSB_DESC_ENDPOINT) {
+      ep_max = std::max(ep_max, static_cast<uint8_t>(desc_config[offset + 2] & 0x0F));
+    }
+  }
+
+  const uint8_t itf = config.bNumInterfaces;
+  const uint8_t ep_notif = static_cast<uint8_t>(0x80 | (ep_max + 1));
+  const uint8_t ep_out = static_cast<uint8_t>(ep_max + 2);
+  const uint8_t ep_in = static_cast<uint8_t>(0x80 | ep_out);
+  const uint8_t desc_cdc[] = {
+      TUD_CDC_DESCRIPTOR(itf, 0, ep_notif, 8, ep_out, ep_in, 64)};
+
+  if (ep_out > 15 || config_len + sizeof(desc_cdc) > composite_desc_config_.size()) {
+    OGXM_LOG("Config interface doesn't fit the driver's descriptors\n");
+    return false;
+  }
+
+  std::memcpy(composite_desc_config_.data(), desc_config, config_len);
+  std::memcpy(composite_desc_config_.data() + config_len, desc_cdc, sizeof(desc_cdc));
+
+  config.wTotalLength = tu_htole16(static_cast<uint16_t>(config_len + sizeof(desc_cdc)));
+  config.bNumInterfaces = itf + 2;
+  std::memcpy(composite_desc_config_.data(), &config, sizeof(config));
+
+  // The CDC function is bound through an IAD, which needs the misc class triplet
+  std::memcpy(&composite_desc_device_, desc_device, sizeof(tusb_desc_device_t));
+  if (composite_desc_device_.bcdUSB < 0x0200) {
+    composite_desc_device_.bcdUSB = 0x0200;
+  }
+  composite_desc_device_.bDeviceClass = TUSB_CLASS_MISC;
+  composite_desc_device_.bDeviceSubClass = MISC_SUBCLASS_COMMON;
+  composite_desc_device_.bDeviceProtocol = MISC_PROTOCOL_IAD;
+
+  class_drivers_[0] = *device_driver_->get_class_driver();
+  class_drivers_[1] = {
+    .name = TUD_DRV_NAME("CONFIG"),
+    .init = cdcd_init,
+    .deinit = cdcd_deinit,
+    .reset = cdcd_reset,
+    .open = cdcd_open,
+    .control_xfer_cb = cdcd_control_xfer_cb,
+    .xfer_cb = cdcd_xfer_cb,
+    .sof = NULL
+  };
+  return true;
+}
+
+void DeviceManager::process(const uint8_t idx, Gamepad &gamepad) {
+  device_driver_->process(idx, gamepad);
+
+  // Runs after the gamepad report is queued and never waits on the host
+  if (config_protocol_) {
+    config_protocol_->process(idx, gamepad);
+  }
+}
+
+void DeviceManager::cdc_rx_cb() {
+  if (config_protocol_) {
+    config_protocol_->receive();
+  }
+}
+
+void DeviceManager::cdc_line_state_cb(bool dtr) {
+  if (config_protocol_) {
+    config_protocol_->line_state_changed(dtr);
+  }
+}
+
+const usbd_class_driver_t *DeviceManager::get_class_drivers(uint8_t *driver_count) {
+  if (composite_) {
+    *driver_count = 2;
+    return class_drivers_;
+  }
+  *driver_count = 1;
+  return device_driver_->get_class_driver();
+}
+
+const uint8_t *DeviceManager::get_descriptor_device() {
+  if (composite_) {
+    return reinterpret_cast<const uint8_t *>(&composite_desc_device_);
+  }
+  return device_driver_->get_descriptor_device_cb();
+}
+
+const uint8_t *DeviceManager::get_descriptor_configuration(uint8_t index) {
+  if (composite_) {
+    return composite_desc_config_.data();
+  }
+  return device_driver_->get_descriptor_configuration_cb(index);
+}
+
+// Detaches from the console, tears down the class driver and brings up the new
+// one in place. The host side and core1 keep running.
+bool DeviceManager::switch_driver(DeviceDriverType driver_type,
+                                  Gamepad (&gamepads)[MAX_GAMEPADS]) {
+  if (device_driver_ && driver_type == driver_type_) {
+    return false;
+  }
+
+  OGXM_LOG("Switching device driver to: " + OGXM_TO_STRING(driver_type) +
+           "\n");
+
+  const bool tud_was_inited = tud_inited();
+  switch_start_ms_ = board_api::ms_since_boot();
+
+  if (tud_was_inited) {
+    tud_disconnect();
+    sleep_ms(REATTACH_DELAY_MS);
+    // Resets class drivers and endpoints, usbd_app_driver_get_cb() is queried
+    // again by tud_init()
+    tud_deinit(BOARD_TUD_RHPORT);
+  }
+
+  _device_driver.reset();
+  device_driver_ = nullptr;
+  config_protocol_.reset();
+  composite_ = false;
+
+  for (size_t i = 0; i < MAX_GAMEPADS; ++i) {
+    gamepads[i].set_analog_device(false);
+    gamepads[i].reset_pad_out();
+  }
+
+  initialize_driver(driver_type, gamepads);
+
+  if (!device_driver_) {
+    OGXM_LOG("Device driver switch failed\n");
+    return false;
+  }
+
+  if (tud_was_inited) {
+    switch_pending_ = true;
+    tud_init(BOARD_TUD_RHPORT);
+  }
+  return true;
+}
+
+void DeviceManager::mounted() {
+  if (switch_pending_) {
+    switch_pending_ = false;
+    switch_time_ms_ = board_api::ms_since_boot() - switch_start_ms_;
+    OGXM_LOG("Device driver switched in %u ms\n", switch_time_ms_);
+  }
+}
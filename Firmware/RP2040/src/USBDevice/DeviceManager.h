@@ -2,10 +2,12 @@
 #define _DEVICE_MANAGER_H_
 
 #include <cstdint>
-#include <memory>
+#include <array>
+#include <optional>
 
 #include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
 #include "USBDevice/DeviceDriver/DeviceDriver.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppProtocol.h"
 
 class DeviceManager {
 public:
@@ -19,14 +21,58 @@ public:
 
 	//Must be called before any other method
 	void initialize_driver(DeviceDriverType driver_type, Gamepad(&gamepads)[MAX_GAMEPADS]);
+
+	//Replaces the running driver without a reboot, call from core0
+	bool switch_driver(DeviceDriverType driver_type, Gamepad(&gamepads)[MAX_GAMEPADS]);
+
+	//Called by tusb when the device has been enumerated
+	void mounted();
+
+	//Runs the driver for one gamepad, then the config interface if there is one
+	void process(const uint8_t idx, Gamepad& gamepad);
+
+	//Called by tusb when the config interface has received data
+	void cdc_rx_cb();
+	//Called by tusb when the host opens or closes it
+	void cdc_line_state_cb(bool dtr);
+
+	//Class drivers and descriptors handed to tusb, these include 
+	//the config interface when the driver runs as a composite device
+	const usbd_class_driver_t* get_class_drivers(uint8_t* driver_count);
+	const uint8_t* get_descriptor_device();
+	const uint8_t* get_descriptor_configuration(uint8_t index);
 	
-	DeviceDriver* get_driver() { return device_driver_.get(); }
+	DeviceDriver* get_driver() { return device_driver_; }
+	DeviceDriverType get_driver_type() const { return driver_type_; }
+
+	//Time from the last switch_driver() call until the console enumerated the new driver
+	uint32_t get_switch_time_ms() const { return switch_time_ms_; }
 	
 private:
+	//Time the console gets to see the device detached before it reappears
+	static constexpr uint32_t REATTACH_DELAY_MS = 50;
+
     DeviceManager() = default;
 	~DeviceManager() = default;
 
-	std::unique_ptr<DeviceDriver> device_driver_{nullptr};
+	//Lives in DeviceManager.cpp's driver storage, nullptr until initialize_driver()
+	DeviceDriver* device_driver_{nullptr};
+	DeviceDriverType driver_type_{DeviceDriverType::NONE};
+
+	static constexpr size_t CONFIG_DESC_MAX_LEN = 512;
+
+	//Driver descriptors with a CDC config interface appended
+	bool composite_{false};
+	usbd_class_driver_t class_drivers_[2];
+	tusb_desc_device_t composite_desc_device_;
+	std::array<uint8_t, CONFIG_DESC_MAX_LEN> composite_desc_config_;
+	std::optional<WebAppProtocol> config_protocol_;
+
+	bool build_composite();
+
+	uint32_t switch_start_ms_{0};
+	uint32_t switch_time_ms_{0};
+	bool switch_pending_{false};
 };
 
 #endif // _DEVICE_MANAGER_H_
\ No newline at end of file
@@ -8,8 +8,22 @@
 
 const usbd_class_driver_t *usbd_app_driver_get_cb(uint8_t *driver_count) 
 {
-	*driver_count = 1;
-	return DeviceManager::get_instance().get_driver()->get_class_driver();
+	return DeviceManager::get_instance().get_class_drivers(driver_count);
+}
+
+void tud_mount_cb() 
+{
+	DeviceManager::get_instance().mounted();
+}
+
+void tud_cdc_rx_cb(uint8_t itf) 
+{
+	DeviceManager::get_instance().cdc_rx_cb();
+}
+
+void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts) 
+{
+	DeviceManager::get_instance().cdc_line_state_cb(dtr);
 }
 
 uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen) 
@@ -35,7 +49,7 @@ uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid)
 
 uint8_t const *tud_descriptor_device_cb() 
 {
-	return DeviceManager::get_instance().get_driver()->get_descriptor_device_cb();
+	return DeviceManager::get_instance().get_descriptor_device();
 }
 
 uint8_t const *tud_hid_descriptor_report_cb(uint8_t itf) 
@@ -45,7 +59,7 @@ uint8_t const *tud_hid_descriptor_report_cb(uint8_t itf)
 
 uint8_t const *tud_descriptor_configuration_cb(uint8_t index) 
 {
-	return DeviceManager::get_instance().get_driver()->get_descriptor_configuration_cb(index);
+	return DeviceManager::get_instance().get_descriptor_configuration(index);
 }
 
 uint8_t const* tud_descriptor_device_qualifier_cb() 
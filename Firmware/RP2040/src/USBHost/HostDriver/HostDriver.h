@@ -24,9 +24,20 @@ public:
   virtual void process_report(Gamepad &gamepad, uint8_t address,
                               uint8_t instance, const uint8_t *report,
                               uint16_t len) = 0;
+  // Returns false if nothing could be queued, HostManager tries again later.
+  // Must not block or run tuh_task()
   virtual bool send_feedback(Gamepad &gamepad, uint8_t address,
                              uint8_t instance) = 0;
 
+  // How HostManager schedules send_feedback(): no more often than
+  // min_interval_ms, and while rumble is on again every keepalive_ms even if
+  // the PadOut didn't change (0 = only on change)
+  struct FeedbackTiming {
+    uint32_t min_interval_ms{0};
+    uint32_t keepalive_ms{0};
+  };
+  virtual FeedbackTiming feedback_timing() const { return FeedbackTiming(); }
+
   virtual void connect_cb(Gamepad &gamepad, uint8_t address, uint8_t instance) {
   }; // Wireless specific
   virtual void disconnect_cb(Gamepad &gamepad, uint8_t address,
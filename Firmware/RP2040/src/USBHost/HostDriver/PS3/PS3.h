@@ -23,6 +23,8 @@ public:
                       const uint8_t *report, uint16_t len) override;
   bool send_feedback(Gamepad &gamepad, uint8_t address,
                      uint8_t instance) override;
+  // Spamming set_report doesn't work, limit the rate
+  FeedbackTiming feedback_timing() const override { return {300, 0}; }
 
 private:
   enum class InitStage { RESP1, RESP2, RESP3, DONE };
@@ -46,6 +48,7 @@ private:
                                 uint8_t *buffer, tuh_xfer_cb_t complete_cb,
                                 uintptr_t user_data);
   static void get_report_complete_cb(tuh_xfer_s *xfer);
+  static void rumble_complete_cb(tuh_xfer_s *xfer);
 };
 
 #endif // _PS3_HOST_H_
\ No newline at end of file
@@ -201,25 +201,24 @@ void PS3V2Host::process_report(Gamepad &gamepad, uint8_t address,
 
 bool PS3V2Host::send_feedback(Gamepad &gamepad, uint8_t address,
                               uint8_t instance) {
-  static uint32_t last_rumble_ms = 0;
+  // Not ready yet, HostManager tries again on its next pass
+  if (!init_state_.reports_enabled) {
+    return false;
+  }
 
-  uint32_t current_ms = time_us_32() / 1000;
+  Gamepad::PadOut gp_out = gamepad.get_pad_out();
 
-  // Spamming set_report doesn't work, limit the rate
-  if (init_state_.reports_enabled && current_ms - last_rumble_ms >= 300) {
-    Gamepad::PadOut gp_out = gamepad.get_pad_out();
+  out_report_.rumble.right_duration = (gp_out.rumble_r > 0) ? 20 : 0;
+  out_report_.rumble.right_motor_on = (gp_out.rumble_r > 0) ? 1 : 0;
 
-    out_report_.rumble.right_duration = (gp_out.rumble_r > 0) ? 20 : 0;
-    out_report_.rumble.right_motor_on = (gp_out.rumble_r > 0) ? 1 : 0;
+  out_report_.rumble.left_duration = (gp_out.rumble_l > 0) ? 20 : 0;
+  out_report_.rumble.left_motor_force = gp_out.rumble_l;
 
-    out_report_.rumble.left_duration = (gp_out.rumble_l > 0) ? 20 : 0;
-    out_report_.rumble.left_motor_force = gp_out.rumble_l;
+  // With a complete callback the transfer is queued instead of waited on
+  return send_control_xfer(address, &PS3V2Host::RUMBLE_REQUEST,
+                           reinterpret_cast<uint8_t *>(&out_report_),
+                           rumble_complete_cb, 0);
+}
 
-    last_rumble_ms = current_ms;
+void PS3V2Host::rumble_complete_cb(tuh_xfer_s *xfer) {}
 
-    return send_control_xfer(address, &PS3V2Host::RUMBLE_REQUEST,
-                             reinterpret_cast<uint8_t *>(&out_report_), nullptr,
-                             0);
-  }
-  return true;
-}
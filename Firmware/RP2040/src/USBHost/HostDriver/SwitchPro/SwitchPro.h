@@ -16,6 +16,8 @@ public:
     void initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len) override;
     void process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len) override;
     bool send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance) override;
+    //The controller lets rumble lapse unless it keeps getting rumble data
+    FeedbackTiming feedback_timing() const override { return { 0, 100 }; }
 
 private:
     enum class InitState
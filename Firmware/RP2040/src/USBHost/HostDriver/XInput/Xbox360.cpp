@@ -7,7 +7,7 @@
 
 void Xbox360Host::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len)
 {
-    tuh_xinput::set_led(address, instance, idx_ + 1, true);
+    tuh_xinput::set_led(address, instance, idx_ + 1);
     tuh_xinput::receive_report(address, instance);
 }
 
@@ -54,5 +54,5 @@ void Xbox360Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t inst
 bool Xbox360Host::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
     Gamepad::PadOut gp_out = gamepad.get_pad_out();
-    return tuh_xinput::set_rumble(address, 0, gp_out.rumble_l, gp_out.rumble_r, false);
+    return tuh_xinput::set_rumble(address, 0, gp_out.rumble_l, gp_out.rumble_r);
 }
\ No newline at end of file
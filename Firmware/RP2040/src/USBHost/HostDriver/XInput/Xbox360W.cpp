@@ -86,7 +86,7 @@ void Xbox360WHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t ins
 bool Xbox360WHost::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
     Gamepad::PadOut gp_out = gamepad.get_pad_out(); 
-    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r, false);
+    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r);
 }
 
 void Xbox360WHost::connect_cb(Gamepad& gamepad, uint8_t address, uint8_t instance)
@@ -97,7 +97,7 @@ void Xbox360WHost::connect_cb(Gamepad& gamepad, uint8_t address, uint8_t instanc
     TaskQueue::Core1::queue_delayed_task(TaskQueue::Core1::get_new_task_id(), 1000, false, 
     [address, instance, this]
     {
-        tuh_xinput::set_led(address, instance, idx_ + 1, false);
+        tuh_xinput::set_led(address, instance, idx_ + 1);
         tuh_xinput::xbox360_chatpad_init(address, instance);
         
         TaskQueue::Core1::queue_delayed_task(tid_chatpad_keepalive_, tuh_xinput::KEEPALIVE_MS, true, 
@@ -112,4 +112,6 @@ void Xbox360WHost::connect_cb(Gamepad& gamepad, uint8_t address, uint8_t instanc
 void Xbox360WHost::disconnect_cb(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
     TaskQueue::Core1::cancel_delayed_task(tid_chatpad_keepalive_);
+    //HostManager leaves the slot neutral, the next pad's first report must not be skipped as a repeat
+    prev_in_report_ = XInput::InReportWireless();
 }
\ No newline at end of file
@@ -69,5 +69,5 @@ void XboxOGHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t insta
 bool XboxOGHost::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
     Gamepad::PadOut gp_out = gamepad.get_pad_out();
-    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r, false);
+    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r);
 }
\ No newline at end of file
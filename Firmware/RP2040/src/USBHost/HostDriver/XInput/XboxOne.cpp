@@ -105,5 +105,5 @@ bool XboxOneHost::send_feedback(Gamepad &gamepad, uint8_t address,
                                 uint8_t instance) {
   Gamepad::PadOut gp_out = gamepad.get_pad_out();
   return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l,
-                                gp_out.rumble_r, false);
+                                gp_out.rumble_r);
 }
\ No newline at end of file
@@ -2,7 +2,6 @@
 
 #if (TUSB_OPT_HOST_ENABLED && CFG_TUH_XINPUT)
 
-#include <chrono>
 #include <cstring>
 
 #include "USBHost/HostDriver/XInput/tuh_xinput/tuh_xinput.h"
@@ -85,21 +84,44 @@ get_itf_by_instance(uint8_t dev_addr, uint8_t instance) {
   return &device->interfaces[instance];
 }
 
-static void std_sleep_ms(uint32_t ms) {
-  auto start = std::chrono::high_resolution_clock::now();
-  while (std::chrono::duration_cast<std::chrono::milliseconds>(
-             std::chrono::high_resolution_clock::now() - start)
-             .count() < ms) {
-    tuh_task();
+// Starts the next queued OUT packet if the endpoint is free. Called again from
+// xfer_cb when it completes, so the queue drains without anyone waiting on it.
+// A packet the stack refuses is dropped and the next one tried, nothing would
+// come back through xfer_cb to start it otherwise. False if one was dropped.
+static bool submit_next_report(uint8_t dev_addr, Interface *interface) {
+  bool submitted = true;
+  while (!interface->out_queue.empty()) {
+    // Busy, the packet in flight will pull this one when it completes
+    if (!usbh_edpt_claim(dev_addr, interface->ep_out)) {
+      return submitted;
+    }
+
+    const uint16_t len =
+        interface->out_queue.pop(interface->ep_out_buffer.data());
+
+    if (usbh_edpt_xfer(dev_addr, interface->ep_out,
+                       interface->ep_out_buffer.data(), len)) {
+      return submitted;
+    }
+    usbh_edpt_release(dev_addr, interface->ep_out);
+    submitted = false;
   }
+  return submitted;
 }
 
-static void wait_for_tx_complete(uint8_t dev_addr, uint8_t ep_addr) {
-  while (usbh_edpt_busy(dev_addr, ep_addr)) {
-    tuh_task();
-  }
+static bool queue_report(uint8_t dev_addr, uint8_t instance,
+                         const uint8_t *buffer, uint16_t len,
+                         OutReportQueue::Priority priority) {
+  Interface *interface = get_itf_by_instance(dev_addr, instance);
+  TU_VERIFY(interface != nullptr && interface->ep_out != INVALID_IDX);
+  TU_VERIFY(interface->out_queue.push(buffer, len, priority));
+  return submit_next_report(dev_addr, interface);
 }
 
+// Keepalives don't need the result, having a callback just keeps
+// tuh_control_xfer from blocking until the transfer is done
+static void ctrl_xfer_complete_cb(tuh_xfer_s *xfer) { (void)xfer; }
+
 bool send_ctrl_xfer(uint8_t dev_addr, const tusb_control_request_t *request,
                     uint8_t *buffer, tuh_xfer_cb_t complete_cb,
                     uintptr_t user_data) {
@@ -112,30 +134,25 @@ bool send_ctrl_xfer(uint8_t dev_addr, const tusb_control_request_t *request,
   return tuh_control_xfer(&transfer);
 }
 
-static void xboxone_init(Interface *interface, uint8_t dev_addr,
-                         uint8_t instance) {
+static void xboxone_init(uint8_t dev_addr, uint8_t instance) {
   uint16_t PID, VID;
   tuh_vid_pid_get(dev_addr, &VID, &PID);
 
+  // Queued in order, each goes out when the one before it completes
   send_report(dev_addr, instance, XboxOne::POWER_ON, sizeof(XboxOne::POWER_ON));
-  wait_for_tx_complete(dev_addr, interface->ep_out);
   send_report(dev_addr, instance, XboxOne::S_INIT, sizeof(XboxOne::S_INIT));
-  wait_for_tx_complete(dev_addr, interface->ep_out);
 
   if (VID == 0x045e && (PID == 0x0b00)) {
     send_report(dev_addr, instance, XboxOne::EXTRA_INPUT_PACKET_INIT,
                 sizeof(XboxOne::EXTRA_INPUT_PACKET_INIT));
-    wait_for_tx_complete(dev_addr, interface->ep_out);
   }
 
   // Required for PDP aftermarket controllers
   if (VID == 0x0e6f) {
     send_report(dev_addr, instance, XboxOne::PDP_LED_ON,
                 sizeof(XboxOne::PDP_LED_ON));
-    wait_for_tx_complete(dev_addr, interface->ep_out);
     send_report(dev_addr, instance, XboxOne::PDP_AUTH,
                 sizeof(XboxOne::PDP_AUTH));
-    wait_for_tx_complete(dev_addr, interface->ep_out);
   }
 }
 
@@ -229,10 +246,9 @@ static bool set_config(uint8_t dev_addr, uint8_t itf_num) {
     interface->connected = false;
     send_report(dev_addr, instance, Xbox360W::INQUIRE_PRESENT,
                 sizeof(Xbox360W::INQUIRE_PRESENT));
-    wait_for_tx_complete(dev_addr, interface->ep_out);
     break;
   case DevType::XBOXONE:
-    xboxone_init(interface, dev_addr, instance);
+    xboxone_init(dev_addr, instance);
     break;
   default:
     break;
@@ -249,11 +265,22 @@ static bool set_config(uint8_t dev_addr, uint8_t itf_num) {
 static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result,
                     uint32_t xferred_bytes) {
   Interface *interface = get_itf_by_ep(dev_addr, ep_addr);
+  TU_VERIFY(interface != nullptr);
   uint8_t instance = get_instance_by_itf_num(dev_addr, interface->itf_num);
-  TU_VERIFY(interface != nullptr && instance != INVALID_IDX);
+  TU_VERIFY(instance != INVALID_IDX);
 
   const uint8_t dir = tu_edpt_dir(ep_addr);
 
+  if (dir == TUSB_DIR_OUT) {
+    if (result == XFER_RESULT_SUCCESS && report_sent_cb) {
+      report_sent_cb(dev_addr, instance, interface->ep_out_buffer.data(),
+                     static_cast<uint16_t>(xferred_bytes));
+    }
+    // A failed packet isn't retried, the next one is still worth sending
+    submit_next_report(dev_addr, interface);
+    return true;
+  }
+
   if (result != XFER_RESULT_SUCCESS) {
     // Erro de transferência - tentar receber novamente sem processar dados
     // corrompidos
@@ -280,8 +307,8 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result,
 
           TU_LOG1("Xbox 360 wireless controller connected\n");
 
-          // I think some 3rd party adapters need this:
-          std_sleep_ms(1000);
+          // Sent again by xbox360_chatpad_init after the host's connect
+          // delay, some 3rd party adapters need it late
           send_report(dev_addr, instance, Xbox360W::RUMBLE_ENABLE,
                       sizeof(Xbox360W::RUMBLE_ENABLE));
 
@@ -291,6 +318,7 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result,
         } else if (in_buffer[1] == 0x00 && interface->connected) {
           interface->connected = false;
           interface->chatpad_inited = false;
+          interface->out_queue.clear();
 
           TU_LOG1("Xbox 360 wireless controller disconnected\n");
 
@@ -313,7 +341,7 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result,
         new_pad_data = true;
         break;
       case XboxOne::GIP_CMD_ANNOUNCE:
-        xboxone_init(interface, dev_addr, instance);
+        xboxone_init(dev_addr, instance);
         break;
       }
       break;
@@ -332,11 +360,6 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result,
     } else {
       receive_report(dev_addr, instance);
     }
-  } else {
-    if (report_sent_cb) {
-      report_sent_cb(dev_addr, instance, interface->ep_out_buffer.data(),
-                     static_cast<uint16_t>(xferred_bytes));
-    }
   }
   return true;
 }
@@ -359,6 +382,7 @@ void close(uint8_t dev_addr) {
       TU_LOG1("XInput unmount\r\n");
       device->interfaces[i].itf_num = 0xFF;
       device->interfaces[i].connected = false;
+      device->interfaces[i].out_queue.clear();
     }
   }
 }
@@ -383,18 +407,8 @@ const usbh_class_driver_t *class_driver() {
 
 bool send_report(uint8_t dev_addr, uint8_t instance, const uint8_t *buffer,
                  uint16_t len) {
-  Interface *interface = get_itf_by_instance(dev_addr, instance);
-  TU_VERIFY(interface != nullptr);
-  TU_VERIFY(usbh_edpt_claim(dev_addr, interface->ep_out));
-
-  std::memcpy(interface->ep_out_buffer.data(), buffer, len);
-
-  if (!usbh_edpt_xfer(dev_addr, interface->ep_out,
-                      interface->ep_out_buffer.data(), len)) {
-    usbh_edpt_release(dev_addr, interface->ep_out);
-    return false;
-  }
-  return true;
+  return queue_report(dev_addr, instance, buffer, len,
+                      OutReportQueue::Priority::COMMAND);
 }
 
 bool receive_report(uint8_t dev_addr, uint8_t instance) {
@@ -409,7 +423,7 @@ bool receive_report(uint8_t dev_addr, uint8_t instance) {
   return true;
 }
 
-bool set_led(uint8_t dev_addr, uint8_t instance, uint8_t quadrant, bool block) {
+bool set_led(uint8_t dev_addr, uint8_t instance, uint8_t quadrant) {
   Interface *interface = get_itf_by_instance(dev_addr, instance);
   TU_VERIFY(interface != nullptr);
 
@@ -431,15 +445,11 @@ bool set_led(uint8_t dev_addr, uint8_t instance, uint8_t quadrant, bool block) {
     return true;
   }
 
-  bool ret = send_report(dev_addr, instance, buffer, len);
-  if (block && ret) {
-    wait_for_tx_complete(dev_addr, interface->ep_out);
-  }
-  return ret;
+  return send_report(dev_addr, instance, buffer, len);
 }
 
 bool set_rumble(uint8_t dev_addr, uint8_t instance, uint8_t rumble_l,
-                uint8_t rumble_r, bool block) {
+                uint8_t rumble_r) {
   Interface *interface = get_itf_by_instance(dev_addr, instance);
   TU_VERIFY(interface != nullptr);
 
@@ -477,11 +487,9 @@ bool set_rumble(uint8_t dev_addr, uint8_t instance, uint8_t rumble_l,
     return true;
   }
 
-  bool ret = send_report(dev_addr, instance, buffer, len);
-  if (block && ret) {
-    wait_for_tx_complete(dev_addr, interface->ep_out);
-  }
-  return true;
+  // Replaces any rumble still waiting, only the latest motor values matter
+  return queue_report(dev_addr, instance, buffer, len,
+                      OutReportQueue::Priority::RUMBLE);
 }
 
 void xbox360_chatpad_init(uint8_t address, uint8_t instance) {
@@ -495,13 +503,10 @@ void xbox360_chatpad_init(uint8_t address, uint8_t instance) {
 
   send_report(address, instance, Xbox360W::CONTROLLER_INFO,
               sizeof(Xbox360W::CONTROLLER_INFO));
-  wait_for_tx_complete(address, interface->ep_out);
   send_report(address, instance, Xbox360W::Chatpad::INIT,
               sizeof(Xbox360W::Chatpad::INIT));
-  wait_for_tx_complete(address, interface->ep_out);
   send_report(address, instance, Xbox360W::RUMBLE_ENABLE,
               sizeof(Xbox360W::RUMBLE_ENABLE));
-  wait_for_tx_complete(address, interface->ep_out);
 
   uint8_t led_ctrl[4];
   std::memcpy(led_ctrl, Xbox360W::Chatpad::LED_CTRL,
@@ -509,7 +514,6 @@ void xbox360_chatpad_init(uint8_t address, uint8_t instance) {
   led_ctrl[2] = Xbox360W::Chatpad::LED_ON[0];
 
   send_report(address, instance, led_ctrl, sizeof(led_ctrl));
-  wait_for_tx_complete(address, interface->ep_out);
 
   interface->chatpad_inited = true;
   interface->chatpad_stage = ChatpadStage::KEEPALIVE_1;
@@ -525,7 +529,7 @@ bool xbox360_chatpad_keepalive(uint8_t address, uint8_t instance) {
     switch (interface->dev_type) {
     case DevType::XBOX360:
       send_ctrl_xfer(interface->dev_addr, &Xbox360::Chatpad::KEEPALIVE_1,
-                     nullptr, nullptr, 0);
+                     nullptr, ctrl_xfer_complete_cb, 0);
       break;
     case DevType::XBOX360W:
       send_report(interface->dev_addr, instance, Xbox360W::Chatpad::KEEPALIVE_1,
@@ -540,7 +544,7 @@ bool xbox360_chatpad_keepalive(uint8_t address, uint8_t instance) {
     switch (interface->dev_type) {
     case DevType::XBOX360:
       send_ctrl_xfer(interface->dev_addr, &Xbox360::Chatpad::KEEPALIVE_2,
-                     nullptr, nullptr, 0);
+                     nullptr, ctrl_xfer_complete_cb, 0);
       break;
     case DevType::XBOX360W:
       send_report(interface->dev_addr, instance, Xbox360W::Chatpad::KEEPALIVE_2,
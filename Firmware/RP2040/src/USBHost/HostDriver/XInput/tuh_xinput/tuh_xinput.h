@@ -36,6 +36,8 @@ SOFTWARE.
 #include "host/usbh.h"
 #include "host/usbh_pvt.h"
 
+#include "USBHost/HostDriver/XInput/tuh_xinput/tuh_xinput_queue.h"
+
 namespace tuh_xinput
 {
     enum class DevType { UNKNOWN, XBOX360, XBOX360W, XBOXOG, XBOXONE };
@@ -55,6 +57,10 @@ namespace tuh_xinput
 
     static constexpr uint8_t ENDPOINT_SIZE = 64;
     static constexpr uint32_t KEEPALIVE_MS = 1000;
+    static constexpr uint8_t OUT_QUEUE_DEPTH = 8;
+    static constexpr uint8_t OUT_PACKET_SIZE = 24; //Largest XInput OUT packet is 19 bytes
+
+    using OutReportQueue = OutQueue<OUT_QUEUE_DEPTH, OUT_PACKET_SIZE>;
 
     struct Interface
     {
@@ -77,16 +83,20 @@ namespace tuh_xinput
 
         std::array<uint8_t, ENDPOINT_SIZE> ep_in_buffer{0};
         std::array<uint8_t, ENDPOINT_SIZE> ep_out_buffer{0};
+
+        //Sent one at a time from the OUT transfer callback, nothing waits on the endpoint
+        OutReportQueue out_queue;
     };
 
     // API
 
     const usbh_class_driver_t* class_driver();
 
+    //OUT reports are queued and return once queued, not once sent
     bool send_report(uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len);
     bool receive_report(uint8_t address, uint8_t instance);
-    bool set_rumble(uint8_t address, uint8_t instance, uint8_t rumble_l, uint8_t rumble_r, bool block);
-    bool set_led(uint8_t address, uint8_t instance, uint8_t led_number, bool block);
+    bool set_rumble(uint8_t address, uint8_t instance, uint8_t rumble_l, uint8_t rumble_r);
+    bool set_led(uint8_t address, uint8_t instance, uint8_t led_number);
 
     //Wireless only atm
     void xbox360_chatpad_init(uint8_t address, uint8_t instance); 
@@ -0,0 +1,111 @@
+#ifndef _TUH_XINPUT_QUEUE_H_
+#define _TUH_XINPUT_QUEUE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <array>
+
+namespace tuh_xinput
+{
+    //Packets waiting on an interface's OUT endpoint. Commands (init, LEDs, chatpad
+    //keepalives) go out in the order they were queued and always ahead of rumble.
+    //Rumble keeps only the newest packet, a motor value that was replaced before it
+    //went out is never worth sending.
+    template <uint8_t DEPTH, uint8_t PACKET_SIZE>
+    class OutQueue
+    {
+    public:
+        enum class Priority { COMMAND, RUMBLE };
+
+        static_assert(DEPTH > 0 && DEPTH <= 128, "OutQueue depth must fit its counters");
+
+        //False if the packet doesn't fit or the command queue is full
+        bool push(const uint8_t* data, uint16_t len, Priority priority)
+        {
+            if (len == 0 || len > PACKET_SIZE)
+            {
+                return false;
+            }
+            if (priority == Priority::RUMBLE)
+            {
+                if (rumble_.len)
+                {
+                    ++coalesced_;
+                }
+                store(rumble_, data, len);
+                return true;
+            }
+            if (count_ >= DEPTH)
+            {
+                ++dropped_;
+                return false;
+            }
+            store(commands_[(head_ + count_) % DEPTH], data, len);
+            ++count_;
+            return true;
+        }
+
+        //Copies the next packet into buffer (PACKET_SIZE bytes) and returns its
+        //length, 0 if nothing is waiting
+        uint16_t pop(uint8_t* buffer)
+        {
+            Packet* packet = nullptr;
+            if (count_)
+            {
+                packet = &commands_[head_];
+                head_ = (head_ + 1) % DEPTH;
+                --count_;
+            }
+            else if (rumble_.len)
+            {
+                packet = &rumble_;
+            }
+            else
+            {
+                return 0;
+            }
+            const uint16_t len = packet->len;
+            std::memcpy(buffer, packet->data.data(), len);
+            packet->len = 0;
+            return len;
+        }
+
+        void clear()
+        {
+            head_ = 0;
+            count_ = 0;
+            rumble_.len = 0;
+        }
+
+        bool empty() const { return count_ == 0 && rumble_.len == 0; }
+        uint8_t commands() const { return count_; }
+        bool rumble_pending() const { return rumble_.len != 0; }
+
+        //Rumble packets replaced before they went out, commands refused when full
+        uint32_t coalesced() const { return coalesced_; }
+        uint32_t dropped() const { return dropped_; }
+
+    private:
+        struct Packet
+        {
+            std::array<uint8_t, PACKET_SIZE> data{0};
+            uint16_t len{0};
+        };
+
+        std::array<Packet, DEPTH> commands_;
+        Packet rumble_;
+        uint8_t head_{0};
+        uint8_t count_{0};
+        uint32_t coalesced_{0};
+        uint32_t dropped_{0};
+
+        static void store(Packet& packet, const uint8_t* data, uint16_t len)
+        {
+            std::memcpy(packet.data.data(), data, len);
+            packet.len = len;
+        }
+    };
+
+} // namespace tuh_xinput
+
+#endif // _TUH_XINPUT_QUEUE_H_
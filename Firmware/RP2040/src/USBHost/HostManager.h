@@ -6,9 +6,10 @@
 #include <hardware/regs/usb.h>
 #include <hardware/resets.h>
 #include <hardware/structs/usb.h>
-#include <memory>
+#include <pico/time.h>
 
 #include "Board/Config.h"
+#include "DriverSlot.h"
 #include "USBHost/HardwareIDs.h"
 #include "USBHost/HostDriver/DInput/DInput.h"
 #include "USBHost/HostDriver/HIDGeneric/HIDGeneric.h"
@@ -21,6 +22,7 @@
 #include "USBHost/HostDriver/PSClassic/PSClassic.h"
 #include "USBHost/HostDriver/SwitchPro/SwitchPro.h"
 #include "USBHost/HostDriver/SwitchWired/SwitchWired.h"
+#include "USBHost/HostSlots.h"
 
 #include "USBHost/HostDriver/XInput/Xbox360.h"
 #include "USBHost/HostDriver/XInput/Xbox360W.h"
@@ -46,10 +48,14 @@ public:
 
   bool use_ps3_v2 = false;
 
+  struct FeedbackStats {
+    uint32_t submitted{0}; // send_feedback() queued an output
+    uint32_t skipped{0};   // Nothing new, or too soon for the device
+    uint32_t failed{0};    // Nothing could be queued, tried again next pass
+  };
+
   inline void initialize(Gamepad (&gamepads)[MAX_GAMEPADS]) {
-    for (size_t i = 0; i < MAX_GAMEPADS; ++i) {
-      gamepads_[i] = &gamepads[i];
-    }
+    slots_.initialize(gamepads);
   }
 
   // XInput doesn't need report_desc or desc_len
@@ -57,198 +63,218 @@ public:
                            const uint8_t address, const uint8_t instance,
                            uint8_t const *report_desc = nullptr,
                            uint16_t desc_len = 0) {
-    uint8_t gp_idx = find_free_gamepad();
-    if (gp_idx == INVALID_IDX || instance >= MAX_INTERFACES) {
-      return false;
-    }
-
-    // Check if this device is already mounted
-    uint8_t dev_idx = get_device_slot(address);
-    // If not, find a free device slot
-    if (dev_idx == INVALID_IDX &&
-        ((dev_idx = find_free_device_slot()) == INVALID_IDX)) {
+    // Same slot if this interface is mounted again without an unmount
+    bool remount = false;
+    const uint8_t gp_idx = slots_.claim(address, instance, remount);
+    if (gp_idx == INVALID_IDX) {
       return false;
     }
 
-    Device &device_slot = device_slots_[dev_idx];
-    Interface &interface = device_slot.interfaces[instance];
+    Interface &interface = interfaces_[gp_idx];
 
     switch (driver_type) {
     case HostDriverType::PS5:
-      interface.driver = std::make_unique<PS5Host>(gp_idx);
+      interface.driver.emplace<PS5Host>(gp_idx);
       break;
     case HostDriverType::PS4:
-      interface.driver = std::make_unique<PS4Host>(gp_idx);
+      interface.driver.emplace<PS4Host>(gp_idx);
       break;
     case HostDriverType::PS3:
       // PS2->PS3 Adapters mimic PS3 VID/PID but have different report
       // descriptor length (176 vs 148)
       if (desc_len == 176) {
-        interface.driver = std::make_unique<HIDHost>(gp_idx);
+        interface.driver.emplace<HIDHost>(gp_idx);
       } else if (use_ps3_v2) {
-        interface.driver = std::make_unique<PS3V2Host>(gp_idx);
+        interface.driver.emplace<PS3V2Host>(gp_idx);
       } else {
-        interface.driver = std::make_unique<PS3Host>(gp_idx);
+        interface.driver.emplace<PS3Host>(gp_idx);
       }
       break;
     case HostDriverType::PS3V2:
-      interface.driver = std::make_unique<PS3V2Host>(gp_idx);
+      interface.driver.emplace<PS3V2Host>(gp_idx);
       break;
     case HostDriverType::DINPUT:
-      interface.driver = std::make_unique<DInputHost>(gp_idx);
+      interface.driver.emplace<DInputHost>(gp_idx);
       break;
     case HostDriverType::SWITCH:
-      interface.driver = std::make_unique<SwitchWiredHost>(gp_idx);
+      interface.driver.emplace<SwitchWiredHost>(gp_idx);
       break;
     case HostDriverType::SWITCH_PRO:
-      interface.driver = std::make_unique<SwitchProHost>(gp_idx);
+      interface.driver.emplace<SwitchProHost>(gp_idx);
       break;
     case HostDriverType::N64:
-      interface.driver = std::make_unique<N64Host>(gp_idx);
+      interface.driver.emplace<N64Host>(gp_idx);
       break;
     case HostDriverType::PSCLASSIC:
-      interface.driver = std::make_unique<PSClassicHost>(gp_idx);
+      interface.driver.emplace<PSClassicHost>(gp_idx);
       break;
     case HostDriverType::XBOXOG:
-      interface.driver = std::make_unique<XboxOGHost>(gp_idx);
+      interface.driver.emplace<XboxOGHost>(gp_idx);
       break;
     case HostDriverType::XBOXONE:
-      interface.driver = std::make_unique<XboxOneHost>(gp_idx);
+      interface.driver.emplace<XboxOneHost>(gp_idx);
       break;
     case HostDriverType::XBOX360:
-      interface.driver = std::make_unique<Xbox360Host>(gp_idx);
+      interface.driver.emplace<Xbox360Host>(gp_idx);
       break;
     case HostDriverType::XBOX360W: // Composite device, takes up all 4 gamepads
                                    // when mounted
-      interface.driver = std::make_unique<Xbox360WHost>(gp_idx);
+      interface.driver.emplace<Xbox360WHost>(gp_idx);
       break;
 
     default:
       if (is_hid_gamepad(report_desc, desc_len)) {
-        interface.driver = std::make_unique<HIDHost>(gp_idx);
+        interface.driver.emplace<HIDHost>(gp_idx);
       } else {
+        slots_.unclaim(address, instance, remount);
         return false;
       }
       break;
     }
 
-    device_slot.address = address;
-    interface.gamepad_idx = gp_idx;
-    interface.gamepad = gamepads_[gp_idx];
-    interface.driver->initialize(*interface.gamepad, device_slot.address,
-                                 instance, report_desc, desc_len);
+    interface.gamepad = slots_.gamepad(gp_idx);
+    interface.feedback = Feedback();
+    interface.feedback.sent_seq = interface.gamepad->pad_out_seq();
+    interface.driver->initialize(*interface.gamepad, address, instance,
+                                 report_desc, desc_len);
+    slots_.attach(gp_idx);
 
     return true;
   }
 
   inline void process_report(uint8_t address, uint8_t instance,
                              const uint8_t *report, uint16_t len) {
-    for (auto &device_slot : device_slots_) {
-      if (device_slot.address == address &&
-          device_slot.interfaces[instance].driver &&
-          device_slot.interfaces[instance].gamepad) {
-        device_slot.interfaces[instance].driver->process_report(
-            *device_slot.interfaces[instance].gamepad, address, instance,
-            report, len);
-
-        // Check for shortcut: Start + Dpad Left + Y to switch to PS3V2
-        if (device_slot.interfaces[instance].driver->get_driver_type() ==
-            HostDriverType::PS3) {
-          Gamepad *gp = device_slot.interfaces[instance].gamepad;
-          if ((gp->get_pad_in().buttons & gp->MAP_BUTTON_START) &&
-              (gp->get_pad_in().dpad & gp->MAP_DPAD_LEFT) &&
-              (gp->get_pad_in().buttons & gp->MAP_BUTTON_Y)) {
-
-            // Logic to switch driver would normally be here, but we can't
-            // easily hotswap in this structure without re-enumerating or
-            // forcing a type change. However, the user asked to CLONE the
-            // driver and "The shortcut for this new driver will be Start + Dpad
-            // Left + Y" This implies we need a way to force this driver. Since
-            // we can't magically know on connection, maybe we persist a flag?
-            // Or, if this is for the *next* connection?
-            // Let's assume we want to trigger a persistent setting or mode
-            // switch.
-
-            // BUT, typically "shortcut for this new driver" implies ACTIVATING
-            // it. If the device is ALREADY connected as PS3, we want to re-init
-            // as PS3V2?
-
-            // Re-reading user request: "o atalho para este novo driver, será
-            // Start + Dpad Left + Y" This sounds like a runtime switch. Let's
-            // implement a forced disconnect/reconnect with override? Or better,
-            // let's just log it for now or set a static flag.
-
-            // Simpler approach for "Testing":
-            // If this combination is held DURING connection? No, that's hard.
-            // If held during runtime, we swap the driver pointer?
-
-            // Let's implement a static override in HostManager that forces
-            // PS3V2 for PS3 VIDs
-            if ((gp->get_pad_in().buttons & gp->MAP_BUTTON_START) &&
-                (gp->get_pad_in().dpad & gp->MAP_DPAD_LEFT) &&
-                (gp->get_pad_in().buttons & gp->MAP_BUTTON_Y)) {
-              this->use_ps3_v2 = !this->use_ps3_v2;
-              // Trigger re-enumeration... effectively by resetting
-              device_slot.reset();
-              // The loop will pick it up again, but we need to pass the hint.
-              // This is getting complex.
-
-              // WAIT. If I just want to clone and "place the name ps3v2", maybe
-              // I just add it to the list and the user manually selects it? "o
-              // atalho para este novo driver, será Start + Dpad Left + Y" This
-              // implies a togglable state.
-            }
-          }
+    Interface *interface = find_interface(address, instance);
+    if (!interface) {
+      return;
+    }
+    // A profile stored from core0 is swapped in here, between two reports
+    interface->gamepad->apply_pending_profile();
+    interface->driver->process_report(*interface->gamepad, address, instance,
+                                      report, len);
+
+    // Check for shortcut: Start + Dpad Left + Y to switch to PS3V2
+    if (interface->driver->get_driver_type() == HostDriverType::PS3) {
+      Gamepad *gp = interface->gamepad;
+      if ((gp->get_pad_in().buttons & gp->MAP_BUTTON_START) &&
+          (gp->get_pad_in().dpad & gp->MAP_DPAD_LEFT) &&
+          (gp->get_pad_in().buttons & gp->MAP_BUTTON_Y)) {
+
+        // Logic to switch driver would normally be here, but we can't
+        // easily hotswap in this structure without re-enumerating or
+        // forcing a type change. However, the user asked to CLONE the
+        // driver and "The shortcut for this new driver will be Start + Dpad
+        // Left + Y" This implies we need a way to force this driver. Since
+        // we can't magically know on connection, maybe we persist a flag?
+        // Or, if this is for the *next* connection?
+        // Let's assume we want to trigger a persistent setting or mode
+        // switch.
+
+        // BUT, typically "shortcut for this new driver" implies ACTIVATING
+        // it. If the device is ALREADY connected as PS3, we want to re-init
+        // as PS3V2?
+
+        // Re-reading user request: "o atalho para este novo driver, será
+        // Start + Dpad Left + Y" This sounds like a runtime switch. Let's
+        // implement a forced disconnect/reconnect with override? Or better,
+        // let's just log it for now or set a static flag.
+
+        // Simpler approach for "Testing":
+        // If this combination is held DURING connection? No, that's hard.
+        // If held during runtime, we swap the driver pointer?
+
+        // Let's implement a static override in HostManager that forces
+        // PS3V2 for PS3 VIDs
+        if ((gp->get_pad_in().buttons & gp->MAP_BUTTON_START) &&
+            (gp->get_pad_in().dpad & gp->MAP_DPAD_LEFT) &&
+            (gp->get_pad_in().buttons & gp->MAP_BUTTON_Y)) {
+          this->use_ps3_v2 = !this->use_ps3_v2;
+          // Trigger re-enumeration... effectively by resetting
+          reset_device(address);
+          // The loop will pick it up again, but we need to pass the hint.
+          // This is getting complex.
+
+          // WAIT. If I just want to clone and "place the name ps3v2", maybe
+          // I just add it to the list and the user manually selects it? "o
+          // atalho para este novo driver, será Start + Dpad Left + Y" This
+          // implies a togglable state.
         }
       }
     }
   }
 
   inline void connect_cb(uint8_t address, uint8_t instance) {
-    for (auto &device_slot : device_slots_) {
-      if (device_slot.address == address &&
-          device_slot.interfaces[instance].driver &&
-          device_slot.interfaces[instance].gamepad) {
-        device_slot.interfaces[instance].driver->connect_cb(
-            *device_slot.interfaces[instance].gamepad, address, instance);
-      }
+    Interface *interface = find_interface(address, instance);
+    if (interface) {
+      interface->driver->connect_cb(*interface->gamepad, address, instance);
     }
   }
 
   inline void disconnect_cb(uint8_t address, uint8_t instance) {
-    for (auto &device_slot : device_slots_) {
-      if (device_slot.address == address &&
-          device_slot.interfaces[instance].driver &&
-          device_slot.interfaces[instance].gamepad) {
-        device_slot.interfaces[instance].driver->disconnect_cb(
-            *device_slot.interfaces[instance].gamepad, address, instance);
-      }
+    Interface *interface = find_interface(address, instance);
+    if (interface) {
+      interface->driver->disconnect_cb(*interface->gamepad, address, instance);
+      // The receiver stays mounted, don't leave the pad's last input held
+      slots_.detach(slots_.find(address, instance));
     }
   }
 
-  // Call on a timer
+  // Call on a timer. An interface is only sent to when its PadOut changed
+  // since the last output it took, or its device wants the output repeated,
+  // and never sooner than the device's minimum interval. Drivers only queue
+  // transfers, the main loop's tuh_task() runs them
   inline void send_feedback() {
-    for (auto &device_slot : device_slots_) {
-      if (device_slot.address == INVALID_IDX) {
+    const uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
+      Interface &interface = interfaces_[i];
+      if (!interface.driver) {
         continue;
       }
-      for (uint8_t i = 0; i < MAX_INTERFACES; ++i) {
-        if (device_slot.interfaces[i].driver &&
-            device_slot.interfaces[i].gamepad->new_pad_out()) {
-          device_slot.interfaces[i].driver->send_feedback(
-              *device_slot.interfaces[i].gamepad, device_slot.address, i);
-          tuh_task();
-        }
+      Feedback &feedback = interface.feedback;
+      const HostDriver::FeedbackTiming timing =
+          interface.driver->feedback_timing();
+      // Read before the driver takes the PadOut, a change that lands in
+      // between is sent again next pass
+      const uint32_t seq = interface.gamepad->pad_out_seq();
+      const uint32_t elapsed_ms = now_ms - feedback.sent_ms;
+      const bool keepalive = feedback.rumbling && timing.keepalive_ms &&
+                             (elapsed_ms >= timing.keepalive_ms);
+
+      if ((seq == feedback.sent_seq && !keepalive) ||
+          elapsed_ms < timing.min_interval_ms) {
+        ++feedback.stats.skipped;
+        continue;
+      }
+
+      const Gamepad::PadOut pad_out = interface.gamepad->peek_pad_out();
+      if (interface.driver->send_feedback(*interface.gamepad,
+                                          slots_.address(i),
+                                          slots_.instance(i))) {
+        feedback.sent_seq = seq;
+        feedback.sent_ms = now_ms;
+        feedback.rumbling = (pad_out.rumble_l || pad_out.rumble_r);
+        ++feedback.stats.submitted;
+      } else {
+        ++feedback.stats.failed;
       }
     }
   }
 
+  inline FeedbackStats get_feedback_stats(uint8_t gamepad_idx) const {
+    if (gamepad_idx >= MAX_GAMEPADS) {
+      return FeedbackStats();
+    }
+    return interfaces_[gamepad_idx].feedback.stats;
+  }
+
+  // Each interface of a device gets its own unmount callback
   void deinit_driver(DriverClass driver_class, uint8_t address,
                      uint8_t instance) {
-    for (auto &device_slot : device_slots_) {
-      if (device_slot.address == address) {
-        device_slot.reset();
-      }
+    // The device side stays enumerated, the slot is left neutral
+    const uint8_t gp_idx = slots_.release(address, instance);
+    if (gp_idx != INVALID_IDX) {
+      interfaces_[gp_idx].reset();
     }
   }
 
@@ -282,77 +308,65 @@ public:
 
   inline uint8_t get_gamepad_idx(DriverClass driver_class, uint8_t address,
                                  uint8_t instance) {
-    for (auto &device_slot : device_slots_) {
-      if (device_slot.address == address && instance < MAX_INTERFACES) {
-        return device_slot.interfaces[instance].gamepad_idx;
-      }
-    }
-    return INVALID_IDX;
+    return slots_.find(address, instance);
   }
 
-  inline bool any_mounted() {
-    for (auto &device_slot : device_slots_) {
-      if (device_slot.address != INVALID_IDX) {
-        return true;
-      }
-    }
-    return false;
-  }
+  inline bool any_mounted() { return slots_.any(); }
 
 private:
   static constexpr uint8_t INVALID_IDX = 0xFF;
+  // Non-hub devices are numbered 1 to CFG_TUH_DEVICE_MAX and hubs after them
+  static constexpr uint8_t MAX_ADDRESS = CFG_TUH_DEVICE_MAX + CFG_TUH_HUB;
+
+  struct Feedback {
+    uint32_t sent_seq{0}; // Gamepad::pad_out_seq() of the last output queued
+    uint32_t sent_ms{0};
+    bool rumbling{false};
+    FeedbackStats stats;
+  };
+
+  // Every host driver setup_driver() can create, each gamepad has storage for
+  // the largest of them
+  using HostDriverSlot =
+      DriverSlot<HostDriver, PS5Host, PS4Host, PS3Host, PS3V2Host, DInputHost,
+                 SwitchWiredHost, SwitchProHost, N64Host, PSClassicHost,
+                 XboxOGHost, XboxOneHost, Xbox360Host, Xbox360WHost, HIDHost>;
 
   struct Interface {
-    std::unique_ptr<HostDriver> driver{nullptr};
+    HostDriverSlot driver;
     Gamepad *gamepad{nullptr};
-    uint8_t gamepad_idx{INVALID_IDX};
-  };
-  struct Device {
-    uint8_t address{INVALID_IDX};
-    Interface interfaces[MAX_INTERFACES];
+    Feedback feedback;
 
     void reset() {
-      address = INVALID_IDX;
-      for (auto &interface : interfaces) {
-        interface.driver.reset();
-        interface.gamepad_idx = INVALID_IDX;
-        interface.gamepad = nullptr;
-      }
+      driver.reset();
+      gamepad = nullptr;
+      feedback = Feedback();
     }
   };
 
-  Device device_slots_[MAX_GAMEPADS];
-  Gamepad *gamepads_[MAX_GAMEPADS];
+  // (address, instance) <-> gamepad index, interfaces_ is indexed by gamepad
+  HostSlots<MAX_ADDRESS, MAX_INTERFACES, MAX_GAMEPADS> slots_;
+  Interface interfaces_[MAX_GAMEPADS];
 
   HostManager() {}
 
-  inline uint8_t find_free_device_slot() {
-    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
-      if (device_slots_[i].address == INVALID_IDX) {
-        return i;
-      }
+  // nullptr unless the interface is mounted with a driver
+  inline Interface *find_interface(uint8_t address, uint8_t instance) {
+    const uint8_t gp_idx = slots_.find(address, instance);
+    if (gp_idx == INVALID_IDX || !interfaces_[gp_idx].driver) {
+      return nullptr;
     }
-    return INVALID_IDX;
+    return &interfaces_[gp_idx];
   }
 
-  inline uint8_t find_free_gamepad() {
-    uint8_t count = 0;
-
-    for (auto &device_slot : device_slots_) {
-      for (auto &interface : device_slot.interfaces) {
-        if (interface.gamepad_idx != INVALID_IDX) {
-          ++count;
-        }
+  // Drops every interface of the device without touching the gamepads
+  inline void reset_device(uint8_t address) {
+    for (uint8_t i = 0; i < MAX_INTERFACES; ++i) {
+      const uint8_t gp_idx = slots_.forget(address, i);
+      if (gp_idx != INVALID_IDX) {
+        interfaces_[gp_idx].reset();
       }
     }
-    return (count < MAX_GAMEPADS) ? count : INVALID_IDX;
-  }
-
-  inline uint8_t get_device_slot(uint8_t address) {
-    if (address > MAX_GAMEPADS) {
-      return INVALID_IDX;
-    }
-    return address - 1;
   }
 
   // inline DriverClass determine_driver_class(HostDriver::Type host_type)
@@ -383,14 +397,8 @@ private:
   }
 
   inline HostDriver *get_driver_by_gamepad(uint8_t gamepad_idx) {
-    for (const auto &device_slot : device_slots_) {
-      for (const auto &interface : device_slot.interfaces) {
-        if (interface.gamepad_idx == gamepad_idx) {
-          return interface.driver.get();
-        }
-      }
-    }
-    return nullptr;
+    return (gamepad_idx < MAX_GAMEPADS) ? interfaces_[gamepad_idx].driver.get()
+                                        : nullptr;
   }
 };
 
@@ -0,0 +1,86 @@
+#ifndef _HOST_SLOTS_H_
+#define _HOST_SLOTS_H_
+
+#include <cstdint>
+
+#include "Gamepad/Gamepad.h"
+#include "USBHost/InterfaceMap.h"
+
+// Which gamepad each mounted interface drives, and what happens to that
+// gamepad as controllers come and go. The device side stays enumerated
+// through all of it, so a slot without a controller reports neutral input and
+// keeps its profile and the console's last rumble for the next one.
+template <uint8_t MAX_ADDRESS, uint8_t MAX_INSTANCES, uint8_t MAX_SLOTS>
+class HostSlots {
+public:
+  static constexpr uint8_t INVALID_IDX =
+      InterfaceMap<MAX_ADDRESS, MAX_INSTANCES, MAX_SLOTS>::INVALID_IDX;
+
+  void initialize(Gamepad (&gamepads)[MAX_SLOTS]) {
+    for (uint8_t i = 0; i < MAX_SLOTS; ++i) {
+      gamepads_[i] = &gamepads[i];
+    }
+  }
+
+  // Slot for a mounting interface, INVALID_IDX if every slot is taken.
+  // remount is set when it's mounted again without an unmount, it keeps its
+  // slot
+  inline uint8_t claim(uint8_t address, uint8_t instance, bool &remount) {
+    remount = (map_.find(address, instance) != INVALID_IDX);
+    return map_.add(address, instance);
+  }
+
+  // Undoes claim() for an interface no driver took
+  inline void unclaim(uint8_t address, uint8_t instance, bool remount) {
+    if (!remount) {
+      map_.remove(address, instance);
+    }
+  }
+
+  // A driver is running on the slot, the new controller picks up the
+  // console's last rumble
+  inline void attach(uint8_t idx) { gamepads_[idx]->resend_pad_out(); }
+
+  // The controller went away but its interface stays mounted, e.g. a wireless
+  // pad powered off
+  inline void detach(uint8_t idx) {
+    if (idx < MAX_SLOTS && gamepads_[idx]) {
+      release_gamepad(*gamepads_[idx]);
+    }
+  }
+
+  // Interface unmounted, frees the slot and leaves its gamepad neutral.
+  // Returns the slot it held, INVALID_IDX if it had none
+  inline uint8_t release(uint8_t address, uint8_t instance) {
+    const uint8_t idx = map_.remove(address, instance);
+    detach(idx);
+    return idx;
+  }
+
+  // Frees the slot without touching the gamepad, the interface is expected to
+  // mount again straight away
+  inline uint8_t forget(uint8_t address, uint8_t instance) {
+    return map_.remove(address, instance);
+  }
+
+  inline Gamepad *gamepad(uint8_t idx) const { return gamepads_[idx]; }
+  inline uint8_t find(uint8_t address, uint8_t instance) const {
+    return map_.find(address, instance);
+  }
+  inline bool any() const { return map_.any(); }
+  inline uint8_t address(uint8_t idx) const { return map_.address(idx); }
+  inline uint8_t instance(uint8_t idx) const { return map_.instance(idx); }
+
+private:
+  InterfaceMap<MAX_ADDRESS, MAX_INSTANCES, MAX_SLOTS> map_;
+  Gamepad *gamepads_[MAX_SLOTS]{};
+
+  // Neutral input for the console, the pad out and profile stay with the slot
+  static inline void release_gamepad(Gamepad &gamepad) {
+    gamepad.reset_pad_in();
+    gamepad.reset_chatpad_in();
+    gamepad.set_analog_host(false);
+  }
+};
+
+#endif // _HOST_SLOTS_H_
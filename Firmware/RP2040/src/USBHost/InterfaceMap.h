@@ -0,0 +1,103 @@
+#ifndef _INTERFACE_MAP_H_
+#define _INTERFACE_MAP_H_
+
+#include <cstdint>
+
+// Maps a mounted (device address, interface instance) to a gamepad slot and
+// back in constant time. Addresses aren't contiguous behind a hub and a single
+// device can hold several slots (Xbox 360 wireless receiver), so nothing here
+// assumes an address tells you the slot. Slots are handed out lowest first so a
+// controller plugged back in takes the slot that was freed.
+template <uint8_t MAX_ADDRESS, uint8_t MAX_INSTANCES, uint8_t MAX_SLOTS>
+class InterfaceMap {
+public:
+  static constexpr uint8_t INVALID_IDX = 0xFF;
+
+  static_assert(MAX_SLOTS > 0 && MAX_SLOTS <= 8,
+                "InterfaceMap slot mask is 8 bits");
+
+  InterfaceMap() { clear(); }
+
+  void clear() {
+    for (auto &instances : slot_by_itf_) {
+      for (auto &slot : instances) {
+        slot = INVALID_IDX;
+      }
+    }
+    for (auto &itf : itf_by_slot_) {
+      itf = Itf();
+    }
+    used_ = 0;
+  }
+
+  inline uint8_t find(uint8_t address, uint8_t instance) const {
+    if (address > MAX_ADDRESS || instance >= MAX_INSTANCES) {
+      return INVALID_IDX;
+    }
+    return slot_by_itf_[address][instance];
+  }
+
+  // Slot for the interface, the one it already has if it was never removed.
+  // INVALID_IDX if the interface is out of range or every slot is taken
+  inline uint8_t add(uint8_t address, uint8_t instance) {
+    if (address == 0 || address > MAX_ADDRESS || instance >= MAX_INSTANCES) {
+      return INVALID_IDX;
+    }
+    uint8_t slot = slot_by_itf_[address][instance];
+    if (slot != INVALID_IDX) {
+      return slot;
+    }
+    if ((slot = lowest_free()) == INVALID_IDX) {
+      return INVALID_IDX;
+    }
+    slot_by_itf_[address][instance] = slot;
+    itf_by_slot_[slot] = {address, instance};
+    used_ |= (1U << slot);
+    return slot;
+  }
+
+  // Returns the slot the interface held, INVALID_IDX if it had none
+  inline uint8_t remove(uint8_t address, uint8_t instance) {
+    const uint8_t slot = find(address, instance);
+    if (slot != INVALID_IDX) {
+      slot_by_itf_[address][instance] = INVALID_IDX;
+      itf_by_slot_[slot] = Itf();
+      used_ &= ~(1U << slot);
+    }
+    return slot;
+  }
+
+  inline bool used(uint8_t slot) const {
+    return slot < MAX_SLOTS && (used_ & (1U << slot));
+  }
+  inline bool any() const { return used_ != 0; }
+  inline uint8_t address(uint8_t slot) const {
+    return itf_by_slot_[slot].address;
+  }
+  inline uint8_t instance(uint8_t slot) const {
+    return itf_by_slot_[slot].instance;
+  }
+
+private:
+  struct Itf {
+    uint8_t address{0};
+    uint8_t instance{INVALID_IDX};
+  };
+
+  // Address 0 is only used during enumeration, it's kept so lookups index
+  // directly
+  uint8_t slot_by_itf_[MAX_ADDRESS + 1][MAX_INSTANCES];
+  Itf itf_by_slot_[MAX_SLOTS];
+  uint8_t used_{0};
+
+  inline uint8_t lowest_free() const {
+    for (uint8_t i = 0; i < MAX_SLOTS; ++i) {
+      if (!(used_ & (1U << i))) {
+        return i;
+      }
+    }
+    return INVALID_IDX;
+  }
+};
+
+#endif // _INTERFACE_MAP_H_
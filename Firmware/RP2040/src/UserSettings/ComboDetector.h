@@ -0,0 +1,88 @@
+#ifndef _COMBO_DETECTOR_H_
+#define _COMBO_DETECTOR_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/*  Edge driven button combo detector. Feed it each change of the button state with
+    the time it happened, poll() reports a combo once it has been held for its hold time.
+    Each combo has its own state machine: IDLE -> HELD (on the press edge) -> FIRED,
+    any change of the button state returns it to IDLE or HELD. */
+template <size_t NUM_COMBOS>
+class ComboDetector
+{
+public:
+    static constexpr int32_t NO_COMBO = -1;
+
+    struct Combo
+    {
+        uint32_t buttons;
+        uint32_t hold_ms;
+    };
+
+    ComboDetector(const std::array<Combo, NUM_COMBOS>& combos)
+        : combos_(combos) {}
+
+    //Call when the button state changes, time_ms is when the change happened
+    void update(uint32_t buttons, uint32_t time_ms)
+    {
+        for (size_t i = 0; i < NUM_COMBOS; ++i)
+        {
+            if (combos_[i].buttons == buttons)
+            {
+                if (states_[i].state == State::IDLE)
+                {
+                    states_[i].state = State::HELD;
+                    states_[i].since_ms = time_ms;
+                }
+            }
+            else
+            {
+                states_[i].state = State::IDLE;
+            }
+        }
+    }
+
+    //Returns the index of a combo whose hold time has just been satisfied, or NO_COMBO
+    int32_t poll(uint32_t now_ms)
+    {
+        for (size_t i = 0; i < NUM_COMBOS; ++i)
+        {
+            if (states_[i].state == State::HELD &&
+                static_cast<uint32_t>(now_ms - states_[i].since_ms) >= combos_[i].hold_ms)
+            {
+                states_[i].state = State::FIRED;
+                return static_cast<int32_t>(i);
+            }
+        }
+        return NO_COMBO;
+    }
+
+    void reset()
+    {
+        for (auto& state : states_)
+        {
+            state.state = State::IDLE;
+        }
+    }
+
+private:
+    enum class State : uint8_t
+    {
+        IDLE = 0,
+        HELD,
+        FIRED
+    };
+
+    struct ComboState
+    {
+        State state{State::IDLE};
+        uint32_t since_ms{0};
+    };
+
+    const std::array<Combo, NUM_COMBOS> combos_;
+    std::array<ComboState, NUM_COMBOS> states_;
+};
+
+#endif // _COMBO_DETECTOR_H_
@@ -4,18 +4,30 @@
 #include <cstdint>
 #include <string>
 #include <array>
+#include <algorithm>
 #include <cstring>
 #include <hardware/flash.h>
+#include <hardware/sync.h>
 #include <pico/mutex.h>
+#include <pico/multicore.h>
 
 /* Define NVS_SECTORS (number of sectors to allocate to storage) either here or with CMake */
 
+/*  Flash is only written while the other core is paused or stopped, a core that should keep 
+    running through writes must call multicore_lockout_victim_init() at startup. */
+
+/*  The last BLOCK_SECTORS of the NVS region are reserved for a single raw block 
+    (used for records too large for a key/value entry), the rest holds key/value entries. */
 class NVSTool
 {
 public:
     static constexpr size_t   KEY_LEN_MAX = 16; //Including null terminator
     static constexpr size_t   VALUE_LEN_MAX = FLASH_PAGE_SIZE - KEY_LEN_MAX;
-    static constexpr uint32_t MAX_ENTRIES = ((NVS_SECTORS * FLASH_SECTOR_SIZE) / FLASH_PAGE_SIZE) - 1;
+    static constexpr uint32_t BLOCK_SECTORS = 1;
+    static constexpr size_t   BLOCK_LEN_MAX = BLOCK_SECTORS * FLASH_SECTOR_SIZE;
+    static constexpr uint32_t MAX_ENTRIES = (((NVS_SECTORS - BLOCK_SECTORS) * FLASH_SECTOR_SIZE) / FLASH_PAGE_SIZE) - 1;
+
+    static_assert(NVS_SECTORS > BLOCK_SECTORS, "NVSTool: NVS_SECTORS must leave room for key/value entries");
 
     static NVSTool& get_instance()
     {
@@ -80,9 +92,56 @@ public:
         return false;
     }
 
+    //Replaces the contents of the block region with a single write, len must be <= BLOCK_LEN_MAX
+    bool write_block(const void* data, size_t len)
+    {
+        if (len == 0 || len > BLOCK_LEN_MAX)
+        {
+            return false;
+        }
+
+        mutex_enter_blocking(&nvs_mutex_);
+        FlashLock lock = flash_lock();
+
+        for (uint32_t i = 0; i < BLOCK_SECTORS; ++i) 
+        {
+            flash_range_erase(BLOCK_START_OFFSET + i * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+        }
+
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
+        std::array<uint8_t, FLASH_PAGE_SIZE> page_buffer;
+
+        for (size_t offset = 0; offset < len; offset += FLASH_PAGE_SIZE) 
+        {
+            size_t page_len = std::min(len - offset, static_cast<size_t>(FLASH_PAGE_SIZE));
+            page_buffer.fill(0xFF);
+            std::memcpy(page_buffer.data(), src + offset, page_len);
+            flash_range_program(BLOCK_START_OFFSET + offset, page_buffer.data(), FLASH_PAGE_SIZE);
+        }
+
+        flash_unlock(lock);
+        mutex_exit(&nvs_mutex_);
+        return true;
+    }
+
+    //Reads straight from XIP, offset + len must be <= BLOCK_LEN_MAX
+    bool read_block(void* data, size_t len, size_t offset = 0)
+    {
+        if (offset + len > BLOCK_LEN_MAX)
+        {
+            return false;
+        }
+
+        mutex_enter_blocking(&nvs_mutex_);
+        std::memcpy(data, reinterpret_cast<const uint8_t*>(XIP_BASE + BLOCK_START_OFFSET + offset), len);
+        mutex_exit(&nvs_mutex_);
+        return true;
+    }
+
     void erase_all()
     {
         mutex_enter_blocking(&nvs_mutex_);
+        FlashLock lock = flash_lock();
 
         for (uint32_t i = 0; i < NVS_SECTORS; ++i) 
         {
@@ -98,6 +157,7 @@ public:
                                 sizeof(Entry));
         }
 
+        flash_unlock(lock);
         mutex_exit(&nvs_mutex_);
     }
 
@@ -134,9 +194,37 @@ private:
 
     static constexpr const char INVALID_KEY[KEY_LEN_MAX] = "INVALID";
     static constexpr uint32_t NVS_START_OFFSET = PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE * NVS_SECTORS;
+    static constexpr uint32_t BLOCK_START_OFFSET = NVS_START_OFFSET + FLASH_SECTOR_SIZE * (NVS_SECTORS - BLOCK_SECTORS);
+
+    static constexpr uint64_t LOCKOUT_TIMEOUT_US = 100 * 1000;
+
+    struct FlashLock
+    {
+        uint32_t irq_state;
+        bool lockout;
+    };
 
     mutex_t nvs_mutex_;
 
+    //Pauses the other core if it's a lockout victim, if it was reset the lockout times out and is skipped
+    inline FlashLock flash_lock()
+    {
+        FlashLock lock;
+        lock.lockout = multicore_lockout_victim_is_initialized(1 - get_core_num()) && 
+                       multicore_lockout_start_timeout_us(LOCKOUT_TIMEOUT_US);
+        lock.irq_state = save_and_disable_interrupts();
+        return lock;
+    }
+
+    inline void flash_unlock(const FlashLock& lock)
+    {
+        restore_interrupts(lock.irq_state);
+        if (lock.lockout)
+        {
+            multicore_lockout_end_blocking();
+        }
+    }
+
     inline Entry* get_entry(const uint32_t index) 
     {
         return reinterpret_cast<Entry*>(XIP_BASE + NVS_START_OFFSET + index * sizeof(Entry));
@@ -154,25 +242,30 @@ private:
 
     void update_entry(uint32_t index, const std::string& key, const void* buffer, size_t len)
     {
-        uint32_t entry_offset = index * sizeof(Entry);
-        uint32_t sector_offset = ((NVS_START_OFFSET + entry_offset) / FLASH_SECTOR_SIZE) * FLASH_SECTOR_SIZE;
+        uint32_t entry_offset = NVS_START_OFFSET + index * sizeof(Entry);
+        uint32_t sector_offset = (entry_offset / FLASH_SECTOR_SIZE) * FLASH_SECTOR_SIZE;
 
         std::array<uint8_t, FLASH_SECTOR_SIZE> sector_buffer;
         std::memcpy(sector_buffer.data(), reinterpret_cast<const uint8_t*>(XIP_BASE + sector_offset), FLASH_SECTOR_SIZE);
 
-        flash_range_erase(sector_offset, FLASH_SECTOR_SIZE);
-
-        Entry* entry_to_write = reinterpret_cast<Entry*>(sector_buffer.data() + entry_offset);
+        //Entries past the first sector sit at their offset within their own sector
+        Entry* entry_to_write = reinterpret_cast<Entry*>(sector_buffer.data() + (entry_offset - sector_offset));
 
         *entry_to_write = Entry();
         std::strncpy(entry_to_write->key, key.c_str(), key.size());
         entry_to_write->key[key.size()] = '\0';
         std::memcpy(entry_to_write->value, buffer, len);
 
+        FlashLock lock = flash_lock();
+
+        flash_range_erase(sector_offset, FLASH_SECTOR_SIZE);
+
         for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE; ++i) 
         {
             flash_range_program(sector_offset + i * FLASH_PAGE_SIZE, sector_buffer.data() + i * FLASH_PAGE_SIZE, FLASH_PAGE_SIZE);
         }
+
+        flash_unlock(lock);
     }
 
 }; // class NVSTool
@@ -0,0 +1,207 @@
+#ifndef _PROFILE_BANK_H_
+#define _PROFILE_BANK_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+#include <cstring>
+
+#include "Board/Config.h"
+#include "UserSettings/UserProfile.h"
+
+/*  All user profiles and the active profile id of each gamepad slot, packed into a
+    single record so they can be read from flash in one pass and stored with one write.
+
+    Layout: Header | profile_count * profile_len bytes of profiles
+    Records written by a newer version may have a larger header, larger profiles or more
+    of them, the known prefix of each is used and the rest ignored. */
+#pragma pack(push, 1)
+struct ProfileBank
+{
+    static constexpr uint32_t MAGIC = 0x5042474F; // "OGBP"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint8_t  MAX_PROFILES = 8;
+    static constexpr uint8_t  MAX_SLOTS = 4;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t crc;           // CRC32 of everything after this field, up to the end of the record
+        uint16_t version;
+        uint16_t header_len;
+        uint16_t profile_len;
+        uint8_t  profile_count;
+        uint8_t  slot_count;
+        std::array<uint8_t, MAX_SLOTS> active_ids;
+    };
+    static_assert(sizeof(Header) == 20, "ProfileBank::Header size mismatch");
+
+    static constexpr size_t CRC_OFFSET = offsetof(Header, version);
+
+    Header header;
+    std::array<UserProfile, MAX_PROFILES> profiles;
+
+    ProfileBank()
+    {
+        header.magic = MAGIC;
+        header.crc = 0;
+        header.version = VERSION;
+        header.header_len = sizeof(Header);
+        header.profile_len = sizeof(UserProfile);
+        header.profile_count = MAX_PROFILES;
+        header.slot_count = MAX_SLOTS;
+
+        for (uint8_t i = 0; i < MAX_SLOTS; ++i)
+        {
+            header.active_ids[i] = (i < MAX_GAMEPADS) ? (i + 1) : 1;
+        }
+        for (uint8_t i = 0; i < MAX_PROFILES; ++i)
+        {
+            profiles[i] = UserProfile();
+            profiles[i].id = i + 1;
+        }
+    }
+
+    //Finalizes the header before writing
+    void seal()
+    {
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.header_len = sizeof(Header);
+        header.profile_len = sizeof(UserProfile);
+        header.profile_count = MAX_PROFILES;
+        header.slot_count = MAX_SLOTS;
+        header.crc = crc32(reinterpret_cast<const uint8_t*>(this) + CRC_OFFSET, sizeof(ProfileBank) - CRC_OFFSET);
+    }
+
+    //True if this is a sealed bank of the current layout with a valid id in every slot
+    bool verify() const
+    {
+        if (header.magic != MAGIC ||
+            header.version != VERSION ||
+            header.header_len != sizeof(Header) ||
+            header.profile_len != sizeof(UserProfile) ||
+            header.profile_count != MAX_PROFILES ||
+            header.slot_count != MAX_SLOTS ||
+            header.crc != crc32(reinterpret_cast<const uint8_t*>(this) + CRC_OFFSET, sizeof(ProfileBank) - CRC_OFFSET))
+        {
+            return false;
+        }
+        for (uint8_t i = 0; i < MAX_PROFILES; ++i)
+        {
+            if (profiles[i].id != i + 1)
+            {
+                return false;
+            }
+        }
+        for (const auto& id : header.active_ids)
+        {
+            if (id < 1 || id > MAX_PROFILES)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Total length of a stored record described by header, 0 if the header can't be used
+    static size_t record_len(const Header& stored)
+    {
+        if (stored.magic != MAGIC ||
+            stored.header_len < sizeof(Header) ||
+            stored.profile_len < sizeof(UserProfile) ||
+            stored.profile_count < MAX_PROFILES)
+        {
+            return 0;
+        }
+        return static_cast<size_t>(stored.header_len) + static_cast<size_t>(stored.profile_count) * stored.profile_len;
+    }
+
+    /*  Loads and verifies a stored record, read(void* dst, size_t len, size_t offset) 
+        copies bytes from storage. The CRC is checked before anything is copied into the bank, 
+        a record of the current layout is then fetched in one read, records from newer 
+        versions are copied per profile with their unknown fields dropped. */
+    template <typename ReadFunc>
+    bool load(ReadFunc&& read)
+    {
+        Header stored;
+        if (!read(&stored, sizeof(Header), 0))
+        {
+            return false;
+        }
+
+        const size_t len = record_len(stored);
+        if (len == 0)
+        {
+            return false;
+        }
+
+        std::array<uint8_t, 64> chunk;
+        uint32_t crc = 0;
+
+        for (size_t offset = CRC_OFFSET; offset < len; offset += chunk.size())
+        {
+            const size_t chunk_len = std::min(chunk.size(), len - offset);
+            if (!read(chunk.data(), chunk_len, offset))
+            {
+                return false;
+            }
+            crc = crc32(chunk.data(), chunk_len, crc);
+        }
+        if (crc != stored.crc)
+        {
+            return false;
+        }
+
+        if (len == sizeof(ProfileBank))
+        {
+            return read(this, sizeof(ProfileBank), 0);
+        }
+
+        for (uint8_t i = 0; i < MAX_PROFILES; ++i)
+        {
+            if (!read(&profiles[i], sizeof(UserProfile), stored.header_len + i * stored.profile_len))
+            {
+                return false;
+            }
+        }
+
+        header = stored;
+        header.header_len = sizeof(Header);
+        header.profile_len = sizeof(UserProfile);
+        header.profile_count = MAX_PROFILES;
+        return true;
+    }
+
+    //Pass the previous result as crc to continue a running checksum
+    static uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0)
+    {
+        crc ^= 0xFFFFFFFF;
+        for (size_t i = 0; i < len; ++i)
+        {
+            crc = CRC32_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFF;
+    }
+
+private:
+    static constexpr std::array<uint32_t, 256> CRC32_TABLE = []
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (uint8_t j = 0; j < 8; ++j)
+            {
+                crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+};
+static_assert(sizeof(ProfileBank) == sizeof(ProfileBank::Header) + sizeof(UserProfile) * ProfileBank::MAX_PROFILES, "ProfileBank size mismatch");
+#pragma pack(pop)
+
+#endif // _PROFILE_BANK_H_
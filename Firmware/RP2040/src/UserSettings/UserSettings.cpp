@@ -7,6 +7,7 @@
 
 #include "Board/board_api.h"
 #include "Board/ogxm_log.h"
+#include "UserSettings/ComboDetector.h"
 #include "UserSettings/UserSettings.h"
 
 static constexpr uint32_t BUTTON_COMBO(const uint16_t &buttons,
@@ -128,42 +129,46 @@ DeviceDriverType UserSettings::DEFAULT_DRIVER() {
   return VALID_DRIVER_TYPES[0];
 }
 
-// Checks if button combo has been held for 3 seconds, returns true if mode has
-// been changed
-bool UserSettings::check_for_driver_change(Gamepad &gamepad) {
-  Gamepad::PadIn gp_in = gamepad.get_pad_in();
-  static uint32_t last_button_combo = BUTTON_COMBO(gp_in.buttons, gp_in.dpad);
-  static uint8_t call_count = 0;
+static constexpr auto DRIVER_COMBOS = [] {
+  std::array<ComboDetector<BUTTON_COMBO_MAP.size()>::Combo,
+             BUTTON_COMBO_MAP.size()>
+      combos{};
+  for (size_t i = 0; i < BUTTON_COMBO_MAP.size(); ++i) {
+    combos[i] = {BUTTON_COMBO_MAP[i].combo, UserSettings::COMBO_HOLD_MS};
+  }
+  return combos;
+}();
 
-  uint32_t current_button_combo = BUTTON_COMBO(gp_in.buttons, gp_in.dpad);
+// Cheap enough to call every loop, only locks the gamepad when its buttons have
+// changed. Returns true once when a driver combo has been held for
+// COMBO_HOLD_MS and the mode has been changed
+bool UserSettings::check_for_driver_change(Gamepad &gamepad) {
+  static ComboDetector<BUTTON_COMBO_MAP.size()> combo_detector(DRIVER_COMBOS);
 
-  if (!(current_button_combo &
-        (static_cast<uint32_t>(Gamepad::BUTTON_START) << 16)) ||
-      last_button_combo != current_button_combo) {
-    last_button_combo = current_button_combo;
-    call_count = 0;
-    return false;
+  if (requested_driver_ != DeviceDriverType::NONE) {
+    const DeviceDriverType new_driver = requested_driver_;
+    requested_driver_ = DeviceDriverType::NONE;
+    if (is_valid_driver(new_driver) && new_driver != current_driver_) {
+      current_driver_ = new_driver;
+      return true;
+    }
   }
 
-  ++call_count;
+  if (gamepad.new_button_state()) {
+    Gamepad::ButtonState button_state = gamepad.get_button_state();
+    combo_detector.update(
+        BUTTON_COMBO(button_state.buttons, button_state.dpad),
+        button_state.since_ms);
+  }
 
-  if (call_count < GP_CHECK_COUNT) {
+  int32_t combo_idx = combo_detector.poll(board_api::ms_since_boot());
+  if (combo_idx == ComboDetector<BUTTON_COMBO_MAP.size()>::NO_COMBO) {
     return false;
   }
 
-  call_count = 0;
-
-  DeviceDriverType new_driver = DeviceDriverType::NONE;
+  DeviceDriverType new_driver = BUTTON_COMBO_MAP[combo_idx].driver;
 
-  for (const auto &combo_map : BUTTON_COMBO_MAP) {
-    if (combo_map.combo == current_button_combo &&
-        is_valid_driver(combo_map.driver)) {
-      new_driver = combo_map.driver;
-      break;
-    }
-  }
-
-  if (new_driver == DeviceDriverType::NONE || new_driver == current_driver_) {
+  if (!is_valid_driver(new_driver) || new_driver == current_driver_) {
     return false;
   }
 
@@ -181,10 +186,14 @@ bool UserSettings::store_profile(uint8_t index, const UserProfile &profile) {
     index = 0;
   }
 
+  ProfileBank &bank = get_profile_bank();
+  bank.header.active_ids[index] = profile.id;
+  bank.profiles[profile.id - 1] = profile;
+  bank.seal();
+
   board_api::usb::disconnect_all();
 
-  nvs_tool_.write(ACTIVE_PROFILE_KEY(index), &profile.id, sizeof(uint8_t));
-  nvs_tool_.write(PROFILE_KEY(profile.id), &profile, sizeof(UserProfile));
+  nvs_tool_.write_block(&bank, sizeof(ProfileBank));
 
   board_api::reboot();
 
@@ -213,34 +222,74 @@ bool UserSettings::store_profile_and_driver_type(
     new_driver_type = DEFAULT_DRIVER();
   }
 
+  ProfileBank &bank = get_profile_bank();
+  bank.header.active_ids[index] = profile.id;
+  bank.profiles[profile.id - 1] = profile;
+  bank.seal();
+
   board_api::usb::disconnect_all();
 
   nvs_tool_.write(DRIVER_TYPE_KEY(),
                   reinterpret_cast<const uint8_t *>(&new_driver_type),
                   sizeof(new_driver_type));
-  nvs_tool_.write(ACTIVE_PROFILE_KEY(index), &profile.id, sizeof(uint8_t));
-  nvs_tool_.write(PROFILE_KEY(profile.id), &profile, sizeof(UserProfile));
+  nvs_tool_.write_block(&bank, sizeof(ProfileBank));
 
   board_api::reboot();
 
   return true;
 }
 
-// Disconnects usb and resets pico if it's a new & valid mode, call from core0
-void UserSettings::store_driver_type(DeviceDriverType new_driver) {
+// Stores the profile in a single bank write, USB stays connected and nothing
+// reboots. The write erases a sector with core1 locked out, so don't call it
+// from a USB callback. The bank in RAM only changes if the write succeeds.
+// Call from core0
+bool UserSettings::store_profile_live(uint8_t index, const UserProfile &profile) {
+  if (profile.id < 1 || profile.id > MAX_PROFILES) {
+    return false;
+  }
+  if (index > MAX_GAMEPADS - 1) {
+    index = 0;
+  }
+
+  // Sealed in place to avoid a second bank on the stack, put back on failure
+  ProfileBank &bank = get_profile_bank();
+  const uint8_t prev_id = bank.header.active_ids[index];
+  const UserProfile prev_profile = bank.profiles[profile.id - 1];
+  bank.header.active_ids[index] = profile.id;
+  bank.profiles[profile.id - 1] = profile;
+  bank.seal();
+
+  if (!nvs_tool_.write_block(&bank, sizeof(ProfileBank))) {
+    bank.header.active_ids[index] = prev_id;
+    bank.profiles[profile.id - 1] = prev_profile;
+    bank.seal();
+    return false;
+  }
+  return true;
+}
+
+// The board's loop switches drivers in place when check_for_driver_change()
+// returns true, call from core0
+void UserSettings::request_driver_change(DeviceDriverType new_driver_type) {
+  requested_driver_ = new_driver_type;
+}
+
+// Stores the driver type without rebooting, switch to it with
+// DeviceManager::switch_driver(), call from core0
+bool UserSettings::store_driver_type(DeviceDriverType new_driver) {
   if (!is_valid_driver(new_driver)) {
     OGXM_LOG("Invalid driver type detected during store: " +
              OGXM_TO_STRING(new_driver) + "\n");
-    return;
+    return false;
   }
 
   OGXM_LOG("Storing new driver type: " + OGXM_TO_STRING(new_driver) + "\n");
 
-  board_api::usb::disconnect_all();
-
-  nvs_tool_.write(DRIVER_TYPE_KEY(), &new_driver, sizeof(uint8_t));
-
-  board_api::reboot();
+  if (!nvs_tool_.write(DRIVER_TYPE_KEY(), &new_driver, sizeof(uint8_t))) {
+    return false;
+  }
+  current_driver_ = new_driver;
+  return true;
 }
 
 uint8_t UserSettings::get_active_profile_id(const uint8_t index) {
@@ -249,8 +298,7 @@ uint8_t UserSettings::get_active_profile_id(const uint8_t index) {
     return 0x01;
   }
 
-  uint8_t read_profile_id = 0;
-  nvs_tool_.read(ACTIVE_PROFILE_KEY(index), &read_profile_id, sizeof(uint8_t));
+  uint8_t read_profile_id = get_profile_bank().header.active_ids[index];
 
   if (read_profile_id < 1 || read_profile_id > MAX_PROFILES) {
     OGXM_LOG("UserSettings::get_active_profile_id: Invalid profile id\n");
@@ -264,8 +312,12 @@ UserProfile UserSettings::get_profile_by_index(const uint8_t index) {
 }
 
 UserProfile UserSettings::get_profile_by_id(const uint8_t profile_id) {
-  UserProfile profile;
-  nvs_tool_.read(PROFILE_KEY(profile_id), &profile, sizeof(UserProfile));
+  if (profile_id < 1 || profile_id > MAX_PROFILES) {
+    OGXM_LOG("Invalid profile id, returning default profile\n");
+    return UserProfile();
+  }
+
+  const UserProfile &profile = get_profile_bank().profiles[profile_id - 1];
 
   if (profile.id != profile_id) {
     OGXM_LOG("Profile read failed, returning default profile\n");
@@ -331,6 +383,11 @@ void UserSettings::initialize_flash() {
 
   if (read_init_flag == FLASH_INIT_FLAG) {
     OGXM_LOG("Flash already initialized: %i\n", read_init_flag);
+
+    if (!load_profile_bank()) {
+      // Flash written by firmware that stored each profile under its own key
+      migrate_profile_bank();
+    }
     return;
   }
 
@@ -342,30 +399,82 @@ void UserSettings::initialize_flash() {
   uint8_t device_mode_buffer = static_cast<uint8_t>(DEFAULT_DRIVER());
   nvs_tool_.write(DRIVER_TYPE_KEY(), &device_mode_buffer, sizeof(uint8_t));
 
-  OGXM_LOG("Writing default profile ids\n");
+  OGXM_LOG("Writing default profiles, bank size: %i\n", sizeof(ProfileBank));
 
-  for (uint8_t i = 0; i < MAX_GAMEPADS; i++) {
-    uint8_t profile_id = i + 1;
-    nvs_tool_.write(ACTIVE_PROFILE_KEY(i), &profile_id, sizeof(uint8_t));
+  profile_bank_ = ProfileBank();
+  profile_bank_.seal();
+  nvs_tool_.write_block(&profile_bank_, sizeof(ProfileBank));
+  profile_bank_loaded_ = true;
+
+  OGXM_LOG("Writing init flag\n");
+
+  uint8_t init_flag_buffer = FLASH_INIT_FLAG;
+  nvs_tool_.write(INIT_FLAG_KEY(), &init_flag_buffer, sizeof(uint8_t));
+
+  OGXM_LOG("Flash initialized\n");
+}
+
+// Reads all profiles and active profile ids into RAM in one pass
+bool UserSettings::load_profile_bank() {
+  profile_bank_loaded_ = profile_bank_.load(
+      [this](void *dst, size_t len, size_t offset) {
+        return nvs_tool_.read_block(dst, len, offset);
+      });
+
+  if (!profile_bank_loaded_) {
+    OGXM_LOG("Profile bank missing or corrupt\n");
   }
+  return profile_bank_loaded_;
+}
 
-  OGXM_LOG("Writing default profiles\n");
+// Packs profiles stored under per-profile keys into the profile bank, invalid
+// entries are replaced with defaults
+void UserSettings::migrate_profile_bank() {
+  OGXM_LOG("Migrating profiles to profile bank\n");
 
-  {
-    UserProfile profile;
-    OGXM_LOG("Profile size: %i\n", sizeof(UserProfile));
+  profile_bank_ = ProfileBank();
 
-    for (uint8_t i = 0; i < MAX_PROFILES; i++) {
-      profile.id = i + 1;
-      nvs_tool_.write(PROFILE_KEY(profile.id), &profile, sizeof(UserProfile));
-      OGXM_LOG("Profile " + std::to_string(profile.id) + " written\n");
+  for (uint8_t i = 0; i < MAX_GAMEPADS; i++) {
+    uint8_t profile_id = 0;
+    if (nvs_tool_.read(ACTIVE_PROFILE_KEY(i), &profile_id, sizeof(uint8_t)) &&
+        profile_id >= 1 && profile_id <= MAX_PROFILES) {
+      profile_bank_.header.active_ids[i] = profile_id;
     }
   }
 
-  OGXM_LOG("Writing init flag\n");
+  for (uint8_t i = 0; i < MAX_PROFILES; i++) {
+    UserProfile profile;
+    if (nvs_tool_.read(PROFILE_KEY(i + 1), &profile, sizeof(UserProfile)) &&
+        profile.id == i + 1) {
+      profile_bank_.profiles[i] = profile;
+    }
+  }
 
-  uint8_t init_flag_buffer = FLASH_INIT_FLAG;
-  nvs_tool_.write(INIT_FLAG_KEY(), &init_flag_buffer, sizeof(uint8_t));
+  profile_bank_.seal();
+  nvs_tool_.write_block(&profile_bank_, sizeof(ProfileBank));
+  profile_bank_loaded_ = true;
+}
 
-  OGXM_LOG("Flash initialized\n");
-}
\ No newline at end of file
+const ProfileBank &UserSettings::read_profile_bank() {
+  return get_profile_bank();
+}
+
+// Call from core0, the caller applies the new profiles to its gamepads
+bool UserSettings::store_profile_bank(const ProfileBank &bank) {
+  if (!bank.verify()) {
+    OGXM_LOG("Rejected invalid profile bank\n");
+    return false;
+  }
+  profile_bank_ = bank;
+  profile_bank_loaded_ = true;
+  return nvs_tool_.write_block(&profile_bank_, sizeof(ProfileBank));
+}
+
+ProfileBank &UserSettings::get_profile_bank() {
+  if (!profile_bank_loaded_ && !load_profile_bank()) {
+    // Use defaults until initialize_flash() repairs storage
+    profile_bank_ = ProfileBank();
+    profile_bank_loaded_ = true;
+  }
+  return profile_bank_;
+}
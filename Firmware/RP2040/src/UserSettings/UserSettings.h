@@ -8,6 +8,7 @@
 #include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
 #include "UserSettings/UserProfile.h"
 #include "UserSettings/NVSTool.h"
+#include "UserSettings/ProfileBank.h"
 #include "Gamepad/Gamepad.h"
 
 /* Only write/store flash from Core0 */
@@ -15,7 +16,7 @@ class UserSettings
 {
 public:
     static constexpr uint8_t MAX_PROFILES = 8;
-    static constexpr int32_t GP_CHECK_DELAY_MS = 600;
+    static constexpr uint32_t COMBO_HOLD_MS = 3000;
 
     static UserSettings& get_instance()
     {
@@ -36,9 +37,18 @@ public:
     UserProfile get_profile_by_id(const uint8_t profile_id);
     uint8_t get_active_profile_id(const uint8_t index);
 
-    void store_driver_type(DeviceDriverType new_driver_type);
+    bool store_driver_type(DeviceDriverType new_driver_type);
     bool store_profile(uint8_t index, const UserProfile& profile);
     bool store_profile_and_driver_type(DeviceDriverType new_driver_type, uint8_t index, const UserProfile& profile);
+    //Stores a profile without rebooting, the caller applies it to its gamepads
+    bool store_profile_live(uint8_t index, const UserProfile& profile);
+    //Reported by the next check_for_driver_change() as if its combo had been held
+    void request_driver_change(DeviceDriverType new_driver_type);
+
+    //All profiles and active profile ids as stored in flash
+    const ProfileBank& read_profile_bank();
+    //Replaces all profiles in a single flash write without rebooting, bank must be sealed
+    bool store_profile_bank(const ProfileBank& bank);
 
 private:
     UserSettings() = default;
@@ -46,12 +56,24 @@ private:
     UserSettings(const UserSettings&) = delete;
     UserSettings& operator=(const UserSettings&) = delete;
 
-    static constexpr uint8_t GP_CHECK_COUNT = 3000 / GP_CHECK_DELAY_MS;
     static constexpr uint8_t FLASH_INIT_FLAG = 0xF8;
     const std::string DATETIME_TAG = BUILD_DATETIME; 
     
     NVSTool& nvs_tool_{NVSTool::get_instance()};
     DeviceDriverType current_driver_{DeviceDriverType::NONE};
+    DeviceDriverType requested_driver_{DeviceDriverType::NONE};
+
+    //RAM copy of all profiles, loaded once from flash
+    ProfileBank profile_bank_;
+    bool profile_bank_loaded_{false};
+
+    static_assert(MAX_PROFILES == ProfileBank::MAX_PROFILES, "UserSettings: MAX_PROFILES mismatch");
+    static_assert(MAX_GAMEPADS <= ProfileBank::MAX_SLOTS, "UserSettings: MAX_GAMEPADS exceeds ProfileBank slots");
+    static_assert(sizeof(ProfileBank) <= NVSTool::BLOCK_LEN_MAX, "UserSettings: ProfileBank doesn't fit in NVS block");
+
+    bool load_profile_bank();
+    void migrate_profile_bank();
+    ProfileBank& get_profile_bank();
     
     DeviceDriverType DEFAULT_DRIVER();
     const std::string INIT_FLAG_KEY();
@@ -5,6 +5,8 @@
 #define ENABLE_LE_PERIPHERAL
 #define ENABLE_LE_CENTRAL
 #define ENABLE_L2CAP_LE_CREDIT_BASED_FLOW_CONTROL_MODE
+// Lets a whole profile fit in one or two LL packets once the ATT MTU is raised
+#define ENABLE_LE_DATA_LENGTH_EXTENSION
 
 #ifndef OGXM_DEBUG
 #define ENABLE_LOG_INFO
@@ -0,0 +1,321 @@
+#ifndef _AXIS_MAPPER_H_
+#define _AXIS_MAPPER_H_
+
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+#include "libfixmath/fix16.hpp"
+#include "Gamepad/Range.h"
+#include "Gamepad/fix16ext.h"
+#include "UserSettings/JoystickSettings.h"
+#include "UserSettings/TriggerSettings.h"
+#include "UserSettings/UserProfile.h"
+
+/*  Stick and trigger processing for a profile, shared by both firmwares' Gamepad and
+    free of SDK calls so it also builds for the host. Settings left at their defaults
+    are skipped, scaled values are passed through as they are. */
+class AxisMapper
+{
+public:
+    AxisMapper() = default;
+    ~AxisMapper() = default;
+
+    void set_profile(const UserProfile& profile)
+    {
+        if ((joy_settings_l_en_ = !joy_settings_l_.is_same(profile.joystick_settings_l)))
+        {
+            joy_settings_l_.set_from_raw(profile.joystick_settings_l);
+            //This needs to be addressed in the webapp, just multiply here for now
+            joy_settings_l_.axis_restrict *= static_cast<int16_t>(100);
+            joy_settings_l_.angle_restrict *= static_cast<int16_t>(100);
+            joy_settings_l_.anti_dz_angular *= static_cast<int16_t>(100);
+        }
+        if ((joy_settings_r_en_ = !joy_settings_r_.is_same(profile.joystick_settings_r)))
+        {
+            joy_settings_r_.set_from_raw(profile.joystick_settings_r);
+            //This needs to be addressed in the webapp, just multiply here for now
+            joy_settings_r_.axis_restrict *= static_cast<int16_t>(100);
+            joy_settings_r_.angle_restrict *= static_cast<int16_t>(100);
+            joy_settings_r_.anti_dz_angular *= static_cast<int16_t>(100);
+        }
+        if ((trig_settings_l_en_ = !trig_settings_l_.is_same(profile.trigger_settings_l)))
+        {
+            trig_settings_l_.set_from_raw(profile.trigger_settings_l);
+        }
+        if ((trig_settings_r_en_ = !trig_settings_r_.is_same(profile.trigger_settings_r)))
+        {
+            trig_settings_r_.set_from_raw(profile.trigger_settings_r);
+        }
+    }
+
+    inline bool joystick_l_enabled() const { return joy_settings_l_en_; }
+    inline bool joystick_r_enabled() const { return joy_settings_r_en_; }
+    inline bool trigger_l_enabled() const { return trig_settings_l_en_; }
+    inline bool trigger_r_enabled() const { return trig_settings_r_en_; }
+
+    //Any range to int16_t, bits > 0 for values that only use that many bits of T
+    template <uint8_t bits = 0, typename T>
+    static inline std::pair<int16_t, int16_t> scale_joystick(T x, T y)
+    {
+        if constexpr (bits > 0)
+        {
+            return { Range::scale_from_bits<int16_t, bits>(x), Range::scale_from_bits<int16_t, bits>(y) };
+        }
+        else if constexpr (!std::is_same_v<T, int16_t>)
+        {
+            return { Range::scale<int16_t>(x), Range::scale<int16_t>(y) };
+        }
+        else
+        {
+            return { x, y };
+        }
+    }
+
+    //Any range to uint8_t, bits > 0 for values that only use that many bits of T
+    template <uint8_t bits = 0, typename T>
+    static inline uint8_t scale_trigger(T value)
+    {
+        if constexpr (bits > 0)
+        {
+            return Range::scale_from_bits<uint8_t, bits>(value);
+        }
+        else if constexpr (!std::is_same_v<T, uint8_t>)
+        {
+            return Range::scale<uint8_t>(value);
+        }
+        else
+        {
+            return value;
+        }
+    }
+
+    inline std::pair<int16_t, int16_t> joystick_l(int16_t x, int16_t y, bool invert_y = false) const
+    {
+        return  joy_settings_l_en_
+                    ? apply_joystick_settings(x, y, joy_settings_l_, invert_y)
+                    : std::make_pair(x, (invert_y ? Range::invert(y) : y));
+    }
+
+    inline std::pair<int16_t, int16_t> joystick_r(int16_t x, int16_t y, bool invert_y = false) const
+    {
+        return  joy_settings_r_en_
+                    ? apply_joystick_settings(x, y, joy_settings_r_, invert_y)
+                    : std::make_pair(x, (invert_y ? Range::invert(y) : y));
+    }
+
+    inline uint8_t trigger_l(uint8_t value) const
+    {
+        return trig_settings_l_en_ ? apply_trigger_settings(value, trig_settings_l_) : value;
+    }
+
+    inline uint8_t trigger_r(uint8_t value) const
+    {
+        return trig_settings_r_en_ ? apply_trigger_settings(value, trig_settings_r_) : value;
+    }
+
+    static inline std::pair<int16_t, int16_t> apply_joystick_settings(
+        int16_t gp_joy_x,
+        int16_t gp_joy_y,
+        const JoystickSettings& set,
+        bool invert_y)
+    {
+        static const Fix16
+            FIX_0(0.0f),
+            FIX_1(1.0f),
+            FIX_2(2.0f),
+            FIX_45(45.0f),
+            FIX_90(90.0f),
+            FIX_180(180.0f),
+            FIX_EPSILON(0.0001f),
+            FIX_EPSILON2(0.001f),
+            FIX_ELLIPSE_DEF(1.570796f),
+            FIX_DIAG_DIVISOR(0.29289f);
+
+        Fix16 x = (set.invert_x ? Fix16(Range::invert(gp_joy_x)) : Fix16(gp_joy_x)) / Range::MAX<int16_t>;
+        Fix16 y = ((set.invert_y ^ invert_y) ? Fix16(Range::invert(gp_joy_y)) : Fix16(gp_joy_y)) / Range::MAX<int16_t>;
+
+        const Fix16 abs_x = fix16::abs(x);
+        const Fix16 abs_y = fix16::abs(y);
+        const Fix16 inv_axis_restrict = FIX_1 / (FIX_1 - set.axis_restrict);
+
+        Fix16 rAngle = (abs_x < FIX_EPSILON)
+            ? FIX_90
+            : fix16::rad2deg(fix16::abs(fix16::atan(y / x)));
+
+        Fix16 axial_x = (abs_x <= set.axis_restrict && rAngle > FIX_45)
+            ? FIX_0
+            : ((abs_x - set.axis_restrict) * inv_axis_restrict);
+
+        Fix16 axial_y = (abs_y <= set.axis_restrict && rAngle <= FIX_45)
+            ? FIX_0
+            : ((abs_y - set.axis_restrict) * inv_axis_restrict);
+
+        Fix16 in_magnitude = fix16::sqrt(fix16::sq(axial_x) + fix16::sq(axial_y));
+
+        if (in_magnitude < set.dz_inner)
+        {
+            return { 0, 0 };
+        }
+
+        Fix16 angle =
+            fix16::abs(axial_x) < FIX_EPSILON
+                ? FIX_90
+                : fix16::rad2deg(fix16::abs(fix16::atan(axial_y / axial_x)));
+
+        Fix16 anti_r_scale = (set.anti_dz_square_y_scale == FIX_0) ? set.anti_dz_square : set.anti_dz_square_y_scale;
+        Fix16 anti_dz_c = set.anti_dz_circle;
+
+        if (anti_r_scale > FIX_0 && anti_dz_c > FIX_0)
+        {
+            Fix16 anti_ellip_scale = anti_ellip_scale / anti_dz_c;
+            Fix16 ellipse_angle = fix16::atan((FIX_1 / anti_ellip_scale) * fix16::tan(fix16::rad2deg(rAngle)));
+            ellipse_angle = (ellipse_angle < FIX_0) ? FIX_ELLIPSE_DEF : ellipse_angle;
+
+            Fix16 ellipse_x = fix16::cos(ellipse_angle);
+            Fix16 ellipse_y = fix16::sqrt(fix16::sq(anti_ellip_scale) * (FIX_1 - fix16::sq(ellipse_x)));
+            anti_dz_c *= fix16::sqrt(fix16::sq(ellipse_x) + fix16::sq(ellipse_y));
+        }
+
+        if (anti_dz_c > FIX_0)
+        {
+            anti_dz_c = anti_dz_c / ((anti_dz_c * (FIX_1 - set.anti_dz_circle / set.dz_outer)) / (anti_dz_c * (FIX_1 - set.anti_dz_square)));
+        }
+
+        if (abs_x > set.axis_restrict && abs_y > set.axis_restrict)
+        {
+            const Fix16 FIX_ANGLE_MAX = set.angle_restrict / 2.0f;
+
+            if (angle > FIX_0 && angle < FIX_ANGLE_MAX)
+            {
+                angle = FIX_0;
+            }
+            if (angle > (FIX_90 - FIX_ANGLE_MAX))
+            {
+                angle = FIX_90;
+            }
+            if (angle > FIX_ANGLE_MAX && angle < (FIX_90 - FIX_ANGLE_MAX))
+            {
+                angle = ((angle - FIX_ANGLE_MAX) * FIX_90) / ((FIX_90 - FIX_ANGLE_MAX) - FIX_ANGLE_MAX);
+            }
+        }
+
+        Fix16 ref_angle = (angle < FIX_EPSILON2) ? FIX_0 : angle;
+        Fix16 diagonal = (angle > FIX_45) ? (((angle - FIX_45) * (-FIX_45)) / FIX_45) + FIX_45 : angle;
+
+        const Fix16 angle_comp = set.angle_restrict / FIX_2;
+
+        if (angle < FIX_90 && angle > FIX_0)
+        {
+            angle = ((angle * ((FIX_90 - angle_comp) - angle_comp)) / FIX_90) + angle_comp;
+        }
+
+        if (axial_x < FIX_0 && axial_y > FIX_0)
+        {
+            angle = -angle;
+        }
+        if (axial_x > FIX_0 && axial_y < FIX_0)
+        {
+            angle = angle - FIX_180;
+        }
+        if (axial_x < FIX_0 && axial_y < FIX_0)
+        {
+            angle = angle + FIX_180;
+        }
+
+        //Deadzone Warp
+        Fix16 out_magnitude = (in_magnitude - set.dz_inner) / (set.anti_dz_outer - set.dz_inner);
+        out_magnitude = fix16::pow(out_magnitude, (FIX_1 / set.curve)) * (set.dz_outer - anti_dz_c) + anti_dz_c;
+        out_magnitude = (out_magnitude > set.dz_outer && !set.uncap_radius) ? set.dz_outer : out_magnitude;
+
+        Fix16 d_scale = (((out_magnitude - anti_dz_c) * (set.diag_scale_max - set.diag_scale_min)) / (set.dz_outer - anti_dz_c)) + set.diag_scale_min;
+        Fix16 c_scale = (diagonal * (FIX_1 / fix16::sqrt(FIX_2))) / FIX_45; //Both these lines scale the intensity of the warping
+        c_scale       = FIX_1 - fix16::sqrt(FIX_1 - c_scale * c_scale);     //based on a circular curve to the perfect diagonal
+        d_scale       = (c_scale * (d_scale - FIX_1)) / FIX_DIAG_DIVISOR + FIX_1;
+
+        out_magnitude = out_magnitude * d_scale;
+
+        //Scaling values for square antideadzone
+        Fix16 new_x = fix16::cos(fix16::deg2rad(angle)) * out_magnitude;
+        Fix16 new_y = fix16::sin(fix16::deg2rad(angle)) * out_magnitude;
+
+        //Magic angle wobble fix by user ME.
+        // if (angle > 45.0 && angle < 225.0) {
+        // 	newX = inv(Math.sin(deg2rad(angle - 90.0)))*outputMagnitude;
+        // 	newY = inv(Math.cos(deg2rad(angle - 270.0)))*outputMagnitude;
+        // }
+
+        //Square antideadzone scaling
+        Fix16 output_x = fix16::abs(new_x) * (FIX_1 - set.anti_dz_square / set.dz_outer) + set.anti_dz_square;
+        if (x < FIX_0)
+        {
+            output_x = -output_x;
+        }
+        if (ref_angle == FIX_90)
+        {
+            output_x = FIX_0;
+        }
+
+        Fix16 output_y = fix16::abs(new_y) * (FIX_1 - anti_r_scale / set.dz_outer) + anti_r_scale;
+        if (y < FIX_0)
+        {
+            output_y = -output_y;
+        }
+        if (ref_angle == FIX_0)
+        {
+            output_y = FIX_0;
+        }
+
+        output_x = fix16::clamp(output_x, -FIX_1, FIX_1) * Range::MAX<int16_t>;
+        output_y = fix16::clamp(output_y, -FIX_1, FIX_1) * Range::MAX<int16_t>;
+
+        return { static_cast<int16_t>(fix16_to_int(output_x)), static_cast<int16_t>(fix16_to_int(output_y)) };
+    }
+
+    static inline uint8_t apply_trigger_settings(uint8_t value, const TriggerSettings& set)
+    {
+        Fix16 abs_value = fix16::abs(Fix16(static_cast<int16_t>(value)) / static_cast<int16_t>(Range::MAX<uint8_t>));
+
+        if (abs_value < set.dz_inner)
+        {
+            return 0;
+        }
+
+        static const Fix16
+            FIX_0(0.0f),
+            FIX_1(1.0f);
+
+        Fix16 value_out = (abs_value - set.dz_inner) / (set.anti_dz_outer - set.dz_inner);
+        value_out = fix16::clamp(value_out, FIX_0, FIX_1);
+
+        if (set.anti_dz_inner > FIX_0)
+        {
+            value_out = set.anti_dz_inner + (FIX_1 - set.anti_dz_inner) * value_out;
+        }
+        if (set.curve != FIX_1)
+        {
+            value_out = fix16::pow(value_out, FIX_1 / set.curve);
+        }
+        if (set.anti_dz_outer < FIX_1)
+        {
+            value_out = fix16::clamp(value_out * (FIX_1 / (FIX_1 - set.anti_dz_outer)), FIX_0, FIX_1);
+        }
+
+        value_out *= set.dz_outer;
+        return static_cast<uint8_t>(fix16_to_int(value_out * static_cast<int16_t>(Range::MAX<uint8_t>)));
+    }
+
+private:
+    JoystickSettings joy_settings_l_;
+    JoystickSettings joy_settings_r_;
+    TriggerSettings trig_settings_l_;
+    TriggerSettings trig_settings_r_;
+
+    bool joy_settings_l_en_{false};
+    bool joy_settings_r_en_{false};
+    bool trig_settings_l_en_{false};
+    bool trig_settings_r_en_{false};
+
+}; // class AxisMapper
+
+#endif // _AXIS_MAPPER_H_
@@ -0,0 +1,414 @@
+#ifndef _I2C_LINK_H_
+#define _I2C_LINK_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+
+/*  Delta coding of pad input for the I2C links between boards (four-channel master to
+    slaves, ESP32 to RP2040). Shared by both firmwares, nothing here depends on an SDK.
+
+    Frame: Header | values of the fields set in Header::fields, in FIELDS order | CRC-8
+    The CRC covers everything before it. A frame with every field set is a key frame,
+    the master sends one every KEY_INTERVAL frames and whenever the slave asks for one.
+    Frames are coded against the last one the slave acknowledged, a frame that fails is
+    followed by one that repeats its fields. seq counts every frame sent, a slave that
+    sees a gap asks for a key frame since it can't know which fields it missed.
+
+    Before using frames the master asks for the slave's Caps, each link carries them in
+    its own command packet. A slave that doesn't answer gets the link's legacy packets.
+
+    A slave that drives several pads (CAP_MULTI) takes them in one write instead:
+    MultiHeader | a frame per bit set in MultiHeader::pads, in index order
+    and answers with a MultiReply holding every pad's rumble, so one transaction also
+    polls them all. Each frame keeps its own header and CRC and goes to that pad's
+    Decoder as it is. */
+namespace I2CLink
+{
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t KEY_INTERVAL = 32;
+
+    enum Cap : uint8_t
+    {
+        CAP_DELTA = 1 << 0,
+        CAP_MULTI = 1 << 1,
+    };
+
+    //Pads a multi frame can carry
+    static constexpr uint8_t MAX_PADS = 4;
+
+    //Set in the slave's reply when it needs a key frame
+    static constexpr uint8_t FLAG_NEED_KEY = 1 << 0;
+
+    #pragma pack(push, 1)
+    struct Caps
+    {
+        uint8_t version{VERSION};
+        uint8_t caps{CAP_DELTA};
+    };
+    static_assert(sizeof(Caps) == 2, "I2CLink::Caps size mismatch");
+
+    //Everything a link carries for one pad
+    struct PadState
+    {
+        uint8_t  dpad{0};
+        uint16_t buttons{0};
+        uint8_t  trigger_l{0};
+        uint8_t  trigger_r{0};
+        int16_t  joystick_lx{0};
+        int16_t  joystick_ly{0};
+        int16_t  joystick_rx{0};
+        int16_t  joystick_ry{0};
+        std::array<uint8_t, 10> analog{0};
+        int16_t  accel_x{512};
+        std::array<uint8_t, 3> chatpad{0};
+    };
+    static_assert(sizeof(PadState) == 28, "I2CLink::PadState size mismatch");
+
+    struct Header
+    {
+        uint8_t  packet_len{0};
+        uint8_t  packet_id{0};
+        uint8_t  index{0};
+        uint8_t  seq{0};
+        uint16_t fields{0};
+    };
+    static_assert(sizeof(Header) == 6, "I2CLink::Header size mismatch");
+
+    struct MultiHeader
+    {
+        uint8_t packet_len{0};
+        uint8_t packet_id{0};
+        uint8_t pads{0}; //Bit per pad index with a frame following
+    };
+    static_assert(sizeof(MultiHeader) == 3, "I2CLink::MultiHeader size mismatch");
+
+    struct PadRumble
+    {
+        uint8_t rumble_l{0};
+        uint8_t rumble_r{0};
+    };
+
+    //Slave's answer to a multi frame
+    struct MultiReply
+    {
+        uint8_t packet_len{sizeof(MultiReply)};
+        uint8_t packet_id{0};
+        uint8_t need_key{0}; //Bit per pad index whose Decoder needs a key frame
+        std::array<PadRumble, MAX_PADS> rumble{};
+    };
+    static_assert(sizeof(MultiReply) == 11, "I2CLink::MultiReply size mismatch");
+    #pragma pack(pop)
+
+    struct Field
+    {
+        uint8_t offset;
+        uint8_t len;
+    };
+
+    static constexpr std::array<Field, 11> FIELDS =
+    {{
+        { offsetof(PadState, dpad),        1 },
+        { offsetof(PadState, buttons),     2 },
+        { offsetof(PadState, trigger_l),   1 },
+        { offsetof(PadState, trigger_r),   1 },
+        { offsetof(PadState, joystick_lx), 2 },
+        { offsetof(PadState, joystick_ly), 2 },
+        { offsetof(PadState, joystick_rx), 2 },
+        { offsetof(PadState, joystick_ry), 2 },
+        { offsetof(PadState, analog),      10 },
+        { offsetof(PadState, accel_x),     2 },
+        { offsetof(PadState, chatpad),     3 },
+    }};
+
+    static constexpr uint16_t ALL_FIELDS = (1U << FIELDS.size()) - 1;
+    static constexpr size_t MIN_FRAME_LEN = sizeof(Header) + 1;
+    static constexpr size_t MAX_FRAME_LEN = sizeof(Header) + sizeof(PadState) + 1;
+    static constexpr size_t MAX_MULTI_LEN = sizeof(MultiHeader) + MAX_PADS * MAX_FRAME_LEN;
+    static_assert(MAX_MULTI_LEN <= UINT8_MAX, "I2CLink::MAX_MULTI_LEN doesn't fit packet_len");
+
+    //CRC-8, polynomial 0x07
+    static inline uint8_t crc8(const uint8_t* data, size_t len)
+    {
+        uint8_t crc = 0;
+        for (size_t i = 0; i < len; ++i)
+        {
+            crc ^= data[i];
+            for (uint8_t bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    /*  Master side, the caps to use with a slave that answered with slave. A slave
+        from before VERSION, or one without CAP_DELTA, gets the link's legacy packets (0),
+        and caps this firmware doesn't know are left out. */
+    static inline uint8_t negotiate(const Caps& slave)
+    {
+        if (slave.version < VERSION || !(slave.caps & CAP_DELTA))
+        {
+            return 0;
+        }
+        return slave.caps & (CAP_DELTA | CAP_MULTI);
+    }
+
+    //Length of the values for fields
+    static inline size_t fields_len(uint16_t fields)
+    {
+        size_t len = 0;
+        for (size_t i = 0; i < FIELDS.size(); ++i)
+        {
+            if (fields & (1U << i))
+            {
+                len += FIELDS[i].len;
+            }
+        }
+        return len;
+    }
+
+    //Master side, one per pad
+    class Encoder
+    {
+    public:
+        /*  Writes a frame for state into out (MAX_FRAME_LEN bytes) and returns its length.
+            Call commit() once the slave has acknowledged it, otherwise the next frame
+            is coded against the same base again and repeats the fields of this one, the
+            slave may have applied it anyway. */
+        size_t encode(const PadState& state, uint8_t packet_id, uint8_t index, uint8_t* out)
+        {
+            const bool key = need_key_ || (frames_since_key_ >= KEY_INTERVAL);
+            const uint8_t* cur_ptr = reinterpret_cast<const uint8_t*>(&state);
+            const uint8_t* base_ptr = reinterpret_cast<const uint8_t*>(&base_);
+
+            Header header;
+            header.packet_id = packet_id;
+            header.index = index;
+            header.seq = seq_++;
+
+            size_t len = sizeof(Header);
+            for (size_t i = 0; i < FIELDS.size(); ++i)
+            {
+                const Field& field = FIELDS[i];
+                if (key || (unacked_fields_ & (1U << i)) ||
+                    std::memcmp(cur_ptr + field.offset, base_ptr + field.offset, field.len) != 0)
+                {
+                    std::memcpy(out + len, cur_ptr + field.offset, field.len);
+                    len += field.len;
+                    header.fields |= static_cast<uint16_t>(1U << i);
+                }
+            }
+
+            header.packet_len = static_cast<uint8_t>(len + 1);
+            std::memcpy(out, &header, sizeof(Header));
+            out[len] = crc8(out, len);
+
+            pending_ = state;
+            pending_key_ = (header.fields == ALL_FIELDS);
+            unacked_fields_ = header.fields;
+            return len + 1;
+        }
+
+        void commit()
+        {
+            base_ = pending_;
+            unacked_fields_ = 0;
+            if (pending_key_)
+            {
+                need_key_ = false;
+                frames_since_key_ = 0;
+            }
+            else
+            {
+                ++frames_since_key_;
+            }
+        }
+
+        //Next frame is a key frame, e.g. the slave asked or the link was reset
+        void request_key() { need_key_ = true; }
+
+    private:
+        PadState base_;
+        PadState pending_;
+        uint16_t unacked_fields_{0};
+        uint8_t seq_{0};
+        uint8_t frames_since_key_{0};
+        bool pending_key_{false};
+        bool need_key_{true};
+    };
+
+    //Slave side, one per pad
+    class Decoder
+    {
+    public:
+        enum class Result : uint8_t
+        {
+            OK = 0,
+            GAP,            //Applied, but a frame was missed, state may be stale until the next key
+            BAD_LENGTH,     //Dropped
+            BAD_CRC         //Dropped
+        };
+
+        struct Stats
+        {
+            uint32_t frames{0};
+            uint32_t keys{0};
+            uint32_t gaps{0};
+            uint32_t length_errors{0};
+            uint32_t crc_errors{0};
+        };
+
+        //Applies a frame to state, which holds the last decoded input of this pad
+        Result decode(const uint8_t* data, size_t len, PadState& state)
+        {
+            if (len < MIN_FRAME_LEN || len > MAX_FRAME_LEN || data[0] != len)
+            {
+                ++stats_.length_errors;
+                return Result::BAD_LENGTH;
+            }
+
+            Header header;
+            std::memcpy(&header, data, sizeof(Header));
+
+            if ((header.fields & ~ALL_FIELDS) || sizeof(Header) + fields_len(header.fields) + 1 != len)
+            {
+                ++stats_.length_errors;
+                return Result::BAD_LENGTH;
+            }
+            if (crc8(data, len - 1) != data[len - 1])
+            {
+                ++stats_.crc_errors;
+                return Result::BAD_CRC;
+            }
+
+            uint8_t* state_ptr = reinterpret_cast<uint8_t*>(&state);
+            size_t offset = sizeof(Header);
+            for (size_t i = 0; i < FIELDS.size(); ++i)
+            {
+                if (header.fields & (1U << i))
+                {
+                    std::memcpy(state_ptr + FIELDS[i].offset, data + offset, FIELDS[i].len);
+                    offset += FIELDS[i].len;
+                }
+            }
+
+            ++stats_.frames;
+            const bool key = (header.fields == ALL_FIELDS);
+            const bool gap = synced_ && (header.seq != expected_seq_);
+            expected_seq_ = header.seq + 1;
+
+            if (key)
+            {
+                ++stats_.keys;
+                synced_ = true;
+                need_key_ = false;
+                return Result::OK;
+            }
+            if (gap)
+            {
+                ++stats_.gaps;
+                need_key_ = true;
+                return Result::GAP;
+            }
+            return synced_ ? Result::OK : Result::GAP;
+        }
+
+        //Forget the master, e.g. after it renegotiated
+        void reset()
+        {
+            synced_ = false;
+            need_key_ = true;
+        }
+
+        inline bool need_key() const { return need_key_; }
+        inline const Stats& stats() const { return stats_; }
+
+    private:
+        Stats stats_;
+        uint8_t expected_seq_{0};
+        bool synced_{false};
+        bool need_key_{true};
+    };
+
+    /*  Master side, writes a multi frame for the pads set in pads into out (MAX_MULTI_LEN
+        bytes) and returns its length. encoders and states are indexed by pad, commit()
+        each pad's Encoder once the slave has acknowledged the write. */
+    static inline size_t encode_multi(  Encoder* encoders, const PadState* states, uint8_t pads, 
+                                        uint8_t packet_id, uint8_t* out)
+    {
+        MultiHeader header;
+        header.packet_id = packet_id;
+        header.pads = pads & ((1U << MAX_PADS) - 1);
+
+        size_t len = sizeof(MultiHeader);
+        for (uint8_t i = 0; i < MAX_PADS; ++i)
+        {
+            if (header.pads & (1U << i))
+            {
+                len += encoders[i].encode(states[i], packet_id, i, out + len);
+            }
+        }
+
+        header.packet_len = static_cast<uint8_t>(len);
+        std::memcpy(out, &header, sizeof(MultiHeader));
+        return len;
+    }
+
+    /*  Slave side, calls function(index, frame, frame_len) for each frame of a multi frame.
+        The frames' lengths and indexes are checked first, a malformed write returns false
+        without calling function. The frames' CRCs are left to their Decoders. */
+    template<typename Function>
+    static inline bool split_multi(const uint8_t* data, size_t len, Function&& function)
+    {
+        if (len < sizeof(MultiHeader) || len > MAX_MULTI_LEN || data[0] != len)
+        {
+            return false;
+        }
+
+        const uint8_t pads = data[2];
+        if (pads & ~((1U << MAX_PADS) - 1))
+        {
+            return false;
+        }
+
+        size_t offset = sizeof(MultiHeader);
+        for (uint8_t i = 0; i < MAX_PADS; ++i)
+        {
+            if (!(pads & (1U << i)))
+            {
+                continue;
+            }
+            if (offset + MIN_FRAME_LEN > len)
+            {
+                return false;
+            }
+            const size_t frame_len = data[offset];
+            if (frame_len < MIN_FRAME_LEN || frame_len > MAX_FRAME_LEN || 
+                offset + frame_len > len || data[offset + 2] != i)
+            {
+                return false;
+            }
+            offset += frame_len;
+        }
+        if (offset != len)
+        {
+            return false;
+        }
+
+        offset = sizeof(MultiHeader);
+        for (uint8_t i = 0; i < MAX_PADS; ++i)
+        {
+            if (pads & (1U << i))
+            {
+                function(i, data + offset, static_cast<size_t>(data[offset]));
+                offset += data[offset];
+            }
+        }
+        return true;
+    }
+
+} // namespace I2CLink
+
+#endif // _I2C_LINK_H_
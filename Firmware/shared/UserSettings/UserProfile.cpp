@@ -0,0 +1,45 @@
+#include <cstring>
+
+#include "Gamepad/GamepadDefs.h"
+#include "UserSettings/UserProfile.h"
+
+//New profiles on the ESP32 start with analog buttons off, its build sets this to 0
+#ifndef OGXM_PROFILE_ANALOG_ENABLED
+#define OGXM_PROFILE_ANALOG_ENABLED 1
+#endif
+
+UserProfile::UserProfile()
+{
+    id = 1;
+
+    dpad_up = GamepadDefs::DPAD_UP;
+    dpad_down = GamepadDefs::DPAD_DOWN;
+    dpad_left = GamepadDefs::DPAD_LEFT;
+    dpad_right = GamepadDefs::DPAD_RIGHT;
+
+    button_a = GamepadDefs::BUTTON_A;
+    button_b = GamepadDefs::BUTTON_B;
+    button_x = GamepadDefs::BUTTON_X;
+    button_y = GamepadDefs::BUTTON_Y;
+    button_l3 = GamepadDefs::BUTTON_L3;
+    button_r3 = GamepadDefs::BUTTON_R3;
+    button_back = GamepadDefs::BUTTON_BACK;
+    button_start = GamepadDefs::BUTTON_START;
+    button_lb = GamepadDefs::BUTTON_LB;
+    button_rb = GamepadDefs::BUTTON_RB;
+    button_sys = GamepadDefs::BUTTON_SYS;
+    button_misc = GamepadDefs::BUTTON_MISC;
+
+    analog_enabled = OGXM_PROFILE_ANALOG_ENABLED;
+
+    analog_off_up = GamepadDefs::ANALOG_OFF_UP;
+    analog_off_down = GamepadDefs::ANALOG_OFF_DOWN;
+    analog_off_left = GamepadDefs::ANALOG_OFF_LEFT;
+    analog_off_right = GamepadDefs::ANALOG_OFF_RIGHT;
+    analog_off_a = GamepadDefs::ANALOG_OFF_A;
+    analog_off_b = GamepadDefs::ANALOG_OFF_B;
+    analog_off_x = GamepadDefs::ANALOG_OFF_X;
+    analog_off_y = GamepadDefs::ANALOG_OFF_Y;
+    analog_off_lb = GamepadDefs::ANALOG_OFF_LB;
+    analog_off_rb = GamepadDefs::ANALOG_OFF_RB;
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <cstdint>
+#include <cstdlib>
+
+#include "Check.h"
+#include "Gamepad/AxisMapper.h"
+#include "Gamepad/Range.h"
+#include "Gamepad/fix16ext.h"
+
+/*  Range, fix16ext and AxisMapper checked by their properties (end points, order, zero
+    in zero out) rather than exact fix16 results, so they hold for any libfixmath build
+    options. */
+
+static bool near(Fix16 value, float expected, float tolerance)
+{
+    return std::abs(fix16_to_float(value.value) - expected) <= tolerance;
+}
+
+static void test_range()
+{
+    CHECK(Range::scale<int16_t>(uint8_t(0)) == Range::MIN<int16_t>);
+    CHECK(Range::scale<int16_t>(uint8_t(255)) == Range::MAX<int16_t>);
+    CHECK(Range::scale<uint8_t>(Range::MIN<int16_t>) == 0);
+    CHECK(Range::scale<uint8_t>(Range::MAX<int16_t>) == 255);
+
+    int16_t last = Range::MIN<int16_t>;
+    for (int value = 1; value <= 255; ++value)
+    {
+        int16_t scaled = Range::scale<int16_t>(static_cast<uint8_t>(value));
+        CHECK(scaled > last);
+        last = scaled;
+    }
+
+    //10 bit sticks, out of range values clamp to the ends
+    CHECK((Range::scale_from_bits<int16_t, 10>(int16_t(-512)) == Range::MIN<int16_t>));
+    CHECK((Range::scale_from_bits<int16_t, 10>(int16_t(511)) == Range::MAX<int16_t>));
+    CHECK((Range::scale_from_bits<int16_t, 10>(int16_t(2000)) == Range::MAX<int16_t>));
+
+    CHECK(Range::invert(Range::MIN<int16_t>) == Range::MAX<int16_t>);
+    CHECK(Range::invert(int16_t(100)) == -100);
+    CHECK(Range::invert(uint8_t(0)) == 255);
+    CHECK(Range::clamp<int8_t>(300) == 127);
+    CHECK(Range::clamp<int8_t>(-300) == -128);
+
+    for (int value = 0; value <= 255; ++value)
+    {
+        uint8_t byte = static_cast<uint8_t>(value);
+        CHECK(Scale::int16_to_uint8(Scale::uint8_to_int16(byte)) == byte);
+        CHECK(Scale::int8_to_uint8(Scale::uint8_to_int8(byte)) == byte);
+    }
+    CHECK(Scale::uint8_to_int16(Range::MID<uint8_t>) == 0);
+    CHECK(Scale::int16_to_uint8(0) == Range::MID<uint8_t>);
+}
+
+static void test_fix16ext()
+{
+    CHECK(near(fix16::abs(Fix16(-2.5f)), 2.5f, 0.001f));
+    CHECK(near(fix16::sqrt(Fix16(4.0f)), 2.0f, 0.01f));
+    CHECK(near(fix16::sq(Fix16(-3.0f)), 9.0f, 0.01f));
+    CHECK(near(fix16::clamp(Fix16(2.0f), Fix16(-1.0f), Fix16(1.0f)), 1.0f, 0.0f));
+    CHECK(near(fix16::clamp(Fix16(-2.0f), Fix16(-1.0f), Fix16(1.0f)), -1.0f, 0.0f));
+    CHECK(near(fix16::pow(Fix16(0.5f), Fix16(1.0f)), 0.5f, 0.001f));
+    CHECK(near(fix16::pow(Fix16(0.5f), Fix16(0.0f)), 1.0f, 0.001f));
+    CHECK(near(fix16::pow(Fix16(0.5f), Fix16(2.0f)), 0.25f, 0.01f));
+    CHECK(near(fix16::rad2deg(fix16::deg2rad(Fix16(45.0f))), 45.0f, 0.05f));
+    CHECK(near(fix16::atan(Fix16(1.0f)), 0.785398f, 0.01f));
+
+    for (int deg = -180; deg <= 180; deg += 15)
+    {
+        Fix16 rad = fix16::deg2rad(Fix16(static_cast<int16_t>(deg)));
+        Fix16 unit = fix16::sq(fix16::sin(rad)) + fix16::sq(fix16::cos(rad));
+        CHECK(near(unit, 1.0f, 0.01f));
+    }
+}
+
+static void test_axis_mapper_defaults()
+{
+    AxisMapper mapper;
+    mapper.set_profile(UserProfile());
+
+    CHECK(!mapper.joystick_l_enabled());
+    CHECK(!mapper.joystick_r_enabled());
+    CHECK(!mapper.trigger_l_enabled());
+    CHECK(!mapper.trigger_r_enabled());
+
+    //Defaults pass values through untouched
+    for (int value = -32768; value <= 32767; value += 257)
+    {
+        auto [x, y] = mapper.joystick_l(static_cast<int16_t>(value), static_cast<int16_t>(-value - 1));
+        CHECK(x == value && y == -value - 1);
+        auto [ix, iy] = mapper.joystick_r(0, static_cast<int16_t>(value), true);
+        CHECK(ix == 0 && iy == Range::invert(static_cast<int16_t>(value)));
+    }
+    for (int value = 0; value <= 255; ++value)
+    {
+        CHECK(mapper.trigger_l(static_cast<uint8_t>(value)) == value);
+    }
+
+    CHECK((AxisMapper::scale_joystick(uint8_t(0), uint8_t(255)) == std::pair<int16_t, int16_t>{ Range::MIN<int16_t>, Range::MAX<int16_t> }));
+    CHECK((AxisMapper::scale_joystick<10>(int16_t(-512), int16_t(511)) == std::pair<int16_t, int16_t>{ Range::MIN<int16_t>, Range::MAX<int16_t> }));
+    CHECK(AxisMapper::scale_trigger(uint16_t(65535)) == 255);
+    CHECK(AxisMapper::scale_trigger<10>(uint16_t(1023)) == 255);
+}
+
+static void test_axis_mapper_trigger_deadzone()
+{
+    UserProfile profile;
+    profile.trigger_settings_l.dz_inner = fix16_from_float(0.2f);
+
+    AxisMapper mapper;
+    mapper.set_profile(profile);
+    CHECK(mapper.trigger_l_enabled());
+    CHECK(!mapper.trigger_r_enabled());
+
+    uint8_t last = 0;
+    for (int value = 0; value <= 255; ++value)
+    {
+        uint8_t out = mapper.trigger_l(static_cast<uint8_t>(value));
+        if (value < 50)
+        {
+            CHECK(out == 0);
+        }
+        CHECK(out >= last);
+        last = out;
+    }
+    CHECK(mapper.trigger_l(255) >= 250);
+    CHECK(mapper.trigger_r(100) == 100);
+}
+
+static void test_axis_mapper_joystick_deadzone()
+{
+    UserProfile profile;
+    profile.joystick_settings_l.dz_inner = fix16_from_float(0.1f);
+
+    AxisMapper mapper;
+    mapper.set_profile(profile);
+    CHECK(mapper.joystick_l_enabled());
+
+    CHECK((mapper.joystick_l(0, 0) == std::pair<int16_t, int16_t>{ 0, 0 }));
+    CHECK((mapper.joystick_l(1000, -1000) == std::pair<int16_t, int16_t>{ 0, 0 }));
+
+    //Full deflection on one axis stays on that axis
+    auto [right_x, right_y] = mapper.joystick_l(Range::MAX<int16_t>, 0);
+    CHECK(right_x > 30000 && right_y == 0);
+    auto [down_x, down_y] = mapper.joystick_l(0, Range::MIN<int16_t>);
+    CHECK(down_x == 0 && down_y < -30000);
+
+    //Outside the deadzone the sign of each axis is kept
+    for (int angle = 0; angle < 360; angle += 10)
+    {
+        Fix16 rad = fix16::deg2rad(Fix16(static_cast<int16_t>(angle)));
+        int16_t x = static_cast<int16_t>(fix16_to_int(fix16::cos(rad) * Fix16(int16_t(20000))));
+        int16_t y = static_cast<int16_t>(fix16_to_int(fix16::sin(rad) * Fix16(int16_t(20000))));
+        auto [out_x, out_y] = mapper.joystick_l(x, y);
+        CHECK(std::abs(x) < 1000 || (out_x > 0) == (x > 0));
+        CHECK(std::abs(y) < 1000 || (out_y > 0) == (y > 0));
+    }
+}
+
+int main()
+{
+    test_range();
+    test_fix16ext();
+    test_axis_mapper_defaults();
+    test_axis_mapper_trigger_deadzone();
+    test_axis_mapper_joystick_deadzone();
+    return check::result("AxisMapperTest");
+}
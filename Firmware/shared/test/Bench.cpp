@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Check.h"
+#include "Gamepad/AxisMapper.h"
+#include "I2CLink/I2CLink.h"
+
+/*  Host timings of the hot paths, ns per call. Only useful compared against another
+    run on the same machine, e.g. before and after a change to AxisMapper.
+    ogxm_core_bench [iterations] */
+
+static volatile int32_t sink;
+
+int main(int argc, char** argv)
+{
+    const uint32_t iterations = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+
+    AxisMapper defaults;
+    defaults.set_profile(UserProfile());
+
+    UserProfile profile;
+    profile.joystick_settings_l.dz_inner = fix16_from_float(0.1f);
+    profile.joystick_settings_l.anti_dz_circle = fix16_from_float(0.1f);
+    profile.joystick_settings_l.curve = fix16_from_float(1.5f);
+    profile.trigger_settings_l.dz_inner = fix16_from_float(0.1f);
+    profile.trigger_settings_l.curve = fix16_from_float(1.5f);
+    AxisMapper mapper;
+    mapper.set_profile(profile);
+
+    std::printf("joystick, defaults:   %8.1f ns\n", check::time_ns(iterations, [&](uint32_t i)
+    {
+        auto [x, y] = defaults.joystick_l(static_cast<int16_t>(i * 7), static_cast<int16_t>(i * 13));
+        sink = x + y;
+    }));
+    std::printf("joystick, settings:   %8.1f ns\n", check::time_ns(iterations, [&](uint32_t i)
+    {
+        auto [x, y] = mapper.joystick_l(static_cast<int16_t>(i * 7), static_cast<int16_t>(i * 13));
+        sink = x + y;
+    }));
+    std::printf("trigger, settings:    %8.1f ns\n", check::time_ns(iterations, [&](uint32_t i)
+    {
+        sink = mapper.trigger_l(static_cast<uint8_t>(i));
+    }));
+    std::printf("scale_joystick<10>:   %8.1f ns\n", check::time_ns(iterations, [&](uint32_t i)
+    {
+        auto [x, y] = AxisMapper::scale_joystick<10>(static_cast<int16_t>(i & 0x3FF) - 512, 0);
+        sink = x + y;
+    }));
+
+    I2CLink::Encoder encoder;
+    I2CLink::Decoder decoder;
+    I2CLink::PadState state, slave;
+    uint8_t frame[I2CLink::MAX_FRAME_LEN];
+
+    std::printf("I2CLink encode+decode: %7.1f ns\n", check::time_ns(iterations, [&](uint32_t i)
+    {
+        state.joystick_lx = static_cast<int16_t>(i);
+        if ((i & 0xF) == 0)
+        {
+            state.buttons ^= 1;
+        }
+        size_t len = encoder.encode(state, 1, 0, frame);
+        encoder.commit();
+        sink = static_cast<int32_t>(decoder.decode(frame, len, slave));
+    }));
+    return 0;
+}
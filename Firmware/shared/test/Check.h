@@ -0,0 +1,57 @@
+#ifndef _OGXM_CHECK_H_
+#define _OGXM_CHECK_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+
+/*  Just enough of a test framework for the host tests: CHECK logs the failing
+    expression and carries on so one run shows every failure, the test's main()
+    returns check::result() for ctest. */
+namespace check
+{
+    inline uint32_t& failures()
+    {
+        static uint32_t count = 0;
+        return count;
+    }
+
+    inline bool report(bool ok, const char* expr, const char* file, int line)
+    {
+        if (!ok)
+        {
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+            ++failures();
+        }
+        return ok;
+    }
+
+    inline int result(const char* name)
+    {
+        if (failures())
+        {
+            std::fprintf(stderr, "%s: %u check(s) failed\n", name, failures());
+            return 1;
+        }
+        std::printf("%s: ok\n", name);
+        return 0;
+    }
+
+    //Nanoseconds per call of function, for the benchmarks
+    template<typename Function>
+    inline double time_ns(uint32_t iterations, Function&& function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            function(i);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+} // namespace check
+
+#define CHECK(expr) check::report(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
+
+#endif // _OGXM_CHECK_H_
@@ -0,0 +1,207 @@
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include "Check.h"
+#include "DriverSlot.h"
+
+/*  The RP2040's DriverSlot over many random emplace/reset cycles: every driver it
+    constructs is destroyed exactly once, through Base, and each one sits in the
+    slot's own storage at its type's alignment. */
+
+struct Counts
+{
+    std::array<int32_t, 3> alive{};
+    std::array<uint32_t, 3> constructed{};
+    std::array<uint32_t, 3> destroyed{};
+};
+
+static Counts counts;
+
+struct Base
+{
+    virtual ~Base() = default;
+    virtual uint8_t type() const = 0;
+    virtual uint32_t value() const = 0;
+};
+
+template <uint8_t TYPE>
+struct Counted : Base
+{
+    explicit Counted(uint32_t value) : value_(value)
+    {
+        ++counts.alive[TYPE];
+        ++counts.constructed[TYPE];
+    }
+    ~Counted() override
+    {
+        --counts.alive[TYPE];
+        ++counts.destroyed[TYPE];
+    }
+    uint8_t type() const override { return TYPE; }
+    uint32_t value() const override { return value_; }
+
+    uint32_t value_;
+};
+
+struct Small : Counted<0>
+{
+    using Counted::Counted;
+    uint8_t byte{0x5A};
+};
+
+struct alignas(16) Wide : Counted<1>
+{
+    using Counted::Counted;
+    std::array<uint8_t, 48> bytes{};
+};
+
+struct alignas(64) Aligned : Counted<2>
+{
+    using Counted::Counted;
+    uint32_t word{0};
+};
+
+using Slot = DriverSlot<Base, Small, Wide, Aligned>;
+
+static_assert(Slot::SIZE == sizeof(Aligned) && Slot::SIZE >= sizeof(Wide), "Slot sized for the largest driver");
+static_assert(Slot::ALIGN == alignof(Aligned), "Slot aligned for the most aligned driver");
+
+static int32_t alive()
+{
+    return counts.alive[0] + counts.alive[1] + counts.alive[2];
+}
+
+static bool in_slot(const Slot& slot, const void* driver)
+{
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(&slot);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(driver);
+    return address >= begin && address < begin + sizeof(Slot);
+}
+
+template <typename T>
+static bool aligned(const T* driver)
+{
+    return reinterpret_cast<uintptr_t>(driver) % alignof(T) == 0;
+}
+
+static void test_empty()
+{
+    Slot slot;
+    CHECK(!slot && slot.get() == nullptr);
+    slot.reset();
+    CHECK(!slot && alive() == 0);
+}
+
+static void test_random_cycles(uint32_t seed, uint32_t steps)
+{
+    std::mt19937 rng(seed);
+    std::array<Slot, 4> slots;
+    std::array<int8_t, 4> expected_type;
+    std::array<uint32_t, 4> expected_value{};
+    expected_type.fill(-1);
+
+    const Counts start = counts;
+    uint32_t emplaced = 0;
+
+    for (uint32_t step = 0; step < steps; ++step)
+    {
+        const uint32_t idx = rng() % slots.size();
+        Slot& slot = slots[idx];
+        const uint32_t op = rng() % 4;
+        const uint32_t value = rng();
+
+        if (op == 3)
+        {
+            slot.reset();
+            expected_type[idx] = -1;
+        }
+        else
+        {
+            const Base* driver = nullptr;
+            bool ok = false;
+            switch (op)
+            {
+                case 0:
+                {
+                    Small* small = slot.emplace<Small>(value);
+                    ok = aligned(small) && small->byte == 0x5A;
+                    driver = small;
+                    break;
+                }
+                case 1:
+                {
+                    Wide* wide = slot.emplace<Wide>(value);
+                    ok = aligned(wide);
+                    driver = wide;
+                    break;
+                }
+                default:
+                {
+                    Aligned* big = slot.emplace<Aligned>(value);
+                    ok = aligned(big) && big->word == 0;
+                    driver = big;
+                    break;
+                }
+            }
+            CHECK(ok && in_slot(slot, driver) && slot.get() == driver);
+            expected_type[idx] = static_cast<int8_t>(op);
+            expected_value[idx] = value;
+            ++emplaced;
+        }
+
+        //After every step the slots hold exactly what the reference says they do
+        int32_t expected_alive = 0;
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            if (expected_type[i] < 0)
+            {
+                CHECK(!slots[i] && slots[i].get() == nullptr);
+                continue;
+            }
+            ++expected_alive;
+            CHECK(slots[i] && slots[i]->type() == expected_type[i] && slots[i]->value() == expected_value[i]);
+        }
+        CHECK(alive() == expected_alive);
+    }
+
+    uint32_t constructed = 0;
+    uint32_t destroyed = 0;
+    for (size_t t = 0; t < counts.alive.size(); ++t)
+    {
+        constructed += counts.constructed[t] - start.constructed[t];
+        destroyed += counts.destroyed[t] - start.destroyed[t];
+    }
+    CHECK(constructed == emplaced);
+    CHECK(destroyed + static_cast<uint32_t>(alive()) == constructed);
+}
+
+//Destroying the slot destroys whatever it still holds, once
+static void test_destructor()
+{
+    const Counts start = counts;
+    {
+        Slot held;
+        held.emplace<Wide>(1u);
+        held.emplace<Aligned>(2u);
+        Slot empty;
+        Slot cleared;
+        cleared.emplace<Small>(3u);
+        cleared.reset();
+        CHECK(alive() == 1);
+    }
+    CHECK(alive() == 0);
+    CHECK(counts.destroyed[0] - start.destroyed[0] == 1);
+    CHECK(counts.destroyed[1] - start.destroyed[1] == 1);
+    CHECK(counts.destroyed[2] - start.destroyed[2] == 1);
+}
+
+int main()
+{
+    test_empty();
+    test_random_cycles(1, 20000);
+    test_random_cycles(0xC0FFEE, 20000);
+    test_destructor();
+    CHECK(alive() == 0);
+    return check::result("DriverSlotTest");
+}
@@ -0,0 +1,493 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#include "Check.h"
+#include "I2CLink/I2CLink.h"
+
+using namespace I2CLink;
+
+static bool same(const PadState& a, const PadState& b)
+{
+    return std::memcmp(&a, &b, sizeof(PadState)) == 0;
+}
+
+static uint16_t frame_fields(const uint8_t* frame)
+{
+    Header header;
+    std::memcpy(&header, frame, sizeof(Header));
+    return header.fields;
+}
+
+static void test_key_then_delta()
+{
+    Encoder encoder;
+    Decoder decoder;
+    PadState state, slave;
+    uint8_t frame[MAX_FRAME_LEN];
+
+    //First frame is a key frame
+    state.buttons = 0x1234;
+    size_t len = encoder.encode(state, 0x10, 2, frame);
+    CHECK(len == MAX_FRAME_LEN);
+    CHECK(frame_fields(frame) == ALL_FIELDS);
+    CHECK(frame[2] == 2);
+    CHECK(decoder.decode(frame, len, slave) == Decoder::Result::OK);
+    CHECK(same(state, slave));
+    CHECK(!decoder.need_key());
+    encoder.commit();
+
+    //An idle pad costs a header and a CRC
+    len = encoder.encode(state, 0x10, 2, frame);
+    CHECK(len == MIN_FRAME_LEN);
+    CHECK(decoder.decode(frame, len, slave) == Decoder::Result::OK);
+    encoder.commit();
+
+    //Only the changed fields are sent
+    state.joystick_lx = -1200;
+    state.trigger_r = 77;
+    len = encoder.encode(state, 0x10, 2, frame);
+    CHECK(len == MIN_FRAME_LEN + 2 + 1);
+    CHECK(frame_fields(frame) == ((1U << 3) | (1U << 4)));
+    CHECK(decoder.decode(frame, len, slave) == Decoder::Result::OK);
+    CHECK(same(state, slave));
+    encoder.commit();
+
+    CHECK(decoder.stats().frames == 3 && decoder.stats().keys == 1);
+}
+
+static void test_uncommitted_frame_repeats()
+{
+    Encoder encoder;
+    Decoder decoder;
+    PadState state, slave;
+    uint8_t frame[MAX_FRAME_LEN];
+
+    decoder.decode(frame, encoder.encode(state, 1, 0, frame), slave);
+    encoder.commit();
+
+    //Lost on the bus, never committed
+    state.buttons = 0x0001;
+    encoder.encode(state, 1, 0, frame);
+
+    //The next frame carries the lost field along with the new one
+    state.trigger_l = 200;
+    size_t len = encoder.encode(state, 1, 0, frame);
+    CHECK(frame_fields(frame) == ((1U << 1) | (1U << 2)));
+    CHECK(decoder.decode(frame, len, slave) == Decoder::Result::GAP);
+    CHECK(same(state, slave));
+    CHECK(decoder.need_key());
+}
+
+static void test_key_interval()
+{
+    Encoder encoder;
+    PadState state;
+    uint8_t frame[MAX_FRAME_LEN];
+
+    encoder.encode(state, 1, 0, frame);
+    encoder.commit();
+    for (uint8_t i = 0; i < KEY_INTERVAL; ++i)
+    {
+        CHECK(encoder.encode(state, 1, 0, frame) == MIN_FRAME_LEN);
+        encoder.commit();
+    }
+    CHECK(encoder.encode(state, 1, 0, frame) == MAX_FRAME_LEN);
+    encoder.commit();
+
+    encoder.request_key();
+    CHECK(encoder.encode(state, 1, 0, frame) == MAX_FRAME_LEN);
+}
+
+static void test_rejects_bad_frames()
+{
+    Encoder encoder;
+    Decoder decoder;
+    PadState state, slave;
+    uint8_t frame[MAX_FRAME_LEN];
+
+    state.joystick_ry = 4000;
+    size_t len = encoder.encode(state, 1, 0, frame);
+
+    frame[len - 1] ^= 0x01;
+    CHECK(decoder.decode(frame, len, slave) == Decoder::Result::BAD_CRC);
+    frame[len - 1] ^= 0x01;
+
+    CHECK(decoder.decode(frame, len - 1, slave) == Decoder::Result::BAD_LENGTH);
+    CHECK(decoder.decode(frame, 3, slave) == Decoder::Result::BAD_LENGTH);
+    CHECK(same(slave, PadState()));
+
+    CHECK(decoder.decode(frame, len, slave) == Decoder::Result::OK);
+    CHECK(decoder.stats().crc_errors == 1 && decoder.stats().length_errors == 2);
+}
+
+//What each master makes of the slave's GET_CAPS answer
+static void test_negotiate()
+{
+    CHECK(negotiate(Caps()) == CAP_DELTA);
+
+    //Older firmware answers with zeros, or with a version before this one
+    Caps caps;
+    caps.version = 0;
+    caps.caps = 0;
+    CHECK(negotiate(caps) == 0);
+    caps.caps = CAP_DELTA | CAP_MULTI;
+    CHECK(negotiate(caps) == 0);
+
+    caps.version = VERSION;
+    CHECK(negotiate(caps) == (CAP_DELTA | CAP_MULTI));
+
+    //Multi frames are delta frames, without CAP_DELTA it's legacy packets
+    caps.caps = CAP_MULTI;
+    CHECK(negotiate(caps) == 0);
+
+    //A newer slave keeps the caps both sides know
+    caps.version = VERSION + 1;
+    caps.caps = 0xFF;
+    CHECK(negotiate(caps) == (CAP_DELTA | CAP_MULTI));
+}
+
+//A slave that renegotiates mid-stream resets its decoder, the master's next frame is a key
+static void test_renegotiate()
+{
+    Encoder encoder;
+    Decoder decoder;
+    PadState state, slave;
+    uint8_t frame[MAX_FRAME_LEN];
+
+    for (int i = 0; i < 5; ++i)
+    {
+        state.joystick_lx = static_cast<int16_t>(i * 100);
+        decoder.decode(frame, encoder.encode(state, 1, 0, frame), slave);
+        encoder.commit();
+    }
+
+    decoder.reset();
+    CHECK(decoder.need_key());
+    encoder.request_key();
+    state.buttons = 0x00F0;
+    const size_t len = encoder.encode(state, 1, 0, frame);
+    CHECK(len == MAX_FRAME_LEN);
+    CHECK(decoder.decode(frame, len, slave) == Decoder::Result::OK);
+    CHECK(same(state, slave) && !decoder.need_key());
+}
+
+//Every bit flip in a delta frame's field mask is caught, and the link recovers on the next key
+static void test_corrupt_fields()
+{
+    Encoder encoder;
+    Decoder decoder;
+    PadState state, slave;
+    uint8_t frame[MAX_FRAME_LEN];
+
+    decoder.decode(frame, encoder.encode(state, 1, 0, frame), slave);
+    encoder.commit();
+
+    const size_t fields_at = offsetof(Header, fields);
+    for (uint8_t bit = 0; bit < 16; ++bit)
+    {
+        state.trigger_l = static_cast<uint8_t>(bit + 1);
+        state.joystick_rx = static_cast<int16_t>(-100 * bit);
+        const size_t len = encoder.encode(state, 1, 0, frame);
+        const uint16_t fields = frame_fields(frame);
+        const PadState before = slave;
+
+        frame[fields_at + bit / 8] ^= static_cast<uint8_t>(1U << (bit % 8));
+        const Decoder::Result result = decoder.decode(frame, len, slave);
+        CHECK(result == Decoder::Result::BAD_LENGTH || result == Decoder::Result::BAD_CRC);
+        CHECK(same(before, slave));
+
+        //trigger_l swapped for dpad, same length and the CRC redone on the way: the value
+        //lands in the wrong field, nothing past it moves
+        const uint16_t swapped = fields ^ ((1U << 0) | (1U << 2));
+        std::memcpy(frame + fields_at, &swapped, sizeof(swapped));
+        frame[len - 1] = crc8(frame, len - 1);
+        CHECK(decoder.decode(frame, len, slave) == Decoder::Result::OK);
+        CHECK(slave.dpad == state.trigger_l && slave.joystick_rx == state.joystick_rx);
+
+        //The master saw the write go through, the slave asks for a key in its reply
+        encoder.commit();
+        encoder.request_key();
+        const size_t key_len = encoder.encode(state, 1, 0, frame);
+        CHECK(decoder.decode(frame, key_len, slave) != Decoder::Result::BAD_CRC);
+        CHECK(same(state, slave) && !decoder.need_key());
+        encoder.commit();
+    }
+}
+
+/*  Pad input over a bus that loses writes, loses acks and flips bits, with the
+    slave's need_key flag going back each time. Corruption is never applied, and
+    the slave is never more than a few frames behind. */
+static void test_lossy_round_trip(uint32_t iterations)
+{
+    std::mt19937 rng(42);
+    Encoder encoder;
+    Decoder decoder;
+    PadState state, slave;
+    uint8_t frame[MAX_FRAME_LEN];
+    uint32_t applied_corrupt = 0;
+    uint32_t stale_run = 0;
+    uint32_t max_stale_run = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        const uint32_t change = rng() % 100;
+        if (change < 30)
+        {
+            state.joystick_lx = static_cast<int16_t>(state.joystick_lx + static_cast<int>(rng() % 7) - 3);
+        }
+        if (change < 10)
+        {
+            state.buttons ^= static_cast<uint16_t>(1U << (rng() % 16));
+        }
+        if (change < 5)
+        {
+            state.trigger_r = static_cast<uint8_t>(rng());
+        }
+        if (change == 99)
+        {
+            for (auto& value : state.analog)
+            {
+                value = static_cast<uint8_t>(rng());
+            }
+        }
+
+        const size_t len = encoder.encode(state, 1, 0, frame);
+        const uint32_t fate = rng() % 1000;
+        const bool lost = fate < 5;                     //Never reached the slave
+        const bool ack_lost = fate >= 5 && fate < 10;   //Applied, the master saw an error
+        const bool corrupt = fate >= 10 && fate < 15;
+
+        if (corrupt)
+        {
+            frame[rng() % len] ^= static_cast<uint8_t>(1U << (rng() % 8));
+        }
+        if (!lost)
+        {
+            const Decoder::Result result = decoder.decode(frame, len, slave);
+            applied_corrupt += (corrupt && (result == Decoder::Result::OK || result == Decoder::Result::GAP)) ? 1 : 0;
+        }
+        if (!lost && !ack_lost)
+        {
+            encoder.commit();
+        }
+        if (decoder.need_key())
+        {
+            encoder.request_key();
+        }
+
+        stale_run = same(state, slave) ? 0 : stale_run + 1;
+        max_stale_run = (stale_run > max_stale_run) ? stale_run : max_stale_run;
+    }
+
+    CHECK(applied_corrupt == 0);
+    CHECK(max_stale_run <= 4);
+    CHECK(decoder.stats().gaps > 0 && decoder.stats().crc_errors + decoder.stats().length_errors > 0);
+}
+
+//Random bytes, some with a matching length or CRC, never get past the checks unless whole
+static void test_fuzz_decode(uint32_t iterations)
+{
+    std::mt19937 rng(7);
+    Decoder decoder;
+    PadState slave;
+    uint8_t data[64];
+    uint32_t bad_accepted = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        size_t len = rng() % sizeof(data);
+        for (size_t j = 0; j < len; ++j)
+        {
+            data[j] = static_cast<uint8_t>(rng());
+        }
+        if (len && (rng() % 2))
+        {
+            data[0] = static_cast<uint8_t>(len);
+        }
+
+        bool consistent = false;
+        if (len > sizeof(Header) && (rng() % 2))
+        {
+            const uint16_t fields = static_cast<uint16_t>(rng() & ALL_FIELDS);
+            std::memcpy(data + offsetof(Header, fields), &fields, sizeof(fields));
+            len = sizeof(Header) + fields_len(fields) + 1;
+            data[0] = static_cast<uint8_t>(len);
+            if (rng() % 2)
+            {
+                data[len - 1] = crc8(data, len - 1);
+                consistent = true;
+            }
+        }
+
+        const Decoder::Result result = decoder.decode(data, len, slave);
+        const bool accepted = (result == Decoder::Result::OK || result == Decoder::Result::GAP);
+        bad_accepted += (accepted && !consistent && crc8(data, len - 1) != data[len - 1]) ? 1 : 0;
+        CHECK(!consistent || accepted);
+    }
+    CHECK(bad_accepted == 0);
+    CHECK(decoder.stats().frames > 0 && decoder.stats().crc_errors > 0 && decoder.stats().length_errors > 0);
+}
+
+/* ---- Multi frames ---- */
+
+//The single-slave RP2040 end: one Decoder per pad, rumble and need_key in the reply
+struct MultiSlave
+{
+    std::array<Decoder, MAX_PADS> decoders;
+    std::array<PadState, MAX_PADS> states;
+    std::array<PadRumble, MAX_PADS> rumble;
+    uint32_t frames{0};
+
+    bool receive(const uint8_t* data, size_t len, uint8_t packet_id, MultiReply& reply)
+    {
+        const bool ok = split_multi(data, len, [this](uint8_t i, const uint8_t* frame, size_t frame_len)
+        {
+            decoders[i].decode(frame, frame_len, states[i]);
+            ++frames;
+        });
+
+        reply = MultiReply();
+        reply.packet_id = packet_id;
+        for (uint8_t i = 0; i < MAX_PADS; ++i)
+        {
+            reply.rumble[i] = rumble[i];
+            reply.need_key |= decoders[i].need_key() ? (1U << i) : 0;
+        }
+        return ok;
+    }
+};
+
+//Every set of changed pads goes in one write, each pad's rumble comes back in the reply
+static void test_multi_round_trip()
+{
+    constexpr uint8_t PACKET_ID = 6;
+    std::array<Encoder, MAX_PADS> encoders;
+    std::array<PadState, MAX_PADS> states;
+    MultiSlave slave;
+    uint8_t out[MAX_MULTI_LEN];
+
+    for (uint32_t round = 0; round < 3; ++round)
+    {
+        for (uint8_t pads = 0; pads < (1U << MAX_PADS); ++pads)
+        {
+            for (uint8_t i = 0; i < MAX_PADS; ++i)
+            {
+                if (pads & (1U << i))
+                {
+                    states[i].buttons = static_cast<uint16_t>(pads << 4 | i);
+                    states[i].joystick_ly = static_cast<int16_t>(round * 1000 - pads);
+                }
+                slave.rumble[i].rumble_l = static_cast<uint8_t>(pads + i);
+                slave.rumble[i].rumble_r = static_cast<uint8_t>(0xFF - pads - i);
+            }
+
+            const size_t len = encode_multi(encoders.data(), states.data(), pads, PACKET_ID, out);
+            CHECK(len == out[0] && len <= MAX_MULTI_LEN);
+
+            const uint32_t frames = slave.frames;
+            MultiReply reply;
+            CHECK(slave.receive(out, len, PACKET_ID, reply));
+            CHECK(slave.frames - frames == static_cast<uint32_t>(__builtin_popcount(pads)));
+
+            //The reply as the master reads it off the bus
+            uint8_t bus[sizeof(MultiReply)];
+            std::memcpy(bus, &reply, sizeof(bus));
+            MultiReply read;
+            std::memcpy(&read, bus, sizeof(read));
+            CHECK(read.packet_len == sizeof(MultiReply) && read.packet_id == PACKET_ID);
+
+            for (uint8_t i = 0; i < MAX_PADS; ++i)
+            {
+                if (pads & (1U << i))
+                {
+                    encoders[i].commit();
+                }
+                if (read.need_key & (1U << i))
+                {
+                    encoders[i].request_key();
+                }
+                CHECK(read.rumble[i].rumble_l == static_cast<uint8_t>(pads + i));
+                CHECK(read.rumble[i].rumble_r == static_cast<uint8_t>(0xFF - pads - i));
+                CHECK(same(states[i], slave.states[i]) || !(pads & (1U << i)));
+            }
+        }
+    }
+
+    //The first write to each pad was a key frame, after that only deltas
+    for (uint8_t i = 0; i < MAX_PADS; ++i)
+    {
+        CHECK(same(states[i], slave.states[i]));
+        CHECK(slave.decoders[i].stats().keys == 1 && slave.decoders[i].stats().gaps == 0);
+    }
+
+    //Nothing changed, the write is a poll: a header out, every pad's rumble back
+    CHECK(encode_multi(encoders.data(), states.data(), 0, PACKET_ID, out) == sizeof(MultiHeader));
+}
+
+//A malformed write reaches no Decoder, a pad's bad CRC costs that pad only
+static void test_multi_malformed()
+{
+    std::array<Encoder, MAX_PADS> encoders;
+    std::array<PadState, MAX_PADS> states;
+    MultiSlave slave;
+    MultiReply reply;
+    uint8_t out[MAX_MULTI_LEN];
+
+    states[1].trigger_l = 10;
+    states[3].trigger_r = 20;
+    const uint8_t pads = (1U << 1) | (1U << 3);
+    const size_t len = encode_multi(encoders.data(), states.data(), pads, 6, out);
+
+    uint8_t bad[MAX_MULTI_LEN];
+    auto rejected = [&](size_t bad_len)
+    {
+        const uint32_t frames = slave.frames;
+        return !slave.receive(bad, bad_len, 6, reply) && slave.frames == frames;
+    };
+
+    //Truncated, or a length byte that doesn't match
+    std::memcpy(bad, out, len);
+    bad[0] = static_cast<uint8_t>(len - 1);
+    CHECK(rejected(len - 1));
+    std::memcpy(bad, out, len);
+    bad[0] = static_cast<uint8_t>(len + 1);
+    CHECK(rejected(len));
+
+    //A pad past MAX_PADS, a missing pad bit, a frame with another pad's index
+    std::memcpy(bad, out, len);
+    bad[2] |= 1U << MAX_PADS;
+    CHECK(rejected(len));
+    std::memcpy(bad, out, len);
+    bad[2] = 1U << 1;
+    CHECK(rejected(len));
+    std::memcpy(bad, out, len);
+    bad[sizeof(MultiHeader) + 2] = 0;
+    CHECK(rejected(len));
+    CHECK(rejected(0));
+
+    //Pad 3's CRC is off, pad 1 still applies and pad 3 asks for a key
+    std::memcpy(bad, out, len);
+    bad[len - 1] ^= 0x10;
+    CHECK(slave.receive(bad, len, 6, reply));
+    CHECK(same(states[1], slave.states[1]) && same(PadState(), slave.states[3]));
+    CHECK(slave.decoders[3].stats().crc_errors == 1);
+    CHECK(reply.need_key & (1U << 3));
+}
+
+int main()
+{
+    test_key_then_delta();
+    test_uncommitted_frame_repeats();
+    test_key_interval();
+    test_rejects_bad_frames();
+    test_negotiate();
+    test_renegotiate();
+    test_corrupt_fields();
+    test_lossy_round_trip(200000);
+    test_fuzz_decode(200000);
+    test_multi_round_trip();
+    test_multi_malformed();
+    return check::result("I2CLinkTest");
+}
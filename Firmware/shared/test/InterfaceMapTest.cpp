@@ -0,0 +1,204 @@
+#include <array>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+
+#include "Check.h"
+#include "USBHost/InterfaceMap.h"
+
+/*  The RP2040 host's InterfaceMap against a plain std::map over long seeded sequences of
+    add/remove/find, every address up to CFG_TUH_DEVICE_MAX + CFG_TUH_HUB and every
+    instance, plus the orders a hub and a 4 interface 360 wireless receiver mount in. */
+
+//HostManager's sizes: 4 devices behind a hub plus the hub, an instance per gamepad
+static constexpr uint8_t DEVICE_MAX = 4;
+static constexpr uint8_t HUB = 1;
+static constexpr uint8_t MAX_ADDRESS = DEVICE_MAX + HUB;
+static constexpr uint8_t MAX_INSTANCES = 4;
+
+template <uint8_t MAX_SLOTS>
+class Reference
+{
+public:
+    uint8_t find(uint8_t address, uint8_t instance) const
+    {
+        auto it = slots_.find({address, instance});
+        return (it == slots_.end()) ? 0xFF : it->second;
+    }
+
+    uint8_t add(uint8_t address, uint8_t instance)
+    {
+        if (address == 0 || address > MAX_ADDRESS || instance >= MAX_INSTANCES)
+        {
+            return 0xFF;
+        }
+        const uint8_t slot = find(address, instance);
+        if (slot != 0xFF)
+        {
+            return slot;
+        }
+        for (uint8_t i = 0; i < MAX_SLOTS; ++i)
+        {
+            if (!used_[i])
+            {
+                used_[i] = true;
+                slots_[{address, instance}] = i;
+                return i;
+            }
+        }
+        return 0xFF;
+    }
+
+    uint8_t remove(uint8_t address, uint8_t instance)
+    {
+        const uint8_t slot = find(address, instance);
+        if (slot != 0xFF)
+        {
+            slots_.erase({address, instance});
+            used_[slot] = false;
+        }
+        return slot;
+    }
+
+    const std::map<std::pair<uint8_t, uint8_t>, uint8_t>& slots() const { return slots_; }
+
+private:
+    std::map<std::pair<uint8_t, uint8_t>, uint8_t> slots_;
+    std::array<bool, MAX_SLOTS> used_{};
+};
+
+//Every lookup, forward and back, agrees with the reference
+template <uint8_t MAX_SLOTS>
+static bool same(const InterfaceMap<MAX_ADDRESS, MAX_INSTANCES, MAX_SLOTS>& map, const Reference<MAX_SLOTS>& ref)
+{
+    bool ok = true;
+    for (uint16_t address = 0; address <= MAX_ADDRESS + 1; ++address)
+    {
+        for (uint16_t instance = 0; instance <= MAX_INSTANCES; ++instance)
+        {
+            ok &= map.find(uint8_t(address), uint8_t(instance)) == ref.find(uint8_t(address), uint8_t(instance));
+        }
+    }
+    std::array<bool, MAX_SLOTS> used{};
+    for (const auto& entry : ref.slots())
+    {
+        const uint8_t slot = entry.second;
+        used[slot] = true;
+        ok &= map.used(slot) && map.address(slot) == entry.first.first && map.instance(slot) == entry.first.second;
+    }
+    for (uint8_t slot = 0; slot < MAX_SLOTS; ++slot)
+    {
+        ok &= map.used(slot) == used[slot];
+    }
+    ok &= !map.used(MAX_SLOTS) && map.any() == !ref.slots().empty();
+    return ok;
+}
+
+template <uint8_t MAX_SLOTS>
+static void test_random(uint32_t seed, uint32_t steps)
+{
+    InterfaceMap<MAX_ADDRESS, MAX_INSTANCES, MAX_SLOTS> map;
+    Reference<MAX_SLOTS> ref;
+    std::mt19937 rng(seed);
+    uint32_t mismatches = 0;
+    std::array<std::array<uint8_t, MAX_INSTANCES>, MAX_ADDRESS + 1> held{};
+    uint32_t full = 0;
+
+    for (uint32_t step = 0; step < steps; ++step)
+    {
+        //Mostly in range, now and then address 0 or one past the end of either
+        const uint8_t address = uint8_t(rng() % (MAX_ADDRESS + 2));
+        const uint8_t instance = uint8_t(rng() % (MAX_INSTANCES + 1));
+        switch (rng() % 8)
+        {
+            case 0:
+            case 1:
+            case 2:
+            {
+                const uint8_t slot = map.add(address, instance);
+                mismatches += (slot != ref.add(address, instance)) ? 1 : 0;
+                if (slot != 0xFF)
+                {
+                    held[address][instance] |= uint8_t(1U << slot);
+                }
+                full += (slot == 0xFF && address && address <= MAX_ADDRESS && instance < MAX_INSTANCES) ? 1 : 0;
+                break;
+            }
+            case 3:
+            case 4:
+            case 5:
+                mismatches += (map.remove(address, instance) != ref.remove(address, instance)) ? 1 : 0;
+                break;
+            case 6:
+                mismatches += (map.find(address, instance) != ref.find(address, instance)) ? 1 : 0;
+                break;
+            default:
+                //Everything unplugged at once, e.g. the hub
+                if ((rng() % 64) == 0)
+                {
+                    map.clear();
+                    ref = Reference<MAX_SLOTS>();
+                }
+                break;
+        }
+        mismatches += same(map, ref) ? 0 : 1;
+    }
+    CHECK(mismatches == 0);
+    //The sequence filled the map and gave every interface every slot at some point
+    bool every_slot = true;
+    for (uint8_t address = 1; address <= MAX_ADDRESS; ++address)
+    {
+        for (uint8_t instance = 0; instance < MAX_INSTANCES; ++instance)
+        {
+            every_slot &= held[address][instance] == uint8_t((1U << MAX_SLOTS) - 1);
+        }
+    }
+    CHECK(every_slot && full > 0);
+}
+
+//A hub at 1, pads behind it at 4, 2 and 5, and a receiver at 3 with one slot for each of its 4 interfaces
+static void test_hub_and_receiver()
+{
+    InterfaceMap<MAX_ADDRESS, MAX_INSTANCES, 8> map;
+    Reference<8> ref;
+
+    const std::array<std::pair<uint8_t, uint8_t>, 7> mounts = {{ {4, 0}, {2, 0}, {3, 0}, {3, 1}, {3, 2}, {3, 3}, {5, 0} }};
+    for (size_t i = 0; i < mounts.size(); ++i)
+    {
+        CHECK(map.add(mounts[i].first, mounts[i].second) == i);
+        ref.add(mounts[i].first, mounts[i].second);
+    }
+    CHECK(same(map, ref));
+
+    //Mounting again without an unmount keeps the slot
+    CHECK(map.add(3, 2) == 4);
+
+    //The pad at 2 and the receiver's second pad go, the next two take their slots, lowest first
+    CHECK(map.remove(2, 0) == 1 && map.remove(3, 1) == 3);
+    ref.remove(2, 0);
+    ref.remove(3, 1);
+    CHECK(map.add(3, 1) == 1 && map.add(2, 0) == 3);
+    ref.add(3, 1);
+    ref.add(2, 0);
+    CHECK(same(map, ref));
+
+    //The receiver unplugged frees all four of its slots, the others don't move
+    for (uint8_t instance = 0; instance < MAX_INSTANCES; ++instance)
+    {
+        CHECK(map.remove(3, instance) != 0xFF);
+        ref.remove(3, instance);
+    }
+    CHECK(same(map, ref) && map.find(4, 0) == 0 && map.find(2, 0) == 3 && map.find(5, 0) == 6);
+    CHECK(map.remove(3, 0) == 0xFF);
+}
+
+int main()
+{
+    test_random<4>(1, 50000);
+    test_random<4>(0x5EED, 50000);
+    test_random<1>(7, 10000);
+    test_random<8>(42, 50000);
+    test_hub_and_receiver();
+    return check::result("InterfaceMapTest");
+}
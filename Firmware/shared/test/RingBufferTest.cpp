@@ -0,0 +1,304 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "RingBuffer.h"
+#include "InlineFunction.h"
+
+/*  The ESP32's lock-free queues on host threads: per producer order, nothing lost or
+    duplicated beyond what drops() reports, and a DROP_OLDEST push that can't make room
+    returns instead of waiting on a stalled thread. Built a second time with
+    ThreadSanitizer where the compiler has it. Workers only count, CHECK runs on main. */
+
+struct Item
+{
+    uint32_t producer{0};
+    uint32_t seq{0};
+    uint32_t check{0};
+};
+
+static uint32_t item_check(uint32_t producer, uint32_t seq)
+{
+    return (producer * 2654435761u) ^ seq;
+}
+
+static void test_spsc(uint32_t count)
+{
+    SPSCRingBuffer<Item, 6> queue;
+    std::atomic<bool> done{false};
+    uint32_t pushed = 0;
+
+    std::thread producer([&]
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            pushed += queue.push(Item{0, i, item_check(0, i)}) ? 1 : 0;
+        }
+        done = true;
+    });
+
+    int64_t last = -1;
+    uint32_t received = 0;
+    uint32_t bad = 0;
+    Item item;
+    while (!done.load() || queue.size())
+    {
+        if (queue.pop(item))
+        {
+            bad += (item.check != item_check(0, item.seq) || static_cast<int64_t>(item.seq) <= last) ? 1 : 0;
+            last = item.seq;
+            ++received;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    while (queue.pop(item))
+    {
+        ++received;
+    }
+
+    CHECK(bad == 0);
+    CHECK(received == pushed && received + queue.drops() == count);
+}
+
+//retry pushes each item until it's taken, so nothing may go missing
+template<RingBufferPolicy POLICY>
+static void test_mpsc(uint32_t producers, uint32_t per_producer, bool retry)
+{
+    MPSCRingBuffer<Item, 6, POLICY> queue;
+    std::atomic<uint32_t> done{0};
+    std::vector<std::thread> threads;
+
+    for (uint32_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]
+        {
+            for (uint32_t i = 0; i < per_producer; ++i)
+            {
+                while (!queue.push(Item{p, i, item_check(p, i)}))
+                {
+                    if (!retry)
+                    {
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+            done += 1;
+        });
+    }
+
+    std::vector<int64_t> last(producers, -1);
+    uint64_t received = 0;
+    uint32_t bad = 0;
+    auto receive = [&](const Item& item)
+    {
+        bad += (item.producer >= producers ||
+                item.check != item_check(item.producer, item.seq) ||
+                static_cast<int64_t>(item.seq) <= last[item.producer]) ? 1 : 0;
+        if (item.producer < producers)
+        {
+            last[item.producer] = item.seq;
+        }
+        ++received;
+    };
+
+    Item item;
+    while (done.load() < producers)
+    {
+        if (queue.pop(item))
+        {
+            receive(item);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    while (queue.pop(item))
+    {
+        receive(item);
+    }
+
+    const uint64_t total = static_cast<uint64_t>(producers) * per_producer;
+    CHECK(bad == 0);
+    if (retry)
+    {
+        CHECK(received == total);
+    }
+    else
+    {
+        CHECK(received + queue.drops() == total);
+    }
+}
+
+//InlineFunction tasks as I2CDriver queues them, every task that was taken runs once
+static void test_tasks(uint32_t per_producer)
+{
+    using Task = InlineFunction<void(), 64>;
+    MPSCRingBuffer<Task, 8> queue;
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> expected{0};
+    std::atomic<uint32_t> done{0};
+    std::vector<std::thread> threads;
+
+    for (uint32_t p = 0; p < 3; ++p)
+    {
+        threads.emplace_back([&, p]
+        {
+            for (uint32_t i = 0; i < per_producer; ++i)
+            {
+                const uint64_t value = p * 1000000ull + i;
+                std::atomic<uint64_t>* total = &sum;
+                if (queue.push(Task([total, value] { total->fetch_add(value); })))
+                {
+                    expected += value;
+                }
+            }
+            done += 1;
+        });
+    }
+
+    Task task;
+    while (done.load() < 3)
+    {
+        if (queue.pop(task))
+        {
+            task();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    while (queue.pop(task))
+    {
+        task();
+    }
+    CHECK(sum.load() == expected.load());
+}
+
+/* ---- Stalled threads ---- */
+
+static std::atomic<bool> gate_open{true};
+static std::atomic<bool> gate_entered{false};
+
+//Copying from an item with hold set waits for the gate, which stops a thread between
+//claiming a cell and publishing or releasing it
+struct GateItem
+{
+    uint32_t value{0};
+    bool hold{false};
+
+    GateItem() = default;
+    GateItem(uint32_t value, bool hold = false)
+        : value(value), hold(hold) {}
+    GateItem(const GateItem& other) { *this = other; }
+
+    GateItem& operator=(const GateItem& other)
+    {
+        if (other.hold && !gate_open.load())
+        {
+            gate_entered = true;
+            while (!gate_open.load())
+            {
+                std::this_thread::yield();
+            }
+        }
+        value = other.value;
+        hold = other.hold;
+        return *this;
+    }
+};
+
+using GateQueue = MPSCRingBuffer<GateItem, 4, RingBufferPolicy::DROP_OLDEST>;
+
+static void close_gate()
+{
+    gate_open = false;
+    gate_entered = false;
+}
+
+static void wait_gate()
+{
+    while (!gate_entered.load())
+    {
+        std::this_thread::yield();
+    }
+}
+
+//The oldest cell is claimed but its producer hasn't published it
+static void test_drop_oldest_stalled_producer()
+{
+    GateQueue queue;
+    close_gate();
+    std::thread producer([&queue] { queue.push(GateItem(1, true)); });
+    wait_gate();
+
+    CHECK(queue.push(GateItem(2)) && queue.push(GateItem(3)) && queue.push(GateItem(4)));
+    CHECK(!queue.push(GateItem(5)));
+    CHECK(queue.drops() == 1);
+
+    gate_open = true;
+    producer.join();
+    GateItem item;
+    for (uint32_t value = 1; value <= 4; ++value)
+    {
+        CHECK(queue.pop(item) && item.value == value);
+    }
+    CHECK(!queue.pop(item));
+}
+
+//The consumer has claimed the cell the push needs but not released it
+static void test_drop_oldest_stalled_consumer()
+{
+    GateQueue queue;
+    CHECK(queue.push(GateItem(1, true)) && queue.push(GateItem(2)) && queue.push(GateItem(3)) && queue.push(GateItem(4)));
+
+    close_gate();
+    GateItem held;
+    std::thread consumer([&] { queue.pop(held); });
+    wait_gate();
+
+    //Evicting the rest doesn't free that cell, the push gives up after EVICT_ATTEMPTS
+    CHECK(!queue.push(GateItem(5)));
+    CHECK(queue.drops() >= 1 && queue.drops() <= GateQueue::EVICT_ATTEMPTS + 1);
+
+    gate_open = true;
+    consumer.join();
+    CHECK(held.value == 1);
+    CHECK(queue.push(GateItem(6)));
+    GateItem item;
+    while (queue.pop(item) && item.value != 6) {}
+    CHECK(item.value == 6);
+}
+
+int main(int argc, char** argv)
+{
+    //RingBufferTest [items per producer] for a longer soak
+    const uint32_t count = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200000;
+
+    test_spsc(count * 2);
+    test_mpsc<RingBufferPolicy::REJECT>(1, count, false);
+    test_mpsc<RingBufferPolicy::REJECT>(4, count, false);
+    test_mpsc<RingBufferPolicy::DROP_OLDEST>(4, count, false);
+    test_mpsc<RingBufferPolicy::REJECT>(4, count / 10, true);
+    test_tasks(count);
+    test_drop_oldest_stalled_producer();
+    test_drop_oldest_stalled_consumer();
+    return check::result("RingBufferTest");
+}
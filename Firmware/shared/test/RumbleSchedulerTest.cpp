@@ -0,0 +1,208 @@
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include "Check.h"
+#include "Bluepad32/RumbleScheduler.h"
+
+/*  The Pico W's Bluetooth rumble pacing driven the way send_feedback_cb drives it, a
+    poll every few ms with the console's latest value, through bursts of rumble
+    changes, long holds and stops. Every command is checked as it goes out: never
+    inside the controller's minimum interval, nonzero rumble refreshed before it runs
+    out, a stop sent once, and whatever the console settles on delivered. */
+
+//send_feedback_cb's timer, btstack runs it a few ms late now and then
+static constexpr uint32_t POLL_MS = 4;
+static constexpr uint32_t MAX_JITTER_MS = 3;
+
+struct Violations
+{
+    uint32_t interval{0};
+    uint32_t lapse{0};
+    uint32_t repeat_stop{0};
+    uint32_t undelivered{0};
+    uint32_t duration{0};
+};
+
+struct Stats
+{
+    uint32_t commands{0};
+    uint32_t stops{0};
+    uint32_t refreshes{0};
+};
+
+static void simulate(const RumbleScheduler::Model& model, uint32_t seed, uint32_t start_ms, uint32_t phases,
+                     Violations& violations, Stats& stats)
+{
+    std::mt19937 rng(seed);
+    RumbleScheduler scheduler;
+    scheduler.reset(model);
+
+    uint32_t now = start_ms;
+    bool sent_any = false;
+    uint32_t last_ms = 0;
+    uint8_t last_l = 0;
+    uint8_t last_r = 0;
+    uint8_t console_l = 0;
+    uint8_t console_r = 0;
+    uint32_t console_ms = now;
+
+    //The console value can only be behind for the interval plus a late poll
+    const uint32_t settle_ms = model.min_interval_ms + POLL_MS + MAX_JITTER_MS;
+
+    for (uint32_t phase = 0; phase < phases; ++phase)
+    {
+        //0: burst of new values every poll or so, 1: hold a nonzero value, 2: stop, 3: same value again
+        const uint32_t kind = rng() % 4;
+        const uint32_t length_ms = (kind == 1) ? 200 + rng() % 1500 : 20 + rng() % 300;
+        const uint32_t end = now + length_ms;
+
+        if (kind == 1)
+        {
+            console_l = uint8_t(1 + rng() % 255);
+            console_r = uint8_t(rng() % 256);
+            console_ms = now;
+        }
+        else if (kind == 2)
+        {
+            console_l = console_r = 0;
+            console_ms = now;
+        }
+
+        while (int32_t(end - now) > 0)
+        {
+            if (kind == 0 && (rng() % 3) != 0)
+            {
+                //Several values between two polls, only the last one counts
+                const uint32_t count = 1 + rng() % 3;
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    const bool stop = (rng() % 4) == 0;
+                    console_l = stop ? 0 : uint8_t(rng() % 256);
+                    console_r = stop ? 0 : uint8_t(rng() % 256);
+                    scheduler.set(console_l, console_r);
+                }
+                console_ms = now;
+            }
+            else
+            {
+                //send_feedback_cb calls set() whenever the pad out is new, often with the same value
+                scheduler.set(console_l, console_r);
+            }
+
+            //Nonzero rumble still playing, the last command hasn't run out by the time the next poll runs
+            if (sent_any && (last_l || last_r))
+            {
+                violations.lapse += (now - last_ms >= model.duration_ms) ? 1 : 0;
+            }
+
+            RumbleScheduler::Command command;
+            if (scheduler.update(now, command))
+            {
+                const bool stop = (command.rumble_l == 0 && command.rumble_r == 0);
+                if (sent_any)
+                {
+                    violations.interval += (now - last_ms < model.min_interval_ms) ? 1 : 0;
+                    stats.refreshes += (command.rumble_l == last_l && command.rumble_r == last_r) ? 1 : 0;
+                }
+                violations.repeat_stop += (stop && (!sent_any || (last_l == 0 && last_r == 0))) ? 1 : 0;
+                violations.duration += (command.duration_ms != model.duration_ms) ? 1 : 0;
+
+                sent_any = true;
+                last_ms = now;
+                last_l = command.rumble_l;
+                last_r = command.rumble_r;
+                ++stats.commands;
+                stats.stops += stop ? 1 : 0;
+            }
+
+            //A value the console has held long enough has gone out
+            if (now - console_ms >= settle_ms)
+            {
+                const uint8_t delivered_l = sent_any ? last_l : 0;
+                const uint8_t delivered_r = sent_any ? last_r : 0;
+                violations.undelivered += (delivered_l != console_l || delivered_r != console_r) ? 1 : 0;
+            }
+
+            now += POLL_MS + rng() % (MAX_JITTER_MS + 1);
+        }
+    }
+}
+
+static void test_models()
+{
+    //rumble_model()'s intervals, and one slower than the refresh lead
+    const std::array<RumbleScheduler::Model, 4> models = {{ {10, 250}, {20, 250}, {30, 250}, {60, 120} }};
+    const std::array<uint32_t, 2> starts = {{ 0, 0xFFFFFFFFu - 20000 }};
+
+    for (const auto& model : models)
+    {
+        for (const uint32_t start : starts)
+        {
+            for (uint32_t seed = 1; seed <= 4; ++seed)
+            {
+                Violations violations;
+                Stats stats;
+                simulate(model, seed * 7919 + model.min_interval_ms, start, 400, violations, stats);
+
+                CHECK(violations.interval == 0);
+                CHECK(violations.lapse == 0);
+                CHECK(violations.repeat_stop == 0);
+                CHECK(violations.undelivered == 0);
+                CHECK(violations.duration == 0);
+                //The run had bursts, holds and stops in it
+                CHECK(stats.commands > 100 && stats.stops > 10 && stats.refreshes > 10);
+            }
+        }
+    }
+}
+
+//Hand picked: a burst coalesces to its last value, one stop, nothing once stopped
+static void test_burst_then_stop()
+{
+    RumbleScheduler scheduler;
+    scheduler.reset({20, 250});
+    RumbleScheduler::Command command;
+
+    //Nothing to stop before anything was sent
+    scheduler.set(0, 0);
+    CHECK(!scheduler.update(0, command) && !scheduler.pending());
+
+    scheduler.set(100, 50);
+    CHECK(scheduler.update(0, command) && command.rumble_l == 100 && command.rumble_r == 50);
+
+    //Inside the interval only the latest value is kept
+    scheduler.set(120, 0);
+    CHECK(!scheduler.update(4, command));
+    scheduler.set(140, 10);
+    scheduler.set(160, 20);
+    CHECK(!scheduler.update(19, command) && scheduler.pending());
+    CHECK(scheduler.update(20, command) && command.rumble_l == 160 && command.rumble_r == 20);
+
+    //Back to the value already playing before the interval is up, nothing new to send
+    scheduler.set(0, 0);
+    scheduler.set(160, 20);
+    CHECK(!scheduler.pending() && !scheduler.update(40, command));
+
+    //Refreshed shortly before it runs out
+    CHECK(!scheduler.update(20 + 250 - RumbleScheduler::REFRESH_LEAD_MS - 1, command));
+    CHECK(scheduler.update(20 + 250 - RumbleScheduler::REFRESH_LEAD_MS, command) && command.rumble_l == 160);
+
+    //One stop, then quiet however long it's polled
+    scheduler.set(0, 0);
+    CHECK(scheduler.update(260, command) && command.rumble_l == 0 && command.rumble_r == 0);
+    uint32_t sent = 0;
+    for (uint32_t now = 264; now < 5000; now += POLL_MS)
+    {
+        scheduler.set(0, 0);
+        sent += scheduler.update(now, command) ? 1 : 0;
+    }
+    CHECK(sent == 0);
+}
+
+int main()
+{
+    test_burst_then_stop();
+    test_models();
+    return check::result("RumbleSchedulerTest");
+}
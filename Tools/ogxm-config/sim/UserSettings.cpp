@@ -0,0 +1,135 @@
+#include <fstream>
+
+#include "UserSettings/UserSettings.h"
+
+UserSettings::UserSettings()
+{
+    profile_bank_.seal();
+}
+
+void UserSettings::set_storage(const std::string& path)
+{
+    storage_path_ = path;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return;
+    }
+
+    ProfileBank bank;
+    const bool loaded = bank.load([&file](void* dst, size_t len, size_t offset)
+    {
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(offset));
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(len)));
+    });
+    if (loaded)
+    {
+        profile_bank_ = bank;
+    }
+}
+
+bool UserSettings::is_valid_driver(DeviceDriverType driver)
+{
+    return driver != DeviceDriverType::NONE && driver != DeviceDriverType::UART_BRIDGE;
+}
+
+UserProfile UserSettings::get_profile_by_index(const uint8_t index)
+{
+    return get_profile_by_id(profile_bank_.header.active_ids[(index < MAX_GAMEPADS) ? index : 0]);
+}
+
+UserProfile UserSettings::get_profile_by_id(const uint8_t profile_id)
+{
+    if (profile_id < 1 || profile_id > MAX_PROFILES)
+    {
+        return profile_bank_.profiles[0];
+    }
+    return profile_bank_.profiles[profile_id - 1];
+}
+
+bool UserSettings::store_profile(uint8_t index, const UserProfile& profile)
+{
+    if (!store_profile_live(index, profile))
+    {
+        return false;
+    }
+    ++reboots_;
+    return true;
+}
+
+bool UserSettings::store_profile_live(uint8_t index, const UserProfile& profile)
+{
+    if (profile.id < 1 || profile.id > MAX_PROFILES)
+    {
+        return false;
+    }
+    if (index > MAX_GAMEPADS - 1)
+    {
+        index = 0;
+    }
+    //Like the firmware, the bank in RAM only changes once the write succeeds
+    ProfileBank bank = profile_bank_;
+    bank.header.active_ids[index] = profile.id;
+    bank.profiles[profile.id - 1] = profile;
+    bank.seal();
+    if (!write_storage(bank))
+    {
+        return false;
+    }
+    profile_bank_ = bank;
+    return true;
+}
+
+bool UserSettings::store_profile_and_driver_type(DeviceDriverType new_driver_type, uint8_t index, const UserProfile& profile)
+{
+    if (is_valid_driver(new_driver_type))
+    {
+        current_driver_ = new_driver_type;
+    }
+    return store_profile(index, profile);
+}
+
+//The firmware switches on its next check_for_driver_change(), there's no loop for that here
+void UserSettings::request_driver_change(DeviceDriverType new_driver_type)
+{
+    if (is_valid_driver(new_driver_type))
+    {
+        current_driver_ = new_driver_type;
+    }
+}
+
+const ProfileBank& UserSettings::read_profile_bank()
+{
+    return profile_bank_;
+}
+
+bool UserSettings::store_profile_bank(const ProfileBank& bank)
+{
+    if (!bank.verify())
+    {
+        return false;
+    }
+    if (!write_storage(bank))
+    {
+        return false;
+    }
+    profile_bank_ = bank;
+    return true;
+}
+
+bool UserSettings::write_storage(const ProfileBank& bank)
+{
+    if (fail_writes_)
+    {
+        return false;
+    }
+    ++flash_writes_;
+    if (storage_path_.empty())
+    {
+        return true;
+    }
+    std::ofstream file(storage_path_, std::ios::binary | std::ios::trunc);
+    return static_cast<bool>(file.write(reinterpret_cast<const char*>(&bank), sizeof(ProfileBank)));
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "class/cdc/cdc_device.h"
+
+/*  The pty master plays the device end of the CDC port. A slave fd is held open here so
+    the master never hangs up between clients, and the master runs in packet mode: the
+    flush SerialPort::open() does arrives as a TIOCPKT_FLUSH status, which stands in for
+    DTR going up and is passed on to tud_cdc_line_state_cb(). A close can't be seen, the
+    port stays connected from the first open and each open starts a new session.
+    Writes go no further than the pty's buffer will take, like the CDC tx fifo. */
+
+//Like the CDC rx fifo, the rest waits in the pty
+static constexpr size_t RX_FIFO_LEN = 4096;
+
+static int master_fd = -1;
+static int held_fd = -1;
+static bool connected = false;
+static std::deque<uint8_t> rx_fifo;
+
+const char* cdc_pty::open()
+{
+    master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    int packet_mode = 1;
+    if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0 ||
+        ioctl(master_fd, TIOCPKT, &packet_mode) != 0)
+    {
+        return nullptr;
+    }
+
+    const char* path = ptsname(master_fd);
+    if (path == nullptr)
+    {
+        return nullptr;
+    }
+
+    //Raw mode from the start, the line discipline would otherwise echo device output back
+    held_fd = ::open(path, O_RDWR | O_NOCTTY);
+    if (held_fd < 0)
+    {
+        return nullptr;
+    }
+    termios tio;
+    if (tcgetattr(held_fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(held_fd, TCSANOW, &tio);
+    }
+    return path;
+}
+
+//Moves what the client wrote into rx_fifo, each read starts with a TIOCPKT status byte
+static void read_master()
+{
+    uint8_t buffer[512];
+    while (rx_fifo.size() < RX_FIFO_LEN)
+    {
+        const size_t len = std::min(sizeof(buffer), RX_FIFO_LEN - rx_fifo.size() + 1);
+        const ssize_t read_len = read(master_fd, buffer, len);
+        if (read_len <= 0)
+        {
+            return;
+        }
+
+        if (buffer[0] == TIOCPKT_DATA)
+        {
+            rx_fifo.insert(rx_fifo.end(), buffer + 1, buffer + read_len);
+        }
+        else if (buffer[0] & (TIOCPKT_FLUSHREAD | TIOCPKT_FLUSHWRITE))
+        {
+            //A client opened the port, anything from before it is gone
+            rx_fifo.clear();
+            connected = true;
+            tud_cdc_line_state_cb(0, true, true);
+        }
+    }
+}
+
+void cdc_pty::wait(int timeout_ms)
+{
+    //Returns as soon as the client writes, unless there's no room for it
+    pollfd pfd{ master_fd, POLLIN, 0 };
+    poll(&pfd, (rx_fifo.size() < RX_FIFO_LEN) ? 1 : 0, timeout_ms);
+    read_master();
+}
+
+bool tud_cdc_connected()
+{
+    return connected;
+}
+
+uint32_t tud_cdc_available()
+{
+    return static_cast<uint32_t>(rx_fifo.size());
+}
+
+uint32_t tud_cdc_read(void* buffer, uint32_t bufsize)
+{
+    const uint32_t len = std::min(bufsize, static_cast<uint32_t>(rx_fifo.size()));
+    std::copy_n(rx_fifo.begin(), len, static_cast<uint8_t*>(buffer));
+    rx_fifo.erase(rx_fifo.begin(), rx_fifo.begin() + len);
+    return len;
+}
+
+void tud_cdc_read_flush()
+{
+    rx_fifo.clear();
+}
+
+uint32_t tud_cdc_write(const void* buffer, uint32_t bufsize)
+{
+    if (!connected)
+    {
+        return 0;
+    }
+    ssize_t len = write(master_fd, buffer, bufsize);
+    return (len > 0) ? static_cast<uint32_t>(len) : 0;
+}
+
+uint32_t tud_cdc_write_flush()
+{
+    return 0;
+}
@@ -0,0 +1,66 @@
+#ifndef _USER_SETTINGS_H_
+#define _USER_SETTINGS_H_
+
+#include <cstdint>
+#include <string>
+
+#include "Board/Config.h"
+#include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
+#include "UserSettings/UserProfile.h"
+#include "UserSettings/ProfileBank.h"
+
+/*  Host stand-in for the firmware's UserSettings, takes its place on the include path
+    of the simulator. Profiles live in RAM and are saved to a file in place of flash.
+    Nothing reboots here, stores that would have are counted instead. */
+class UserSettings
+{
+public:
+    static constexpr uint8_t MAX_PROFILES = 8;
+
+    static UserSettings& get_instance()
+    {
+        static UserSettings instance;
+        return instance;
+    }
+
+    //Loads the bank from path if it holds one, stores go back to it
+    void set_storage(const std::string& path);
+
+    bool is_valid_driver(DeviceDriverType driver);
+
+    UserProfile get_profile_by_index(const uint8_t index);
+    UserProfile get_profile_by_id(const uint8_t profile_id);
+
+    DeviceDriverType get_current_driver() const { return current_driver_; }
+
+    bool store_profile(uint8_t index, const UserProfile& profile);
+    bool store_profile_and_driver_type(DeviceDriverType new_driver_type, uint8_t index, const UserProfile& profile);
+    bool store_profile_live(uint8_t index, const UserProfile& profile);
+    void request_driver_change(DeviceDriverType new_driver_type);
+
+    const ProfileBank& read_profile_bank();
+    bool store_profile_bank(const ProfileBank& bank);
+
+    //Number of writes the firmware would have made to flash, and times it would have rebooted
+    uint32_t flash_writes() const { return flash_writes_; }
+    uint32_t reboots() const { return reboots_; }
+    //Flash writes fail until set back to false, the bank in RAM stays as it was
+    void fail_writes(bool fail) { fail_writes_ = fail; }
+
+private:
+    UserSettings();
+    ~UserSettings() = default;
+    UserSettings(const UserSettings&) = delete;
+    UserSettings& operator=(const UserSettings&) = delete;
+
+    ProfileBank profile_bank_;
+    DeviceDriverType current_driver_{DeviceDriverType::WEBAPP};
+    std::string storage_path_;
+    uint32_t flash_writes_{0};
+    uint32_t reboots_{0};
+    bool fail_writes_{false};
+
+    bool write_storage(const ProfileBank& bank);
+};
+
+#endif // _USER_SETTINGS_H_
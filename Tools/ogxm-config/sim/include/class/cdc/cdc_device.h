@@ -0,0 +1,26 @@
+#ifndef _SIM_CDC_DEVICE_H_
+#define _SIM_CDC_DEVICE_H_
+
+#include <cstdint>
+
+//Host stand-in for the TinyUSB CDC device API, backed by a pty (see sim/cdc_pty.cpp,
+//and test/Loopback.cpp for the tests)
+bool tud_cdc_connected();
+uint32_t tud_cdc_available();
+uint32_t tud_cdc_read(void* buffer, uint32_t bufsize);
+void tud_cdc_read_flush();
+uint32_t tud_cdc_write(const void* buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_flush();
+
+//Defined by the application as with TinyUSB, sim/cdc_pty.cpp calls it when a client opens the port
+void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts);
+
+namespace cdc_pty
+{
+    //Creates the pty, returns the path of the port to hand to the client or nullptr
+    const char* open();
+    //Waits up to timeout_ms for data from the client, stands in for tud_task()
+    void wait(int timeout_ms);
+}
+
+#endif // _SIM_CDC_DEVICE_H_
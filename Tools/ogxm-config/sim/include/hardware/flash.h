@@ -0,0 +1,78 @@
+#ifndef _SIM_HARDWARE_FLASH_H_
+#define _SIM_HARDWARE_FLASH_H_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+//Host stand-in for hardware/flash.h, flash is an array in RAM that XIP_BASE points at.
+//Programming only clears bits as on NOR flash, a page has to be erased before it's
+//written again.
+
+#define FLASH_PAGE_SIZE     (1u << 8)
+#define FLASH_SECTOR_SIZE   (1u << 12)
+
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (64 * 1024)
+#endif
+
+namespace sim_flash
+{
+    inline std::array<uint8_t, PICO_FLASH_SIZE_BYTES>& memory()
+    {
+        alignas(FLASH_PAGE_SIZE) static std::array<uint8_t, PICO_FLASH_SIZE_BYTES> flash = []
+        {
+            std::array<uint8_t, PICO_FLASH_SIZE_BYTES> erased;
+            erased.fill(0xFF);
+            return erased;
+        }();
+        return flash;
+    }
+
+    //Sectors erased and pages programmed since the start
+    inline uint32_t& erases()
+    {
+        static uint32_t count = 0;
+        return count;
+    }
+
+    inline uint32_t& programs()
+    {
+        static uint32_t count = 0;
+        return count;
+    }
+
+    //Back to a chip fresh from the factory
+    inline void wipe()
+    {
+        memory().fill(0xFF);
+    }
+}
+
+#define XIP_BASE (reinterpret_cast<uintptr_t>(sim_flash::memory().data()))
+
+static inline void flash_range_erase(uint32_t flash_offs, size_t count)
+{
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES)
+    {
+        return;
+    }
+    std::memset(sim_flash::memory().data() + flash_offs, 0xFF, count);
+    sim_flash::erases() += static_cast<uint32_t>(count / FLASH_SECTOR_SIZE);
+}
+
+static inline void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count)
+{
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES)
+    {
+        return;
+    }
+    uint8_t* flash = sim_flash::memory().data() + flash_offs;
+    for (size_t i = 0; i < count; ++i)
+    {
+        flash[i] &= data[i];
+    }
+    sim_flash::programs() += static_cast<uint32_t>(count / FLASH_PAGE_SIZE);
+}
+
+#endif // _SIM_HARDWARE_FLASH_H_
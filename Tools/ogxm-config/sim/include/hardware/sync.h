@@ -0,0 +1,20 @@
+#ifndef _SIM_HARDWARE_SYNC_H_
+#define _SIM_HARDWARE_SYNC_H_
+
+#include <cstdint>
+
+//Host stand-in for hardware/sync.h, there are no interrupts to disable and everything
+//runs on core 0
+static inline uint32_t save_and_disable_interrupts()
+{
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t) {}
+
+static inline uint32_t get_core_num()
+{
+    return 0;
+}
+
+#endif // _SIM_HARDWARE_SYNC_H_
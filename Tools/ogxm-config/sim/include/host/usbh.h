@@ -0,0 +1,29 @@
+#ifndef _SIM_USBH_H_
+#define _SIM_USBH_H_
+
+#include <cstdint>
+
+#include "tusb.h"
+
+//Host stand-in for the TinyUSB host API, the test defines these
+
+struct tuh_xfer_s;
+typedef void (*tuh_xfer_cb_t)(tuh_xfer_s* xfer);
+
+struct tuh_xfer_s
+{
+    uint8_t daddr;
+    uint8_t ep_addr;
+    xfer_result_t result;
+    uint32_t actual_len;
+    const tusb_control_request_t* setup;
+    uint8_t* buffer;
+    tuh_xfer_cb_t complete_cb;
+    uintptr_t user_data;
+};
+
+bool tuh_vid_pid_get(uint8_t daddr, uint16_t* vid, uint16_t* pid);
+bool tuh_edpt_open(uint8_t daddr, const tusb_desc_endpoint_t* desc_ep);
+bool tuh_control_xfer(tuh_xfer_s* xfer);
+
+#endif // _SIM_USBH_H_
@@ -0,0 +1,27 @@
+#ifndef _SIM_USBH_PVT_H_
+#define _SIM_USBH_PVT_H_
+
+#include <cstdint>
+
+#include "host/usbh.h"
+
+//Host stand-in for the class driver side of the TinyUSB host stack. As in TinyUSB,
+//an endpoint is free again by the time the driver's xfer_cb runs.
+
+typedef struct
+{
+    const char* name;
+    bool (*init)(void);
+    bool (*deinit)(void);
+    bool (*open)(uint8_t rhport, uint8_t dev_addr, const tusb_desc_interface_t* desc_itf, uint16_t max_len);
+    bool (*set_config)(uint8_t dev_addr, uint8_t itf_num);
+    bool (*xfer_cb)(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+    void (*close)(uint8_t dev_addr);
+} usbh_class_driver_t;
+
+bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr);
+bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr);
+bool usbh_edpt_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes);
+void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num);
+
+#endif // _SIM_USBH_PVT_H_
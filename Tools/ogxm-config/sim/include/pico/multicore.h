@@ -0,0 +1,20 @@
+#ifndef _SIM_PICO_MULTICORE_H_
+#define _SIM_PICO_MULTICORE_H_
+
+#include <cstdint>
+
+//Host stand-in for the pico/multicore.h lockout calls NVSTool makes, core 1 is never
+//a lockout victim here so flash writes don't wait on it
+static inline bool multicore_lockout_victim_is_initialized(uint32_t)
+{
+    return false;
+}
+
+static inline bool multicore_lockout_start_timeout_us(uint64_t)
+{
+    return false;
+}
+
+static inline void multicore_lockout_end_blocking() {}
+
+#endif // _SIM_PICO_MULTICORE_H_
@@ -0,0 +1,13 @@
+#ifndef _SIM_PICO_MUTEX_H_
+#define _SIM_PICO_MUTEX_H_
+
+#include <mutex>
+
+//Host stand-in for pico/mutex.h
+typedef std::mutex mutex_t;
+
+static inline void mutex_init(mutex_t*) {}
+static inline void mutex_enter_blocking(mutex_t* mutex) { mutex->lock(); }
+static inline void mutex_exit(mutex_t* mutex) { mutex->unlock(); }
+
+#endif // _SIM_PICO_MUTEX_H_
@@ -0,0 +1,27 @@
+#ifndef _SIM_PICO_TIME_H_
+#define _SIM_PICO_TIME_H_
+
+#include <cstdint>
+#include <chrono>
+
+//Host stand-in for the parts of pico/time.h the protocol uses, time starts with the process
+typedef uint64_t absolute_time_t;
+
+static inline absolute_time_t get_absolute_time()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return static_cast<absolute_time_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t)
+{
+    return t;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t)
+{
+    return static_cast<uint32_t>(t / 1000);
+}
+
+#endif // _SIM_PICO_TIME_H_
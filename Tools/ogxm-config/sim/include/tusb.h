@@ -0,0 +1,101 @@
+#ifndef _SIM_TUSB_H_
+#define _SIM_TUSB_H_
+
+#include <cstdint>
+
+#include "tusb_option.h"
+
+//Host stand-in for the TinyUSB types, macros and descriptor helpers the XInput
+//host driver uses. Layouts match TinyUSB's where the driver reads them.
+
+#define TU_ATTR_WEAK            __attribute__((weak))
+#define TU_ATTR_ALWAYS_INLINE   __attribute__((always_inline))
+#define TU_ATTR_PACKED          __attribute__((packed))
+
+#define TU_LOG1(...)            do {} while (0)
+
+#define TU_GET_3RD_ARG(_1, _2, _3, ...) _3
+#define TU_VERIFY_1(cond)       do { if (!(cond)) { return false; } } while (0)
+#define TU_VERIFY_2(cond, ret)  do { if (!(cond)) { return ret; } } while (0)
+#define TU_VERIFY(...)          TU_GET_3RD_ARG(__VA_ARGS__, TU_VERIFY_2, TU_VERIFY_1, _)(__VA_ARGS__)
+#define TU_ASSERT(...)          TU_VERIFY(__VA_ARGS__)
+
+typedef enum
+{
+    TUSB_DIR_OUT = 0,
+    TUSB_DIR_IN = 1,
+} tusb_dir_t;
+
+typedef enum
+{
+    TUSB_DESC_INTERFACE = 0x04,
+    TUSB_DESC_ENDPOINT = 0x05,
+} tusb_desc_type_t;
+
+typedef enum
+{
+    XFER_RESULT_SUCCESS = 0,
+    XFER_RESULT_FAILED,
+    XFER_RESULT_STALLED,
+    XFER_RESULT_TIMEOUT,
+    XFER_RESULT_INVALID
+} xfer_result_t;
+
+typedef struct TU_ATTR_PACKED
+{
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bInterfaceNumber;
+    uint8_t bAlternateSetting;
+    uint8_t bNumEndpoints;
+    uint8_t bInterfaceClass;
+    uint8_t bInterfaceSubClass;
+    uint8_t bInterfaceProtocol;
+    uint8_t iInterface;
+} tusb_desc_interface_t;
+
+typedef struct TU_ATTR_PACKED
+{
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bEndpointAddress;
+    uint8_t bmAttributes;
+    uint16_t wMaxPacketSize;
+    uint8_t bInterval;
+} tusb_desc_endpoint_t;
+
+typedef struct TU_ATTR_PACKED
+{
+    uint8_t bmRequestType;
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} tusb_control_request_t;
+
+static inline uint8_t tu_desc_len(const void* desc)
+{
+    return static_cast<const uint8_t*>(desc)[0];
+}
+
+static inline uint8_t tu_desc_type(const void* desc)
+{
+    return static_cast<const uint8_t*>(desc)[1];
+}
+
+static inline const uint8_t* tu_desc_next(const void* desc)
+{
+    return static_cast<const uint8_t*>(desc) + tu_desc_len(desc);
+}
+
+static inline tusb_dir_t tu_edpt_dir(uint8_t addr)
+{
+    return (addr & 0x80) ? TUSB_DIR_IN : TUSB_DIR_OUT;
+}
+
+static inline uint16_t tu_edpt_packet_size(const tusb_desc_endpoint_t* desc_ep)
+{
+    return desc_ep->wMaxPacketSize & 0x7FF;
+}
+
+#endif // _SIM_TUSB_H_
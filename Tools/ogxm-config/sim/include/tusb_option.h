@@ -0,0 +1,12 @@
+#ifndef _SIM_TUSB_OPTION_H_
+#define _SIM_TUSB_OPTION_H_
+
+//Host stand-in for the TinyUSB options the XInput host driver checks, sized as
+//Firmware/RP2040/src/tusb_config.h sizes them with a hub
+#define TUSB_OPT_HOST_ENABLED   1
+#define CFG_TUSB_DEBUG          0
+#define CFG_TUH_HUB             1
+#define CFG_TUH_XINPUT          MAX_GAMEPADS
+#define CFG_TUH_DEVICE_MAX      (CFG_TUH_HUB ? 4 : 1)
+
+#endif // _SIM_TUSB_OPTION_H_
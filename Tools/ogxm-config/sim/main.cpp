@@ -0,0 +1,144 @@
+#include <array>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+
+#include "class/cdc/cdc_device.h"
+#include "pico/time.h"
+
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/UserSettings.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppProtocol.h"
+
+/*  Runs the firmware's WebAppProtocol on a pty so ogxm-config (or the WebApp through a
+    serial bridge) can be exercised without hardware. Each gamepad is fed a synthetic
+    controller at the given report rate, through the same scale functions host drivers
+    use, so telemetry shows the profile's joystick and trigger settings at work. */
+
+static volatile std::sig_atomic_t running = 1;
+static WebAppProtocol* config_protocol = nullptr;
+
+static void on_signal(int)
+{
+    running = 0;
+}
+
+//Each client that opens the pty starts a new session, as DTR does on the adapter
+void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts)
+{
+    if (config_protocol != nullptr)
+    {
+        config_protocol->line_state_changed(dtr);
+    }
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s [--bank FILE] [--rate HZ]\n"
+        "  --bank FILE  Load profiles from FILE and save them back in place of flash\n"
+        "  --rate HZ    Input reports per second for each gamepad (default 1000, 0 for none)\n",
+        name);
+}
+
+//Stands in for a host driver, a stored profile is swapped in before the report is mapped
+static void feed_gamepad(Gamepad& gamepad, uint8_t index, uint64_t time_us)
+{
+    gamepad.apply_pending_profile();
+    const double phase = (time_us / 1000000.0) * 2.0 * M_PI * (0.5 + 0.25 * index);
+    Gamepad::PadIn pad_in;
+
+    const int16_t x = static_cast<int16_t>(std::lround(32767.0 * std::cos(phase)));
+    const int16_t y = static_cast<int16_t>(std::lround(32767.0 * std::sin(phase)));
+    std::tie(pad_in.joystick_lx, pad_in.joystick_ly) = gamepad.scale_joystick_l(x, y);
+    std::tie(pad_in.joystick_rx, pad_in.joystick_ry) = gamepad.scale_joystick_r(static_cast<int16_t>(x / 8), static_cast<int16_t>(y / 8));
+
+    pad_in.trigger_l = gamepad.scale_trigger_l(static_cast<uint8_t>(127.5 + 127.5 * std::sin(phase)));
+    pad_in.trigger_r = gamepad.scale_trigger_r(static_cast<uint8_t>(127.5 - 127.5 * std::sin(phase)));
+
+    if ((time_us / 500000) % 2)
+    {
+        pad_in.buttons |= gamepad.MAP_BUTTON_A;
+    }
+    gamepad.set_pad_in(pad_in);
+}
+
+int main(int argc, char** argv)
+{
+    std::string bank_path;
+    uint32_t rate_hz = 1000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--bank") == 0 && i + 1 < argc)
+        {
+            bank_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+        {
+            rate_hz = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    UserSettings& user_settings = UserSettings::get_instance();
+    if (!bank_path.empty())
+    {
+        user_settings.set_storage(bank_path);
+    }
+
+    const char* port = cdc_pty::open();
+    if (port == nullptr)
+    {
+        std::perror("Failed to create pty");
+        return 1;
+    }
+    std::printf("%s\n", port);
+    std::fflush(stdout);
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    static std::array<Gamepad, MAX_GAMEPADS> gamepads;
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        gamepads[i].set_profile(user_settings.get_profile_by_index(i));
+    }
+
+    WebAppProtocol protocol(DeviceDriverType::WEBAPP);
+    config_protocol = &protocol;
+    const uint64_t report_us = (rate_hz > 0) ? (1000000 / rate_hz) : 0;
+    uint64_t next_report_us = 0;
+
+    while (running)
+    {
+        cdc_pty::wait(1);
+
+        const uint64_t now_us = to_us_since_boot(get_absolute_time());
+        if (report_us > 0 && now_us >= next_report_us)
+        {
+            for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+            {
+                feed_gamepad(gamepads[i], i, now_us);
+            }
+            next_report_us = now_us + report_us;
+        }
+
+        protocol.receive();
+        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+        {
+            protocol.process(i, gamepads[i]);
+        }
+    }
+
+    std::fprintf(stderr, "Flash writes: %u, reboots: %u\n", user_settings.flash_writes(), user_settings.reboots());
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "BankTransfer.h"
+
+using PacketID = WebAppCommands::PacketID;
+
+bool download_bank(ConfigClient& client, ProfileBank& bank)
+{
+    std::vector<uint8_t> image(sizeof(ProfileBank));
+    size_t received = 0;
+
+    if (!client.send(PacketID::GET_BANK, 0, 0, nullptr, 0))
+    {
+        return false;
+    }
+
+    ConfigClient::Message message;
+    while (client.receive(message, 2000))
+    {
+        if (message.header.packet_id == PacketID::BANK_DATA && message.data.size() >= sizeof(WebAppCommands::BankChunk))
+        {
+            WebAppCommands::BankChunk chunk;
+            std::memcpy(&chunk, message.data.data(), sizeof(chunk));
+            const size_t chunk_len = message.data.size() - sizeof(chunk);
+
+            if (chunk.total_len != sizeof(ProfileBank) || chunk.offset + chunk_len > image.size())
+            {
+                std::fprintf(stderr, "Device has a different profile layout\n");
+                return false;
+            }
+            std::memcpy(image.data() + chunk.offset, message.data.data() + sizeof(chunk), chunk_len);
+            received += chunk_len;
+        }
+        else if (message.header.packet_id == PacketID::BANK_COMMIT && message.data.size() >= sizeof(WebAppCommands::BankCommit))
+        {
+            WebAppCommands::BankCommit commit;
+            std::memcpy(&commit, message.data.data(), sizeof(commit));
+
+            if (received < image.size() || commit.crc != ProfileBank::crc32(image.data(), image.size()))
+            {
+                std::fprintf(stderr, "Profile bank failed its CRC check\n");
+                return false;
+            }
+            std::memcpy(&bank, image.data(), sizeof(ProfileBank));
+            return true;
+        }
+        else if (message.header.packet_id == PacketID::RESP_ERROR)
+        {
+            break;
+        }
+    }
+    return false;
+}
+
+bool upload_bank(ConfigClient& client, const ProfileBank& bank)
+{
+    const uint8_t* image = reinterpret_cast<const uint8_t*>(&bank);
+    std::array<uint8_t, sizeof(WebAppCommands::BankChunk) + WebAppCommands::BANK_CHUNK_LEN> data;
+
+    for (size_t offset = 0; offset < sizeof(ProfileBank); offset += WebAppCommands::BANK_CHUNK_LEN)
+    {
+        WebAppCommands::BankChunk chunk;
+        chunk.offset = static_cast<uint16_t>(offset);
+        chunk.total_len = sizeof(ProfileBank);
+        const size_t chunk_len = std::min(WebAppCommands::BANK_CHUNK_LEN, sizeof(ProfileBank) - offset);
+
+        std::memcpy(data.data(), &chunk, sizeof(chunk));
+        std::memcpy(data.data() + sizeof(chunk), image + offset, chunk_len);
+        if (!client.send(PacketID::BANK_DATA, 0, 0, data.data(), sizeof(chunk) + chunk_len))
+        {
+            return false;
+        }
+    }
+
+    WebAppCommands::BankCommit commit;
+    commit.total_len = sizeof(ProfileBank);
+    commit.crc = ProfileBank::crc32(image, sizeof(ProfileBank));
+
+    ConfigClient::Message response;
+    return client.request(PacketID::BANK_COMMIT, 0, 0, &commit, sizeof(commit), PacketID::BANK_COMMIT, response);
+}
@@ -0,0 +1,16 @@
+#ifndef _BANK_TRANSFER_H_
+#define _BANK_TRANSFER_H_
+
+#include "UserSettings/ProfileBank.h"
+#include "ConfigClient.h"
+
+/*  The whole ProfileBank in one windowed exchange: BANK_DATA chunks, then a BANK_COMMIT
+    carrying the CRC-32 of the image. A bank is only used, or stored by the device, once
+    every chunk has arrived and the CRC matches. */
+
+//GET_BANK, bank is left as it was unless the full image checks out
+bool download_bank(ConfigClient& client, ProfileBank& bank);
+//Returns once the device has echoed the commit, i.e. the bank is in flash
+bool upload_bank(ConfigClient& client, const ProfileBank& bank);
+
+#endif // _BANK_TRANSFER_H_
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cstring>
+
+#include "ConfigClient.h"
+
+//Give up on the device after this long without an acknowledgement
+static constexpr int STALL_TIMEOUT_MS = 2000;
+
+bool ConfigClient::start()
+{
+    //The first delimiter switches a legacy session over, the second ends anything half sent
+    const uint8_t delimiters[] = { WebAppFrame::DELIMITER, WebAppFrame::DELIMITER };
+    rx_seq_ = 0;
+    tx_seq_ = 0;
+    tx_acked_ = 0;
+    failed_ = false;
+    decoder_.reset();
+    messages_.clear();
+
+    //Differs from the last start() so a late echo of its SYNC isn't taken for this one
+    sync_seq_ = static_cast<uint8_t>(sync_seq_ + 1 + (Clock::now().time_since_epoch().count() % 127));
+    synced_ = false;
+    if (!port_.write(delimiters, sizeof(delimiters)))
+    {
+        return false;
+    }
+
+    const auto deadline = Clock::now() + std::chrono::milliseconds(STALL_TIMEOUT_MS);
+    while (!synced_)
+    {
+        if (Clock::now() >= deadline || !write_frame(WebAppFrame::Type::SYNC, sync_seq_, nullptr, 0))
+        {
+            failed_ = true;
+            return false;
+        }
+        const auto resend = Clock::now() + std::chrono::milliseconds(WebAppFrame::RETRANSMIT_MS);
+        while (!synced_ && Clock::now() < resend)
+        {
+            if (!poll(10))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ConfigClient::write_frame(WebAppFrame::Type type, uint8_t seq, const void* payload, size_t len)
+{
+    uint8_t encoded[WebAppFrame::MAX_ENCODED];
+    size_t encoded_len = WebAppFrame::encode(type, seq, rx_seq_, payload, len, encoded);
+    if (encoded_len == 0 || !port_.write(encoded, encoded_len))
+    {
+        failed_ = true;
+        return false;
+    }
+    ++stats_.frames_sent;
+    stats_.bytes_sent += encoded_len;
+    return true;
+}
+
+void ConfigClient::release_acked(uint8_t ack)
+{
+    const uint8_t acked = static_cast<uint8_t>(ack - tx_acked_);
+    if (acked == 0 || acked > unacked())
+    {
+        return;
+    }
+    tx_acked_ = ack;
+    tx_progress_ = Clock::now();
+}
+
+void ConfigClient::retransmit()
+{
+    for (uint8_t seq = tx_acked_ + 1; seq != static_cast<uint8_t>(tx_seq_ + 1); ++seq)
+    {
+        const TxFrame& frame = tx_window_[seq % WebAppFrame::WINDOW];
+        write_frame(WebAppFrame::Type::DATA, seq, frame.payload.data(), frame.len);
+        ++stats_.retransmits;
+    }
+    tx_progress_ = Clock::now();
+}
+
+void ConfigClient::handle_frame(const WebAppFrame::Header& header, const uint8_t* payload)
+{
+    if (!synced_)
+    {
+        synced_ = (header.type == WebAppFrame::Type::SYNC && header.seq == sync_seq_);
+        return;
+    }
+
+    release_acked(header.ack);
+
+    Message message;
+    if ((header.type == WebAppFrame::Type::DATA || header.type == WebAppFrame::Type::EVENT) &&
+        header.len >= sizeof(WebAppCommands::CommandHeader))
+    {
+        std::memcpy(&message.header, payload, sizeof(WebAppCommands::CommandHeader));
+        message.data.assign(payload + sizeof(WebAppCommands::CommandHeader), payload + header.len);
+    }
+
+    switch (header.type)
+    {
+        case WebAppFrame::Type::DATA:
+            if (header.seq == static_cast<uint8_t>(rx_seq_ + 1))
+            {
+                rx_seq_ = header.seq;
+                messages_.push_back(std::move(message));
+                write_frame(WebAppFrame::Type::ACK, 0, nullptr, 0);
+            }
+            else if (static_cast<uint8_t>(rx_seq_ - header.seq) < WebAppFrame::WINDOW)
+            {
+                write_frame(WebAppFrame::Type::ACK, 0, nullptr, 0);
+            }
+            else
+            {
+                write_frame(WebAppFrame::Type::NAK, 0, nullptr, 0);
+            }
+            break;
+
+        case WebAppFrame::Type::EVENT:
+            if (on_event && header.len >= sizeof(WebAppCommands::CommandHeader))
+            {
+                on_event(message);
+            }
+            break;
+
+        case WebAppFrame::Type::NAK:
+            retransmit();
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool ConfigClient::poll(int timeout_ms)
+{
+    uint8_t buffer[512];
+    long len = port_.read(buffer, sizeof(buffer), timeout_ms);
+    if (len < 0)
+    {
+        failed_ = true;
+        return false;
+    }
+
+    stats_.bytes_received += static_cast<uint64_t>(len);
+    for (long i = 0; i < len; ++i)
+    {
+        if (decoder_.push(buffer[i]))
+        {
+            ++stats_.frames_received;
+            handle_frame(decoder_.header(), decoder_.payload());
+        }
+    }
+
+    if (unacked() > 0)
+    {
+        const auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - tx_progress_).count();
+        if (waited >= STALL_TIMEOUT_MS)
+        {
+            failed_ = true;
+        }
+        else if (waited >= static_cast<long>(WebAppFrame::RETRANSMIT_MS))
+        {
+            retransmit();
+        }
+    }
+    return !failed_;
+}
+
+bool ConfigClient::send(PacketID packet_id, uint8_t player_idx, uint8_t profile_id, const void* data, size_t len)
+{
+    WebAppCommands::CommandHeader header;
+    header.packet_id = packet_id;
+    header.player_idx = player_idx;
+    header.profile_id = profile_id;
+    return send(header, data, len);
+}
+
+bool ConfigClient::send(const WebAppCommands::CommandHeader& header, const void* data, size_t len)
+{
+    if (sizeof(WebAppCommands::CommandHeader) + len > WebAppFrame::MAX_PAYLOAD)
+    {
+        return false;
+    }
+    while (unacked() >= WebAppFrame::WINDOW)
+    {
+        if (!poll(10))
+        {
+            return false;
+        }
+    }
+
+    TxFrame& frame = tx_window_[++tx_seq_ % WebAppFrame::WINDOW];
+    frame.len = static_cast<uint8_t>(sizeof(header) + len);
+    std::memcpy(frame.payload.data(), &header, sizeof(header));
+    if (len > 0)
+    {
+        std::memcpy(frame.payload.data() + sizeof(header), data, len);
+    }
+
+    if (unacked() == 1)
+    {
+        tx_progress_ = Clock::now();
+    }
+    return write_frame(WebAppFrame::Type::DATA, tx_seq_, frame.payload.data(), frame.len);
+}
+
+bool ConfigClient::receive(Message& message, int timeout_ms)
+{
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (messages_.empty())
+    {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0 || !poll(static_cast<int>(std::min<long>(left, 10))))
+        {
+            return false;
+        }
+    }
+    message = std::move(messages_.front());
+    messages_.pop_front();
+    return true;
+}
+
+bool ConfigClient::request(PacketID packet_id, uint8_t player_idx, uint8_t profile_id, const void* data, size_t len,
+                           PacketID response_id, Message& response, int timeout_ms)
+{
+    WebAppCommands::CommandHeader header;
+    header.packet_id = packet_id;
+    header.player_idx = player_idx;
+    header.profile_id = profile_id;
+    return request(header, data, len, response_id, response, timeout_ms);
+}
+
+bool ConfigClient::request(const WebAppCommands::CommandHeader& header, const void* data, size_t len,
+                           PacketID response_id, Message& response, int timeout_ms)
+{
+    if (!send(header, data, len))
+    {
+        return false;
+    }
+    while (receive(response, timeout_ms))
+    {
+        if (response.header.packet_id == response_id)
+        {
+            return true;
+        }
+        if (response.header.packet_id == PacketID::RESP_ERROR)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool ConfigClient::flush(int timeout_ms)
+{
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (unacked() > 0)
+    {
+        if (Clock::now() >= deadline || !poll(10))
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef _CONFIG_CLIENT_H_
+#define _CONFIG_CLIENT_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "USBDevice/DeviceDriver/WebApp/WebAppFrame.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppCommands.h"
+#include "SerialPort.h"
+
+/*  Host side of a framed WebApp session: sends commands as DATA frames with up to
+    WebAppFrame::WINDOW unacknowledged, resends them on a NAK or after RETRANSMIT_MS
+    without progress, and acknowledges the device's DATA frames in order. Events are
+    handed to on_event as they arrive, everything else waits for receive(). */
+class ConfigClient
+{
+public:
+    using PacketID = WebAppCommands::PacketID;
+
+    struct Message
+    {
+        WebAppCommands::CommandHeader header;
+        std::vector<uint8_t> data;
+    };
+
+    struct Stats
+    {
+        uint32_t frames_sent{0};
+        uint32_t frames_received{0};
+        uint32_t retransmits{0};
+        uint64_t bytes_sent{0};
+        uint64_t bytes_received{0};
+    };
+
+    explicit ConfigClient(SerialPort& port)
+        : port_(port) {}
+
+    //Switches the device to framed mode and starts a new session, whatever an earlier
+    //host left behind. Call after opening the port, false if the device doesn't answer
+    bool start();
+
+    //Returns once the command is in the send window, false if the device stops responding
+    bool send(const WebAppCommands::CommandHeader& header, const void* data, size_t len);
+    bool send(PacketID packet_id, uint8_t player_idx, uint8_t profile_id, const void* data, size_t len);
+    //Waits for the next command from the device
+    bool receive(Message& message, int timeout_ms);
+    //Sends a command and waits for the response with response_id, false on RESP_ERROR
+    bool request(const WebAppCommands::CommandHeader& header, const void* data, size_t len,
+                 PacketID response_id, Message& response, int timeout_ms = 2000);
+    bool request(PacketID packet_id, uint8_t player_idx, uint8_t profile_id, const void* data, size_t len,
+                 PacketID response_id, Message& response, int timeout_ms = 2000);
+    //Waits until everything sent has been acknowledged
+    bool flush(int timeout_ms);
+    //Handles whatever arrives for timeout_ms
+    bool poll(int timeout_ms);
+
+    const Stats& stats() const { return stats_; }
+    uint32_t rx_errors() const { return decoder_.errors(); }
+
+    std::function<void(const Message&)> on_event;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct TxFrame
+    {
+        uint8_t len{0};
+        std::array<uint8_t, WebAppFrame::MAX_PAYLOAD> payload;
+    };
+
+    SerialPort& port_;
+    WebAppFrame::Decoder decoder_;
+    std::deque<Message> messages_;
+
+    uint8_t rx_seq_{0};
+    uint8_t tx_seq_{0};
+    uint8_t tx_acked_{0};
+    Clock::time_point tx_progress_;
+    std::array<TxFrame, WebAppFrame::WINDOW> tx_window_;
+    bool failed_{false};
+
+    //Everything before the device echoes sync_seq_ belongs to an earlier session
+    uint8_t sync_seq_{0};
+    bool synced_{false};
+
+    Stats stats_;
+
+    bool write_frame(WebAppFrame::Type type, uint8_t seq, const void* payload, size_t len);
+    void handle_frame(const WebAppFrame::Header& header, const uint8_t* payload);
+    void release_acked(uint8_t ack);
+    void retransmit();
+
+    inline uint8_t unacked() const { return static_cast<uint8_t>(tx_seq_ - tx_acked_); }
+};
+
+#endif // _CONFIG_CLIENT_H_
@@ -0,0 +1,96 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "SerialPort.h"
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+bool SerialPort::open(const std::string& path)
+{
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0)
+    {
+        return false;
+    }
+
+    termios tio;
+    if (tcgetattr(fd_, &tio) != 0)
+    {
+        close();
+        return false;
+    }
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B115200);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(fd_, TCSANOW, &tio);
+    tcflush(fd_, TCIOFLUSH);
+
+    //The firmware only talks once DTR is set, a pty doesn't care
+    int dtr = TIOCM_DTR;
+    ioctl(fd_, TIOCMBIS, &dtr);
+    return true;
+}
+
+void SerialPort::close()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+long SerialPort::read(uint8_t* buffer, size_t len, int timeout_ms)
+{
+    pollfd pfd{ fd_, POLLIN, 0 };
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready < 0)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    if (ready == 0)
+    {
+        return 0;
+    }
+    if (pfd.revents & (POLLERR | POLLHUP))
+    {
+        return -1;
+    }
+
+    ssize_t read_len = ::read(fd_, buffer, len);
+    if (read_len < 0)
+    {
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    }
+    return static_cast<long>(read_len);
+}
+
+bool SerialPort::write(const uint8_t* data, size_t len)
+{
+    size_t written = 0;
+    while (written < len)
+    {
+        ssize_t write_len = ::write(fd_, data + written, len - written);
+        if (write_len < 0)
+        {
+            if (errno != EAGAIN && errno != EINTR)
+            {
+                return false;
+            }
+            pollfd pfd{ fd_, POLLOUT, 0 };
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        written += static_cast<size_t>(write_len);
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef _SERIAL_PORT_H_
+#define _SERIAL_PORT_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+//Raw mode serial port, the OGX-Mini's CDC interface or the simulator's pty
+class SerialPort
+{
+public:
+    SerialPort() = default;
+    ~SerialPort();
+
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    //Returns the number of bytes read, 0 on timeout, -1 on error
+    long read(uint8_t* buffer, size_t len, int timeout_ms);
+    bool write(const uint8_t* data, size_t len);
+
+private:
+    int fd_{-1};
+};
+
+#endif // _SERIAL_PORT_H_
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "UserSettings/ProfileBank.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppTelemetry.h"
+#include "ConfigClient.h"
+#include "BankTransfer.h"
+
+/*  Command line client for the OGX-Mini's framed WebApp protocol, see README.md. */
+
+using Clock = std::chrono::steady_clock;
+using PacketID = WebAppCommands::PacketID;
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+        "Usage: %s PORT COMMAND [ARGS]\n"
+        "  get-profile IDX [FILE]           Print or save the active profile of gamepad IDX\n"
+        "  set-profile IDX FILE [DRIVER]    Store a profile for gamepad IDX, optionally switching driver\n"
+        "  backup FILE                      Save every profile to FILE\n"
+        "  restore FILE                     Replace every profile with a backup, in one flash write\n"
+        "  bench-latency [COUNT]            Round trip time of COUNT profile requests\n"
+        "  bench-throughput [COUNT]         Download the profile bank COUNT times\n"
+        "  telemetry [MASK] [SECONDS] [MIN_INTERVAL_US]\n"
+        "                                   Print input samples of the gamepads in MASK as CSV\n",
+        name);
+}
+
+static double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static bool read_file(const std::string& path, void* data, size_t len)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file || static_cast<size_t>(file.tellg()) != len)
+    {
+        std::fprintf(stderr, "%s must be %zu bytes\n", path.c_str(), len);
+        return false;
+    }
+    file.seekg(0);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(len)));
+}
+
+static bool write_file(const std::string& path, const void* data, size_t len)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    return static_cast<bool>(file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(len)));
+}
+
+static void print_hex(const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        std::printf("%02x%s", data[i], ((i + 1) % 16 == 0 || i + 1 == len) ? "\n" : " ");
+    }
+}
+
+static int get_profile(ConfigClient& client, uint8_t index, const char* path)
+{
+    ConfigClient::Message response;
+    if (!client.request(PacketID::GET_PROFILE_BY_IDX, index, 0, nullptr, 0, PacketID::GET_PROFILE_BY_IDX, response) ||
+        response.data.size() < sizeof(UserProfile))
+    {
+        std::fprintf(stderr, "Failed to read profile\n");
+        return 1;
+    }
+
+    std::printf("Gamepad %u: profile %u, driver %u, max gamepads %u\n",
+                index, response.header.profile_id,
+                static_cast<unsigned>(response.header.device_driver), response.header.max_gamepads);
+    if (path != nullptr)
+    {
+        return write_file(path, response.data.data(), sizeof(UserProfile)) ? 0 : 1;
+    }
+    print_hex(response.data.data(), sizeof(UserProfile));
+    return 0;
+}
+
+static int set_profile(ConfigClient& client, uint8_t index, const char* path, const char* driver)
+{
+    UserProfile profile;
+    if (!read_file(path, &profile, sizeof(profile)))
+    {
+        return 1;
+    }
+
+    //The command header's device_driver selects the driver, WEBAPP keeps the current one
+    WebAppCommands::CommandHeader header;
+    header.packet_id = PacketID::SET_PROFILE;
+    header.device_driver = driver ? static_cast<DeviceDriverType>(std::strtoul(driver, nullptr, 0)) : DeviceDriverType::WEBAPP;
+    header.player_idx = index;
+    header.profile_id = profile.id;
+
+    ConfigClient::Message response;
+    if (!client.request(header, &profile, sizeof(profile), PacketID::SET_PROFILE, response))
+    {
+        std::fprintf(stderr, "Failed to store profile\n");
+        return 1;
+    }
+    std::printf("Stored profile %u for gamepad %u\n", profile.id, index);
+    return 0;
+}
+
+static int backup(ConfigClient& client, const char* path)
+{
+    ProfileBank bank;
+    const auto start = Clock::now();
+    if (!download_bank(client, bank) || !write_file(path, &bank, sizeof(bank)))
+    {
+        std::fprintf(stderr, "Backup failed\n");
+        return 1;
+    }
+    std::printf("Saved %zu bytes in %.1f ms\n", sizeof(bank), ms_since(start));
+    return 0;
+}
+
+static int restore(ConfigClient& client, const char* path)
+{
+    ProfileBank bank;
+    if (!read_file(path, &bank, sizeof(bank)))
+    {
+        return 1;
+    }
+    if (!bank.verify())
+    {
+        std::fprintf(stderr, "%s isn't a valid profile backup\n", path);
+        return 1;
+    }
+
+    const auto start = Clock::now();
+    if (!upload_bank(client, bank))
+    {
+        std::fprintf(stderr, "Restore failed, the device kept its profiles\n");
+        return 1;
+    }
+    std::printf("Restored %zu bytes in %.1f ms\n", sizeof(bank), ms_since(start));
+    return 0;
+}
+
+static int bench_latency(ConfigClient& client, uint32_t count)
+{
+    std::vector<double> times;
+    times.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ConfigClient::Message response;
+        const auto start = Clock::now();
+        if (!client.request(PacketID::GET_PROFILE_BY_IDX, 0, 0, nullptr, 0, PacketID::GET_PROFILE_BY_IDX, response))
+        {
+            std::fprintf(stderr, "Request %u failed\n", i);
+            return 1;
+        }
+        times.push_back(ms_since(start));
+    }
+
+    std::sort(times.begin(), times.end());
+    double total = 0;
+    for (double time : times)
+    {
+        total += time;
+    }
+    std::printf("%u requests: min %.3f ms, avg %.3f ms, p99 %.3f ms, max %.3f ms, %u retransmits\n",
+                count, times.front(), total / count, times[std::min<size_t>(count - 1, (count * 99) / 100)],
+                times.back(), client.stats().retransmits);
+    return 0;
+}
+
+static int bench_throughput(ConfigClient& client, uint32_t count)
+{
+    ProfileBank bank;
+    const auto start = Clock::now();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (!download_bank(client, bank))
+        {
+            std::fprintf(stderr, "Download %u failed\n", i);
+            return 1;
+        }
+    }
+    const double elapsed_ms = ms_since(start);
+    std::printf("%u downloads of %zu bytes in %.1f ms: %.1f KiB/s, %.2f ms each, %u retransmits\n",
+                count, sizeof(ProfileBank), elapsed_ms,
+                (count * sizeof(ProfileBank)) / 1.024 / elapsed_ms, elapsed_ms / count, client.stats().retransmits);
+    return 0;
+}
+
+static int telemetry(ConfigClient& client, uint8_t mask, uint32_t seconds, uint32_t min_interval_us)
+{
+    std::array<WebAppTelemetry::Sample, 8> samples{};
+    std::array<uint8_t, 8> next_seq{};
+    std::array<bool, 8> synced{};
+    uint64_t events = 0;
+    uint64_t dropped = 0;
+    uint64_t gaps = 0;
+
+    std::printf("gamepad,time_us,seq,dropped,raw_lx,raw_ly,raw_rx,raw_ry,raw_lt,raw_rt,"
+                "dpad,buttons,lt,rt,lx,ly,rx,ry\n");
+
+    client.on_event = [&](const ConfigClient::Message& message)
+    {
+        WebAppTelemetry::Header header;
+        const uint8_t index = message.header.player_idx;
+        if (message.header.packet_id != PacketID::TELEMETRY || index >= samples.size() ||
+            message.data.size() < sizeof(header))
+        {
+            return;
+        }
+        std::memcpy(&header, message.data.data(), sizeof(header));
+
+        ++events;
+        dropped += header.dropped;
+        if (synced[index] && header.seq != next_seq[index])
+        {
+            ++gaps;
+            synced[index] = false;
+        }
+        next_seq[index] = static_cast<uint8_t>(header.seq + 1);
+
+        WebAppTelemetry::Sample& sample = samples[index];
+        if (!WebAppTelemetry::apply_delta(sample, header.fields, message.data.data() + sizeof(header), message.data.size() - sizeof(header)))
+        {
+            return;
+        }
+        //Deltas after a lost event are only trusted again from the next key event
+        if (header.fields == WebAppTelemetry::ALL_FIELDS)
+        {
+            synced[index] = true;
+        }
+        if (!synced[index])
+        {
+            return;
+        }
+
+        std::printf("%u,%u,%u,%u,%d,%d,%d,%d,%u,%u,%u,%u,%u,%u,%d,%d,%d,%d\n",
+                    index, header.time_us, header.seq, header.dropped,
+                    sample.raw_joystick_lx, sample.raw_joystick_ly, sample.raw_joystick_rx, sample.raw_joystick_ry,
+                    sample.raw_trigger_l, sample.raw_trigger_r,
+                    sample.dpad, sample.buttons, sample.trigger_l, sample.trigger_r,
+                    sample.joystick_lx, sample.joystick_ly, sample.joystick_rx, sample.joystick_ry);
+    };
+
+    WebAppCommands::TelemetryConfig config;
+    config.gamepad_mask = mask;
+    config.min_interval_us = min_interval_us;
+
+    ConfigClient::Message response;
+    if (!client.request(PacketID::TELEMETRY_START, 0, 0, &config, sizeof(config), PacketID::TELEMETRY_START, response))
+    {
+        std::fprintf(stderr, "Telemetry isn't supported by this device\n");
+        return 1;
+    }
+
+    const auto start = Clock::now();
+    const uint64_t bytes_start = client.stats().bytes_received;
+    while (ms_since(start) < seconds * 1000.0)
+    {
+        if (!client.poll(10))
+        {
+            std::fprintf(stderr, "Device stopped responding\n");
+            return 1;
+        }
+    }
+    const double elapsed_ms = ms_since(start);
+    const uint64_t bytes = client.stats().bytes_received - bytes_start;
+
+    client.request(PacketID::TELEMETRY_STOP, 0, 0, nullptr, 0, PacketID::TELEMETRY_STOP, response);
+
+    std::fprintf(stderr, "%llu events (%.0f/s), %.1f KiB/s, %llu samples dropped by the device, %llu lost, %u bad frames\n",
+                 static_cast<unsigned long long>(events), events * 1000.0 / elapsed_ms, bytes / 1.024 / elapsed_ms,
+                 static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(gaps), client.rx_errors());
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const std::string command = argv[2];
+    auto arg = [&](int idx, const char* fallback) -> const char*
+    {
+        return (argc > idx) ? argv[idx] : fallback;
+    };
+    auto num = [&](int idx, unsigned long fallback) -> uint32_t
+    {
+        return static_cast<uint32_t>((argc > idx) ? std::strtoul(argv[idx], nullptr, 0) : fallback);
+    };
+
+    SerialPort port;
+    if (!port.open(argv[1]))
+    {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    ConfigClient client(port);
+    if (!client.start())
+    {
+        std::fprintf(stderr, "Failed to start session\n");
+        return 1;
+    }
+
+    if (command == "get-profile" && argc >= 4)
+    {
+        return get_profile(client, static_cast<uint8_t>(num(3, 0)), arg(4, nullptr));
+    }
+    if (command == "set-profile" && argc >= 5)
+    {
+        return set_profile(client, static_cast<uint8_t>(num(3, 0)), argv[4], arg(5, nullptr));
+    }
+    if (command == "backup" && argc >= 4)
+    {
+        return backup(client, argv[3]);
+    }
+    if (command == "restore" && argc >= 4)
+    {
+        return restore(client, argv[3]);
+    }
+    if (command == "bench-latency")
+    {
+        return bench_latency(client, std::max<uint32_t>(1, num(3, 200)));
+    }
+    if (command == "bench-throughput")
+    {
+        return bench_throughput(client, std::max<uint32_t>(1, num(3, 20)));
+    }
+    if (command == "telemetry")
+    {
+        return telemetry(client, static_cast<uint8_t>(num(3, 1)), num(4, 5), num(5, 0));
+    }
+
+    usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "Check.h"
+#include "Loopback.h"
+#include "BankTransfer.h"
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/UserSettings.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppProtocol.h"
+
+/*  ogxm-config's backup and restore against the firmware's WebAppProtocol: the whole
+    bank moves in one windowed exchange, a lossy link costs retransmits but never a
+    wrong bank, and the device stores nothing that doesn't match the commit's CRC. */
+
+using PacketID = WebAppCommands::PacketID;
+
+static std::array<Gamepad, MAX_GAMEPADS> gamepads;
+
+static bool same(const ProfileBank& a, const ProfileBank& b)
+{
+    return std::memcmp(&a, &b, sizeof(ProfileBank)) == 0;
+}
+
+static ProfileBank custom_bank(uint8_t seed)
+{
+    ProfileBank bank;
+    for (uint8_t i = 0; i < ProfileBank::MAX_PROFILES; ++i)
+    {
+        bank.profiles[i].button_a = static_cast<uint16_t>(seed << 8 | i);
+        bank.profiles[i].trigger_settings_l.dz_inner = fix16_from_int(seed + i);
+        bank.profiles[i].analog_enabled = seed & 1;
+    }
+    for (uint8_t i = 0; i < ProfileBank::MAX_SLOTS; ++i)
+    {
+        bank.header.active_ids[i] = static_cast<uint8_t>((seed + i) % ProfileBank::MAX_PROFILES + 1);
+    }
+    bank.seal();
+    return bank;
+}
+
+static void test_round_trip()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    SerialPort port;
+    ConfigClient client(port);
+    CHECK(port.open("loopback") && client.start());
+
+    ProfileBank bank;
+    CHECK(download_bank(client, bank));
+    CHECK(same(bank, user_settings.read_profile_bank()));
+
+    //One flash write for the whole bank, the gamepads pick it up without a reboot
+    const uint32_t flash_writes = user_settings.flash_writes();
+    const ProfileBank uploaded = custom_bank(1);
+    CHECK(upload_bank(client, uploaded));
+    CHECK(user_settings.flash_writes() == flash_writes + 1 && user_settings.reboots() == 0);
+    CHECK(same(uploaded, user_settings.read_profile_bank()));
+
+    ProfileBank downloaded;
+    CHECK(download_bank(client, downloaded) && same(uploaded, downloaded));
+    CHECK(client.stats().retransmits == 0);
+
+    port.close();
+    loopback::run(2);
+}
+
+//Bytes dropped and flipped both ways, every transfer still completes with the right bank
+static void test_lossy_link()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    loopback::Faults faults;
+    faults.drop_per_mille = 1;
+    faults.corrupt_per_mille = 1;
+    faults.seed = 32;
+    loopback::set_faults(faults);
+
+    SerialPort port;
+    ConfigClient client(port);
+    CHECK(port.open("loopback") && client.start());
+
+    for (uint8_t i = 0; i < 6; ++i)
+    {
+        const ProfileBank uploaded = custom_bank(static_cast<uint8_t>(10 + i));
+        CHECK(upload_bank(client, uploaded));
+        CHECK(same(uploaded, user_settings.read_profile_bank()));
+
+        ProfileBank downloaded;
+        CHECK(download_bank(client, downloaded) && same(uploaded, downloaded));
+    }
+    CHECK(loopback::stats().dropped > 0 && loopback::stats().corrupted > 0);
+    CHECK(client.stats().retransmits > 0 || client.rx_errors() > 0);
+
+    loopback::set_faults(loopback::Faults());
+    port.close();
+    loopback::run(2);
+}
+
+static bool send_chunk(ConfigClient& client, const ProfileBank& bank, size_t offset)
+{
+    std::array<uint8_t, sizeof(WebAppCommands::BankChunk) + WebAppCommands::BANK_CHUNK_LEN> data;
+    WebAppCommands::BankChunk chunk;
+    chunk.offset = static_cast<uint16_t>(offset);
+    chunk.total_len = sizeof(ProfileBank);
+    const size_t chunk_len = std::min(WebAppCommands::BANK_CHUNK_LEN, sizeof(ProfileBank) - offset);
+
+    std::memcpy(data.data(), &chunk, sizeof(chunk));
+    std::memcpy(data.data() + sizeof(chunk), reinterpret_cast<const uint8_t*>(&bank) + offset, chunk_len);
+    return client.send(PacketID::BANK_DATA, 0, 0, data.data(), sizeof(chunk) + chunk_len);
+}
+
+static bool commit_rejected(ConfigClient& client, uint32_t crc)
+{
+    WebAppCommands::BankCommit commit;
+    commit.total_len = sizeof(ProfileBank);
+    commit.crc = crc;
+    ConfigClient::Message response;
+    return !client.request(PacketID::BANK_COMMIT, 0, 0, &commit, sizeof(commit), PacketID::BANK_COMMIT, response) &&
+           response.header.packet_id == PacketID::RESP_ERROR;
+}
+
+//A commit that doesn't match what arrived, a missing chunk or an unusable bank stores nothing
+static void test_rejected_commits()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    const ProfileBank stored = user_settings.read_profile_bank();
+    const uint32_t flash_writes = user_settings.flash_writes();
+
+    SerialPort port;
+    ConfigClient client(port);
+    CHECK(port.open("loopback") && client.start());
+
+    const ProfileBank bank = custom_bank(40);
+    const uint32_t crc = ProfileBank::crc32(reinterpret_cast<const uint8_t*>(&bank), sizeof(ProfileBank));
+
+    for (size_t offset = 0; offset < sizeof(ProfileBank); offset += WebAppCommands::BANK_CHUNK_LEN)
+    {
+        CHECK(send_chunk(client, bank, offset));
+    }
+    CHECK(commit_rejected(client, crc ^ 1));
+
+    //Every chunk but the last
+    for (size_t offset = 0; offset + WebAppCommands::BANK_CHUNK_LEN < sizeof(ProfileBank); offset += WebAppCommands::BANK_CHUNK_LEN)
+    {
+        CHECK(send_chunk(client, bank, offset));
+    }
+    CHECK(commit_rejected(client, crc));
+
+    //Whole and matching, but slot 0 points at no profile
+    ProfileBank bad = bank;
+    bad.header.active_ids[0] = 0;
+    bad.seal();
+    CHECK(!upload_bank(client, bad));
+
+    CHECK(user_settings.flash_writes() == flash_writes);
+    CHECK(same(stored, user_settings.read_profile_bank()));
+
+    //The session is fine afterwards
+    CHECK(upload_bank(client, bank));
+    CHECK(same(bank, user_settings.read_profile_bank()));
+
+    port.close();
+    loopback::run(2);
+}
+
+//A restore cut off half way leaves nothing behind for the next host's commit to pick up
+static void test_interrupted_upload()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    const ProfileBank stored = user_settings.read_profile_bank();
+    const ProfileBank bank = custom_bank(50);
+    const uint32_t crc = ProfileBank::crc32(reinterpret_cast<const uint8_t*>(&bank), sizeof(ProfileBank));
+
+    SerialPort port;
+    CHECK(port.open("loopback"));
+    {
+        ConfigClient client(port);
+        CHECK(client.start());
+        for (size_t offset = 0; offset < sizeof(ProfileBank); offset += WebAppCommands::BANK_CHUNK_LEN)
+        {
+            CHECK(send_chunk(client, bank, offset));
+        }
+        CHECK(client.flush(2000));
+    }
+    port.close();
+    loopback::run(2);
+    CHECK(port.open("loopback"));
+
+    ConfigClient client(port);
+    CHECK(client.start());
+    CHECK(commit_rejected(client, crc));
+    CHECK(same(stored, user_settings.read_profile_bank()));
+
+    port.close();
+    loopback::run(2);
+}
+
+int main()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        gamepads[i].set_profile(user_settings.get_profile_by_index(i));
+    }
+
+    WebAppProtocol protocol(DeviceDriverType::WEBAPP);
+    loopback::set_device([&protocol]
+    {
+        protocol.receive();
+        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+        {
+            protocol.process(i, gamepads[i]);
+        }
+    });
+    loopback::set_line_state([&protocol](bool connected)
+    {
+        protocol.line_state_changed(connected);
+    });
+
+    test_round_trip();
+    test_lossy_link();
+    test_rejected_commits();
+    test_interrupted_upload();
+    return check::result("BankTransferTest");
+}
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Check.h"
+#include "Gamepad/Gamepad.h"
+#include "BLEServer/ProfileTransfer.h"
+
+/*  The Pico W BLE config server's profile chunking at the MTUs clients negotiate. The
+    stream sends as few notifications as the MTU allows and they join back into the
+    profile, writes of any length up to the payload build it, and the legacy 20 byte
+    reads and writes are as they were. */
+
+using namespace BLEServer;
+
+static constexpr std::array<uint16_t, 6> MTUS = {{ 23, 64, 185, 193, 194, 247 }};
+
+static bool same(const UserProfile& a, const UserProfile& b)
+{
+    return std::memcmp(&a, &b, sizeof(UserProfile)) == 0;
+}
+
+static ProfileBank custom_bank()
+{
+    ProfileBank bank;
+    for (uint8_t i = 0; i < ProfileBank::MAX_PROFILES; ++i)
+    {
+        bank.profiles[i].button_a = static_cast<uint16_t>(0x200 + i);
+        bank.profiles[i].analog_off_lb = static_cast<uint8_t>(0xC0 + i);
+        bank.profiles[i].trigger_settings_l.dz_inner = fix16_from_int(i * 5);
+    }
+    bank.header.active_ids = {6, 2, 7, 4};
+    bank.seal();
+    return bank;
+}
+
+static SetupPacket setup(uint8_t player_idx, uint8_t profile_id)
+{
+    SetupPacket setup_packet;
+    setup_packet.player_idx = player_idx;
+    setup_packet.profile_id = profile_id;
+    return setup_packet;
+}
+
+//What send_notification() sends for one PROFILE_STREAM request
+static std::vector<std::vector<uint8_t>> stream(ProfileReader& reader, uint16_t mtu)
+{
+    std::vector<std::vector<uint8_t>> chunks;
+    do
+    {
+        uint8_t buffer[sizeof(UserProfile)];
+        const uint16_t len = reader.get_profile_data(buffer, sizeof(buffer), payload_len(mtu));
+        if (len == 0)
+        {
+            break;
+        }
+        chunks.emplace_back(buffer, buffer + len);
+    }
+    while (!reader.at_start() && chunks.size() <= sizeof(UserProfile));
+    return chunks;
+}
+
+static UserProfile join(const std::vector<std::vector<uint8_t>>& chunks)
+{
+    UserProfile profile;
+    size_t offset = 0;
+    for (const auto& chunk : chunks)
+    {
+        if (offset + chunk.size() > sizeof(UserProfile))
+        {
+            return UserProfile();
+        }
+        std::memcpy(reinterpret_cast<uint8_t*>(&profile) + offset, chunk.data(), chunk.size());
+        offset += chunk.size();
+    }
+    return (offset == sizeof(UserProfile)) ? profile : UserProfile();
+}
+
+//Every notification full but the last, and no more of them than the MTU needs
+static void test_stream(const ProfileBank& bank)
+{
+    static_assert(sizeof(UserProfile) == 190, "Chunk counts below assume a 190 byte UserProfile");
+    CHECK(payload_len(23) == DEFAULT_PAYLOAD_LEN);
+
+    ProfileReader reader;
+    for (const uint16_t mtu : MTUS)
+    {
+        const size_t payload = payload_len(mtu);
+        const size_t expected = (sizeof(UserProfile) + payload - 1) / payload;
+
+        reader.set_setup_packet(setup(0, 3));
+        const auto chunks = stream(reader, mtu);
+        CHECK(chunks.size() == expected);
+        for (size_t i = 0; i + 1 < chunks.size(); ++i)
+        {
+            CHECK(chunks[i].size() == payload);
+        }
+        CHECK(!chunks.empty() && chunks.back().size() == sizeof(UserProfile) - (expected - 1) * payload);
+        CHECK(same(join(chunks), bank.profiles[2]) && reader.at_start());
+
+        //A second request on the same setup starts from the top
+        CHECK(same(join(stream(reader, mtu)), bank.profiles[2]));
+    }
+    CHECK(stream(reader, 185).size() == 2 && stream(reader, 193).size() == 1 && stream(reader, 23).size() == 10);
+}
+
+static void test_reader_setup(const ProfileBank& bank)
+{
+    ProfileReader reader;
+
+    //0xFF reads the profile a gamepad has active
+    reader.set_setup_packet(setup(2, 0xFF));
+    CHECK(same(join(stream(reader, 247)), bank.profiles[bank.header.active_ids[2] - 1]));
+
+    //A setup packet mid-stream starts the new profile from the top
+    reader.set_setup_packet(setup(0, 1));
+    uint8_t buffer[sizeof(UserProfile)];
+    CHECK(reader.get_profile_data(buffer, sizeof(buffer), payload_len(64)) == payload_len(64) && !reader.at_start());
+    reader.set_setup_packet(setup(0, 5));
+    CHECK(reader.at_start());
+    CHECK(same(join(stream(reader, 64)), bank.profiles[4]));
+
+    //Ids and indexes UserSettings doesn't have, or a buffer that can't take the chunk
+    reader.set_setup_packet(setup(0, UserSettings::MAX_PROFILES + 1));
+    CHECK(reader.get_profile_data(buffer, sizeof(buffer), payload_len(247)) == 0 && reader.at_start());
+    reader.set_setup_packet(setup(UserSettings::MAX_PROFILES, 0xFF));
+    CHECK(reader.get_profile_data(buffer, sizeof(buffer), payload_len(247)) == 0 && reader.at_start());
+    reader.set_setup_packet(setup(0, 1));
+    CHECK(reader.get_profile_data(buffer, DEFAULT_PAYLOAD_LEN - 1) == 0);
+    CHECK(reader.get_profile_data(nullptr, sizeof(buffer)) == 0);
+
+    //PROFILE reads keep to 20 bytes whatever the MTU
+    for (size_t offset = 0; offset < sizeof(UserProfile); offset += DEFAULT_PAYLOAD_LEN)
+    {
+        const uint16_t len = reader.get_profile_data(buffer, sizeof(buffer));
+        CHECK(len == std::min<size_t>(DEFAULT_PAYLOAD_LEN, sizeof(UserProfile) - offset));
+        CHECK(std::memcmp(buffer, reinterpret_cast<const uint8_t*>(&bank.profiles[0]) + offset, len) == 0);
+    }
+    CHECK(reader.at_start());
+}
+
+//The PROFILE write handler's length check, then the write
+static size_t write(ProfileWriter& writer, const uint8_t* data, uint16_t len, uint16_t mtu)
+{
+    if (len == 0 || len > writer.get_xfer_len(payload_len(mtu)))
+    {
+        return 0;
+    }
+    return writer.set_profile_data(data, len);
+}
+
+static void test_writer(const ProfileBank& bank)
+{
+    const UserProfile& profile = bank.profiles[6];
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(&profile);
+    ProfileWriter writer;
+
+    //Legacy clients, 20 byte chunks at the default MTU
+    writer.set_setup_packet(setup(1, 7));
+    size_t offset = 0;
+    while (offset < sizeof(UserProfile))
+    {
+        const uint16_t len = static_cast<uint16_t>(std::min<size_t>(DEFAULT_PAYLOAD_LEN, sizeof(UserProfile) - offset));
+        const size_t written = write(writer, data + offset, len, 23);
+        offset += len;
+        CHECK(written == offset);
+    }
+    CHECK(same(writer.get_profile(), profile) && writer.get_setup_packet().player_idx == 1);
+
+    //One write once the MTU fits the profile, a byte short of that takes two
+    writer.set_setup_packet(setup(1, 7));
+    CHECK(write(writer, data, sizeof(UserProfile), 193) == sizeof(UserProfile));
+    CHECK(same(writer.get_profile(), profile));
+    CHECK(write(writer, data, sizeof(UserProfile), 192) == 0);
+    CHECK(write(writer, data, payload_len(192), 192) == payload_len(192));
+    CHECK(write(writer, data + payload_len(192), 1, 192) == sizeof(UserProfile));
+
+    //Mixed lengths, none longer than the payload or what's left of the profile
+    const std::array<uint16_t, 5> lens = {{ 1, 61, 20, 100, 8 }};
+    writer.set_setup_packet(setup(1, 7));
+    offset = 0;
+    for (const uint16_t len : lens)
+    {
+        CHECK(write(writer, data, 0, 247) == 0);
+        if (offset + len < sizeof(UserProfile))
+        {
+            CHECK(write(writer, data + offset, static_cast<uint16_t>(sizeof(UserProfile) - offset + 1), 247) == 0);
+        }
+        offset += len;
+        CHECK(write(writer, data + offset - len, len, 247) == offset);
+    }
+    CHECK(offset == sizeof(UserProfile) && same(writer.get_profile(), profile));
+
+    //A new setup packet drops a half written profile
+    writer.set_setup_packet(setup(1, 7));
+    CHECK(write(writer, data, 100, 247) == 100);
+    writer.set_setup_packet(setup(2, 3));
+    CHECK(write(writer, data, 100, 247) == 100);
+    CHECK(write(writer, data + 100, sizeof(UserProfile) - 100, 247) == sizeof(UserProfile));
+    CHECK(same(writer.get_profile(), profile) && writer.get_setup_packet().player_idx == 2);
+}
+
+//GAMEPAD notifications carry a whole PadIn or aren't sent
+static void test_gamepad_fits()
+{
+    CHECK(payload_len(23) < sizeof(Gamepad::PadIn));
+    CHECK(payload_len(static_cast<uint16_t>(sizeof(Gamepad::PadIn) + 2)) < sizeof(Gamepad::PadIn));
+    CHECK(payload_len(static_cast<uint16_t>(sizeof(Gamepad::PadIn) + 3)) == sizeof(Gamepad::PadIn));
+    CHECK(payload_len(185) >= sizeof(Gamepad::PadIn));
+}
+
+int main()
+{
+    const ProfileBank bank = custom_bank();
+    CHECK(UserSettings::get_instance().store_profile_bank(bank));
+
+    test_stream(bank);
+    test_reader_setup(bank);
+    test_writer(bank);
+    test_gamepad_fits();
+    return check::result("BleChunkTest");
+}
@@ -0,0 +1,180 @@
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+
+#include "Check.h"
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/ComboDetector.h"
+
+/*  ComboDetector against scripted timelines of button edges and polls, the times are
+    made up so nothing here waits. A combo fires once, counted from its press edge
+    however late the poll, and any other change of the buttons starts it over. */
+
+static constexpr uint32_t A = 1 << 0;
+static constexpr uint32_t B = 1 << 1;
+static constexpr uint32_t C = 1 << 2;
+
+using Detector = ComboDetector<3>;
+
+static constexpr std::array<Detector::Combo, 3> COMBOS =
+{{
+    { A,     3000 },
+    { A | B, 3000 },
+    { C,     500  },
+}};
+
+struct Event
+{
+    uint32_t time_ms;
+    bool     edge;      //update() with buttons, otherwise poll()
+    uint32_t buttons;
+    int32_t  expect;    //What poll() returns
+};
+
+static void run(const char* name, uint32_t start_ms, std::initializer_list<Event> timeline)
+{
+    Detector detector(COMBOS);
+    for (const Event& event : timeline)
+    {
+        const uint32_t time_ms = start_ms + event.time_ms;
+        if (event.edge)
+        {
+            detector.update(event.buttons, time_ms);
+            continue;
+        }
+        const int32_t combo = detector.poll(time_ms);
+        if (combo != event.expect)
+        {
+            std::printf("%s: poll at %u returned %d, expected %d\n",
+                        name, static_cast<unsigned>(event.time_ms), static_cast<int>(combo), static_cast<int>(event.expect));
+        }
+        CHECK(combo == event.expect);
+    }
+}
+
+static constexpr bool EDGE = true;
+static constexpr bool POLL = false;
+static constexpr int32_t NONE = Detector::NO_COMBO;
+
+static void test_timelines()
+{
+    run("hold", 0,
+    {
+        { 100,   EDGE, A, 0 },
+        { 3099,  POLL, 0, NONE },
+        { 3100,  POLL, 0, 0 },
+        { 3101,  POLL, 0, NONE },   //Once per press
+        { 9000,  POLL, 0, NONE },
+        { 9500,  EDGE, 0, 0 },
+        { 9600,  EDGE, A, 0 },
+        { 12599, POLL, 0, NONE },
+        { 12600, POLL, 0, 0 },
+    });
+
+    //The main loop can be busy for a while, the hold counts from the edge
+    run("late poll", 0,
+    {
+        { 0,     EDGE, A, 0 },
+        { 8000,  POLL, 0, 0 },
+        { 8001,  POLL, 0, NONE },
+    });
+
+    run("released early", 0,
+    {
+        { 0,     EDGE, A, 0 },
+        { 2999,  EDGE, 0, 0 },
+        { 3000,  POLL, 0, NONE },
+        { 60000, POLL, 0, NONE },
+    });
+
+    //Adding B mid-hold is a different combo, timed from when B went down
+    run("superset", 0,
+    {
+        { 0,     EDGE, A,     0 },
+        { 1000,  EDGE, A | B, 0 },
+        { 3000,  POLL, 0,     NONE },
+        { 3999,  POLL, 0,     NONE },
+        { 4000,  POLL, 0,     1 },
+        { 4500,  EDGE, A,     0 },
+        { 7499,  POLL, 0,     NONE },
+        { 7500,  POLL, 0,     0 },
+    });
+
+    //Contact bounce restarts the hold at the last press
+    run("bounce", 0,
+    {
+        { 0,     EDGE, C, 0 },
+        { 5,     EDGE, 0, 0 },
+        { 9,     EDGE, C, 0 },
+        { 505,   POLL, 0, NONE },
+        { 509,   POLL, 0, 2 },
+    });
+
+    //Buttons other than the combo's cancel it
+    run("extra button", 0,
+    {
+        { 0,     EDGE, C,     0 },
+        { 200,   EDGE, C | A, 0 },
+        { 600,   POLL, 0,     NONE },
+        { 700,   EDGE, C,     0 },
+        { 1200,  POLL, 0,     2 },
+    });
+
+    //ms_since_boot() wraps after 49 days
+    run("wrap", 0xFFFFF000,
+    {
+        { 0,     EDGE, A, 0 },
+        { 2999,  POLL, 0, NONE },
+        { 3000,  POLL, 0, 0 },
+    });
+}
+
+static void test_reset()
+{
+    Detector detector(COMBOS);
+    detector.update(A, 0);
+    detector.reset();
+    CHECK(detector.poll(5000) == Detector::NO_COMBO);
+
+    //Held through the reset, the next edge starts it again
+    detector.update(A, 6000);
+    CHECK(detector.poll(8999) == Detector::NO_COMBO);
+    CHECK(detector.poll(9000) == 0);
+}
+
+//Gamepad reports an edge for button and dpad changes only, sticks and triggers move freely
+static void test_gamepad_edges()
+{
+    Gamepad gamepad;
+    CHECK(!gamepad.new_button_state());
+
+    Gamepad::PadIn pad_in;
+    pad_in.joystick_lx = 1000;
+    pad_in.trigger_l = 50;
+    gamepad.set_pad_in(pad_in);
+    CHECK(!gamepad.new_button_state());
+
+    pad_in.buttons = Gamepad::BUTTON_START;
+    gamepad.set_pad_in(pad_in);
+    CHECK(gamepad.new_button_state());
+    CHECK(!gamepad.new_button_state());
+    CHECK(gamepad.get_button_state().buttons == Gamepad::BUTTON_START);
+
+    pad_in.joystick_ry = -3000;
+    gamepad.set_pad_in(pad_in);
+    CHECK(!gamepad.new_button_state());
+
+    pad_in.dpad = Gamepad::DPAD_UP;
+    gamepad.set_pad_in(pad_in);
+    CHECK(gamepad.new_button_state());
+    CHECK(gamepad.get_button_state().dpad == Gamepad::DPAD_UP);
+}
+
+int main()
+{
+    test_timelines();
+    test_reset();
+    test_gamepad_edges();
+    return check::result("ComboDetectorTest");
+}
@@ -0,0 +1,279 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#include "Check.h"
+#include "Gamepad/Gamepad.h"
+#include "USBHost/HostSlots.h"
+
+/*  Plug, unplug and replug controllers through HostSlots the way HostManager's
+    mount, unmount and wireless callbacks do, checking what the console side
+    sees in each slot. */
+
+using Slots = HostSlots<5, 4, MAX_GAMEPADS>;
+
+static bool neutral(Gamepad& gamepad)
+{
+    Gamepad::PadIn pad_in = gamepad.peek_pad_in();
+    Gamepad::PadIn idle;
+    return  std::memcmp(&pad_in, &idle, sizeof(Gamepad::PadIn)) == 0 &&
+            gamepad.get_chatpad_in() == Gamepad::ChatpadIn{0, 0, 0} &&
+            !gamepad.analog_enabled();
+}
+
+static void press(Gamepad& gamepad, uint16_t buttons)
+{
+    Gamepad::PadIn pad_in;
+    pad_in.buttons = buttons;
+    pad_in.joystick_lx = 12000;
+    pad_in.trigger_r = 200;
+    gamepad.set_pad_in(pad_in);
+    gamepad.set_chatpad_in({1, 2, 3});
+}
+
+//setup_driver() with a driver that accepted the interface
+static uint8_t mount(Slots& slots, uint8_t address, uint8_t instance, bool& remount)
+{
+    uint8_t idx = slots.claim(address, instance, remount);
+    if (idx != Slots::INVALID_IDX)
+    {
+        slots.attach(idx);
+    }
+    return idx;
+}
+
+static void test_unplug_replug()
+{
+    Gamepad gamepads[MAX_GAMEPADS];
+    Slots slots;
+    slots.initialize(gamepads);
+    bool remount = true;
+
+    CHECK(mount(slots, 1, 0, remount) == 0 && !remount);
+    CHECK(mount(slots, 2, 0, remount) == 1 && !remount);
+    CHECK(slots.gamepad(0) == &gamepads[0]);
+
+    //Console rumbles pad 0, the controller holds a button and sends chatpad keys
+    Gamepad::PadOut rumble;
+    rumble.rumble_l = 180;
+    gamepads[0].set_pad_out(rumble);
+    gamepads[0].get_pad_out();
+    press(gamepads[0], Gamepad::BUTTON_A);
+    gamepads[0].set_analog_host(true);
+    const uint8_t profile_seq = gamepads[0].profile_seq();
+
+    //Unplugged: neutral input, slot free, rumble and profile kept for the next controller
+    CHECK(slots.release(1, 0) == 0);
+    CHECK(neutral(gamepads[0]));
+    CHECK(gamepads[0].new_pad_in());
+    CHECK(gamepads[0].peek_pad_out().rumble_l == 180);
+    CHECK(gamepads[0].profile_seq() == profile_seq);
+    CHECK(slots.find(1, 0) == Slots::INVALID_IDX);
+    CHECK(slots.any());
+
+    //Pad 1 is untouched
+    CHECK(slots.find(2, 0) == 1);
+
+    //Replugged on a new address, takes the freed slot and is sent the console's rumble
+    const uint32_t seq = gamepads[0].pad_out_seq();
+    CHECK(mount(slots, 3, 0, remount) == 0 && !remount);
+    CHECK(gamepads[0].new_pad_out());
+    CHECK(gamepads[0].pad_out_seq() != seq);
+    CHECK(gamepads[0].get_pad_out().rumble_l == 180);
+    CHECK(slots.address(0) == 3 && slots.instance(0) == 0);
+
+    //Mounted again without an unmount keeps its slot
+    CHECK(mount(slots, 3, 0, remount) == 0 && remount);
+
+    //Last controller out, nothing mounted, every slot neutral
+    press(gamepads[1], Gamepad::BUTTON_B);
+    CHECK(slots.release(3, 0) == 0);
+    CHECK(slots.release(2, 0) == 1);
+    CHECK(slots.release(2, 0) == Slots::INVALID_IDX);
+    CHECK(!slots.any());
+    for (auto& gamepad : gamepads)
+    {
+        CHECK(neutral(gamepad));
+    }
+}
+
+static void test_unclaimed_interface()
+{
+    Gamepad gamepads[MAX_GAMEPADS];
+    Slots slots;
+    slots.initialize(gamepads);
+    bool remount = false;
+
+    //No driver for it, the slot goes back
+    CHECK(slots.claim(1, 1, remount) == 0 && !remount);
+    slots.unclaim(1, 1, remount);
+    CHECK(slots.find(1, 1) == Slots::INVALID_IDX && !slots.any());
+
+    //Unless it was a remount, the running driver keeps it
+    CHECK(mount(slots, 1, 0, remount) == 0);
+    CHECK(slots.claim(1, 0, remount) == 0 && remount);
+    slots.unclaim(1, 0, remount);
+    CHECK(slots.find(1, 0) == 0);
+}
+
+static void test_wireless_receiver()
+{
+    Gamepad gamepads[MAX_GAMEPADS];
+    Slots slots;
+    slots.initialize(gamepads);
+    bool remount = false;
+
+    //One receiver, an interface per pad, fills every slot
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        CHECK(mount(slots, 4, i, remount) == i);
+    }
+    CHECK(slots.claim(5, 0, remount) == Slots::INVALID_IDX);
+
+    //Pad 2 powers off, the receiver stays mounted
+    press(gamepads[2], Gamepad::BUTTON_X);
+    press(gamepads[3], Gamepad::BUTTON_Y);
+    slots.detach(slots.find(4, 2));
+    CHECK(neutral(gamepads[2]));
+    CHECK(!neutral(gamepads[3]));
+    CHECK(slots.find(4, 2) == 2);
+    slots.detach(Slots::INVALID_IDX);
+
+    //And comes back on the same interface
+    press(gamepads[2], Gamepad::BUTTON_X);
+    CHECK(gamepads[2].peek_pad_in().buttons == Gamepad::BUTTON_X);
+
+    //Receiver unplugged
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        CHECK(slots.release(4, i) == i);
+    }
+    CHECK(!slots.any());
+    for (auto& gamepad : gamepads)
+    {
+        CHECK(neutral(gamepad));
+    }
+}
+
+//Many plug/unplug cycles on varying addresses, instances and slots. Every controller
+//that goes finds its slot neutral, every one that comes takes the lowest free slot
+//with the profile it had and is sent the console's latest rumble.
+static void test_many_cycles(uint32_t seed, uint32_t cycles)
+{
+    static constexpr uint8_t MAX_ADDRESS = 5;
+    static constexpr uint8_t MAX_INSTANCES = 4;
+    static constexpr std::array<uint16_t, 4> MAPPED_A = {{ Gamepad::BUTTON_B, Gamepad::BUTTON_X, Gamepad::BUTTON_Y, Gamepad::BUTTON_A }};
+
+    Gamepad gamepads[MAX_GAMEPADS];
+    Slots slots;
+    slots.initialize(gamepads);
+
+    std::array<uint8_t, MAX_GAMEPADS> profile_seqs{};
+    std::array<uint8_t, MAX_GAMEPADS> rumble_l{};
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        UserProfile profile;
+        profile.id = i + 1;
+        profile.button_a = MAPPED_A[i];
+        gamepads[i].set_profile(profile);
+        gamepads[i].apply_pending_profile();
+        profile_seqs[i] = gamepads[i].profile_seq();
+    }
+
+    //Which interface holds each slot, 0 for none
+    std::array<uint8_t, MAX_GAMEPADS> slot_address{};
+    std::array<uint8_t, MAX_GAMEPADS> slot_instance{};
+    std::mt19937 rng(seed);
+    uint32_t plugs = 0;
+    uint32_t unplugs = 0;
+    uint32_t failures = 0;
+
+    for (uint32_t cycle = 0; cycle < cycles; ++cycle)
+    {
+        //The console changes its rumble whenever it likes, connected or not
+        const uint8_t console = uint8_t(rng() % MAX_GAMEPADS);
+        Gamepad::PadOut pad_out;
+        pad_out.rumble_l = rumble_l[console] = uint8_t(rng() % 256);
+        gamepads[console].set_pad_out(pad_out);
+        if (slot_address[console])
+        {
+            gamepads[console].get_pad_out();
+        }
+
+        const uint8_t address = uint8_t(1 + rng() % MAX_ADDRESS);
+        const uint8_t instance = uint8_t(rng() % MAX_INSTANCES);
+        const uint8_t held = slots.find(address, instance);
+
+        if (held == Slots::INVALID_IDX)
+        {
+            uint8_t expected = Slots::INVALID_IDX;
+            for (uint8_t i = 0; i < MAX_GAMEPADS && expected == Slots::INVALID_IDX; ++i)
+            {
+                expected = slot_address[i] ? Slots::INVALID_IDX : i;
+            }
+
+            const uint32_t seq = (expected != Slots::INVALID_IDX) ? gamepads[expected].pad_out_seq() : 0;
+            bool remount = true;
+            const uint8_t idx = mount(slots, address, instance, remount);
+            failures += (idx != expected || remount) ? 1 : 0;
+            if (idx == Slots::INVALID_IDX)
+            {
+                continue;
+            }
+
+            Gamepad& gamepad = gamepads[idx];
+            failures += (!gamepad.new_pad_out() || gamepad.pad_out_seq() == seq) ? 1 : 0;
+            failures += (gamepad.get_pad_out().rumble_l != rumble_l[idx]) ? 1 : 0;
+            failures += (gamepad.profile_seq() != profile_seqs[idx] || gamepad.MAP_BUTTON_A != MAPPED_A[idx]) ? 1 : 0;
+            failures += (!neutral(gamepad)) ? 1 : 0;
+
+            slot_address[idx] = address;
+            slot_instance[idx] = instance;
+            press(gamepad, Gamepad::BUTTON_START);
+            gamepad.set_analog_host(true);
+            ++plugs;
+        }
+        else if (rng() % 4 == 0)
+        {
+            //A wireless pad powering off and back on, the interface stays mounted
+            slots.detach(held);
+            failures += (!neutral(gamepads[held])) ? 1 : 0;
+            const uint32_t seq = gamepads[held].pad_out_seq();
+            slots.attach(held);
+            failures += (gamepads[held].pad_out_seq() == seq || gamepads[held].get_pad_out().rumble_l != rumble_l[held]) ? 1 : 0;
+            press(gamepads[held], Gamepad::BUTTON_BACK);
+        }
+        else
+        {
+            failures += (slots.release(address, instance) != held) ? 1 : 0;
+            failures += (!neutral(gamepads[held])) ? 1 : 0;
+            failures += (gamepads[held].peek_pad_out().rumble_l != rumble_l[held]) ? 1 : 0;
+            failures += (gamepads[held].profile_seq() != profile_seqs[held] || gamepads[held].MAP_BUTTON_A != MAPPED_A[held]) ? 1 : 0;
+            slot_address[held] = 0;
+            ++unplugs;
+        }
+
+        //Slots and interfaces agree after every step
+        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+        {
+            if (slot_address[i])
+            {
+                failures += (slots.find(slot_address[i], slot_instance[i]) != i || slots.address(i) != slot_address[i]) ? 1 : 0;
+            }
+        }
+    }
+
+    CHECK(failures == 0);
+    CHECK(plugs > cycles / 8 && unplugs > cycles / 8);
+}
+
+int main()
+{
+    test_unplug_replug();
+    test_unclaimed_interface();
+    test_wireless_receiver();
+    test_many_cycles(1, 5000);
+    test_many_cycles(0xBEEF, 5000);
+    return check::result("HotSwapTest");
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <thread>
+
+#include "class/cdc/cdc_device.h"
+#include "SerialPort.h"
+#include "Loopback.h"
+
+//Like the CDC tx fifo, the device can't get further ahead of the host than this
+static constexpr size_t TX_FIFO_LEN = 256;
+
+static std::function<void()> device_step;
+static std::function<void(bool)> line_state_cb;
+static loopback::Faults faults;
+static loopback::Stats link_stats;
+static std::mt19937 rng(1);
+static std::deque<uint8_t> to_device;
+static std::deque<uint8_t> to_host;
+static bool connected = false;
+
+//Returns false if the byte is lost on the way
+static bool transfer(uint8_t& byte)
+{
+    if (faults.drop_per_mille && rng() % 1000 < faults.drop_per_mille)
+    {
+        ++link_stats.dropped;
+        return false;
+    }
+    if (faults.corrupt_per_mille && rng() % 1000 < faults.corrupt_per_mille)
+    {
+        byte ^= static_cast<uint8_t>(1U << (rng() % 8));
+        ++link_stats.corrupted;
+    }
+    return true;
+}
+
+static void step()
+{
+    if (device_step)
+    {
+        device_step();
+    }
+}
+
+void loopback::set_device(std::function<void()> step)
+{
+    device_step = std::move(step);
+}
+
+void loopback::set_line_state(std::function<void(bool)> line_state)
+{
+    line_state_cb = std::move(line_state);
+}
+
+static void set_connected(bool state)
+{
+    connected = state;
+    if (line_state_cb)
+    {
+        line_state_cb(state);
+    }
+}
+
+void loopback::set_faults(const Faults& new_faults)
+{
+    faults = new_faults;
+    rng.seed(faults.seed);
+}
+
+void loopback::run(int ms)
+{
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    do
+    {
+        step();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    while (std::chrono::steady_clock::now() < end);
+}
+
+void loopback::clear()
+{
+    to_device.clear();
+    to_host.clear();
+    link_stats = Stats();
+}
+
+const loopback::Stats& loopback::stats()
+{
+    return link_stats;
+}
+
+bool tud_cdc_connected()
+{
+    return connected;
+}
+
+uint32_t tud_cdc_available()
+{
+    return static_cast<uint32_t>(to_device.size());
+}
+
+uint32_t tud_cdc_read(void* buffer, uint32_t bufsize)
+{
+    const uint32_t len = std::min(bufsize, static_cast<uint32_t>(to_device.size()));
+    std::copy_n(to_device.begin(), len, static_cast<uint8_t*>(buffer));
+    to_device.erase(to_device.begin(), to_device.begin() + len);
+    return len;
+}
+
+void tud_cdc_read_flush()
+{
+    to_device.clear();
+}
+
+uint32_t tud_cdc_write(const void* buffer, uint32_t bufsize)
+{
+    if (!connected)
+    {
+        return 0;
+    }
+    const uint32_t len = std::min(bufsize, static_cast<uint32_t>(TX_FIFO_LEN - std::min(TX_FIFO_LEN, to_host.size())));
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        uint8_t byte = static_cast<const uint8_t*>(buffer)[i];
+        if (transfer(byte))
+        {
+            to_host.push_back(byte);
+        }
+    }
+    link_stats.to_host += len;
+    return len;
+}
+
+uint32_t tud_cdc_write_flush()
+{
+    return 0;
+}
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+bool SerialPort::open(const std::string&)
+{
+    fd_ = 0;
+    set_connected(true);
+    return true;
+}
+
+void SerialPort::close()
+{
+    if (fd_ >= 0)
+    {
+        fd_ = -1;
+        to_host.clear();
+        set_connected(false);
+    }
+}
+
+long SerialPort::read(uint8_t* buffer, size_t len, int timeout_ms)
+{
+    if (fd_ < 0)
+    {
+        return -1;
+    }
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;)
+    {
+        step();
+        if (!to_host.empty())
+        {
+            const size_t read_len = std::min(len, to_host.size());
+            std::copy_n(to_host.begin(), read_len, buffer);
+            to_host.erase(to_host.begin(), to_host.begin() + read_len);
+            return static_cast<long>(read_len);
+        }
+        if (std::chrono::steady_clock::now() >= end)
+        {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+bool SerialPort::write(const uint8_t* data, size_t len)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < len; ++i)
+    {
+        uint8_t byte = data[i];
+        if (transfer(byte))
+        {
+            to_device.push_back(byte);
+        }
+    }
+    link_stats.to_device += static_cast<uint32_t>(len);
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef _LOOPBACK_H_
+#define _LOOPBACK_H_
+
+#include <cstdint>
+#include <functional>
+
+/*  The CDC port in one process: tud_cdc_* for the firmware and SerialPort for
+    ogxm-config, joined by a byte queue each way. The device loop runs whenever the
+    client waits on the port, and bytes can be dropped or corrupted on the way. */
+namespace loopback
+{
+    struct Faults
+    {
+        uint32_t drop_per_mille{0};
+        uint32_t corrupt_per_mille{0};
+        uint32_t seed{1};
+    };
+
+    struct Stats
+    {
+        uint32_t to_device{0};
+        uint32_t to_host{0};
+        uint32_t dropped{0};
+        uint32_t corrupted{0};
+    };
+
+    //Runs while the client waits, e.g. protocol.receive() and process() for each gamepad
+    void set_device(std::function<void()> step);
+    //Told when the client opens or closes the port, like tud_cdc_line_state_cb()
+    void set_line_state(std::function<void(bool)> line_state);
+    //Applied to both directions from the next byte on
+    void set_faults(const Faults& faults);
+    //Runs the device for ms without the client reading
+    void run(int ms);
+    //Empties both queues and the stats, the port stays as it is
+    void clear();
+
+    const Stats& stats();
+}
+
+#endif // _LOOPBACK_H_
@@ -0,0 +1,206 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Check.h"
+#include "UserSettings/ProfileBank.h"
+
+/*  ProfileBank records as they sit in flash: a sealed bank reloads in one read, any
+    flipped bit is caught before the bank is touched, and records from a newer layout
+    load their known prefix and seal back to the current one. */
+
+struct Flash
+{
+    std::vector<uint8_t> data;
+    uint32_t reads{0};
+    size_t fail_at{SIZE_MAX};
+
+    //The read function UserSettings passes to ProfileBank::load()
+    auto reader()
+    {
+        return [this](void* dst, size_t len, size_t offset)
+        {
+            ++reads;
+            if (offset + len > data.size() || offset + len > fail_at)
+            {
+                return false;
+            }
+            std::memcpy(dst, data.data() + offset, len);
+            return true;
+        };
+    }
+};
+
+static bool same(const ProfileBank& a, const ProfileBank& b)
+{
+    return std::memcmp(&a, &b, sizeof(ProfileBank)) == 0;
+}
+
+static ProfileBank custom_bank()
+{
+    ProfileBank bank;
+    for (uint8_t i = 0; i < ProfileBank::MAX_PROFILES; ++i)
+    {
+        bank.profiles[i].button_a = static_cast<uint16_t>(0x100 + i);
+        bank.profiles[i].analog_off_rb = static_cast<uint8_t>(0xA0 + i);
+        bank.profiles[i].trigger_settings_r.dz_inner = fix16_from_int(i * 3);
+    }
+    bank.header.active_ids = {3, 8, 1, 5};
+    bank.seal();
+    return bank;
+}
+
+static Flash store(const ProfileBank& bank)
+{
+    Flash flash;
+    flash.data.resize(sizeof(ProfileBank));
+    std::memcpy(flash.data.data(), &bank, sizeof(ProfileBank));
+    return flash;
+}
+
+static void test_round_trip()
+{
+    const ProfileBank bank = custom_bank();
+    CHECK(bank.verify());
+
+    Flash flash = store(bank);
+    ProfileBank loaded;
+    CHECK(loaded.load(flash.reader()));
+    CHECK(same(bank, loaded) && loaded.verify());
+
+    //The header, the CRC pass in 64 byte chunks, then the bank in one read
+    const uint32_t crc_reads = (sizeof(ProfileBank) - ProfileBank::CRC_OFFSET + 63) / 64;
+    CHECK(flash.reads == 1 + crc_reads + 1);
+
+    //The CRC covers the layout fields after it, the ids and the profiles
+    ProfileBank changed = bank;
+    changed.profiles[7].button_a ^= 1;
+    CHECK(!changed.verify());
+    changed.seal();
+    CHECK(changed.verify() && changed.header.crc != bank.header.crc);
+}
+
+//Every single bit flip in a stored record fails the load and leaves the bank as it was
+static void test_bit_flips()
+{
+    const ProfileBank bank = custom_bank();
+    const ProfileBank before;
+    uint32_t rejected = 0;
+
+    for (size_t byte = 0; byte < sizeof(ProfileBank); ++byte)
+    {
+        for (uint8_t bit = 0; bit < 8; bit += 3)
+        {
+            Flash flash = store(bank);
+            flash.data[byte] ^= static_cast<uint8_t>(1U << bit);
+
+            ProfileBank loaded;
+            rejected += loaded.load(flash.reader()) ? 0 : 1;
+            CHECK(same(before, loaded));
+        }
+    }
+    CHECK(rejected == sizeof(ProfileBank) * 3);
+}
+
+static void test_rejects()
+{
+    const ProfileBank bank = custom_bank();
+    ProfileBank loaded;
+
+    //Erased flash, and a read that fails part way through
+    Flash erased;
+    erased.data.assign(sizeof(ProfileBank), 0xFF);
+    CHECK(!loaded.load(erased.reader()));
+    Flash partial = store(bank);
+    partial.fail_at = sizeof(ProfileBank) / 2;
+    CHECK(!loaded.load(partial.reader()));
+    CHECK(same(ProfileBank(), loaded));
+
+    //Layouts smaller than this one can't be told apart from garbage, they're migrated instead
+    ProfileBank::Header header = bank.header;
+    header.profile_count = ProfileBank::MAX_PROFILES - 1;
+    CHECK(ProfileBank::record_len(header) == 0);
+    header = bank.header;
+    header.profile_len = sizeof(UserProfile) - 1;
+    CHECK(ProfileBank::record_len(header) == 0);
+    header = bank.header;
+    header.header_len = sizeof(ProfileBank::Header) - 2;
+    CHECK(ProfileBank::record_len(header) == 0);
+    CHECK(ProfileBank::record_len(bank.header) == sizeof(ProfileBank));
+
+    //A sealed bank with ids UserSettings can't use
+    ProfileBank bad = bank;
+    bad.header.active_ids[2] = 0;
+    bad.seal();
+    CHECK(!bad.verify());
+    bad = bank;
+    bad.header.active_ids[0] = ProfileBank::MAX_PROFILES + 1;
+    bad.seal();
+    CHECK(!bad.verify());
+    bad = bank;
+    bad.profiles[4].id = 1;
+    bad.seal();
+    CHECK(!bad.verify());
+}
+
+/*  A record from a newer firmware: a longer header, longer profiles and more of them.
+    The known prefix of each loads, the bank reseals in the current layout and reloads. */
+static void test_newer_layout()
+{
+    constexpr uint16_t HEADER_LEN = sizeof(ProfileBank::Header) + 6;
+    constexpr uint16_t PROFILE_LEN = sizeof(UserProfile) + 10;
+    constexpr uint8_t PROFILE_COUNT = ProfileBank::MAX_PROFILES + 2;
+
+    const ProfileBank bank = custom_bank();
+    ProfileBank::Header header = bank.header;
+    header.version = ProfileBank::VERSION + 1;
+    header.header_len = HEADER_LEN;
+    header.profile_len = PROFILE_LEN;
+    header.profile_count = PROFILE_COUNT;
+
+    Flash flash;
+    flash.data.assign(HEADER_LEN + PROFILE_COUNT * PROFILE_LEN, 0x5A);
+    std::memcpy(flash.data.data(), &header, sizeof(header));
+    for (uint8_t i = 0; i < ProfileBank::MAX_PROFILES; ++i)
+    {
+        std::memcpy(flash.data.data() + HEADER_LEN + i * PROFILE_LEN, &bank.profiles[i], sizeof(UserProfile));
+    }
+    header.crc = ProfileBank::crc32(flash.data.data() + ProfileBank::CRC_OFFSET,
+                                    flash.data.size() - ProfileBank::CRC_OFFSET);
+    std::memcpy(flash.data.data(), &header, sizeof(header));
+    CHECK(ProfileBank::record_len(header) == flash.data.size());
+
+    ProfileBank loaded;
+    CHECK(loaded.load(flash.reader()));
+    CHECK(std::memcmp(&loaded.profiles, &bank.profiles, sizeof(bank.profiles)) == 0);
+    CHECK(loaded.header.active_ids == bank.header.active_ids);
+    CHECK(loaded.header.header_len == sizeof(ProfileBank::Header) &&
+          loaded.header.profile_len == sizeof(UserProfile) &&
+          loaded.header.profile_count == ProfileBank::MAX_PROFILES);
+
+    //Written back by this firmware
+    loaded.seal();
+    CHECK(loaded.verify() && same(bank, loaded));
+    Flash rewritten = store(loaded);
+    ProfileBank reloaded;
+    CHECK(reloaded.load(rewritten.reader()) && same(bank, reloaded));
+
+    //The CRC covers the parts this firmware doesn't know too
+    flash.data[HEADER_LEN + PROFILE_LEN - 1] ^= 0x01;
+    ProfileBank corrupt;
+    CHECK(!corrupt.load(flash.reader()) && same(ProfileBank(), corrupt));
+}
+
+int main()
+{
+    //The standard CRC-32 check value
+    CHECK(ProfileBank::crc32(reinterpret_cast<const uint8_t*>("123456789"), 9) == 0xCBF43926);
+    CHECK(ProfileBank::crc32(reinterpret_cast<const uint8_t*>("56789"), 5,
+          ProfileBank::crc32(reinterpret_cast<const uint8_t*>("1234"), 4)) == 0xCBF43926);
+
+    test_round_trip();
+    test_bit_flips();
+    test_rejects();
+    test_newer_layout();
+    return check::result("ProfileBankTest");
+}
@@ -0,0 +1,247 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "Check.h"
+#include "Board/board_api.h"
+#include "UserSettings/NVSTool.h"
+#include "UserSettings/UserSettings.h"
+
+/*  The firmware's own UserSettings and NVSTool on the flash stand-ins in sim/include.
+    Flash written by firmware that kept each profile and active id under its own key
+    is packed into the profile bank on the next boot, whatever state those keys are in:
+    missing, out of range, or holding a profile that claims another id. */
+
+namespace board_api
+{
+    static uint32_t reboots = 0;
+
+    void reboot() { ++reboots; }
+    uint32_t ms_since_boot() { return 0; }
+
+    namespace usb
+    {
+        void disconnect_all() {}
+    }
+}
+
+//Keys and flag as UserSettings.cpp writes them
+static constexpr uint8_t FLASH_INIT_FLAG = 0xF8;
+
+static std::string profile_key(uint8_t profile_id)
+{
+    return "profile_" + std::to_string(profile_id);
+}
+
+static std::string active_key(uint8_t index)
+{
+    return "active_id_" + std::to_string(index);
+}
+
+static UserProfile legacy_profile(uint8_t id, uint8_t mark)
+{
+    UserProfile profile;
+    profile.id = id;
+    profile.button_a = static_cast<uint16_t>(0x100 + mark);
+    profile.analog_off_lb = mark;
+    profile.trigger_settings_l.dz_inner = fix16_from_int(mark);
+    return profile;
+}
+
+static bool same(const UserProfile& a, const UserProfile& b)
+{
+    return std::memcmp(&a, &b, sizeof(UserProfile)) == 0;
+}
+
+//Flash as the old firmware left it: initialized, no bank, per-key entries written by seed
+template <typename Seed>
+static void old_flash(Seed&& seed)
+{
+    NVSTool& nvs = NVSTool::get_instance();
+    nvs.erase_all();
+    const uint8_t flag = FLASH_INIT_FLAG;
+    CHECK(nvs.write("init_flag", &flag, sizeof(flag)));
+    seed(nvs);
+}
+
+//What the next boot finds in the bank block, read the way load_profile_bank() reads it
+static bool stored_bank(ProfileBank& bank)
+{
+    return bank.load([](void* dst, size_t len, size_t offset)
+    {
+        return NVSTool::get_instance().read_block(dst, len, offset);
+    });
+}
+
+//Every key valid, the bank holds exactly what they did
+static void test_all_keys()
+{
+    const std::array<uint8_t, 4> active = {{ 3, 1, 8, 2 }};
+    old_flash([&](NVSTool& nvs)
+    {
+        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+        {
+            CHECK(nvs.write(active_key(i), &active[i], sizeof(uint8_t)));
+        }
+        for (uint8_t id = 1; id <= UserSettings::MAX_PROFILES; ++id)
+        {
+            const UserProfile profile = legacy_profile(id, uint8_t(id * 3));
+            CHECK(nvs.write(profile_key(id), &profile, sizeof(UserProfile)));
+        }
+    });
+
+    UserSettings& settings = UserSettings::get_instance();
+    settings.initialize_flash();
+
+    const ProfileBank& bank = settings.read_profile_bank();
+    CHECK(bank.verify());
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        CHECK(bank.header.active_ids[i] == active[i]);
+        CHECK(settings.get_active_profile_id(i) == active[i]);
+    }
+    for (uint8_t id = 1; id <= UserSettings::MAX_PROFILES; ++id)
+    {
+        CHECK(same(bank.profiles[id - 1], legacy_profile(id, uint8_t(id * 3))));
+    }
+    CHECK(same(settings.get_profile_by_index(2), legacy_profile(8, 24)));
+
+    //Written back as a bank, the next boot loads it and leaves the old keys alone
+    ProfileBank stored;
+    CHECK(stored_bank(stored) && std::memcmp(&stored, &bank, sizeof(ProfileBank)) == 0);
+
+    const UserProfile changed = legacy_profile(1, 99);
+    CHECK(NVSTool::get_instance().write(profile_key(1), &changed, sizeof(UserProfile)));
+    settings.initialize_flash();
+    CHECK(same(settings.get_profile_by_id(1), legacy_profile(1, 3)));
+}
+
+//Keys that were never written get the bank's defaults, the ones that were are kept
+static void test_missing_keys()
+{
+    old_flash([](NVSTool& nvs)
+    {
+        const uint8_t id = 6;
+        CHECK(nvs.write(active_key(1), &id, sizeof(uint8_t)));
+        const UserProfile profile = legacy_profile(6, 60);
+        CHECK(nvs.write(profile_key(6), &profile, sizeof(UserProfile)));
+    });
+
+    UserSettings& settings = UserSettings::get_instance();
+    settings.initialize_flash();
+
+    const ProfileBank defaults;
+    const ProfileBank& bank = settings.read_profile_bank();
+    CHECK(bank.verify());
+    CHECK(bank.header.active_ids[0] == defaults.header.active_ids[0]);
+    CHECK(bank.header.active_ids[1] == 6);
+    CHECK(bank.header.active_ids[2] == defaults.header.active_ids[2]);
+    CHECK(bank.header.active_ids[3] == defaults.header.active_ids[3]);
+    for (uint8_t i = 0; i < UserSettings::MAX_PROFILES; ++i)
+    {
+        CHECK(same(bank.profiles[i], (i == 5) ? legacy_profile(6, 60) : defaults.profiles[i]));
+    }
+    CHECK(same(settings.get_profile_by_index(1), legacy_profile(6, 60)));
+
+    ProfileBank stored;
+    CHECK(stored_bank(stored) && std::memcmp(&stored, &bank, sizeof(ProfileBank)) == 0);
+}
+
+//Active ids out of range and profiles stored under another id's key are replaced with defaults
+static void test_invalid_entries()
+{
+    old_flash([](NVSTool& nvs)
+    {
+        const std::array<uint8_t, 4> active = {{ 0, UserSettings::MAX_PROFILES + 1, 0xFF, 4 }};
+        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+        {
+            CHECK(nvs.write(active_key(i), &active[i], sizeof(uint8_t)));
+        }
+
+        //Profile 5's key holds profile 2, profile 7's holds an id no profile has
+        const UserProfile moved = legacy_profile(2, 20);
+        CHECK(nvs.write(profile_key(5), &moved, sizeof(UserProfile)));
+        const UserProfile bad_id = legacy_profile(0, 70);
+        CHECK(nvs.write(profile_key(7), &bad_id, sizeof(UserProfile)));
+        const UserProfile good = legacy_profile(4, 40);
+        CHECK(nvs.write(profile_key(4), &good, sizeof(UserProfile)));
+    });
+
+    UserSettings& settings = UserSettings::get_instance();
+    settings.initialize_flash();
+
+    const ProfileBank defaults;
+    const ProfileBank& bank = settings.read_profile_bank();
+    CHECK(bank.verify());
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        CHECK(bank.header.active_ids[i] == defaults.header.active_ids[i]);
+    }
+    CHECK(bank.header.active_ids[3] == 4);
+
+    //Neither the slot it was stored under nor the one it claims takes the moved profile
+    CHECK(same(bank.profiles[4], defaults.profiles[4]));
+    CHECK(same(bank.profiles[1], defaults.profiles[1]));
+    CHECK(same(bank.profiles[6], defaults.profiles[6]));
+    CHECK(same(bank.profiles[3], legacy_profile(4, 40)));
+    CHECK(same(settings.get_profile_by_index(3), legacy_profile(4, 40)));
+
+    ProfileBank stored;
+    CHECK(stored_bank(stored) && std::memcmp(&stored, &bank, sizeof(ProfileBank)) == 0);
+}
+
+//Nothing but the init flag, the bank is all defaults
+static void test_no_keys()
+{
+    old_flash([](NVSTool&) {});
+
+    UserSettings& settings = UserSettings::get_instance();
+    settings.initialize_flash();
+
+    ProfileBank defaults;
+    defaults.seal();
+    ProfileBank stored;
+    CHECK(stored_bank(stored) && std::memcmp(&stored, &defaults, sizeof(ProfileBank)) == 0);
+    CHECK(std::memcmp(&settings.read_profile_bank(), &defaults, sizeof(ProfileBank)) == 0);
+}
+
+//Key/value entries past the first sector of the NVS region, every one reads back
+static void test_nvs_entries()
+{
+    NVSTool& nvs = NVSTool::get_instance();
+    nvs.erase_all();
+
+    const uint32_t count = NVSTool::MAX_ENTRIES - 1;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const uint32_t value = i * 2654435761u;
+        CHECK(nvs.write("key_" + std::to_string(i), &value, sizeof(value)));
+    }
+    const uint32_t extra = 0;
+    CHECK(!nvs.write("one_too_many", &extra, sizeof(extra)));
+
+    //Rewriting a key keeps it in place
+    const uint32_t rewritten = 0xC0DE;
+    CHECK(nvs.write("key_20", &rewritten, sizeof(rewritten)));
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t value = 0;
+        const bool found = nvs.read("key_" + std::to_string(i), &value, sizeof(value));
+        mismatches += (!found || value != ((i == 20) ? rewritten : i * 2654435761u)) ? 1 : 0;
+    }
+    CHECK(mismatches == 0);
+}
+
+int main()
+{
+    test_nvs_entries();
+    test_all_keys();
+    test_missing_keys();
+    test_invalid_entries();
+    test_no_keys();
+    CHECK(board_api::reboots == 0);
+    return check::result("ProfileMigrationTest");
+}
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "Check.h"
+#include "Loopback.h"
+#include "ConfigClient.h"
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/UserSettings.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppProtocol.h"
+
+/*  SET_PROFILE from ogxm-config against the firmware's WebAppProtocol: a framed store
+    is written by process() rather than the rx callback and applied to the gamepads
+    without a reboot, a legacy store from the WebApp still reboots into it. */
+
+using PacketID = WebAppCommands::PacketID;
+
+static std::array<Gamepad, MAX_GAMEPADS> gamepads;
+static WebAppProtocol* protocol = nullptr;
+
+//The device loop, or only what tud_cdc_rx_cb() runs
+static void device_loop()
+{
+    protocol->receive();
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        protocol->process(i, gamepads[i]);
+    }
+}
+
+static void rx_callback_only()
+{
+    protocol->receive();
+}
+
+static UserProfile trigger_profile(uint8_t id)
+{
+    UserProfile profile;
+    profile.id = id;
+    profile.trigger_settings_l.dz_inner = fix16_from_float(0.5f);
+    return profile;
+}
+
+static void test_framed_store_applies_live()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    const uint32_t flash_writes = user_settings.flash_writes();
+    const uint8_t profile_seq = gamepads[1].profile_seq();
+    CHECK(gamepads[1].scale_trigger_l(uint8_t(50)) > 0);
+
+    SerialPort port;
+    ConfigClient client(port);
+    CHECK(port.open("loopback") && client.start());
+
+    const UserProfile profile = trigger_profile(3);
+    ConfigClient::Message response;
+    CHECK(client.request(PacketID::SET_PROFILE, 1, profile.id, &profile, sizeof(UserProfile), PacketID::SET_PROFILE, response));
+    CHECK(response.header.profile_id == 3);
+
+    //One flash write, no reboot, the port stays open
+    CHECK(user_settings.flash_writes() == flash_writes + 1);
+    CHECK(user_settings.reboots() == 0);
+    CHECK(user_settings.get_profile_by_index(1).id == 3);
+
+    //Every gamepad is handed its profile on the next pass
+    loopback::run(2);
+    for (auto& gamepad : gamepads)
+    {
+        CHECK(gamepad.profile_seq() != profile_seq);
+    }
+    //The host side keeps mapping with the old one until it swaps the new one in between reports
+    CHECK(gamepads[1].scale_trigger_l(uint8_t(50)) > 0);
+    for (auto& gamepad : gamepads)
+    {
+        gamepad.apply_pending_profile();
+    }
+    CHECK(gamepads[1].scale_trigger_l(uint8_t(50)) == 0);
+    CHECK(gamepads[0].scale_trigger_l(uint8_t(50)) > 0);
+
+    //Still talking
+    CHECK(client.request(PacketID::GET_PROFILE_BY_IDX, 1, 0, nullptr, 0, PacketID::GET_PROFILE_BY_IDX, response));
+    CHECK(response.data.size() == sizeof(UserProfile) && response.data[0] == 3);
+
+    //A new driver is left for the board's loop to switch to
+    WebAppCommands::CommandHeader header;
+    header.packet_id = PacketID::SET_PROFILE;
+    header.device_driver = DeviceDriverType::XINPUT;
+    header.player_idx = 0;
+    header.profile_id = 4;
+    const UserProfile other = trigger_profile(4);
+    CHECK(client.request(header, &other, sizeof(UserProfile), PacketID::SET_PROFILE, response));
+    CHECK(user_settings.get_current_driver() == DeviceDriverType::XINPUT);
+    CHECK(user_settings.reboots() == 0);
+
+    port.close();
+    loopback::run(2);
+}
+
+//The rx path only latches the profile, the write and the response wait for process()
+static void test_store_waits_for_process()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    const uint32_t flash_writes = user_settings.flash_writes();
+
+    SerialPort port;
+    ConfigClient client(port);
+    CHECK(port.open("loopback") && client.start());
+
+    loopback::set_device(rx_callback_only);
+    const UserProfile profile = trigger_profile(6);
+    CHECK(client.send(PacketID::SET_PROFILE, 0, profile.id, &profile, sizeof(UserProfile)));
+    loopback::run(5);
+    CHECK(user_settings.flash_writes() == flash_writes);
+    CHECK(user_settings.get_profile_by_index(0).id != 6);
+
+    //Nothing more is read while it waits, the next request is answered after the store
+    ConfigClient::Message response;
+    CHECK(client.send(PacketID::GET_PROFILE_BY_IDX, 0, 0, nullptr, 0));
+    loopback::run(5);
+
+    loopback::set_device(device_loop);
+    CHECK(client.poll(100));
+    CHECK(user_settings.flash_writes() == flash_writes + 1);
+    CHECK(user_settings.get_profile_by_index(0).id == 6);
+    CHECK(client.request(PacketID::GET_PROFILE_BY_IDX, 0, 0, nullptr, 0, PacketID::GET_PROFILE_BY_IDX, response));
+    CHECK(response.data.size() == sizeof(UserProfile) && response.data[0] == 6);
+
+    port.close();
+    loopback::run(2);
+}
+
+//A failed flash write is answered with an error and leaves the profiles as they were
+static void test_failed_store()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    const ProfileBank stored = user_settings.read_profile_bank();
+    const uint8_t profile_seq = gamepads[0].profile_seq();
+
+    SerialPort port;
+    ConfigClient client(port);
+    CHECK(port.open("loopback") && client.start());
+
+    user_settings.fail_writes(true);
+    const UserProfile profile = trigger_profile(7);
+    ConfigClient::Message response;
+    CHECK(!client.request(PacketID::SET_PROFILE, 0, profile.id, &profile, sizeof(UserProfile), PacketID::SET_PROFILE, response));
+    CHECK(response.header.packet_id == PacketID::RESP_ERROR);
+    user_settings.fail_writes(false);
+
+    loopback::run(2);
+    CHECK(std::memcmp(&stored, &user_settings.read_profile_bank(), sizeof(ProfileBank)) == 0);
+    CHECK(gamepads[0].profile_seq() == profile_seq);
+
+    //The session carries on
+    CHECK(client.request(PacketID::SET_PROFILE, 0, profile.id, &profile, sizeof(UserProfile), PacketID::SET_PROFILE, response));
+    CHECK(user_settings.get_profile_by_index(0).id == 7);
+
+    port.close();
+    loopback::run(2);
+}
+
+/*  set_profile() from core0 while core1 maps reports. Each report sees one whole profile,
+    its button mapping and its trigger deadzone always come from the same one. */
+static void test_profile_swap_across_cores()
+{
+    UserProfile remapped = trigger_profile(2);
+    remapped.button_a = Gamepad::BUTTON_B;
+    const UserProfile plain = trigger_profile(1);
+
+    Gamepad gamepad;
+    gamepad.set_profile(UserProfile());
+    gamepad.apply_pending_profile();
+
+    std::atomic<bool> done{false};
+    std::thread core0([&]
+    {
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            gamepad.set_profile((i & 1) ? remapped : UserProfile());
+        }
+        gamepad.set_profile(plain);
+        done = true;
+    });
+
+    uint32_t reports = 0;
+    uint32_t mixed = 0;
+    while (!done.load() || reports == 0)
+    {
+        gamepad.apply_pending_profile();
+        const bool b = (gamepad.MAP_BUTTON_A == Gamepad::BUTTON_B);
+        const uint8_t trigger = gamepad.scale_trigger_l(uint8_t(50));
+        mixed += (b && trigger > 0) ? 1 : 0;
+        ++reports;
+    }
+    core0.join();
+    gamepad.apply_pending_profile();
+
+    CHECK(mixed == 0);
+    CHECK(gamepad.MAP_BUTTON_A == Gamepad::BUTTON_A && gamepad.scale_trigger_l(uint8_t(50)) == 0);
+}
+
+//64 byte WebApp packets: packet_len, packet_id, device_driver, max_gamepads, player_idx,
+//profile_id, chunks_total, chunk_idx, chunk_len, data
+static void write_packet(SerialPort& port, PacketID packet_id, uint8_t chunks_total, uint8_t chunk_idx,
+                         const uint8_t* data, uint8_t len)
+{
+    std::array<uint8_t, 64> packet{};
+    const uint8_t header[] = { 64, static_cast<uint8_t>(packet_id), static_cast<uint8_t>(DeviceDriverType::WEBAPP),
+                               MAX_GAMEPADS, 2, 5, chunks_total, chunk_idx, len };
+    std::memcpy(packet.data(), header, sizeof(header));
+    std::memcpy(packet.data() + sizeof(header), data, len);
+    port.write(packet.data(), packet.size());
+}
+
+//The WebApp reads input packets the whole time, the device stops reading while they back up
+static void drain(SerialPort& port, int ms)
+{
+    uint8_t buffer[256];
+    for (int i = 0; i < ms; ++i)
+    {
+        port.read(buffer, sizeof(buffer), 1);
+    }
+}
+
+static void test_legacy_store_reboots()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    const uint32_t reboots = user_settings.reboots();
+    const uint8_t profile_seq = gamepads[2].profile_seq();
+
+    SerialPort port;
+    CHECK(port.open("loopback"));
+
+    const UserProfile profile = trigger_profile(5);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(&profile);
+    constexpr size_t CHUNK_LEN = 64 - 9;
+    constexpr uint8_t CHUNKS = static_cast<uint8_t>((sizeof(UserProfile) + CHUNK_LEN - 1) / CHUNK_LEN);
+
+    write_packet(port, PacketID::SET_PROFILE_START, CHUNKS, 0, nullptr, 0);
+    for (uint8_t i = 0; i < CHUNKS; ++i)
+    {
+        const size_t offset = i * CHUNK_LEN;
+        const uint8_t len = static_cast<uint8_t>(std::min(CHUNK_LEN, sizeof(UserProfile) - offset));
+        write_packet(port, PacketID::SET_PROFILE, CHUNKS, i, data + offset, len);
+    }
+    drain(port, 10);
+
+    //Stored, and the adapter reboots into it rather than applying it
+    CHECK(user_settings.reboots() == reboots + 1);
+    CHECK(user_settings.get_profile_by_index(2).id == 5);
+    CHECK(gamepads[2].profile_seq() == profile_seq);
+
+    port.close();
+    loopback::run(2);
+}
+
+int main()
+{
+    UserSettings& user_settings = UserSettings::get_instance();
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        gamepads[i].set_profile(user_settings.get_profile_by_index(i));
+        gamepads[i].apply_pending_profile();
+    }
+
+    WebAppProtocol webapp_protocol(DeviceDriverType::WEBAPP);
+    protocol = &webapp_protocol;
+    loopback::set_device(device_loop);
+
+    test_framed_store_applies_live();
+    test_store_waits_for_process();
+    test_failed_store();
+    test_profile_swap_across_cores();
+    test_legacy_store_reboots();
+    return check::result("ProfileStoreTest");
+}
@@ -0,0 +1,145 @@
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "Loopback.h"
+#include "ConfigClient.h"
+#include "Gamepad/Gamepad.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppProtocol.h"
+
+/*  Framed sessions between ogxm-config and the firmware's WebAppProtocol: a host that
+    comes back finds no trace of the previous one, whether or not the port was closed
+    in between, and a session survives garbage and a lossy link. */
+
+using PacketID = WebAppCommands::PacketID;
+
+static std::array<Gamepad, MAX_GAMEPADS> gamepads;
+
+static bool get_profile(ConfigClient& client, uint8_t index)
+{
+    ConfigClient::Message response;
+    return  client.request(PacketID::GET_PROFILE_BY_IDX, index, 0, nullptr, 0, PacketID::GET_PROFILE_BY_IDX, response) &&
+            response.header.player_idx == index &&
+            response.data.size() == sizeof(UserProfile);
+}
+
+//The first host leaves the device with a full window, the next one never closed the port
+static void test_stale_window()
+{
+    SerialPort port;
+    CHECK(port.open("loopback"));
+    {
+        ConfigClient client(port);
+        CHECK(client.start());
+        CHECK(get_profile(client, 0));
+        CHECK(client.send(PacketID::GET_BANK, 0, 0, nullptr, 0));
+        loopback::run(5);
+    }
+
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        ConfigClient client(port);
+        CHECK(client.start());
+        CHECK(get_profile(client, i));
+        CHECK(get_profile(client, i + 1));
+        CHECK(client.stats().retransmits == 0);
+    }
+    port.close();
+    loopback::run(2);
+}
+
+//Closed mid-stream, the DTR change drops the session and what was queued for it
+static void test_line_state()
+{
+    SerialPort port;
+    CHECK(port.open("loopback"));
+    {
+        ConfigClient client(port);
+        CHECK(client.start());
+        CHECK(client.send(PacketID::GET_BANK, 0, 0, nullptr, 0));
+        loopback::run(5);
+    }
+    port.close();
+    CHECK(port.open("loopback"));
+
+    ConfigClient client(port);
+    CHECK(client.start());
+    CHECK(get_profile(client, 2));
+    CHECK(client.stats().retransmits == 0 && client.rx_errors() == 0);
+    port.close();
+    loopback::run(2);
+}
+
+static void test_garbage()
+{
+    std::mt19937 rng(99);
+    SerialPort port;
+    CHECK(port.open("loopback"));
+
+    for (int i = 0; i < 50; ++i)
+    {
+        //Half a legacy packet, or noise in the middle of a framed session
+        std::vector<uint8_t> garbage(rng() % 300);
+        for (auto& byte : garbage)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+        port.write(garbage.data(), garbage.size());
+        loopback::run(1);
+
+        ConfigClient client(port);
+        CHECK(client.start());
+        CHECK(get_profile(client, static_cast<uint8_t>(i % MAX_GAMEPADS)));
+    }
+    port.close();
+    loopback::run(2);
+}
+
+static void test_lossy_link()
+{
+    loopback::Faults faults;
+    faults.drop_per_mille = 1;
+    faults.corrupt_per_mille = 1;
+    faults.seed = 7;
+    loopback::set_faults(faults);
+
+    SerialPort port;
+    CHECK(port.open("loopback"));
+    ConfigClient client(port);
+    CHECK(client.start());
+    for (uint8_t i = 0; i < 30; ++i)
+    {
+        CHECK(get_profile(client, i % MAX_GAMEPADS));
+    }
+    CHECK(loopback::stats().dropped > 0 && loopback::stats().corrupted > 0);
+
+    loopback::set_faults(loopback::Faults());
+    port.close();
+    loopback::run(2);
+}
+
+int main()
+{
+    WebAppProtocol protocol(DeviceDriverType::WEBAPP);
+    loopback::set_device([&protocol]
+    {
+        protocol.receive();
+        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+        {
+            protocol.process(i, gamepads[i]);
+        }
+    });
+
+    test_stale_window();
+
+    loopback::set_line_state([&protocol](bool connected)
+    {
+        protocol.line_state_changed(connected);
+    });
+    test_line_state();
+    test_garbage();
+    test_lossy_link();
+    return check::result("SessionTest");
+}
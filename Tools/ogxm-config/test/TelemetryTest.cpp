@@ -0,0 +1,255 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include "Check.h"
+#include "Loopback.h"
+#include "ConfigClient.h"
+#include "Gamepad/Gamepad.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppProtocol.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppTelemetry.h"
+
+/*  TELEMETRY events from the firmware's WebAppProtocol as ogxm-config's telemetry command
+    decodes them: every input sample is either sent or counted in a later event's dropped,
+    min_interval_us caps the rate, and the decoded sample follows the gamepad. */
+
+using PacketID = WebAppCommands::PacketID;
+using Clock = std::chrono::steady_clock;
+
+static std::array<Gamepad, MAX_GAMEPADS> gamepads;
+
+//Input samples set_pad_in() per device loop pass on each gamepad in feed_mask
+static uint32_t feed_per_pass = 0;
+static uint8_t feed_mask = 0;
+static std::array<uint32_t, MAX_GAMEPADS> fed{};
+
+static void feed_sample(uint8_t index)
+{
+    ++fed[index];
+    Gamepad::PadIn pad_in;
+    pad_in.joystick_lx = static_cast<int16_t>(fed[index]);
+    pad_in.buttons = static_cast<uint16_t>(fed[index] >> 4);
+    pad_in.trigger_r = static_cast<uint8_t>(index * 50);
+    gamepads[index].set_pad_in(pad_in);
+}
+
+static void feed()
+{
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        for (uint32_t j = 0; (feed_mask & (1U << i)) && j < feed_per_pass; ++j)
+        {
+            feed_sample(i);
+        }
+    }
+}
+
+struct Receiver
+{
+    std::array<WebAppTelemetry::Sample, MAX_GAMEPADS> samples{};
+    std::array<uint32_t, MAX_GAMEPADS> events{};
+    std::array<uint32_t, MAX_GAMEPADS> dropped{};
+    std::array<uint8_t, MAX_GAMEPADS> next_seq{};
+    uint32_t gaps{0};
+    uint32_t bad{0};
+
+    void attach(ConfigClient& client)
+    {
+        client.on_event = [this](const ConfigClient::Message& message)
+        {
+            //The device's input events arrive here too
+            if (message.header.packet_id != PacketID::TELEMETRY)
+            {
+                return;
+            }
+            WebAppTelemetry::Header header;
+            const uint8_t index = message.header.player_idx;
+            if (index >= MAX_GAMEPADS || message.data.size() < sizeof(header))
+            {
+                ++bad;
+                return;
+            }
+            std::memcpy(&header, message.data.data(), sizeof(header));
+            gaps += (header.seq != next_seq[index]) ? 1 : 0;
+            next_seq[index] = static_cast<uint8_t>(header.seq + 1);
+            ++events[index];
+            dropped[index] += header.dropped;
+            bad += WebAppTelemetry::apply_delta(samples[index], header.fields,
+                        message.data.data() + sizeof(header), message.data.size() - sizeof(header)) ? 0 : 1;
+        };
+    }
+};
+
+//poll() returns with the first bytes, like the telemetry command this keeps at it for ms
+static bool poll_for(ConfigClient& client, int ms)
+{
+    const auto end = Clock::now() + std::chrono::milliseconds(ms);
+    while (Clock::now() < end)
+    {
+        if (!client.poll(1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Each subscribed gamepad starts with one event holding its current input
+static bool start(ConfigClient& client, const Receiver& receiver, uint8_t mask, uint32_t min_interval_us)
+{
+    WebAppCommands::TelemetryConfig config;
+    config.gamepad_mask = mask;
+    config.min_interval_us = min_interval_us;
+    ConfigClient::Message response;
+    if (!client.request(PacketID::TELEMETRY_START, 0, 0, &config, sizeof(config), PacketID::TELEMETRY_START, response) ||
+        !poll_for(client, 10))
+    {
+        return false;
+    }
+
+    fed.fill(0);
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        const bool subscribed = (mask & (1U << i));
+        const Gamepad::PadIn pad_in = gamepads[i].peek_pad_in();
+        if (receiver.events[i] != (subscribed ? 1U : 0U) ||
+            (subscribed && receiver.samples[i].joystick_lx != pad_in.joystick_lx))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool stop(ConfigClient& client)
+{
+    ConfigClient::Message response;
+    return client.request(PacketID::TELEMETRY_STOP, 0, 0, nullptr, 0, PacketID::TELEMETRY_STOP, response);
+}
+
+//Polls for ms while the controllers feed, then lets the last sample out
+static void stream(ConfigClient& client, uint32_t per_pass, uint8_t mask, int ms)
+{
+    feed_per_pass = per_pass;
+    feed_mask = mask;
+    CHECK(poll_for(client, ms));
+    feed_per_pass = 0;
+    CHECK(poll_for(client, 20));
+}
+
+//One sample per pass, no limit: each one arrives and the last decodes to the gamepad's input
+static void test_every_sample()
+{
+    SerialPort port;
+    ConfigClient client(port);
+    Receiver receiver;
+    receiver.attach(client);
+    CHECK(port.open("loopback") && client.start());
+
+    const uint8_t mask = (1U << 0) | (1U << 2);
+    CHECK(start(client, receiver, mask, 0));
+    stream(client, 1, mask, 100);
+    CHECK(stop(client));
+
+    for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        if (!(mask & (1U << i)))
+        {
+            CHECK(receiver.events[i] == 0);
+            continue;
+        }
+        CHECK(fed[i] > 50);
+        CHECK(receiver.events[i] == fed[i] + 1 && receiver.dropped[i] == 0);
+        CHECK(receiver.samples[i].joystick_lx == static_cast<int16_t>(fed[i]));
+        CHECK(receiver.samples[i].buttons == static_cast<uint16_t>(fed[i] >> 4));
+        CHECK(receiver.samples[i].trigger_r == i * 50);
+    }
+    CHECK(receiver.gaps == 0 && receiver.bad == 0);
+
+    port.close();
+    loopback::run(2);
+}
+
+//Input faster than the device loop, samples overwritten in between are reported as dropped
+static void test_drop_count()
+{
+    SerialPort port;
+    ConfigClient client(port);
+    Receiver receiver;
+    receiver.attach(client);
+    CHECK(port.open("loopback") && client.start());
+
+    CHECK(start(client, receiver, 1U << 1, 0));
+    stream(client, 5, 1U << 1, 100);
+    CHECK(stop(client));
+
+    CHECK(receiver.events[1] > 50);
+    CHECK(receiver.events[1] + receiver.dropped[1] == fed[1] + 1);
+    CHECK(receiver.dropped[1] >= receiver.events[1] * 3);
+    CHECK(receiver.samples[1].joystick_lx == static_cast<int16_t>(fed[1]));
+    CHECK(receiver.gaps == 0 && receiver.bad == 0);
+
+    port.close();
+    loopback::run(2);
+}
+
+//min_interval_us caps the event rate, what's skipped for it still adds up
+static void test_rate_limit()
+{
+    constexpr uint32_t MIN_INTERVAL_US = 5000;
+    constexpr int STREAM_MS = 200;
+
+    SerialPort port;
+    ConfigClient client(port);
+    Receiver receiver;
+    receiver.attach(client);
+    CHECK(port.open("loopback") && client.start());
+
+    CHECK(start(client, receiver, 1U << 3, MIN_INTERVAL_US));
+    const auto begin = Clock::now();
+    feed_per_pass = 1;
+    feed_mask = 1U << 3;
+    CHECK(poll_for(client, STREAM_MS));
+    feed_per_pass = 0;
+    const double elapsed_us = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+
+    //Samples skipped since the last event are reported with the next one
+    CHECK(poll_for(client, 2 * MIN_INTERVAL_US / 1000));
+    feed_sample(3);
+    CHECK(poll_for(client, 2 * MIN_INTERVAL_US / 1000));
+    CHECK(stop(client));
+
+    CHECK(receiver.events[3] >= 5);
+    CHECK(receiver.events[3] <= static_cast<uint32_t>(elapsed_us / MIN_INTERVAL_US) + 3);
+    CHECK(fed[3] > receiver.events[3] * 2);
+    CHECK(receiver.events[3] + receiver.dropped[3] == fed[3] + 1);
+    CHECK(receiver.samples[3].joystick_lx == static_cast<int16_t>(fed[3]));
+    CHECK(receiver.gaps == 0 && receiver.bad == 0);
+
+    port.close();
+    loopback::run(2);
+}
+
+int main()
+{
+    WebAppProtocol protocol(DeviceDriverType::WEBAPP);
+    loopback::set_device([&protocol]
+    {
+        feed();
+        protocol.receive();
+        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
+        {
+            protocol.process(i, gamepads[i]);
+        }
+    });
+    loopback::set_line_state([&protocol](bool connected)
+    {
+        protocol.line_state_changed(connected);
+    });
+
+    test_every_sample();
+    test_drop_count();
+    test_rate_limit();
+    return check::result("TelemetryTest");
+}
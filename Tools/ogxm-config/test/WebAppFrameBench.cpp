@@ -0,0 +1,56 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Check.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppFrame.h"
+
+/*  Host timings of WebAppFrame encode and decode, ns per frame. Only useful compared
+    against another run on the same machine. webapp_frame_bench [iterations] */
+
+using namespace WebAppFrame;
+
+static volatile uint32_t sink;
+
+static void bench(const char* name, size_t len, uint32_t iterations)
+{
+    std::vector<uint8_t> payload(len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        //A zero every few bytes, like a UserProfile
+        payload[i] = (i % 5) ? static_cast<uint8_t>(i * 37) : 0;
+    }
+
+    uint8_t encoded[MAX_ENCODED];
+    const size_t encoded_len = encode(Type::DATA, 1, 0, payload.data(), len, encoded);
+    Decoder decoder;
+
+    const double encode_ns = check::time_ns(iterations, [&](uint32_t i)
+    {
+        sink = static_cast<uint32_t>(encode(Type::DATA, static_cast<uint8_t>(i), 0, payload.data(), len, encoded));
+    });
+    const double decode_ns = check::time_ns(iterations, [&](uint32_t)
+    {
+        uint32_t frames = 0;
+        for (size_t j = 0; j < encoded_len; ++j)
+        {
+            frames += decoder.push(encoded[j]) ? 1 : 0;
+        }
+        sink = frames;
+    });
+
+    std::printf("%-12s encode %8.1f ns  decode %8.1f ns  (%5.1f MB/s)\n",
+                name, encode_ns, decode_ns, (encoded_len * 1000.0) / decode_ns);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t iterations = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200000;
+
+    //An ACK, an input event and a bank chunk
+    bench("0 bytes", 0, iterations);
+    bench("32 bytes", 32, iterations);
+    bench("240 bytes", MAX_PAYLOAD, iterations);
+    return 0;
+}
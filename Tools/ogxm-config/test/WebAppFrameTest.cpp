@@ -0,0 +1,148 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "USBDevice/DeviceDriver/WebApp/WebAppFrame.h"
+
+/*  WebAppFrame encode and Decoder: every payload length round trips, and random,
+    corrupted, truncated or oversized input never yields a frame that wasn't sent
+    and never stops the next good frame from decoding. */
+
+using namespace WebAppFrame;
+
+static std::mt19937 rng(0x0C0FFEE);
+
+static std::vector<uint8_t> random_payload(size_t len)
+{
+    std::vector<uint8_t> payload(len);
+    const uint32_t mode = rng() % 3;
+    for (auto& byte : payload)
+    {
+        //Mostly zeros, mostly 0xFF, or anything, to hit every COBS code byte
+        byte = (mode == 0) ? ((rng() % 8) ? 0 : static_cast<uint8_t>(rng()))
+             : (mode == 1) ? ((rng() % 8) ? 0xFF : 0)
+             : static_cast<uint8_t>(rng());
+    }
+    return payload;
+}
+
+//Feeds bytes to the decoder, returns the number of frames it accepted
+static uint32_t push_all(Decoder& decoder, const uint8_t* data, size_t len)
+{
+    uint32_t frames = 0;
+    for (size_t i = 0; i < len; ++i)
+    {
+        frames += decoder.push(data[i]) ? 1 : 0;
+    }
+    return frames;
+}
+
+static bool decodes_to(Decoder& decoder, const uint8_t* encoded, size_t encoded_len, Type type, uint8_t seq,
+                       const std::vector<uint8_t>& payload)
+{
+    return  push_all(decoder, encoded, encoded_len) == 1 &&
+            decoder.header().type == type &&
+            decoder.header().seq == seq &&
+            decoder.header().len == payload.size() &&
+            std::memcmp(decoder.payload(), payload.data(), payload.size()) == 0;
+}
+
+static void test_round_trip()
+{
+    Decoder decoder;
+    uint8_t encoded[MAX_ENCODED];
+
+    for (size_t len = 0; len <= MAX_PAYLOAD; ++len)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            const std::vector<uint8_t> payload = random_payload(len);
+            const size_t encoded_len = encode(Type::DATA, static_cast<uint8_t>(len), 7, payload.data(), len, encoded);
+            CHECK(encoded_len > 0 && encoded_len <= MAX_ENCODED);
+            CHECK(encoded[encoded_len - 1] == DELIMITER);
+            CHECK(std::memchr(encoded, DELIMITER, encoded_len - 1) == nullptr);
+            CHECK(decodes_to(decoder, encoded, encoded_len, Type::DATA, static_cast<uint8_t>(len), payload));
+        }
+    }
+    CHECK(encode(Type::DATA, 0, 0, encoded, MAX_PAYLOAD + 1, encoded) == 0);
+    CHECK(decoder.errors() == 0);
+}
+
+//Any single bit flip or lost byte costs the frame it landed in and nothing else
+static void test_corruption()
+{
+    Decoder decoder;
+    uint8_t encoded[MAX_ENCODED];
+    uint8_t next[MAX_ENCODED];
+    uint32_t accepted = 0;
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        const std::vector<uint8_t> payload = random_payload(rng() % (MAX_PAYLOAD + 1));
+        size_t encoded_len = encode(Type::DATA, 1, 0, payload.data(), payload.size(), encoded);
+
+        const size_t at = rng() % (encoded_len - 1);
+        if (i % 2)
+        {
+            encoded[at] ^= static_cast<uint8_t>(1U << (rng() % 8));
+        }
+        else
+        {
+            std::memmove(encoded + at, encoded + at + 1, encoded_len - at - 1);
+            --encoded_len;
+        }
+        accepted += push_all(decoder, encoded, encoded_len);
+
+        //A flip to 0x00 splits the frame, the next one still decodes
+        const std::vector<uint8_t> good = random_payload(rng() % 32);
+        const size_t next_len = encode(Type::EVENT, 2, 0, good.data(), good.size(), next);
+        CHECK(decodes_to(decoder, next, next_len, Type::EVENT, 2, good));
+    }
+    CHECK(accepted == 0);
+    CHECK(decoder.errors() >= 20000);
+}
+
+static void test_garbage_and_oversize()
+{
+    Decoder decoder;
+    uint8_t encoded[MAX_ENCODED];
+    const std::vector<uint8_t> payload = random_payload(40);
+    const size_t encoded_len = encode(Type::ACK, 3, 9, payload.data(), payload.size(), encoded);
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        //Random bytes with the odd delimiter, then a delimiter and a good frame
+        std::vector<uint8_t> garbage(rng() % (MAX_ENCODED * 3));
+        for (auto& byte : garbage)
+        {
+            byte = (rng() % 64) ? static_cast<uint8_t>(rng() | 1) : DELIMITER;
+        }
+        push_all(decoder, garbage.data(), garbage.size());
+        decoder.push(DELIMITER);
+        CHECK(decodes_to(decoder, encoded, encoded_len, Type::ACK, 3, payload));
+    }
+
+    //Longer than any frame, without a delimiter
+    std::vector<uint8_t> long_run(MAX_ENCODED * 4, 0x01);
+    CHECK(push_all(decoder, long_run.data(), long_run.size()) == 0);
+    const uint32_t errors = decoder.errors();
+    decoder.push(DELIMITER);
+    CHECK(decoder.errors() == errors + 1);
+    CHECK(decodes_to(decoder, encoded, encoded_len, Type::ACK, 3, payload));
+
+    //reset() drops a half received frame
+    push_all(decoder, encoded, encoded_len / 2);
+    decoder.reset();
+    CHECK(decodes_to(decoder, encoded, encoded_len, Type::ACK, 3, payload));
+}
+
+int main()
+{
+    test_round_trip();
+    test_corruption();
+    test_garbage_and_oversize();
+    return check::result("WebAppFrameTest");
+}
@@ -0,0 +1,306 @@
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "USBHost/HostDriver/XInput/tuh_xinput/tuh_xinput.h"
+#include "USBHost/HostDriver/XInput/tuh_xinput/tuh_xinput_cmd.h"
+
+/*  The XInput host class's OUT queue, on its own and through tuh_xinput.cpp with a
+    simulated transfer engine in place of TinyUSB's: commands go out in order and
+    ahead of rumble, a newer rumble replaces one that hasn't gone out, a full queue
+    refuses and counts, and completions drain the queue even past a transfer the
+    stack refused. */
+
+using namespace tuh_xinput;
+
+static constexpr uint8_t ADDRESS = 1;
+static constexpr uint8_t EP_IN = 0x81;
+static constexpr uint8_t EP_OUT = 0x01;
+
+using Packet = std::vector<uint8_t>;
+
+//What TinyUSB's host stack does for the driver, one transfer per endpoint at a time
+namespace engine
+{
+    struct Endpoint
+    {
+        bool claimed{false};
+        bool busy{false};
+        uint16_t len{0};
+    };
+
+    std::map<std::pair<uint8_t, uint8_t>, Endpoint> endpoints;
+    std::vector<Packet> wire;
+    uint32_t refuse_xfers{0};
+    uint32_t refused{0};
+    const Interface* mounted{nullptr};
+    std::vector<Packet> sent;
+
+    Endpoint& out() { return endpoints[{ADDRESS, EP_OUT}]; }
+
+    //The packet on the OUT endpoint finished, the endpoint is free before xfer_cb runs
+    bool complete(xfer_result_t result = XFER_RESULT_SUCCESS)
+    {
+        Endpoint& ep = out();
+        if (!ep.busy)
+        {
+            return false;
+        }
+        ep.busy = false;
+        ep.claimed = false;
+        class_driver()->xfer_cb(ADDRESS, EP_OUT, result, ep.len);
+        return true;
+    }
+
+    //Completes transfers until the endpoint goes idle
+    uint32_t drain()
+    {
+        uint32_t count = 0;
+        while (complete())
+        {
+            ++count;
+        }
+        return count;
+    }
+}
+
+bool tuh_vid_pid_get(uint8_t, uint16_t* vid, uint16_t* pid)
+{
+    *vid = 0x045E;
+    *pid = 0x028E;
+    return true;
+}
+
+bool tuh_edpt_open(uint8_t, const tusb_desc_endpoint_t*) { return true; }
+bool tuh_control_xfer(tuh_xfer_s*) { return true; }
+void usbh_driver_set_config_complete(uint8_t, uint8_t) {}
+
+bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr)
+{
+    engine::Endpoint& ep = engine::endpoints[{dev_addr, ep_addr}];
+    if (ep.claimed || ep.busy)
+    {
+        return false;
+    }
+    ep.claimed = true;
+    return true;
+}
+
+bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr)
+{
+    engine::endpoints[{dev_addr, ep_addr}].claimed = false;
+    return true;
+}
+
+bool usbh_edpt_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes)
+{
+    engine::Endpoint& ep = engine::endpoints[{dev_addr, ep_addr}];
+    if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN)
+    {
+        ep.busy = true;
+        return true;
+    }
+    if (!ep.claimed || ep.busy)
+    {
+        return false;
+    }
+    if (engine::refuse_xfers)
+    {
+        --engine::refuse_xfers;
+        ++engine::refused;
+        return false;
+    }
+    ep.busy = true;
+    ep.len = total_bytes;
+    engine::wire.emplace_back(buffer, buffer + total_bytes);
+    return true;
+}
+
+namespace tuh_xinput
+{
+    void mount_cb(uint8_t, uint8_t, const Interface* interface)
+    {
+        engine::mounted = interface;
+    }
+
+    void report_sent_cb(uint8_t, uint8_t, const uint8_t* report, uint16_t len)
+    {
+        engine::sent.emplace_back(report, report + len);
+    }
+
+    void report_received_cb(uint8_t, uint8_t, const uint8_t*, uint16_t) {}
+}
+
+static Packet command(uint8_t id)
+{
+    return Packet{0x00, 0x03, id, 0x00};
+}
+
+static bool send(const Packet& packet)
+{
+    return send_report(ADDRESS, 0, packet.data(), static_cast<uint16_t>(packet.size()));
+}
+
+//Rumble as tuh_xinput::set_rumble() builds it for a wired 360 pad
+static Packet rumble(uint8_t l, uint8_t r)
+{
+    Packet packet(Xbox360::RUMBLE, Xbox360::RUMBLE + sizeof(Xbox360::RUMBLE));
+    packet[3] = l;
+    packet[4] = r;
+    return packet;
+}
+
+//A wired 360 pad on a fresh driver and engine
+static void mount_xbox360()
+{
+    engine::endpoints.clear();
+    engine::wire.clear();
+    engine::sent.clear();
+    engine::refuse_xfers = 0;
+    engine::refused = 0;
+    engine::mounted = nullptr;
+
+    const uint8_t config[] =
+    {
+        9, TUSB_DESC_INTERFACE, 0, 0, 2, 0xFF, 0x5D, 0x01, 0,
+        7, TUSB_DESC_ENDPOINT, EP_IN, 0x03, 32, 0, 4,
+        7, TUSB_DESC_ENDPOINT, EP_OUT, 0x03, 32, 0, 8,
+    };
+    const usbh_class_driver_t* driver = class_driver();
+    driver->init();
+    CHECK(driver->open(0, ADDRESS, reinterpret_cast<const tusb_desc_interface_t*>(config), sizeof(config)));
+    CHECK(driver->set_config(ADDRESS, 0));
+    CHECK(engine::mounted != nullptr && engine::mounted->ep_out == EP_OUT);
+}
+
+static void test_queue_order()
+{
+    OutReportQueue queue;
+    uint8_t buffer[OUT_PACKET_SIZE];
+    const uint8_t rumble_1[] = {1, 1};
+    const uint8_t rumble_2[] = {2, 2, 2};
+
+    CHECK(queue.push(rumble_1, sizeof(rumble_1), OutReportQueue::Priority::RUMBLE));
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        const Packet packet = command(i);
+        CHECK(queue.push(packet.data(), uint16_t(packet.size()), OutReportQueue::Priority::COMMAND));
+    }
+    CHECK(queue.push(rumble_2, sizeof(rumble_2), OutReportQueue::Priority::RUMBLE));
+    CHECK(queue.coalesced() == 1 && queue.commands() == 3 && queue.rumble_pending());
+
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        CHECK(queue.pop(buffer) == 4 && buffer[2] == i);
+    }
+    CHECK(queue.pop(buffer) == sizeof(rumble_2) && buffer[0] == 2);
+    CHECK(queue.pop(buffer) == 0 && queue.empty());
+
+    //Too long, empty, or a full command queue, rumble still gets its slot
+    uint8_t big[OUT_PACKET_SIZE + 1] = {0};
+    CHECK(!queue.push(big, sizeof(big), OutReportQueue::Priority::COMMAND));
+    CHECK(!queue.push(big, 0, OutReportQueue::Priority::RUMBLE));
+    for (uint8_t i = 0; i < OUT_QUEUE_DEPTH; ++i)
+    {
+        CHECK(queue.push(big, 1, OutReportQueue::Priority::COMMAND));
+    }
+    CHECK(!queue.push(big, 1, OutReportQueue::Priority::COMMAND) && queue.dropped() == 1);
+    CHECK(queue.push(rumble_1, sizeof(rumble_1), OutReportQueue::Priority::RUMBLE));
+    queue.clear();
+    CHECK(queue.empty() && queue.dropped() == 1);
+}
+
+//Commands in order and ahead of rumble, a rumble waiting behind them is replaced by a newer one
+static void test_engine_order()
+{
+    mount_xbox360();
+
+    CHECK(send(command(0)) && engine::wire.size() == 1);
+    CHECK(set_rumble(ADDRESS, 0, 10, 20));
+    CHECK(send(command(1)) && send(command(2)));
+    CHECK(set_rumble(ADDRESS, 0, 30, 40));
+    CHECK(engine::wire.size() == 1 && engine::mounted->out_queue.coalesced() == 1);
+
+    CHECK(engine::drain() == 4);
+    const std::vector<Packet> expected = { command(0), command(1), command(2), rumble(30, 40) };
+    CHECK(engine::wire == expected && engine::sent == expected);
+    CHECK(engine::mounted->out_queue.empty() && !engine::out().claimed);
+
+    //Nothing queued, the next packet goes straight out
+    CHECK(set_rumble(ADDRESS, 0, 0, 0));
+    CHECK(engine::wire.size() == 5 && engine::wire.back() == rumble(0, 0));
+    CHECK(engine::drain() == 1);
+}
+
+//A full command queue refuses and counts, what it held still goes out in order
+static void test_engine_full()
+{
+    mount_xbox360();
+
+    CHECK(send(command(0)));
+    for (uint8_t i = 1; i <= OUT_QUEUE_DEPTH; ++i)
+    {
+        CHECK(send(command(i)));
+    }
+    CHECK(!send(command(0xEE)) && !send(command(0xEF)));
+    CHECK(engine::mounted->out_queue.dropped() == 2);
+
+    //Rumble has its own slot, a full command queue doesn't stop it
+    CHECK(set_rumble(ADDRESS, 0, 1, 2));
+
+    CHECK(engine::drain() == OUT_QUEUE_DEPTH + 2u);
+    CHECK(engine::wire.size() == OUT_QUEUE_DEPTH + 2u);
+    for (uint8_t i = 0; i <= OUT_QUEUE_DEPTH; ++i)
+    {
+        CHECK(engine::wire[i] == command(i));
+    }
+    CHECK(engine::wire.back() == rumble(1, 2));
+}
+
+//usbh_edpt_xfer refusing a packet drops it, what's behind it still drains
+static void test_engine_refused()
+{
+    mount_xbox360();
+
+    //Refused with the endpoint idle, the call reports it and leaves the endpoint free
+    engine::refuse_xfers = 1;
+    CHECK(!send(command(0)));
+    CHECK(engine::refused == 1 && engine::wire.empty() && !engine::out().claimed);
+    CHECK(send(command(1)) && engine::wire.size() == 1);
+
+    //Refused while draining from xfer_cb, the next packet goes in its place
+    CHECK(send(command(2)) && send(command(3)) && set_rumble(ADDRESS, 0, 5, 6));
+    engine::refuse_xfers = 1;
+    CHECK(engine::complete());
+    CHECK(engine::refused == 2 && engine::wire.size() == 2 && engine::wire.back() == command(3));
+    CHECK(engine::drain() == 2);
+
+    //Everything behind a packet refused, nothing is left claimed or queued
+    CHECK(send(command(4)) && send(command(5)) && set_rumble(ADDRESS, 0, 7, 8));
+    engine::refuse_xfers = 2;
+    CHECK(engine::complete());
+    CHECK(engine::refused == 4 && !engine::out().claimed && !engine::out().busy);
+    CHECK(engine::mounted->out_queue.empty());
+
+    //A failed transfer isn't retried and isn't reported sent
+    const size_t sent = engine::sent.size();
+    CHECK(send(command(6)) && send(command(7)));
+    CHECK(engine::complete(XFER_RESULT_STALLED));
+    CHECK(engine::sent.size() == sent && engine::wire.back() == command(7));
+    CHECK(engine::drain() == 1 && engine::sent.back() == command(7));
+
+    const std::vector<Packet> expected = { command(1), command(3), rumble(5, 6), command(4), command(6), command(7) };
+    CHECK(engine::wire == expected);
+}
+
+int main()
+{
+    test_queue_order();
+    test_engine_order();
+    test_engine_full();
+    test_engine_refused();
+    return check::result("XInputOutTest");
+}